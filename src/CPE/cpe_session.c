@@ -32,6 +32,7 @@
 #include "CPE/public/cpe_dict.h"
 #include "CPE/public/cpe_lang.h"
 #include "OVAL/public/oval_agent_api.h"
+#include "OVAL/oval_agent_api_impl.h"
 #include "source/public/oscap_source.h"
 #include "source/oscap_source_priv.h"
 #include "oscap_helpers.h"
@@ -119,6 +120,8 @@ struct oval_agent_session *cpe_session_lookup_oval_session(struct cpe_session *c
 			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Cannot create OVAL session for '%s' for CPE applicability checking", prefixed_href);
 			return NULL;
 		}
+		if (cpe->collection_cache != NULL)
+			oval_agent_set_collection_cache(session, cpe->collection_cache);
 		if (cpe->thin_results) {
 			struct oval_results_model *res_model = oval_agent_get_results_model(session);
 			struct oval_directives_model *dir_model = oval_results_model_get_directives_model(res_model);
@@ -166,3 +169,8 @@ void cpe_session_set_cache(struct cpe_session *session, struct oscap_htable *sou
 {
 	session->sources_cache = sources_cache;
 }
+
+void cpe_session_set_collection_cache(struct cpe_session *session, struct oval_collection_cache *collection_cache)
+{
+	session->collection_cache = collection_cache;
+}
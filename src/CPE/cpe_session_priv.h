@@ -30,6 +30,7 @@
 #include "common/util.h"
 #include "OVAL/public/oval_agent_api.h"
 
+struct oval_collection_cache;
 
 struct cpe_session {
 	struct oscap_list *dicts;                       ///< All CPE dictionaries except the one embedded in XCCDF
@@ -37,6 +38,7 @@ struct cpe_session {
 	struct oscap_htable *oval_sessions;             ///< Caches CPE OVAL check results
 	struct oscap_htable *applicable_platforms;
 	struct oscap_htable *sources_cache;             ///< Not owned cache [path -> oscap_source]
+	struct oval_collection_cache *collection_cache; ///< Not owned cache of collected OVAL objects
 	bool thin_results;                              ///< Should OVAL results related to CPE be exported as THIN?
 };
 
@@ -48,5 +50,6 @@ bool cpe_session_add_cpe_lang_model_source(struct cpe_session *session, struct o
 bool cpe_session_add_cpe_dict_source(struct cpe_session *session, struct oscap_source *source);
 bool cpe_session_add_cpe_autodetect_source(struct cpe_session *session, struct oscap_source *source);
 void cpe_session_set_cache(struct cpe_session *session, struct oscap_htable *sources_cache);
+void cpe_session_set_collection_cache(struct cpe_session *session, struct oval_collection_cache *collection_cache);
 
 #endif
@@ -63,6 +63,7 @@ struct oval_agent_session {
 	struct oval_results_model    * res_model;
 	oval_probe_session_t  * psess;
 #endif
+	unsigned int eval_workers;
 };
 
 
@@ -135,6 +136,7 @@ oval_agent_session_t * oval_agent_new_session(struct oval_definition_model *mode
 #endif
 
 	ag_sess->product_name = NULL;
+	ag_sess->eval_workers = 1;
 
 	return ag_sess;
 }
@@ -158,6 +160,73 @@ void oval_agent_set_product_name(oval_agent_session_t *ag_sess, char * product_n
 #endif
 }
 
+void oval_agent_set_eval_workers(oval_agent_session_t *ag_sess, unsigned int workers)
+{
+	__attribute__nonnull__(ag_sess);
+
+	ag_sess->eval_workers = workers > 0 ? workers : 1;
+}
+
+void oval_agent_set_collection_cache(oval_agent_session_t *ag_sess, struct oval_collection_cache *cache)
+{
+	__attribute__nonnull__(ag_sess);
+
+#if defined(OVAL_PROBES_ENABLED)
+	oval_probe_session_set_collection_cache(ag_sess->psess, cache);
+#endif
+}
+
+int oval_agent_prefetch_definitions(oval_agent_session_t *ag_sess, struct oscap_stringlist *ids)
+{
+#if defined(OVAL_PROBES_ENABLED)
+	if (ag_sess->eval_workers < 2)
+		return 0;
+
+	struct oscap_list *definitions = oscap_list_new();
+	struct oscap_string_iterator *id_it = oscap_stringlist_get_strings(ids);
+	while (oscap_string_iterator_has_more(id_it)) {
+		const char *id = oscap_string_iterator_next(id_it);
+		struct oval_definition *oval_def = oval_definition_model_get_definition(ag_sess->def_model, id);
+		if (oval_def != NULL)
+			oscap_list_add(definitions, oval_def);
+	}
+	oscap_string_iterator_free(id_it);
+
+	int ret = oval_probe_prefetch_definitions(ag_sess->psess, definitions, ag_sess->eval_workers);
+	oscap_list_free(definitions, NULL);
+	return ret;
+#else
+	return 0;
+#endif
+}
+
+void oval_agent_renumber_items(oval_agent_session_t *ag_sess)
+{
+	__attribute__nonnull__(ag_sess);
+
+	oval_syschar_model_renumber_items(ag_sess->sys_model);
+}
+
+static int _oval_agent_prefetch_all_definitions(oval_agent_session_t *ag_sess)
+{
+#if defined(OVAL_PROBES_ENABLED)
+	if (ag_sess->eval_workers < 2)
+		return 0;
+
+	struct oscap_list *definitions = oscap_list_new();
+	struct oval_definition_iterator *oval_def_it = oval_definition_model_get_definitions(ag_sess->def_model);
+	while (oval_definition_iterator_has_more(oval_def_it))
+		oscap_list_add(definitions, oval_definition_iterator_next(oval_def_it));
+	oval_definition_iterator_free(oval_def_it);
+
+	int ret = oval_probe_prefetch_definitions(ag_sess->psess, definitions, ag_sess->eval_workers);
+	oscap_list_free(definitions, NULL);
+	return ret;
+#else
+	return 0;
+#endif
+}
+
 static struct oval_result_system *_oval_agent_get_first_result_system(oval_agent_session_t *ag_sess)
 {
 	struct oval_results_model *rmodel = oval_agent_get_results_model(ag_sess);
@@ -277,6 +346,11 @@ int oval_agent_eval_system(oval_agent_session_t * ag_sess, agent_reporter cb, vo
 	int ret = 0;
 
 	dI("OVAL agent started to evaluate OVAL definitions on your system.");
+	/* Definitions are still evaluated one by one in document order, the
+	 * objects are just collected up front. */
+	if (_oval_agent_prefetch_all_definitions(ag_sess) != 0)
+		dW("Parallel collection of OVAL objects failed, falling back to serial collection.");
+
 	oval_def_it = oval_definition_model_get_definitions(ag_sess->def_model);
 	while (oval_definition_iterator_has_more(oval_def_it)) {
 		oval_def = oval_definition_iterator_next(oval_def_it);
@@ -306,6 +380,7 @@ int oval_agent_eval_system(oval_agent_session_t * ag_sess, agent_reporter cb, vo
 
 cleanup:
 	oval_definition_iterator_free(oval_def_it);
+	oval_agent_renumber_items(ag_sess);
 	dI("OVAL agent finished evaluation.");
 	return ret;
 }
@@ -567,6 +642,9 @@ oval_agent_eval_multi_check(oval_agent_session_t *sess)
 	xccdf_test_result_type_t xccdf_result;
 	xccdf_test_result_type_t final_result = 0;
 
+	if (_oval_agent_prefetch_all_definitions(sess) != 0)
+		dW("Parallel collection of OVAL objects failed, falling back to serial collection.");
+
 	oval_def_it = oval_definition_model_get_definitions(sess->def_model);
 	if (!oval_definition_iterator_has_more(oval_def_it)) {
 		// We are evaluating oval, which has no definitions. We are in state
@@ -631,6 +709,9 @@ _oval_agent_list_definitions(void *usr, xccdf_policy_engine_query_t query_type,
 {
 	__attribute__nonnull__(usr);
 	struct oval_agent_session *sess = (struct oval_agent_session *) usr;
+	if (query_type != POLICY_ENGINE_QUERY_NAMES_FOR_HREF && query_type != POLICY_ENGINE_QUERY_OVAL_DEFS_FOR_HREF) {
+		return NULL;
+	}
 	if (query_data != NULL && strcmp(sess->filename, (const char *) query_data)) {
 		return NULL;
 	}
@@ -82,4 +82,31 @@
 #define OVAL_VAR_SCHEMA_LOCATION "http://oval.mitre.org/XMLSchema/oval-results-5 oval-results-schema.xsd http://oval.mitre.org/XMLSchema/oval-common-5 oval-common-schema.xsd http://oval.mitre.org/XMLSchema/oval-variables-5 oval-variables-schema.xsd"
 
 
+struct oval_agent_session;
+struct oscap_stringlist;
+
+/**
+ * Collect the independent objects of the given definitions up front, using
+ * the number of threads set by oval_agent_set_eval_workers().
+ * @param ids list of definition IDs, unknown IDs are skipped
+ * @returns 0 on success; -1 on error
+ */
+int oval_agent_prefetch_definitions(struct oval_agent_session *ag_sess, struct oscap_stringlist *ids);
+
+/**
+ * Give the collected items of the session sequential IDs in the order of
+ * the objects. Called once the evaluation is finished, so that the results
+ * don't depend on the order in which the objects were collected.
+ */
+void oval_agent_renumber_items(struct oval_agent_session *ag_sess);
+
+struct oval_collection_cache;
+
+/**
+ * Share the collected objects with the other sessions using the same cache.
+ * The cache is not owned by the session and has to outlive it. Does nothing
+ * if the library is built without probes.
+ */
+void oval_agent_set_collection_cache(struct oval_agent_session *ag_sess, struct oval_collection_cache *cache);
+
 #endif				/* OVAL_AGENT_API_IMPL_H_ */
@@ -0,0 +1,215 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "oval_collection_cache.h"
+#include "probes/SEAP/_sexp-ID.h"
+#include "probes/public/probe-api.h"
+#include "common/list.h"
+#include "common/util.h"
+#include "common/debug_priv.h"
+
+/*
+ * The replies are kept in addition to the system characteristics of each
+ * session, so the total number of the cached items is bounded. Once the
+ * cache is full, the further replies aren't cached; the objects are
+ * collected again by each session which refers to them.
+ */
+#define OVAL_COLLECTION_CACHE_MAX_ITEMS 65536
+
+struct oval_cached_reply {
+	SEXP_t *key;
+	SEXP_t *s_sys;
+	struct oval_cached_reply *next; /**< next reply with the same key hash */
+};
+
+struct oval_collection_cache {
+	pthread_mutex_t      lock;
+	struct oscap_htable *replies; /**< key hash -> struct oval_cached_reply */
+	size_t               items;   /**< items of all the cached replies */
+};
+
+static void oval_cached_reply_free(struct oval_cached_reply *reply)
+{
+	while (reply != NULL) {
+		struct oval_cached_reply *next = reply->next;
+
+		SEXP_free(reply->key);
+		SEXP_free(reply->s_sys);
+		free(reply);
+		reply = next;
+	}
+}
+
+struct oval_collection_cache *oval_collection_cache_new(void)
+{
+	struct oval_collection_cache *cache = malloc(sizeof(struct oval_collection_cache));
+
+	pthread_mutex_init(&cache->lock, NULL);
+	cache->replies = oscap_htable_new();
+	cache->items = 0;
+
+	return cache;
+}
+
+void oval_collection_cache_free(struct oval_collection_cache *cache)
+{
+	if (cache == NULL)
+		return;
+
+	oscap_htable_free(cache->replies, (oscap_destruct_func) oval_cached_reply_free);
+	pthread_mutex_destroy(&cache->lock);
+	free(cache);
+}
+
+void oval_collection_cache_clear(struct oval_collection_cache *cache)
+{
+	if (cache == NULL)
+		return;
+
+	pthread_mutex_lock(&cache->lock);
+	oscap_htable_free(cache->replies, (oscap_destruct_func) oval_cached_reply_free);
+	cache->replies = oscap_htable_new();
+	cache->items = 0;
+	pthread_mutex_unlock(&cache->lock);
+}
+
+bool oval_collection_cache_accepts(struct oval_object *object)
+{
+	bool accepts = true;
+	struct oval_object_content_iterator *cit = oval_object_get_object_contents(object);
+
+	while (accepts && oval_object_content_iterator_has_more(cit)) {
+		struct oval_object_content *content = oval_object_content_iterator_next(cit);
+
+		accepts = oval_object_content_get_type(content) == OVAL_OBJECTCONTENT_ENTITY;
+	}
+	oval_object_content_iterator_free(cit);
+
+	return accepts;
+}
+
+/*
+ * The object S-exp is ((name :id "..." attrs...) entities...), the key
+ * is the same list with the id attribute left out.
+ */
+static SEXP_t *oval_collection_cache_key(const SEXP_t *s_obj, char hash[17])
+{
+	SEXP_t *key, *header, *memb, *rest;
+	bool skip = false;
+
+	key = SEXP_list_new(NULL);
+	header = SEXP_list_first(s_obj);
+	SEXP_list_foreach(memb, header) {
+		if (skip) {
+			skip = false;
+		} else if (SEXP_strcmp(memb, ":id") == 0) {
+			skip = true;
+		} else {
+			SEXP_list_add(key, memb);
+		}
+	}
+	SEXP_free(header);
+
+	rest = SEXP_list_rest(s_obj);
+	SEXP_list_add(key, rest);
+	SEXP_free(rest);
+
+	snprintf(hash, 17, "%016" PRIx64, SEXP_ID_v(key));
+
+	return key;
+}
+
+SEXP_t *oval_collection_cache_get(struct oval_collection_cache *cache, const SEXP_t *s_obj)
+{
+	struct oval_cached_reply *reply;
+	SEXP_t *key, *s_sys = NULL;
+	char hash[17];
+
+	key = oval_collection_cache_key(s_obj, hash);
+
+	pthread_mutex_lock(&cache->lock);
+	for (reply = oscap_htable_get(cache->replies, hash); reply != NULL; reply = reply->next) {
+		if (SEXP_deepcmp(reply->key, key)) {
+			s_sys = SEXP_ref(reply->s_sys);
+			break;
+		}
+	}
+	pthread_mutex_unlock(&cache->lock);
+
+	SEXP_free(key);
+
+	return s_sys;
+}
+
+/*
+ * A reply without any items still takes some memory, it's counted as one.
+ */
+static size_t oval_collection_cache_weight(const SEXP_t *s_sys)
+{
+	SEXP_t *items = probe_cobj_get_items(s_sys);
+	size_t weight = items != NULL ? SEXP_list_length(items) : 0;
+
+	SEXP_free(items);
+
+	return weight > 0 ? weight : 1;
+}
+
+void oval_collection_cache_add(struct oval_collection_cache *cache, const SEXP_t *s_obj, SEXP_t *s_sys)
+{
+	struct oval_cached_reply *reply, *first;
+	size_t weight;
+	SEXP_t *key;
+	char hash[17];
+
+	weight = oval_collection_cache_weight(s_sys);
+	key = oval_collection_cache_key(s_obj, hash);
+
+	pthread_mutex_lock(&cache->lock);
+	if (cache->items + weight > OVAL_COLLECTION_CACHE_MAX_ITEMS) {
+		pthread_mutex_unlock(&cache->lock);
+		dD("The collection cache is full, the reply isn't cached.");
+		SEXP_free(key);
+		return;
+	}
+	cache->items += weight;
+
+	reply = malloc(sizeof(struct oval_cached_reply));
+	reply->key = key;
+	reply->s_sys = SEXP_ref(s_sys);
+
+	first = oscap_htable_get(cache->replies, hash);
+	if (first == NULL) {
+		reply->next = NULL;
+		oscap_htable_add(cache->replies, hash, reply);
+	} else {
+		/* keep the first reply in the table */
+		reply->next = first->next;
+		first->next = reply;
+	}
+	pthread_mutex_unlock(&cache->lock);
+}
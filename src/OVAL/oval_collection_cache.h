@@ -0,0 +1,60 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+
+#pragma once
+#ifndef OVAL_COLLECTION_CACHE_H
+#define OVAL_COLLECTION_CACHE_H
+
+#include <sexp.h>
+#include "public/oval_definitions.h"
+
+/*
+ * Probe replies shared by the OVAL sessions of a scan. The replies are
+ * keyed by the S-exp of the collected object without its ID, i.e. by the
+ * object content, behaviors and the values of the referenced variables,
+ * so equal objects from different definition models are collected once.
+ * The number of the cached items is bounded, replies which don't fit are
+ * not cached.
+ */
+struct oval_collection_cache;
+
+struct oval_collection_cache *oval_collection_cache_new(void);
+void oval_collection_cache_free(struct oval_collection_cache *cache);
+
+/*
+ * Forget all the replies, e.g. because the system has changed.
+ */
+void oval_collection_cache_clear(struct oval_collection_cache *cache);
+
+/*
+ * Objects with sets or filters refer to other objects and states by ID,
+ * which are resolved in the definition model of the session, so their
+ * collection can't be shared.
+ */
+bool oval_collection_cache_accepts(struct oval_object *object);
+
+/*
+ * Returns a new reference to the reply for an object equal to s_obj,
+ * NULL if there is none.
+ */
+SEXP_t *oval_collection_cache_get(struct oval_collection_cache *cache, const SEXP_t *s_obj);
+void oval_collection_cache_add(struct oval_collection_cache *cache, const SEXP_t *s_obj, SEXP_t *s_sys);
+
+#endif /* OVAL_COLLECTION_CACHE_H */
@@ -94,14 +94,42 @@ static void _syschar_add_bindings(struct oval_syschar *sc, struct oval_string_ma
 	oval_collection_iterator_free(var_itr);
 }
 
+void oval_probe_bind_variables(struct oval_syschar *sysc)
+{
+	struct oval_string_map *vm = oval_string_map_new();
+
+	oval_obj_collect_var_refs(oval_syschar_get_object(sysc), vm);
+	_syschar_add_bindings(sysc, vm);
+	oval_string_map_free(vm, NULL);
+}
+
+/*
+ * Give the syschar of a duplicate object the result of the object with
+ * the same content. The items are shared, both syschars refer to them.
+ */
+static void _syschar_copy_collection(struct oval_syschar *dst, struct oval_syschar *src)
+{
+	oval_syschar_set_flag(dst, oval_syschar_get_flag(src));
+
+	struct oval_message_iterator *msg_itr = oval_syschar_get_messages(src);
+	while (oval_message_iterator_has_more(msg_itr))
+		oval_syschar_add_message(dst, oval_message_clone(oval_message_iterator_next(msg_itr)));
+	oval_message_iterator_free(msg_itr);
+
+	struct oval_sysitem_iterator *item_itr = oval_syschar_get_sysitem(src);
+	while (oval_sysitem_iterator_has_more(item_itr))
+		oval_syschar_add_sysitem(dst, oval_sysitem_iterator_next(item_itr));
+	oval_sysitem_iterator_free(item_itr);
+}
+
 int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *object, int flags, struct oval_syschar **out_syschar)
 {
 	char *oid;
 	struct oval_syschar *sysc;
+	struct oval_object *canonical;
         oval_subtype_t type;
 	const char *type_name;
         oval_ph_t *ph;
-	struct oval_string_map *vm;
 	struct oval_syschar_model *model;
 	int ret;
 
@@ -140,6 +168,24 @@ int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *obj
 	if (out_syschar)
 		*out_syschar = sysc;
 
+	canonical = oval_string_map_get_value(psess->duplicates, oid);
+	if (canonical != NULL && !(flags & OVAL_PDFLAG_NOREPLY)) {
+		struct oval_syschar *canonical_sysc = NULL;
+
+		ret = oval_probe_query_object(psess, canonical, flags, &canonical_sysc);
+
+		/* objects evaluated for other variable instances are collected on their own */
+		if (canonical_sysc != NULL &&
+		    oval_syschar_get_variable_instance(canonical_sysc) == oval_syschar_get_variable_instance(sysc)) {
+			dI("Using the items of %s_object '%s' for '%s'.", type_name, oval_object_get_id(canonical), oid);
+			_syschar_copy_collection(sysc, canonical_sysc);
+
+			if (ret == 0)
+				oval_probe_bind_variables(sysc);
+			return ret;
+		}
+	}
+
 	ph = oval_probe_handler_get(psess->ph, type);
 
 	if (ph == NULL) {
@@ -157,12 +203,8 @@ int oval_probe_query_object(oval_probe_session_t *psess, struct oval_object *obj
 		return ret;
 	}
 
-	if (!(flags & OVAL_PDFLAG_NOREPLY)) {
-		vm = oval_string_map_new();
-		oval_obj_collect_var_refs(object, vm);
-		_syschar_add_bindings(sysc, vm);
-		oval_string_map_free(vm, NULL);
-	}
+	if (!(flags & OVAL_PDFLAG_NOREPLY))
+		oval_probe_bind_variables(sysc);
 
 	return 0;
 }
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "public/oval_definitions.h"
+#include "public/oval_schema_version.h"
+#include "oval_probe_impl.h"
+#include "adt/oval_string_map_impl.h"
+#include "common/oscap_string.h"
+#include "common/debug_priv.h"
+
+/*
+ * Objects are compared by a canonical string made of everything that is
+ * sent to the probe, except the object ID. Strings are prefixed by their
+ * length and missing ones are written as "-", so that different contents
+ * can't produce the same key. Variables, states and the objects of sets
+ * are referred to by their IDs, which are unique within the model.
+ */
+static void _oval_dedup_key_str(struct oscap_string *key, const char *str)
+{
+	char buf[32];
+
+	if (str == NULL) {
+		oscap_string_append_string(key, "-,");
+		return;
+	}
+	snprintf(buf, sizeof(buf), "%zu:", strlen(str));
+	oscap_string_append_string(key, buf);
+	oscap_string_append_string(key, str);
+	oscap_string_append_char(key, ',');
+}
+
+static void _oval_dedup_key_int(struct oscap_string *key, long long num)
+{
+	char buf[32];
+
+	snprintf(buf, sizeof(buf), "%lld,", num);
+	oscap_string_append_string(key, buf);
+}
+
+static void _oval_dedup_key_entity(struct oscap_string *key, struct oval_entity *entity)
+{
+	struct oval_variable *variable;
+	struct oval_value *value;
+
+	_oval_dedup_key_str(key, oval_entity_get_name(entity));
+	_oval_dedup_key_int(key, oval_entity_get_type(entity));
+	_oval_dedup_key_int(key, oval_entity_get_datatype(entity));
+	_oval_dedup_key_int(key, oval_entity_get_operation(entity));
+	_oval_dedup_key_int(key, oval_entity_get_mask(entity));
+	_oval_dedup_key_int(key, oval_entity_get_varref_type(entity));
+
+	variable = oval_entity_get_variable(entity);
+	_oval_dedup_key_str(key, variable != NULL ? oval_variable_get_id(variable) : NULL);
+
+	value = oval_entity_get_value(entity);
+	if (value != NULL) {
+		_oval_dedup_key_int(key, oval_value_get_datatype(value));
+		_oval_dedup_key_str(key, oval_value_get_text(value));
+	} else {
+		_oval_dedup_key_str(key, NULL);
+	}
+}
+
+static void _oval_dedup_key_filter(struct oscap_string *key, struct oval_filter *filter)
+{
+	struct oval_state *state = oval_filter_get_state(filter);
+
+	_oval_dedup_key_int(key, oval_filter_get_filter_action(filter));
+	_oval_dedup_key_str(key, state != NULL ? oval_state_get_id(state) : NULL);
+}
+
+static void _oval_dedup_key_setobject(struct oscap_string *key, struct oval_setobject *set)
+{
+	_oval_dedup_key_int(key, oval_setobject_get_type(set));
+	_oval_dedup_key_int(key, oval_setobject_get_operation(set));
+
+	oscap_string_append_char(key, '(');
+	struct oval_setobject_iterator *subset_it = oval_setobject_get_subsets(set);
+	while (oval_setobject_iterator_has_more(subset_it))
+		_oval_dedup_key_setobject(key, oval_setobject_iterator_next(subset_it));
+	oval_setobject_iterator_free(subset_it);
+
+	struct oval_object_iterator *obj_it = oval_setobject_get_objects(set);
+	while (oval_object_iterator_has_more(obj_it))
+		_oval_dedup_key_str(key, oval_object_get_id(oval_object_iterator_next(obj_it)));
+	oval_object_iterator_free(obj_it);
+
+	struct oval_filter_iterator *filter_it = oval_setobject_get_filters(set);
+	while (oval_filter_iterator_has_more(filter_it))
+		_oval_dedup_key_filter(key, oval_filter_iterator_next(filter_it));
+	oval_filter_iterator_free(filter_it);
+	oscap_string_append_char(key, ')');
+}
+
+/*
+ * Returns the canonical content of the object, NULL if the object has a
+ * content which is not known here and mustn't be merged with others.
+ */
+static char *_oval_dedup_key(struct oval_object *object)
+{
+	struct oscap_string *key = oscap_string_new();
+	oval_schema_version_t version = oval_object_get_platform_schema_version(object);
+	bool known = true;
+	int i;
+
+	_oval_dedup_key_int(key, oval_object_get_subtype(object));
+	for (i = 0; i < OVAL_SCHEMA_VERSION_COMPONENTS_COUNT; ++i)
+		_oval_dedup_key_int(key, version.component[i]);
+
+	oscap_string_append_char(key, '[');
+	struct oval_behavior_iterator *bhv_it = oval_object_get_behaviors(object);
+	while (oval_behavior_iterator_has_more(bhv_it)) {
+		struct oval_behavior *behavior = oval_behavior_iterator_next(bhv_it);
+
+		_oval_dedup_key_str(key, oval_behavior_get_key(behavior));
+		_oval_dedup_key_str(key, oval_behavior_get_value(behavior));
+	}
+	oval_behavior_iterator_free(bhv_it);
+	oscap_string_append_char(key, ']');
+
+	struct oval_object_content_iterator *cnt_it = oval_object_get_object_contents(object);
+	while (known && oval_object_content_iterator_has_more(cnt_it)) {
+		struct oval_object_content *content = oval_object_content_iterator_next(cnt_it);
+		oval_object_content_type_t type = oval_object_content_get_type(content);
+
+		_oval_dedup_key_int(key, type);
+		_oval_dedup_key_str(key, oval_object_content_get_field_name(content));
+
+		switch (type) {
+		case OVAL_OBJECTCONTENT_ENTITY:
+			_oval_dedup_key_int(key, oval_object_content_get_varCheck(content));
+			_oval_dedup_key_entity(key, oval_object_content_get_entity(content));
+			break;
+		case OVAL_OBJECTCONTENT_SET:
+			_oval_dedup_key_setobject(key, oval_object_content_get_setobject(content));
+			break;
+		case OVAL_OBJECTCONTENT_FILTER:
+			_oval_dedup_key_filter(key, oval_object_content_get_filter(content));
+			break;
+		default:
+			known = false;
+		}
+	}
+	oval_object_content_iterator_free(cnt_it);
+
+	if (!known) {
+		oscap_string_free(key);
+		return NULL;
+	}
+
+	return oscap_string_bequeath(key);
+}
+
+struct oval_string_map *oval_probe_dedup_objects(struct oval_definition_model *model)
+{
+	struct oval_string_map *first, *duplicates;
+	size_t count = 0;
+
+	duplicates = oval_string_map_new();
+	if (model == NULL)
+		return duplicates;
+
+	first = oval_string_map_new();
+
+	struct oval_object_iterator *obj_it = oval_definition_model_get_objects(model);
+	while (oval_object_iterator_has_more(obj_it)) {
+		struct oval_object *object = oval_object_iterator_next(obj_it);
+		struct oval_object *canonical;
+		char *key;
+
+		/* internal copies made for variable instances */
+		if (oval_object_get_base_obj(object) != NULL)
+			continue;
+
+		key = _oval_dedup_key(object);
+		if (key == NULL)
+			continue;
+
+		canonical = oval_string_map_get_value(first, key);
+		if (canonical == NULL) {
+			oval_string_map_put(first, key, object);
+		} else {
+			dD("Object '%s' has the same content as '%s'.",
+			   oval_object_get_id(object), oval_object_get_id(canonical));
+			oval_string_map_put(duplicates, oval_object_get_id(object), canonical);
+			++count;
+		}
+		free(key);
+	}
+	oval_object_iterator_free(obj_it);
+
+	oval_string_map_free(first, NULL);
+
+	if (count > 0)
+		dI("%zu objects will be collected only once, as duplicates of other objects.", count);
+
+	return duplicates;
+}
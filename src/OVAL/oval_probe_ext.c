@@ -47,6 +47,7 @@
 #include "oval_sexp.h"
 #include "probe-table.h"
 #include "_oval_probe_handler.h"
+#include "_oval_probe_session.h"
 
 #define __ERRBUF_SIZE 128
 
@@ -432,7 +433,6 @@ static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj,
 		return -1;
 	}
 
-	ctx->subtype = pd->subtype;
 	for (retry = 0;;) {
 		/*
 		 * Establish connection to probe. The connection may be
@@ -440,6 +440,7 @@ static int oval_probe_comm(SEAP_CTX_t *ctx, oval_pd_t *pd, const SEXP_t *s_iobj,
 		 * by the probe context handling functions.
 		 */
 		if (pd->sd == -1) {
+			ctx->subtype = pd->subtype;
 			pd->sd = SEAP_connect(ctx);
 
 			if (pd->sd < 0) {
@@ -960,10 +961,25 @@ int oval_probe_ext_init(oval_pext_t *pext)
         return(ret);
 }
 
+/*
+ * Collection cache of the session, NULL if the replies to the object
+ * can't be shared with other sessions.
+ */
+static struct oval_collection_cache *oval_pext_cache(oval_pext_t *pext, struct oval_object *object)
+{
+	struct oval_collection_cache *cache = ((oval_probe_session_t *)pext->sess_ptr)->cache;
+
+	if (cache == NULL || !oval_collection_cache_accepts(object))
+		return (NULL);
+
+	return (cache);
+}
+
 int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struct oval_syschar *syschar, int flags)
 {
         SEXP_t *s_obj, *s_sys;
 	struct oval_object *object;
+	struct oval_collection_cache *cache = NULL;
 	int ret;
 
 	if (syschar == NULL) {
@@ -977,7 +993,27 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
 	if (ret != 0)
 		return (1);
 
-	ret = oval_probe_comm(ctx, pd, s_obj, flags, &s_sys);
+	if (!(flags & OVAL_PDFLAG_NOREPLY))
+		cache = oval_pext_cache(pext, object);
+
+	if (cache != NULL) {
+		s_sys = oval_collection_cache_get(cache, s_obj);
+
+		if (s_sys != NULL) {
+			dD("Reusing the collected items of an equal object, id: %s", oval_object_get_id(object));
+			SEXP_free(s_obj);
+			ret = oval_sexp_to_sysch(s_sys, syschar);
+			SEXP_free(s_sys);
+
+			return (ret);
+		}
+		ret = oval_probe_comm(ctx, pd, s_obj, flags, &s_sys);
+
+		if (ret == 0)
+			oval_collection_cache_add(cache, s_obj, s_sys);
+	} else {
+		ret = oval_probe_comm(ctx, pd, s_obj, flags, &s_sys);
+	}
 	SEXP_free(s_obj);
 
 	if (ret != 0) {
@@ -1019,6 +1055,375 @@ int oval_probe_ext_eval(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext, struc
 	return (ret);
 }
 
+/*
+ * Parallel collection of independent objects. The calling thread does
+ * everything that touches the OVAL models (S-exp conversion, probe
+ * descriptor table, translation of the results). Worker threads only
+ * exchange messages with the probes and each probe descriptor is adopted
+ * by exactly one worker, which pipelines the requests of its probe. The
+ * descriptors are handed back to the calling thread once all the workers
+ * are finished.
+ */
+#define OVAL_PEXT_INFLIGHT 1
+
+struct oval_pext_job {
+	struct oval_syschar *syschar;
+	SEXP_t *s_obj;
+	SEXP_t *s_sys;
+	int     ret; /**< 0 collected, OVAL_PEXT_INFLIGHT waiting for reply, -1 not collected */
+	struct oval_collection_cache *cache; /**< where to keep the reply, NULL if not shared */
+};
+
+struct oval_pext_group {
+	oval_pd_t             *pd;
+	struct oval_pext_job **jobs;
+	size_t                 count;
+	bool                   failed; /**< the connection has to be dropped */
+};
+
+struct oval_pext_queue {
+	pthread_mutex_t         lock;
+	SEAP_CTX_t             *ctx;
+	struct oval_pext_group *groups;
+	size_t                  count;
+	size_t                  next;
+};
+
+/*
+ * Keeps up to probe_table_get_max_inflight() requests in flight; probes
+ * which don't opt in get one request at a time. The replies may arrive in
+ * any order and are matched to the requests by message ID, so a slow
+ * object doesn't hold back the fast ones. Objects for which the probe
+ * reported an error are left to the serial collection.
+ */
+static int oval_probe_comm_pipelined(SEAP_CTX_t *ctx, struct oval_pext_group *group)
+{
+	oval_pd_t    *pd = group->pd;
+	SEAP_msgid_t *ids;
+	SEAP_msg_t   *s_omsg, *s_imsg;
+	SEAP_msgid_t  rid;
+	size_t first, sent, pending, i, depth;
+
+	depth = (size_t)probe_table_get_max_inflight(pd->subtype);
+	ids = malloc(sizeof(SEAP_msgid_t) * group->count);
+	first = sent = pending = 0;
+
+	while (sent < group->count || pending > 0) {
+		while (sent < group->count && pending < depth) {
+			s_omsg = SEAP_msg_new();
+			SEAP_msg_set(s_omsg, group->jobs[sent]->s_obj);
+
+			if (SEAP_sendmsg(ctx, pd->sd, s_omsg) != 0) {
+				protect_errno {
+					dW("Can't send message: %u, %s.", errno, strerror(errno));
+					SEAP_msg_free(s_omsg);
+				}
+				goto fail;
+			}
+
+			ids[sent] = SEAP_msg_id(s_omsg);
+			group->jobs[sent]->ret = OVAL_PEXT_INFLIGHT;
+			SEAP_msg_free(s_omsg);
+			++sent;
+			++pending;
+		}
+
+		s_imsg = NULL;
+
+		if (SEAP_recvmsg(ctx, pd->sd, &s_imsg) != 0) {
+			if (errno != ECANCELED) {
+				protect_errno {
+					dW("Can't receive message: %u, %s.", errno, strerror(errno));
+				}
+				goto fail;
+			}
+			/*
+			 * The probe reported an error for one of the requests,
+			 * the error queue tells which one.
+			 */
+			for (i = first; i < sent; ++i) {
+				SEAP_err_t *err = NULL;
+
+				if (group->jobs[i]->ret != OVAL_PEXT_INFLIGHT)
+					continue;
+				if (SEAP_recverr_byid(ctx, pd->sd, &err, ids[i]) != 0)
+					continue;
+
+				dD("Probe reported an error for message %u: %u.", (unsigned int)ids[i], err->code);
+				SEAP_error_free(err);
+				group->jobs[i]->ret = -1;
+				--pending;
+			}
+		} else if (SEAP_msg_reply_id(s_imsg, &rid) == 0) {
+			for (i = first; i < sent; ++i) {
+				if (ids[i] == rid && group->jobs[i]->ret == OVAL_PEXT_INFLIGHT)
+					break;
+			}
+
+			if (i < sent) {
+				group->jobs[i]->s_sys = SEAP_msg_get(s_imsg);
+				group->jobs[i]->ret = 0;
+				--pending;
+			} else {
+				dW("Unexpected reply to message %u.", (unsigned int)rid);
+			}
+
+			SEAP_msg_free(s_imsg);
+		} else {
+			dW("Received a message which is not a reply.");
+			SEAP_msg_free(s_imsg);
+		}
+
+		while (first < sent && group->jobs[first]->ret != OVAL_PEXT_INFLIGHT)
+			++first;
+	}
+
+	free(ids);
+	return (0);
+fail:
+	for (i = first; i < sent; ++i) {
+		if (group->jobs[i]->ret == OVAL_PEXT_INFLIGHT)
+			group->jobs[i]->ret = -1;
+	}
+
+	free(ids);
+	return (-1);
+}
+
+static void *oval_probe_ext_worker(void *arg)
+{
+	struct oval_pext_queue *queue = (struct oval_pext_queue *)arg;
+	struct oval_pext_group *group;
+
+#if defined(HAVE_PTHREAD_SETNAME_NP)
+# if defined(OS_APPLE)
+	pthread_setname_np("oval_collect");
+# else
+	pthread_setname_np(pthread_self(), "oval_collect");
+# endif
+#endif
+
+	for (;;) {
+		pthread_mutex_lock(&queue->lock);
+		group = queue->next < queue->count ? &queue->groups[queue->next++] : NULL;
+		pthread_mutex_unlock(&queue->lock);
+
+		if (group == NULL)
+			break;
+
+		dD("Collecting %zu %s objects.", group->count, oval_subtype_get_text(group->pd->subtype));
+		SEAP_adopt(queue->ctx, group->pd->sd);
+
+		if (oval_probe_comm_pipelined(queue->ctx, group) != 0) {
+			/*
+			 * Replies to the requests still in flight would be
+			 * taken for replies to other requests, the connection
+			 * is dropped by the calling thread once all workers
+			 * are finished. The serial collection reconnects.
+			 */
+			dW("Can't talk to the %s probe, sd=%d will be closed.",
+			   oval_subtype_get_text(group->pd->subtype), group->pd->sd);
+			group->failed = true;
+		}
+	}
+
+	/*
+	 * Errors are thread local; the objects are probed again by the
+	 * serial collection which reports them properly.
+	 */
+	if (oscap_err()) {
+		dW("Parallel collection failed: %s", oscap_err_desc());
+		oscap_clearerr();
+	}
+
+	return (NULL);
+}
+
+static oval_pd_t *oval_probe_ext_pd_open(oval_pext_t *pext, oval_subtype_t type)
+{
+	oval_pd_t *pd;
+	char       probe_uri[PATH_MAX + 1];
+	size_t     probe_urilen;
+
+	pd = oval_pdtbl_get(pext->pdtbl, type);
+
+	if (pd == NULL) {
+		if (!probe_table_exists(type))
+			return (NULL);
+
+		probe_urilen = snprintf(probe_uri, sizeof probe_uri, "%s://%s",
+				OVAL_PROBE_SCHEME, oval_subtype_get_text(type));
+
+		if (probe_urilen >= sizeof probe_uri)
+			return (NULL);
+
+		dI("Starting probe on URI '%s'.", probe_uri);
+
+		if (oval_pdtbl_add(pext->pdtbl, type, -1, probe_uri) != 0)
+			return (NULL);
+
+		pd = oval_pdtbl_get(pext->pdtbl, type);
+	}
+
+	if (pd != NULL && pd->sd == -1) {
+		pext->pdtbl->ctx->subtype = pd->subtype;
+		pd->sd = SEAP_connect(pext->pdtbl->ctx);
+
+		if (pd->sd < 0) {
+			protect_errno {
+				dW("Can't connect: %u, %s.", errno, strerror(errno));
+			}
+			pd->sd = -1;
+			return (NULL);
+		}
+	}
+
+	return (pd);
+}
+
+int oval_probe_ext_eval_parallel(oval_pext_t *pext, struct oval_syschar **syschars, size_t count, unsigned int workers)
+{
+	struct oval_pext_job  *jobs;
+	struct oval_pext_queue queue;
+	pthread_t *threads;
+	size_t i, j, nthreads;
+
+	if (pext == NULL || pext->pdtbl == NULL || syschars == NULL)
+		return (-1);
+
+	if (count == 0)
+		return (0);
+
+	jobs = calloc(count, sizeof(struct oval_pext_job));
+	queue.ctx    = pext->pdtbl->ctx;
+	queue.groups = NULL;
+	queue.count  = 0;
+	queue.next   = 0;
+
+	/*
+	 * Prepare the requests and group them by probe.
+	 */
+	for (i = 0; i < count; ++i) {
+		struct oval_object *object = oval_syschar_get_object(syschars[i]);
+		oval_subtype_t subtype = oval_object_get_subtype(object);
+		struct oval_pext_group *group = NULL;
+		oval_pd_t *pd;
+
+		jobs[i].syschar = syschars[i];
+		jobs[i].ret = -1;
+
+		pd = oval_probe_ext_pd_open(pext, subtype);
+		if (pd == NULL)
+			continue;
+
+		if (oval_object_to_sexp(pext->sess_ptr, oval_subtype_to_str(subtype), syschars[i], &jobs[i].s_obj) != 0) {
+			jobs[i].s_obj = NULL;
+			continue;
+		}
+
+		jobs[i].cache = oval_pext_cache(pext, object);
+		if (jobs[i].cache != NULL) {
+			jobs[i].s_sys = oval_collection_cache_get(jobs[i].cache, jobs[i].s_obj);
+
+			if (jobs[i].s_sys != NULL) {
+				/* collected by another session already */
+				dD("Reusing the collected items of an equal object, id: %s", oval_object_get_id(object));
+				jobs[i].cache = NULL;
+				jobs[i].ret = 0;
+				continue;
+			}
+		}
+
+		for (j = 0; j < queue.count; ++j) {
+			if (queue.groups[j].pd == pd) {
+				group = &queue.groups[j];
+				break;
+			}
+		}
+
+		if (group == NULL) {
+			queue.groups = realloc(queue.groups, sizeof(struct oval_pext_group) * (queue.count + 1));
+			group = &queue.groups[queue.count++];
+			group->pd    = pd;
+			group->jobs  = NULL;
+			group->count = 0;
+			group->failed = false;
+		}
+
+		group->jobs = realloc(group->jobs, sizeof(struct oval_pext_job *) * (group->count + 1));
+		group->jobs[group->count++] = &jobs[i];
+	}
+
+	nthreads = workers < queue.count ? workers : queue.count;
+	dI("Collecting %zu objects of %zu types using %zu threads.", count, queue.count, nthreads);
+
+	if (nthreads > 0) {
+		threads = malloc(sizeof(pthread_t) * nthreads);
+		pthread_mutex_init(&queue.lock, NULL);
+
+		for (i = 0; i < nthreads; ++i) {
+			if (pthread_create(&threads[i], NULL, oval_probe_ext_worker, &queue) != 0) {
+				dW("Can't start collection thread: %u, %s.", errno, strerror(errno));
+				break;
+			}
+		}
+
+		/*
+		 * Run the queue in this thread too if no worker could be started.
+		 */
+		if (i == 0)
+			oval_probe_ext_worker(&queue);
+
+		for (j = 0; j < i; ++j)
+			pthread_join(threads[j], NULL);
+
+		/*
+		 * Connections are opened and closed by this thread only, the
+		 * workers just exchange messages on the descriptors.
+		 */
+		for (j = 0; j < queue.count; ++j) {
+			oval_pd_t *pd = queue.groups[j].pd;
+
+			if (pd->sd == -1)
+				continue;
+
+			SEAP_adopt(queue.ctx, pd->sd);
+			if (queue.groups[j].failed) {
+				SEAP_close(queue.ctx, pd->sd);
+				pd->sd = -1;
+			}
+		}
+
+		pthread_mutex_destroy(&queue.lock);
+		free(threads);
+	}
+
+	/*
+	 * Translate the results in the original order. Objects which were
+	 * not collected keep the unknown flag and are probed again when
+	 * their test is evaluated.
+	 */
+	for (i = 0; i < count; ++i) {
+		if (jobs[i].ret == 0 && jobs[i].s_sys != NULL) {
+			oval_sexp_to_sysch(jobs[i].s_sys, jobs[i].syschar);
+
+			if (jobs[i].cache != NULL)
+				oval_collection_cache_add(jobs[i].cache, jobs[i].s_obj, jobs[i].s_sys);
+		}
+
+		SEXP_free(jobs[i].s_obj);
+		SEXP_free(jobs[i].s_sys);
+	}
+
+	for (j = 0; j < queue.count; ++j)
+		free(queue.groups[j].jobs);
+
+	free(queue.groups);
+	free(jobs);
+
+	return (0);
+}
+
 int oval_probe_ext_reset(SEAP_CTX_t *ctx, oval_pd_t *pd, oval_pext_t *pext)
 {
         SEAP_cmd_exec(ctx, pd->sd, SEAP_EXEC_RECV, PROBECMD_RESET, NULL, SEAP_CMDTYPE_SYNC, NULL, NULL);
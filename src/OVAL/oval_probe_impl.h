@@ -63,5 +63,26 @@ const char *oval_subtype_to_str(oval_subtype_t subtype);
 
 int oval_probe_hint_definition(oval_probe_session_t *sess, struct oval_definition *definition, int variable_instance_hint);
 
+/*
+ * Record the values of the variables used by the object of the syschar,
+ * once the object is collected.
+ */
+void oval_probe_bind_variables(struct oval_syschar *sysc);
+
+struct oscap_list;
+int oval_probe_prefetch_definitions(oval_probe_session_t *sess, struct oscap_list *definitions, unsigned int workers);
+
+/*
+ * Find the objects of the model which have the same content as another
+ * object. Returns a map from the ID of each such object to the first object
+ * with its content; the duplicates are not collected but get the items of
+ * that object.
+ */
+struct oval_string_map *oval_probe_dedup_objects(struct oval_definition_model *model);
+
+struct oval_collection_cache;
+/* Share the probe replies with other sessions, the cache isn't owned by the session */
+void oval_probe_session_set_collection_cache(oval_probe_session_t *sess, struct oval_collection_cache *cache);
+
 #endif /* OVAL_PROBE_IMPL_H */
 /// @}
@@ -0,0 +1,447 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "public/oval_definitions.h"
+#include "public/oval_system_characteristics.h"
+#include "oval_system_characteristics_impl.h"
+#include "oval_probe_impl.h"
+#include "_oval_probe_session.h"
+#include "_oval_probe_handler.h"
+#include "adt/oval_string_map_impl.h"
+#include "common/list.h"
+#include "common/_error.h"
+#include "common/debug_priv.h"
+
+/* Level of an object which is not collected before the evaluation */
+#define OVAL_PLAN_SKIP -1
+/* Level of an object whose dependencies are being resolved */
+#define OVAL_PLAN_PENDING -2
+
+struct oval_plan_entry {
+	struct oval_object *object;
+	oval_subtype_t      subtype;
+	int                 level;  /**< length of the longest chain of objects this one depends on */
+	size_t              index;  /**< position in the evaluation order */
+	bool                has_set;
+};
+
+struct oval_prefetch_ctx {
+	oval_probe_session_t   *sess;
+	struct oval_string_map *visited; /**< definitions already seen */
+	struct oval_string_map *entries; /**< object ID -> struct oval_plan_entry */
+	struct oscap_list      *objects; /**< planned entries, in evaluation order */
+};
+
+static void _oval_probe_prefetch_definition(struct oval_prefetch_ctx *ctx, struct oval_definition *definition);
+static int _oval_probe_plan_object(struct oval_prefetch_ctx *ctx, struct oval_object *object);
+static int _oval_probe_plan_variable(struct oval_prefetch_ctx *ctx, struct oval_variable *variable);
+
+static inline int _oval_probe_plan_max(int level, int dep_level)
+{
+	if (level == OVAL_PLAN_SKIP || dep_level == OVAL_PLAN_SKIP)
+		return OVAL_PLAN_SKIP;
+	return dep_level > level ? dep_level : level;
+}
+
+static int _oval_probe_plan_component(struct oval_prefetch_ctx *ctx, struct oval_component *component)
+{
+	int level = 0;
+
+	if (component == NULL)
+		return 0;
+
+	switch (oval_component_get_type(component)) {
+	case OVAL_COMPONENT_LITERAL:
+		return 0;
+	case OVAL_COMPONENT_OBJECTREF:
+		level = _oval_probe_plan_object(ctx, oval_component_get_object(component));
+		return level == OVAL_PLAN_SKIP ? OVAL_PLAN_SKIP : level + 1;
+	case OVAL_COMPONENT_VARREF:
+		return _oval_probe_plan_variable(ctx, oval_component_get_variable(component));
+	case OVAL_COMPONENT_UNKNOWN:
+		return OVAL_PLAN_SKIP;
+	default:{
+		struct oval_component_iterator *comp_it = oval_component_get_function_components(component);
+		while (level != OVAL_PLAN_SKIP && oval_component_iterator_has_more(comp_it))
+			level = _oval_probe_plan_max(level, _oval_probe_plan_component(ctx, oval_component_iterator_next(comp_it)));
+		oval_component_iterator_free(comp_it);
+		return level;
+	}
+	}
+}
+
+static int _oval_probe_plan_variable(struct oval_prefetch_ctx *ctx, struct oval_variable *variable)
+{
+	if (variable == NULL)
+		return OVAL_PLAN_SKIP;
+
+	switch (oval_variable_get_type(variable)) {
+	case OVAL_VARIABLE_EXTERNAL:
+	case OVAL_VARIABLE_CONSTANT:
+		return 0;
+	case OVAL_VARIABLE_LOCAL:
+		return _oval_probe_plan_component(ctx, oval_variable_get_component(variable));
+	default:
+		return OVAL_PLAN_SKIP;
+	}
+}
+
+static int _oval_probe_plan_entity(struct oval_prefetch_ctx *ctx, struct oval_entity *entity)
+{
+	if (entity == NULL || oval_entity_get_varref_type(entity) == OVAL_ENTITY_VARREF_NONE)
+		return 0;
+	return _oval_probe_plan_variable(ctx, oval_entity_get_variable(entity));
+}
+
+static int _oval_probe_plan_state(struct oval_prefetch_ctx *ctx, struct oval_state *state)
+{
+	int level = 0;
+
+	if (state == NULL)
+		return 0;
+
+	struct oval_state_content_iterator *cont_it = oval_state_get_contents(state);
+	while (level != OVAL_PLAN_SKIP && oval_state_content_iterator_has_more(cont_it)) {
+		struct oval_state_content *cont = oval_state_content_iterator_next(cont_it);
+		level = _oval_probe_plan_max(level, _oval_probe_plan_entity(ctx, oval_state_content_get_entity(cont)));
+	}
+	oval_state_content_iterator_free(cont_it);
+
+	return level;
+}
+
+static int _oval_probe_plan_setobject(struct oval_prefetch_ctx *ctx, struct oval_setobject *set)
+{
+	int level = 0;
+
+	switch (oval_setobject_get_type(set)) {
+	case OVAL_SET_AGGREGATE:{
+		struct oval_setobject_iterator *set_it = oval_setobject_get_subsets(set);
+		while (level != OVAL_PLAN_SKIP && oval_setobject_iterator_has_more(set_it))
+			level = _oval_probe_plan_max(level, _oval_probe_plan_setobject(ctx, oval_setobject_iterator_next(set_it)));
+		oval_setobject_iterator_free(set_it);
+		return level;
+	}
+	case OVAL_SET_COLLECTIVE:{
+		struct oval_object_iterator *obj_it = oval_setobject_get_objects(set);
+		while (level != OVAL_PLAN_SKIP && oval_object_iterator_has_more(obj_it)) {
+			int dep_level = _oval_probe_plan_object(ctx, oval_object_iterator_next(obj_it));
+			level = _oval_probe_plan_max(level, dep_level == OVAL_PLAN_SKIP ? OVAL_PLAN_SKIP : dep_level + 1);
+		}
+		oval_object_iterator_free(obj_it);
+
+		struct oval_filter_iterator *filter_it = oval_setobject_get_filters(set);
+		while (level != OVAL_PLAN_SKIP && oval_filter_iterator_has_more(filter_it))
+			level = _oval_probe_plan_max(level, _oval_probe_plan_state(ctx, oval_filter_get_state(oval_filter_iterator_next(filter_it))));
+		oval_filter_iterator_free(filter_it);
+		return level;
+	}
+	default:
+		return OVAL_PLAN_SKIP;
+	}
+}
+
+/*
+ * Computes the level of the object, that is the length of the longest
+ * chain of objects which must be collected before this object can be
+ * collected. The dependencies are added to the plan before the object,
+ * which gives a topological order of the objects. Objects on cyclic
+ * paths and objects which are not handled by an external probe are left
+ * to the evaluation.
+ */
+static int _oval_probe_plan_object(struct oval_prefetch_ctx *ctx, struct oval_object *object)
+{
+	struct oval_plan_entry *entry;
+	int level = 0;
+
+	if (object == NULL)
+		return OVAL_PLAN_SKIP;
+
+	const char *oid = oval_object_get_id(object);
+	entry = oval_string_map_get_value(ctx->entries, oid);
+	if (entry != NULL) {
+		if (entry->level == OVAL_PLAN_PENDING) {
+			dD("Object '%s' depends on itself, leaving it to the evaluation.", oid);
+			return OVAL_PLAN_SKIP;
+		}
+		return entry->level;
+	}
+
+	entry = malloc(sizeof(struct oval_plan_entry));
+	entry->object = object;
+	entry->subtype = oval_object_get_subtype(object);
+	entry->level = OVAL_PLAN_PENDING;
+	entry->has_set = false;
+	oval_string_map_put(ctx->entries, oid, entry);
+
+	struct oval_object_content_iterator *cont_it = oval_object_get_object_contents(object);
+	while (level != OVAL_PLAN_SKIP && oval_object_content_iterator_has_more(cont_it)) {
+		struct oval_object_content *cont = oval_object_content_iterator_next(cont_it);
+
+		switch (oval_object_content_get_type(cont)) {
+		case OVAL_OBJECTCONTENT_ENTITY:
+			level = _oval_probe_plan_max(level, _oval_probe_plan_entity(ctx, oval_object_content_get_entity(cont)));
+			break;
+		case OVAL_OBJECTCONTENT_FILTER:
+			level = _oval_probe_plan_max(level, _oval_probe_plan_state(ctx, oval_filter_get_state(oval_object_content_get_filter(cont))));
+			break;
+		case OVAL_OBJECTCONTENT_SET:
+			entry->has_set = true;
+			level = _oval_probe_plan_max(level, _oval_probe_plan_setobject(ctx, oval_object_content_get_setobject(cont)));
+			break;
+		default:
+			level = OVAL_PLAN_SKIP;
+		}
+	}
+	oval_object_content_iterator_free(cont_it);
+
+	oval_ph_t *ph = oval_probe_handler_get(ctx->sess->ph, entry->subtype);
+	if (ph == NULL || ph->func != &oval_probe_ext_handler)
+		level = OVAL_PLAN_SKIP;
+
+	entry->level = level;
+	if (level != OVAL_PLAN_SKIP) {
+		entry->index = oscap_list_get_itemcount(ctx->objects);
+		oscap_list_add(ctx->objects, entry);
+	}
+
+	return level;
+}
+
+static void _oval_probe_prefetch_criteria(struct oval_prefetch_ctx *ctx, struct oval_criteria_node *cnode)
+{
+	switch (oval_criteria_node_get_type(cnode)) {
+	case OVAL_NODETYPE_CRITERION:{
+		struct oval_test *test = oval_criteria_node_get_test(cnode);
+		if (test == NULL)
+			return;
+		struct oval_object *object = oval_test_get_object(test);
+		if (object == NULL)
+			return;
+		/* mirror oval_probe_query_test(), incompatible objects are never probed */
+		if (oval_test_get_subtype(test) != oval_object_get_subtype(object))
+			return;
+		_oval_probe_plan_object(ctx, object);
+		/* objects referenced like this: test->state->variable->object */
+		struct oval_state_iterator *ste_it = oval_test_get_states(test);
+		while (oval_state_iterator_has_more(ste_it))
+			_oval_probe_plan_state(ctx, oval_state_iterator_next(ste_it));
+		oval_state_iterator_free(ste_it);
+		return;
+	}
+	case OVAL_NODETYPE_CRITERIA:{
+		struct oval_criteria_node_iterator *cnode_it = oval_criteria_node_get_subnodes(cnode);
+		if (cnode_it == NULL)
+			return;
+		while (oval_criteria_node_iterator_has_more(cnode_it)) {
+			struct oval_criteria_node *node = oval_criteria_node_iterator_next(cnode_it);
+			_oval_probe_prefetch_criteria(ctx, node);
+		}
+		oval_criteria_node_iterator_free(cnode_it);
+		return;
+	}
+	case OVAL_NODETYPE_EXTENDDEF:{
+		struct oval_definition *oval_def = oval_criteria_node_get_definition(cnode);
+		_oval_probe_prefetch_definition(ctx, oval_def);
+		return;
+	}
+	case OVAL_NODETYPE_UNKNOWN:
+		return;
+	}
+}
+
+static void _oval_probe_prefetch_definition(struct oval_prefetch_ctx *ctx, struct oval_definition *definition)
+{
+	if (definition == NULL)
+		return;
+	const char *id = oval_definition_get_id(definition);
+	if (oval_string_map_get_value(ctx->visited, id) != NULL)
+		return;
+	oval_string_map_put(ctx->visited, id, definition);
+
+	struct oval_criteria_node *cnode = oval_definition_get_criteria(definition);
+	if (cnode != NULL)
+		_oval_probe_prefetch_criteria(ctx, cnode);
+}
+
+/* Orders the plan by level, then by probe, then by evaluation order. */
+static int _oval_plan_entry_cmp(const void *a, const void *b)
+{
+	const struct oval_plan_entry *e1 = *(const struct oval_plan_entry **)a;
+	const struct oval_plan_entry *e2 = *(const struct oval_plan_entry **)b;
+
+	if (e1->level != e2->level)
+		return e1->level < e2->level ? -1 : 1;
+	if (e1->subtype != e2->subtype)
+		return e1->subtype < e2->subtype ? -1 : 1;
+	if (e1->index != e2->index)
+		return e1->index < e2->index ? -1 : 1;
+	return 0;
+}
+
+static void _oval_probe_plan_log(struct oval_plan_entry **plan, size_t count)
+{
+	size_t i, run;
+
+	dI("OVAL collection plan: %zu objects in %d levels.", count,
+	   count > 0 ? plan[count - 1]->level + 1 : 0);
+
+	for (i = 0; i < count; i += run) {
+		for (run = 1; i + run < count; ++run) {
+			if (plan[i + run]->level != plan[i]->level || plan[i + run]->subtype != plan[i]->subtype)
+				break;
+		}
+		dI("  level %d: %zu %s_object(s)", plan[i]->level, run, oval_subtype_to_str(plan[i]->subtype));
+	}
+
+	for (i = 0; i < count; ++i)
+		dD("Planned %s_object '%s' at level %d.", oval_subtype_to_str(plan[i]->subtype),
+		   oval_object_get_id(plan[i]->object), plan[i]->level);
+}
+
+/**
+ * Plans and runs the collection of the objects of the given definitions
+ * before the definitions are evaluated. Objects are ordered topologically
+ * by their variable and set dependencies and grouped by probe, so that
+ * each probe receives all its objects of one level as a single pipelined
+ * batch. Level 0 objects (no variables and no sets) are collected
+ * concurrently by up to @a workers threads, the remaining levels are
+ * collected level by level in the calling thread, because evaluating
+ * their variables calls back into the library. The collected objects are
+ * stored in the system characteristics model of the session, so the
+ * subsequent evaluation of the definitions finds them there. Objects
+ * which could not be collected are left to the evaluation, which reports
+ * the errors.
+ * @param definitions list of struct oval_definition
+ * @returns 0 on success; -1 on error
+ */
+int oval_probe_prefetch_definitions(oval_probe_session_t *sess, struct oscap_list *definitions, unsigned int workers)
+{
+	struct oval_prefetch_ctx ctx;
+	struct oval_plan_entry **plan;
+	struct oval_syschar **syschars;
+	size_t count, nsyschars, i;
+	int ret;
+
+	if (sess == NULL || definitions == NULL)
+		return -1;
+	if (workers < 2)
+		return 0;
+
+	/*
+	 * The chroot offline mode changes the root directory of the whole
+	 * process, so the probes must not run concurrently.
+	 */
+	const char *rootdir = getenv("OSCAP_PROBE_ROOT");
+	if (rootdir != NULL && strlen(rootdir) > 0)
+		return 0;
+
+	ctx.sess = sess;
+	ctx.visited = oval_string_map_new();
+	ctx.entries = oval_string_map_new();
+	ctx.objects = oscap_list_new();
+
+	struct oscap_iterator *def_it = oscap_iterator_new(definitions);
+	while (oscap_iterator_has_more(def_it))
+		_oval_probe_prefetch_definition(&ctx, oscap_iterator_next(def_it));
+	oscap_iterator_free(def_it);
+
+	count = oscap_list_get_itemcount(ctx.objects);
+	plan = malloc(sizeof(struct oval_plan_entry *) * (count + 1));
+	syschars = malloc(sizeof(struct oval_syschar *) * (count + 1));
+
+	i = 0;
+	struct oscap_iterator *obj_it = oscap_iterator_new(ctx.objects);
+	while (oscap_iterator_has_more(obj_it))
+		plan[i++] = oscap_iterator_next(obj_it);
+	oscap_iterator_free(obj_it);
+
+	qsort(plan, count, sizeof(struct oval_plan_entry *), _oval_plan_entry_cmp);
+	_oval_probe_plan_log(plan, count);
+
+	/*
+	 * level 0, duplicates are replaced by the object with the same content
+	 * and get its items when they are queried
+	 */
+	struct oval_string_map *scheduled = oval_string_map_new();
+	nsyschars = 0;
+	for (i = 0; i < count && plan[i]->level == 0; ++i) {
+		struct oval_object *object = plan[i]->object;
+		struct oval_object *canonical;
+
+		if (plan[i]->has_set)
+			continue;
+		canonical = oval_string_map_get_value(sess->duplicates, oval_object_get_id(object));
+		if (canonical != NULL)
+			object = canonical;
+		if (oval_string_map_get_value(scheduled, oval_object_get_id(object)) != NULL)
+			continue;
+		if (oval_syschar_model_get_syschar(sess->sys_model, oval_object_get_id(object)) != NULL)
+			continue;
+		oval_string_map_put(scheduled, oval_object_get_id(object), object);
+		syschars[nsyschars++] = oval_syschar_new(sess->sys_model, object);
+	}
+	oval_string_map_free(scheduled, NULL);
+
+	dI("Prefetching %zu independent objects using %u workers.", nsyschars, workers);
+	ret = oval_probe_ext_eval_parallel(sess->pext, syschars, nsyschars, workers);
+
+	/*
+	 * Objects of level 0 may use constant and external variables. The
+	 * evaluation doesn't query the collected objects again, so their
+	 * variable values are recorded here, like oval_probe_query_object()
+	 * does. Objects which were not collected keep the unknown flag and
+	 * get them when they are queried.
+	 */
+	for (i = 0; i < nsyschars; ++i) {
+		if (oval_syschar_get_flag(syschars[i]) != SYSCHAR_FLAG_UNKNOWN)
+			oval_probe_bind_variables(syschars[i]);
+	}
+
+	/*
+	 * Sets are collected with the help of the library and the variables
+	 * of the higher levels are evaluated by the library, so these objects
+	 * are queried one by one; they are still grouped by probe.
+	 */
+	for (i = 0; ret == 0 && i < count; ++i) {
+		if (plan[i]->level == 0 && !plan[i]->has_set)
+			continue;
+		if (oval_probe_query_object(sess, plan[i]->object, 0, NULL) == -1) {
+			/* the evaluation queries the object again and reports the error */
+			dD("Prefetching of %s_object '%s' failed: %s", oval_subtype_to_str(plan[i]->subtype),
+			   oval_object_get_id(plan[i]->object), oscap_err_desc());
+			oscap_clearerr();
+		}
+	}
+
+	free(syschars);
+	free(plan);
+	oscap_list_free(ctx.objects, NULL);
+	oval_string_map_free(ctx.entries, free);
+	oval_string_map_free(ctx.visited, NULL);
+
+	return ret;
+}
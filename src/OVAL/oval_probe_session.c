@@ -133,6 +133,7 @@ static void oval_probe_session_init(oval_probe_session_t *sess, struct oval_sysc
         sess->pext = oval_pext_new();
         sess->pext->model    = &sess->sys_model;
         sess->pext->sess_ptr = sess;
+        sess->duplicates = oval_probe_dedup_objects(model != NULL ? oval_syschar_model_get_definition_model(model) : NULL);
 
         __init_once();
 
@@ -154,6 +155,7 @@ static void oval_probe_session_init(oval_probe_session_t *sess, struct oval_sysc
 oval_probe_session_t *oval_probe_session_new(struct oval_syschar_model *model)
 {
         oval_probe_session_t *sess = malloc(sizeof(oval_probe_session_t));
+        sess->cache = NULL;
         oval_probe_session_init(sess, model);
         return sess;
 }
@@ -167,6 +169,7 @@ static void oval_probe_session_free(oval_probe_session_t *sess)
 
 	oval_phtbl_free(sess->ph);
 	oval_pext_free(sess->pext);
+	oval_string_map_free(sess->duplicates, NULL);
 }
 
 void oval_probe_session_reinit(oval_probe_session_t *sess, struct oval_syschar_model *model)
@@ -212,6 +215,11 @@ int oval_probe_session_abort(oval_probe_session_t *sess)
         return ph->func(OVAL_SUBTYPE_ALL, ph->uptr, PROBE_HANDLER_ACT_ABORT);
 }
 
+void oval_probe_session_set_collection_cache(oval_probe_session_t *sess, struct oval_collection_cache *cache)
+{
+	sess->cache = cache;
+}
+
 struct oval_syschar_model *oval_probe_session_getmodel(oval_probe_session_t *sess)
 {
 	if (sess == NULL) {
@@ -41,6 +41,7 @@
 #include "source/xslt_priv.h"
 #include "public/oval_agent_api.h"
 #include "public/oval_session.h"
+#include "oval_agent_api_impl.h"
 #include "../DS/public/ds_sds_session.h"
 #include "oscap_source.h"
 #include "oscap_helpers.h"
@@ -85,6 +86,7 @@ struct oval_session {
 	bool fetch_remote_resources;
 	download_progress_calllback_t progress;
 	const char *local_files;
+	unsigned int eval_workers;
 };
 
 struct oval_session *oval_session_new(const char *filename)
@@ -333,6 +335,7 @@ static int oval_session_setup_agent(struct oval_session *session)
 	free(path_clone);
 
 	oval_agent_set_product_name(session->sess, (char *)oscap_productname);
+	oval_agent_set_eval_workers(session->sess, session->eval_workers);
 	return 0;
 }
 
@@ -350,6 +353,7 @@ int oval_session_evaluate_id(struct oval_session *session, const char *id, oval_
 	}
 
 	oval_agent_eval_definition(session->sess, id);
+	oval_agent_renumber_items(session->sess);
 	*result = OVAL_RESULT_NOT_EVALUATED;
 	oval_agent_get_definition_result(session->sess, id, result);
 	if (oscap_err()) {
@@ -452,6 +456,11 @@ void oval_session_set_export_system_characteristics(struct oval_session *session
 	session->export_sys_chars = export;
 }
 
+void oval_session_set_eval_workers(struct oval_session *session, unsigned int workers)
+{
+	session->eval_workers = workers;
+}
+
 void oval_session_configure_remote_resources(struct oval_session *session, bool allowed, const char *local_files, download_progress_calllback_t callback)
 {
 	session->fetch_remote_resources = allowed;
@@ -152,6 +152,13 @@ char *oval_sysitem_get_id(struct oval_sysitem *item)
 	return item->id;
 }
 
+void oval_sysitem_set_id(struct oval_sysitem *item, const char *id)
+{
+	__attribute__nonnull__(item);
+	free(item->id);
+	item->id = oscap_strdup(id);
+}
+
 struct oval_message_iterator *oval_sysitem_get_messages(struct oval_sysitem *item)
 {
 	__attribute__nonnull__(item);
@@ -32,6 +32,7 @@
 #include <config.h>
 #endif
 
+#include <stdio.h>
 #include <string.h>
 #include <time.h>
 
@@ -305,6 +306,59 @@ struct oval_sysitem *oval_syschar_model_get_new_sysitem(struct oval_syschar_mode
 	return sysitem;
 }
 
+/*
+ * The probes number the items in the order in which they are collected,
+ * which depends on the number of collection threads. Once the collection
+ * is finished the items get sequential IDs in the order of the objects,
+ * i.e. the order of the collected objects in the exported document, and of
+ * the items of each object. Items shared by several objects keep the ID
+ * given for the first one. The syschars and the results refer to the items
+ * directly, so only the lookup map has to be rebuilt.
+ */
+void oval_syschar_model_renumber_items(struct oval_syschar_model *model)
+{
+	struct oval_string_map *sysitem_map;
+	struct oval_sysitem *sysitem;
+	unsigned int next_id = 1;
+	char id[32];
+
+	__attribute__nonnull__(model);
+
+	sysitem_map = oval_string_map_new();
+
+	struct oval_syschar_iterator *syschars = oval_syschar_model_get_syschars(model);
+	while (oval_syschar_iterator_has_more(syschars)) {
+		struct oval_syschar *syschar = oval_syschar_iterator_next(syschars);
+		struct oval_sysitem_iterator *sysitems = oval_syschar_get_sysitem(syschar);
+
+		while (oval_sysitem_iterator_has_more(sysitems)) {
+			sysitem = oval_sysitem_iterator_next(sysitems);
+			if (oval_string_map_get_value(sysitem_map, oval_sysitem_get_id(sysitem)) == sysitem)
+				continue; /* already renumbered */
+			snprintf(id, sizeof id, "%u", next_id++);
+			oval_sysitem_set_id(sysitem, id);
+			oval_string_map_put(sysitem_map, id, sysitem);
+		}
+		oval_sysitem_iterator_free(sysitems);
+	}
+	oval_syschar_iterator_free(syschars);
+
+	/* items which no object refers to follow in the order of their old IDs */
+	struct oval_iterator *sysitems = oval_string_map_values(model->sysitem_map);
+	while (oval_collection_iterator_has_more(sysitems)) {
+		sysitem = oval_collection_iterator_next(sysitems);
+		if (oval_string_map_get_value(sysitem_map, oval_sysitem_get_id(sysitem)) == sysitem)
+			continue;
+		snprintf(id, sizeof id, "%u", next_id++);
+		oval_sysitem_set_id(sysitem, id);
+		oval_string_map_put(sysitem_map, id, sysitem);
+	}
+	oval_collection_iterator_free(sysitems);
+
+	oval_string_map_free(model->sysitem_map, NULL);
+	model->sysitem_map = sysitem_map;
+}
+
 xmlNode *oval_syschar_model_to_dom(struct oval_syschar_model * syschar_model, xmlDocPtr doc, xmlNode * parent, 
 			           oval_syschar_resolver resolver, void *user_arg, bool export_syschar)
 {
@@ -72,6 +72,8 @@ struct oval_syschar *oval_syschar_model_get_new_syschar(struct oval_syschar_mode
 struct oval_sysitem *oval_syschar_model_get_new_sysitem(struct oval_syschar_model *, const char *id);
 void oval_syschar_model_add_syschar(struct oval_syschar_model *model, struct oval_syschar *syschar);
 void oval_syschar_model_add_sysitem(struct oval_syschar_model *model, struct oval_sysitem *sysitem);
+void oval_syschar_model_renumber_items(struct oval_syschar_model *model);
+void oval_sysitem_set_id(struct oval_sysitem *item, const char *id);
 
 void oval_syschar_model_set_schema(struct oval_syschar_model *model, const char * schema);
 const char * oval_syschar_model_get_schema(struct oval_syschar_model * model);
@@ -62,5 +62,12 @@ SEXP_t *SEAP_msg_get(SEAP_msg_t *msg);
 
 int SEAP_msgattr_set(SEAP_msg_t *msg, const char *name, SEXP_t *value);
 bool SEAP_msgattr_exists(SEAP_msg_t *msg, const char *name);
+SEXP_t *SEAP_msgattr_get(SEAP_msg_t *msg, const char *name);
+
+/*
+ * Get the ID of the request a reply was sent for. Returns -1 if the message
+ * is not a reply.
+ */
+int SEAP_msg_reply_id(SEAP_msg_t *msg, SEAP_msgid_t *id);
 
 #endif /* _SEAP_MESSAGE_H */
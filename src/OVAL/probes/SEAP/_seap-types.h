@@ -25,6 +25,7 @@
 #define _SEAP_TYPES_H
 
 #include <stdint.h>
+#include <pthread.h>
 #include "_sexp-types.h"
 #include "../../../common/util.h"
 #include "generic/rbt/rbt_common.h"
@@ -36,6 +37,7 @@ typedef uint8_t SEAP_cflags_t;
 typedef struct {
         rbt_t       *tree;
         bitmap_t    *bmap;
+        pthread_mutex_t lock; /* descriptors are added and removed by several collection threads */
 } SEAP_desctable_t;
 
 typedef struct {
@@ -49,6 +49,7 @@ int SEAP_open(SEAP_CTX_t *ctx, const char *path, uint32_t flags);
 SEXP_t *SEAP_read(SEAP_CTX_t *ctx, int sd);
 int SEAP_write(SEAP_CTX_t *ctx, int sd, SEXP_t *sexp);
 int SEAP_close(SEAP_CTX_t *ctx, int sd);
+int SEAP_adopt(SEAP_CTX_t *ctx, int sd);
 
 int SEAP_openfd(SEAP_CTX_t *ctx, int fd, uint32_t flags);
 int SEAP_openfd2(SEAP_CTX_t *ctx, int ifd, int ofd, uint32_t flags);
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#pragma once
+#ifndef _SEXP_ARENA_H
+#define _SEXP_ARENA_H
+
+#include <stddef.h>
+
+/*
+ * Region allocator for S-exp values and list blocks. While an arena is
+ * bound to a thread, the values and list blocks created by the thread are
+ * carved from 64k chunks instead of being malloc'd one by one.
+ *
+ * The values are still reference counted and freed one by one; a chunk
+ * only counts its live allocations and is released in bulk when the last
+ * one is freed and the arena doesn't carve from it anymore. Values which
+ * outlive the arena, e.g. items kept in the probe caches, keep their chunk
+ * allocated.
+ */
+typedef struct SEXP_arena SEXP_arena_t;
+
+SEXP_arena_t *SEXP_arena_new (void);
+
+/*
+ * Stop carving from the arena. The chunks are freed as soon as all the
+ * values allocated from them are freed.
+ */
+void SEXP_arena_free (SEXP_arena_t *arena);
+
+/*
+ * Bind the arena to the calling thread, NULL unbinds the current one.
+ * Returns the previously bound arena.
+ */
+SEXP_arena_t *SEXP_arena_bind (SEXP_arena_t *arena);
+
+/*
+ * Allocate memory aligned to 16 bytes from the arena bound to the calling
+ * thread. Returns NULL if no arena is bound or if the size is too big, the
+ * caller has to fall back to malloc and remember which one was used.
+ */
+void *SEXP_arena_alloc (size_t size);
+void  SEXP_arena_dealloc (void *ptr);
+
+/*
+ * Number of the chunks of all the arenas which weren't released yet.
+ */
+size_t SEXP_arena_chunk_count (void);
+
+#endif /* _SEXP_ARENA_H */
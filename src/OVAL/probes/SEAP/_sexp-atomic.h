@@ -34,4 +34,7 @@ uint32_t SEXP_atomic_dec_u32 (volatile uint32_t *ptr);
 uint32_t SEXP_atomic_inc_u32 (volatile uint32_t *ptr);
 bool     SEXP_atomic_cas_u32 (volatile uint32_t *ptr, uint32_t old, uint32_t new);
 
+void    *SEXP_atomic_load_ptr  (void * volatile *ptr);
+void     SEXP_atomic_store_ptr (void * volatile *ptr, void *val);
+
 #endif /* _SEXP_ATOMIC_H */
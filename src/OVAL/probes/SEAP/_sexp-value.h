@@ -40,6 +40,7 @@ typedef uint8_t SEXP_valtype_t;
 
 typedef struct {
         uint32_t refs;
+        bool     arena; /* allocated from an arena */
         size_t   size;
 } SEXP_valhdr_t;
 
@@ -56,6 +57,7 @@ typedef struct {
 #define SEXP_VALP_HDR(p) ((SEXP_valhdr_t *)(((uintptr_t)(p)) & SEXP_VALP_MASK))
 
 int       SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_valtype_t type);
+void      SEXP_val_free (SEXP_val_t *dsc);
 void      SEXP_val_dsc (SEXP_val_t *dst, uintptr_t ptr);
 uintptr_t SEXP_val_ptr (SEXP_val_t *dsc);
 
@@ -83,8 +85,19 @@ SEXP_DEFNUM(u64, uint64_t);
  * List
  */
 
+/*
+ * l_addr caches the last block of the list so that the blocks don't have
+ * to be walked on every append. It's set only while no block of the list
+ * is shared with another list; it's NULL otherwise and SEXP_list_add falls
+ * back to SEXP_rawval_lblk_add, which copies the shared blocks. It's cleared
+ * by SEXP_list_rest on a list which other threads may read at the same time,
+ * so the readers of a shared value use SEXP_atomic_load_ptr and
+ * SEXP_atomic_store_ptr. SEXP_list_add owns the value and needn't.
+ */
 struct SEXP_val_list {
         void    *b_addr;
+        void    *l_addr;
+        size_t   length;
         uint16_t offset;
 };
 
@@ -94,11 +107,13 @@ struct SEXP_val_lblk {
         uintptr_t nxsz;
         uint16_t  real;
         uint16_t  refs;
-	SEXP_t *memb;
+        bool      arena; /* allocated from an arena */
+	SEXP_t *memb;   /* follows the block in the same allocation */
 };
 
 size_t    SEXP_rawval_list_length (struct SEXP_val_list *list);
 uintptr_t SEXP_rawval_list_copy (uintptr_t s_valp);
+void      SEXP_rawval_list_add (struct SEXP_val_list *list, const SEXP_t *s_exp);
 
 uintptr_t SEXP_rawval_lblk_copy (uintptr_t lblkp, uint16_t n_skip);
 uintptr_t SEXP_rawval_lblk_new  (uint8_t sz);
@@ -119,6 +134,15 @@ void      SEXP_rawval_lblk_free1 (uintptr_t lblkp, void (*func) (SEXP_t *));
 #define SEXP_LBLKP_MASK (UINTPTR_MAX << 4)
 #define SEXP_LBLKS_MASK 0x0f
 
+/*
+ * A block of size sz holds 2^sz items. The size is stored in the low four
+ * bits of nxsz, so the largest block holds 2^15 items. Each new block of a
+ * list doubles the size, after the largest one it starts again at 2^6.
+ */
+#define SEXP_LBLK_SZ_MAX     15
+#define SEXP_LBLK_SZ_RESTART 6
+#define SEXP_LBLK_NEXT_SZ(sz) ((sz) == SEXP_LBLK_SZ_MAX ? SEXP_LBLK_SZ_RESTART : (sz) + 1)
+
 #define SEXP_VALP_LBLK(valp) ((struct SEXP_val_lblk *)((uintptr_t)(valp) & SEXP_LBLKP_MASK))
 
 uintptr_t SEXP_rawval_copy(uintptr_t s_valp);
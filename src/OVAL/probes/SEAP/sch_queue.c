@@ -50,6 +50,7 @@ int sch_queue_connect(SEAP_desc_t *desc)
 	pthread_mutex_init(&data->to_probe_mutex, NULL);
 
 	data->parent_thread_id = pthread_self();
+	pthread_mutex_init(&data->parent_mutex, NULL);
 
 	struct probe_common_main_argument *arg = malloc(sizeof(struct probe_common_main_argument));
 	arg->subtype = desc->subtype;
@@ -69,6 +70,17 @@ int sch_queue_connect(SEAP_desc_t *desc)
 	return 0;
 }
 
+static bool sch_queue_is_parent(sch_queuedata_t *data)
+{
+	bool is_parent;
+
+	pthread_mutex_lock(&data->parent_mutex);
+	is_parent = pthread_equal(pthread_self(), data->parent_thread_id);
+	pthread_mutex_unlock(&data->parent_mutex);
+
+	return is_parent;
+}
+
 SEXP_t *sch_queue_recvsexp(SEAP_desc_t *desc)
 {
 	sch_queuedata_t *data = (sch_queuedata_t *)desc->scheme_data;
@@ -76,7 +88,7 @@ SEXP_t *sch_queue_recvsexp(SEAP_desc_t *desc)
 	pthread_mutex_t *mutex;
 	pthread_cond_t *cond;
 	int *cnt;
-	if (pthread_equal(pthread_self(), data->parent_thread_id)) {
+	if (sch_queue_is_parent(data)) {
 		queue = data->from_probe_queue;
 		mutex = &data->from_probe_mutex;
 		cond = &data->from_probe_cond;
@@ -104,7 +116,7 @@ ssize_t sch_queue_sendsexp(SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags)
 	pthread_mutex_t *mutex;
 	pthread_cond_t *cond;
 	int *cnt;
-	if (pthread_equal(pthread_self(), data->parent_thread_id)) {
+	if (sch_queue_is_parent(data)) {
 		queue = data->to_probe_queue;
 		mutex = &data->to_probe_mutex;
 		cond = &data->to_probe_cond;
@@ -143,7 +155,22 @@ int sch_queue_close(SEAP_desc_t *desc, uint32_t flags)
 cleanup:
 	oscap_queue_free(data->to_probe_queue, NULL);
 	oscap_queue_free(data->from_probe_queue, NULL);
+	pthread_mutex_destroy(&data->parent_mutex);
 	free(data);
 	free(desc->arg);
 	return ret;
 }
+
+/*
+ * The direction of the queues is given by the thread which uses the
+ * descriptor, make the calling thread the library side end. The caller
+ * has to ensure there are no requests in flight.
+ */
+void sch_queue_adopt(SEAP_desc_t *desc)
+{
+	sch_queuedata_t *data = (sch_queuedata_t *) desc->scheme_data;
+
+	pthread_mutex_lock(&data->parent_mutex);
+	data->parent_thread_id = pthread_self();
+	pthread_mutex_unlock(&data->parent_mutex);
+}
@@ -30,6 +30,7 @@
 typedef struct {
 	pthread_t probe_thread_id;
 	pthread_t parent_thread_id;
+	pthread_mutex_t parent_mutex; /* parent_thread_id is changed by sch_queue_adopt */
 	struct oscap_queue *to_probe_queue;
 	struct oscap_queue *from_probe_queue;
 	pthread_cond_t to_probe_cond;
@@ -44,5 +45,6 @@ int sch_queue_connect(SEAP_desc_t *desc);
 ssize_t sch_queue_sendsexp(SEAP_desc_t *desc, SEXP_t *sexp, uint32_t flags);
 SEXP_t *sch_queue_recvsexp(SEAP_desc_t *desc);
 int sch_queue_close(SEAP_desc_t *desc, uint32_t flags);
+void sch_queue_adopt(SEAP_desc_t *desc);
 
 #endif /* OPENSCAP_SCH_QUEUE_H */
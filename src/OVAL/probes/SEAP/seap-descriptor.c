@@ -35,12 +35,13 @@ SEAP_desctable_t *SEAP_desctable_new (void)
 	SEAP_desctable_t *t = malloc(sizeof(SEAP_desctable_t));
         t->tree = NULL;
         t->bmap = NULL;
+        pthread_mutex_init(&t->lock, NULL);
 
         return(t);
 }
 
-int SEAP_desc_add(SEAP_desctable_t *sd_table, SEAP_scheme_t scheme,
-                   void *scheme_data)
+static int SEAP_desc_add_locked(SEAP_desctable_t *sd_table, SEAP_scheme_t scheme,
+                                void *scheme_data)
 {
         bitmap_bitn_t sd;
         pthread_mutexattr_t mutex_attr;
@@ -91,7 +92,19 @@ int SEAP_desc_add(SEAP_desctable_t *sd_table, SEAP_scheme_t scheme,
         return (-1);
 }
 
-int SEAP_desc_del (SEAP_desctable_t *sd_table, int sd)
+int SEAP_desc_add(SEAP_desctable_t *sd_table, SEAP_scheme_t scheme,
+                   void *scheme_data)
+{
+        int sd;
+
+        pthread_mutex_lock(&sd_table->lock);
+        sd = SEAP_desc_add_locked(sd_table, scheme, scheme_data);
+        pthread_mutex_unlock(&sd_table->lock);
+
+        return (sd);
+}
+
+static int SEAP_desc_del_locked (SEAP_desctable_t *sd_table, int sd)
 {
         SEAP_desc_t *dsc = NULL;
 
@@ -114,6 +127,17 @@ int SEAP_desc_del (SEAP_desctable_t *sd_table, int sd)
         return (0);
 }
 
+int SEAP_desc_del (SEAP_desctable_t *sd_table, int sd)
+{
+        int ret;
+
+        pthread_mutex_lock(&sd_table->lock);
+        ret = SEAP_desc_del_locked(sd_table, sd);
+        pthread_mutex_unlock(&sd_table->lock);
+
+        return (ret);
+}
+
 static void __SEAP_desc_errqueue_free_cb(struct rbt_i32_node *n)
 {
     SEAP_error_free(n->data);
@@ -141,6 +165,7 @@ void SEAP_desctable_free(SEAP_desctable_t *sd_table)
                 rbt_i32_free_cb(sd_table->tree, &SEAP_desc_free_node);
         if (sd_table->bmap != NULL)
                 bitmap_free(sd_table->bmap);
+        pthread_mutex_destroy(&sd_table->lock);
 	free(sd_table);
 }
 
@@ -148,15 +173,18 @@ SEAP_desc_t *SEAP_desc_get (SEAP_desctable_t *sd_table, int sd)
 {
         SEAP_desc_t *dsc = NULL;
 
-        if (sd < 0 || sd_table->tree == NULL) {
+        if (sd < 0) {
                 errno = EBADF;
                 return (NULL);
         }
 
-        if (rbt_i32_get(sd_table->tree, sd, (void *)&dsc) != 0) {
+        pthread_mutex_lock(&sd_table->lock);
+        if (sd_table->tree == NULL || rbt_i32_get(sd_table->tree, sd, (void *)&dsc) != 0)
+                dsc = NULL;
+        pthread_mutex_unlock(&sd_table->lock);
+
+        if (dsc == NULL)
                 errno = EBADF;
-                return (NULL);
-        }
 
         return(dsc);
 }
@@ -66,7 +66,7 @@ typedef struct {
 #define SEAP_DESC_FDOUT 0x00000002
 #define SEAP_DESC_SELF  -1
 
-#define SEAP_DESCTBL_INITIALIZER { NULL, NULL }
+#define SEAP_DESCTBL_INITIALIZER { NULL, NULL, PTHREAD_MUTEX_INITIALIZER }
 
 #define SEAP_BUFFER_SIZE 2*4096
 #define SEAP_MAX_OPENDESC 128
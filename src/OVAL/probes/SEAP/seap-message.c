@@ -29,6 +29,7 @@
 #include "_sexp-types.h"
 #include "_seap-types.h"
 #include "_seap-message.h"
+#include "public/sexp-manip.h"
 #include "debug_priv.h"
 
 SEAP_msg_t *SEAP_msg_new (void)
@@ -147,3 +148,39 @@ bool SEAP_msgattr_exists (SEAP_msg_t *msg, const char *name)
         return (false);
 }
 
+SEXP_t *SEAP_msgattr_get (SEAP_msg_t *msg, const char *name)
+{
+        uint16_t i;
+
+        _A(msg  != NULL);
+        _A(name != NULL);
+
+        for (i = 0; i < msg->attrs_cnt; ++i) {
+                if (strcmp (name, msg->attrs[i].name) == 0)
+                        return (SEXP_ref (msg->attrs[i].value));
+        }
+
+        return (NULL);
+}
+
+int SEAP_msg_reply_id (SEAP_msg_t *msg, SEAP_msgid_t *id)
+{
+        SEXP_t *r0;
+
+        _A(msg != NULL);
+        _A(id  != NULL);
+
+        r0 = SEAP_msgattr_get (msg, "reply-id");
+
+        if (r0 == NULL)
+                return (-1);
+
+#if SEAP_MSGID_BITS == 64
+        *id = SEXP_number_getu_64 (r0);
+#else
+        *id = SEXP_number_getu_32 (r0);
+#endif
+        SEXP_free (r0);
+
+        return (0);
+}
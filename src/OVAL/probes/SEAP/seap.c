@@ -621,3 +621,20 @@ int SEAP_close (SEAP_CTX_t *ctx, int sd)
 
         return(ret);
 }
+
+int SEAP_adopt (SEAP_CTX_t *ctx, int sd)
+{
+        SEAP_desc_t *dsc;
+
+        _A(ctx != NULL);
+
+        dsc = SEAP_desc_get (ctx->sd_table, sd);
+
+        if (dsc == NULL) {
+                errno = EBADF;
+                return (-1);
+        }
+
+        sch_queue_adopt(dsc);
+        return (0);
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "_sexp-atomic.h"
+#include "_sexp-arena.h"
+#include "../../../common/util.h"
+
+/*
+ * The chunks are aligned to their size so that the chunk of an
+ * allocation can be found from its address.
+ */
+#define SEXP_ARENA_CHUNK_SIZE (64 * 1024)
+#define SEXP_ARENA_CHUNK_MASK (~((uintptr_t)SEXP_ARENA_CHUNK_SIZE - 1))
+#define SEXP_ARENA_MAX_ALLOC  (SEXP_ARENA_CHUNK_SIZE / 16)
+#define SEXP_ARENA_ALIGN(sz)  (((sz) + 15) & ~((size_t)15))
+
+struct SEXP_arena_chunk {
+        /*
+         * Allocations which weren't freed yet, plus one
+         * while the arena carves from the chunk.
+         */
+        volatile uint32_t live;
+        size_t used;
+};
+
+struct SEXP_arena {
+        struct SEXP_arena_chunk *chunk;
+};
+
+static pthread_key_t  __arena_key;
+static pthread_once_t __arena_once = PTHREAD_ONCE_INIT;
+
+/* Chunks which weren't released yet, of all the arenas */
+static volatile uint32_t __arena_chunks = 0;
+
+static void SEXP_arena_key_init (void)
+{
+        (void)pthread_key_create (&__arena_key, NULL);
+}
+
+static void SEXP_arena_chunk_decref (struct SEXP_arena_chunk *chunk)
+{
+        if (SEXP_atomic_dec_u32 (&chunk->live) == 0) {
+                oscap_aligned_free (chunk);
+                SEXP_atomic_dec_u32 (&__arena_chunks);
+        }
+}
+
+SEXP_arena_t *SEXP_arena_new (void)
+{
+        SEXP_arena_t *arena = malloc (sizeof (SEXP_arena_t));
+
+        if (arena == NULL)
+                return (NULL);
+
+        arena->chunk = NULL;
+
+        return (arena);
+}
+
+void SEXP_arena_free (SEXP_arena_t *arena)
+{
+        if (arena == NULL)
+                return;
+
+        if (arena->chunk != NULL)
+                SEXP_arena_chunk_decref (arena->chunk);
+
+        free (arena);
+}
+
+SEXP_arena_t *SEXP_arena_bind (SEXP_arena_t *arena)
+{
+        SEXP_arena_t *prev;
+
+        (void)pthread_once (&__arena_once, SEXP_arena_key_init);
+
+        prev = pthread_getspecific (__arena_key);
+        (void)pthread_setspecific (__arena_key, arena);
+
+        return (prev);
+}
+
+void *SEXP_arena_alloc (size_t size)
+{
+        SEXP_arena_t *arena;
+        struct SEXP_arena_chunk *chunk;
+        void *ptr;
+
+        (void)pthread_once (&__arena_once, SEXP_arena_key_init);
+
+        arena = pthread_getspecific (__arena_key);
+
+        if (arena == NULL)
+                return (NULL);
+
+        size = SEXP_ARENA_ALIGN(size);
+
+        if (size > SEXP_ARENA_MAX_ALLOC)
+                return (NULL);
+
+        chunk = arena->chunk;
+
+        if (chunk == NULL || chunk->used + size > SEXP_ARENA_CHUNK_SIZE) {
+                struct SEXP_arena_chunk *next;
+
+                next = oscap_aligned_malloc (SEXP_ARENA_CHUNK_SIZE, SEXP_ARENA_CHUNK_SIZE);
+
+                if (next == NULL)
+                        return (NULL);
+
+                next->live = 1;
+                next->used = SEXP_ARENA_ALIGN(sizeof (struct SEXP_arena_chunk));
+                SEXP_atomic_inc_u32 (&__arena_chunks);
+
+                /*
+                 * The full chunk is freed when the
+                 * last allocation from it is freed.
+                 */
+                if (chunk != NULL)
+                        SEXP_arena_chunk_decref (chunk);
+
+                arena->chunk = chunk = next;
+        }
+
+        ptr = (uint8_t *)chunk + chunk->used;
+        chunk->used += size;
+        SEXP_atomic_inc_u32 (&chunk->live);
+
+        return (ptr);
+}
+
+void SEXP_arena_dealloc (void *ptr)
+{
+        SEXP_arena_chunk_decref ((struct SEXP_arena_chunk *)((uintptr_t)ptr & SEXP_ARENA_CHUNK_MASK));
+}
+
+size_t SEXP_arena_chunk_count (void)
+{
+        return (__arena_chunks);
+}
@@ -61,6 +61,17 @@ bool SEXP_atomic_cas_u32 (volatile uint32_t *ptr, uint32_t old, uint32_t new)
         return ((bool) __sync_bool_compare_and_swap (ptr, old, new));
 }
 
+void *SEXP_atomic_load_ptr (void * volatile *ptr)
+{
+        return (__sync_val_compare_and_swap (ptr, NULL, NULL));
+}
+
+void SEXP_atomic_store_ptr (void * volatile *ptr, void *val)
+{
+        (void)__sync_lock_test_and_set (ptr, val);
+        __sync_synchronize ();
+}
+
 #ifdef SEXP_ATOMIC_64BITS
 uint64_t SEXP_atomic_dec_u64 (volatile uint64_t *ptr)
 {
@@ -210,6 +221,26 @@ bool SEXP_atomic_cas_u32 (volatile uint32_t *ptr, uint32_t old, uint32_t new)
         return (r);
 }
 
+void *SEXP_atomic_load_ptr (void * volatile *ptr)
+{
+        void *r;
+
+        SEXP_atomic_once();
+        SEXP_atomic_lock((uintptr_t)ptr);
+        r = *ptr;
+        SEXP_atomic_unlock((uintptr_t)ptr);
+
+        return (r);
+}
+
+void SEXP_atomic_store_ptr (void * volatile *ptr, void *val)
+{
+        SEXP_atomic_once();
+        SEXP_atomic_lock((uintptr_t)ptr);
+        *ptr = val;
+        SEXP_atomic_unlock((uintptr_t)ptr);
+}
+
 #ifdef SEXP_ATOMIC_64BITS
 uint64_t SEXP_atomic_dec_u64 (volatile uint64_t *ptr)
 {
@@ -43,6 +43,7 @@
 #include "_sexp-types.h"
 #include "_sexp-value.h"
 #include "_sexp-rawptr.h"
+#include "_sexp-atomic.h"
 #include "public/sexp-manip.h"
 #include "public/sexp-manip_r.h"
 #include "debug_priv.h"
@@ -1054,6 +1055,7 @@ SEXP_t *SEXP_list_last (const SEXP_t *list)
 {
         SEXP_val_t v_dsc;
         struct SEXP_val_lblk *l_blk;
+        void *l_addr;
 
         if (list == NULL) {
                 errno = EFAULT;
@@ -1069,7 +1071,12 @@ SEXP_t *SEXP_list_last (const SEXP_t *list)
                 return (NULL);
         }
 
-        l_blk = SEXP_VALP_LBLK(SEXP_rawval_lblk_last ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr));
+        l_addr = SEXP_atomic_load_ptr (&SEXP_LCASTP(v_dsc.mem)->l_addr);
+
+        if (l_addr != NULL)
+                l_blk = SEXP_VALP_LBLK(l_addr);
+        else
+                l_blk = SEXP_VALP_LBLK(SEXP_rawval_lblk_last ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr));
 
         if (l_blk == NULL)
                 return (NULL);
@@ -1217,20 +1224,17 @@ SEXP_t *SEXP_list_add (SEXP_t *list, const SEXP_t *s_exp)
 
                 list->s_valp = uptr;
                 SEXP_val_dsc (&v_dsc, list->s_valp);
-
-                uptr = SEXP_rawval_lblk_last ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr);
-                SEXP_rawval_lblk_add1 (uptr, s_exp);
-        } else {
-                /*
-                 * Only one reference exists to the value.
-                 * However, list blocks have their own
-                 * reference counter and some blocks can
-                 * be shared. This case is handled by the
-                 * function SEXP_rawval_list_add.
-                 */
-                SEXP_LCASTP(v_dsc.mem)->b_addr = (void *)SEXP_rawval_lblk_add ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, s_exp);
         }
 
+        /*
+         * Only one reference exists to the value.
+         * However, list blocks have their own
+         * reference counter and some blocks can
+         * be shared. This case is handled by the
+         * function SEXP_rawval_list_add.
+         */
+        SEXP_rawval_list_add (SEXP_LCASTP(v_dsc.mem), s_exp);
+
         return (list);
 }
 
@@ -1302,6 +1306,11 @@ SEXP_t *SEXP_list_pop (SEXP_t *list)
                         SEXP_LCASTP(v_dsc.mem)->b_addr = SEXP_VALP_LBLK(lblk->nxsz);
                 }
 
+                if (SEXP_LCASTP(v_dsc.mem)->length > 0)
+                        --SEXP_LCASTP(v_dsc.mem)->length;
+
+                SEXP_LCASTP(v_dsc.mem)->l_addr = NULL;
+
                 SEXP_rawval_lblk_free1 ((uintptr_t)lblk, SEXP_free_lmemb);
         }
 
@@ -1552,16 +1561,16 @@ SEXP_t *SEXP_unref (SEXP_t *s_exp_o)
 
                         switch (v_dsc.type) {
                         case SEXP_VALTYPE_STRING:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_NUMBER:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_LIST:
                                 if (SEXP_LCASTP(v_dsc.mem)->b_addr != NULL)
                                         SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, SEXP_free_lmemb);
 
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         default:
                                 abort ();
@@ -1747,16 +1756,16 @@ static void SEXP_free_lmemb (SEXP_t *s_exp)
                 if (SEXP_rawval_decref (s_exp->s_valp)) {
                         switch (v_dsc.type) {
                         case SEXP_VALTYPE_STRING:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_NUMBER:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_LIST:
                                 if (SEXP_LCASTP(v_dsc.mem)->b_addr != NULL)
                                         SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, SEXP_free_lmemb);
 
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         default:
                                 abort ();
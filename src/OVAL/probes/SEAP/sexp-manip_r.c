@@ -27,6 +27,7 @@
 #include "_sexp-types.h"
 #include "_sexp-value.h"
 #include "_sexp-rawptr.h"
+#include "_sexp-atomic.h"
 #include "public/sexp-manip_r.h"
 #include "debug_priv.h"
 
@@ -300,7 +301,7 @@ SEXP_t *SEXP_list_new_rv (SEXP_t *sexp_mem, SEXP_t *memb, va_list alist)
                 s_ptr[++s_cur] = va_arg (alist, SEXP_t *);
         }
 
-        if (SEXP_val_new (&v_dsc, sizeof (void *) + sizeof (uint16_t),
+        if (SEXP_val_new (&v_dsc, sizeof (struct SEXP_val_list),
                           SEXP_VALTYPE_LIST) != 0)
         {
                 /* TODO: handle this */
@@ -312,6 +313,8 @@ SEXP_t *SEXP_list_new_rv (SEXP_t *sexp_mem, SEXP_t *memb, va_list alist)
 
                 SEXP_LCASTP(v_dsc.mem)->offset = 0;
                 SEXP_LCASTP(v_dsc.mem)->b_addr = (void *)SEXP_rawval_lblk_new (b_exp);
+                SEXP_LCASTP(v_dsc.mem)->l_addr = SEXP_LCASTP(v_dsc.mem)->b_addr;
+                SEXP_LCASTP(v_dsc.mem)->length = s_cur;
 
                 if (SEXP_rawval_lblk_fill ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr,
                                            s_ptr, s_cur) != ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr))
@@ -322,6 +325,8 @@ SEXP_t *SEXP_list_new_rv (SEXP_t *sexp_mem, SEXP_t *memb, va_list alist)
         } else {
                 SEXP_LCASTP(v_dsc.mem)->offset = 0;
                 SEXP_LCASTP(v_dsc.mem)->b_addr = NULL;
+                SEXP_LCASTP(v_dsc.mem)->l_addr = NULL;
+                SEXP_LCASTP(v_dsc.mem)->length = 0;
         }
 
         SEXP_init(sexp_mem);
@@ -369,7 +374,7 @@ SEXP_t *SEXP_list_rest_r (SEXP_t *rest, const SEXP_t *list)
                 return (NULL);
         }
 
-        if (SEXP_val_new (&v_dsc_r, sizeof (void *) + sizeof (uint16_t),
+        if (SEXP_val_new (&v_dsc_r, sizeof (struct SEXP_val_list),
                           SEXP_VALTYPE_LIST) != 0)
         {
                 /* TODO: handle this */
@@ -378,6 +383,9 @@ SEXP_t *SEXP_list_rest_r (SEXP_t *rest, const SEXP_t *list)
 
         SEXP_LCASTP(v_dsc_r.mem)->offset = SEXP_LCASTP(v_dsc_o.mem)->offset + 1;
         SEXP_LCASTP(v_dsc_r.mem)->b_addr = SEXP_LCASTP(v_dsc_o.mem)->b_addr;
+        SEXP_LCASTP(v_dsc_r.mem)->l_addr = NULL;
+        SEXP_LCASTP(v_dsc_r.mem)->length = SEXP_LCASTP(v_dsc_o.mem)->length > 0 ?
+                SEXP_LCASTP(v_dsc_o.mem)->length - 1 : 0;
 
         lblk = SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc_r.mem)->b_addr);
 
@@ -387,8 +395,16 @@ SEXP_t *SEXP_list_rest_r (SEXP_t *rest, const SEXP_t *list)
                         SEXP_LCASTP(v_dsc_r.mem)->b_addr = SEXP_VALP_LBLK(lblk->nxsz);
                 }
 
-                if (SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc_r.mem)->b_addr) != NULL)
+                if (SEXP_VALP_LBLK(SEXP_LCASTP(v_dsc_r.mem)->b_addr) != NULL) {
                         SEXP_LCASTP(v_dsc_r.mem)->b_addr = (void *)SEXP_rawval_lblk_incref ((uintptr_t) SEXP_LCASTP(v_dsc_r.mem)->b_addr);
+                        /*
+                         * The blocks are shared with the rest now,
+                         * the original list can't append in place.
+                         * The value of the list may be read by other
+                         * threads, hence the atomic store.
+                         */
+                        SEXP_atomic_store_ptr (&SEXP_LCASTP(v_dsc_o.mem)->l_addr, NULL);
+                }
         }
 
         SEXP_init(rest);
@@ -430,16 +446,16 @@ void __SEXP_free_r (SEXP_t *s_exp, const char *file, uint32_t line, const char *
                 if (SEXP_rawval_decref (s_exp->s_valp)) {
                         switch (v_dsc.type) {
                         case SEXP_VALTYPE_STRING:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_NUMBER:
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         case SEXP_VALTYPE_LIST:
                                 if (SEXP_LCASTP(v_dsc.mem)->b_addr != NULL)
                                         SEXP_rawval_lblk_free ((uintptr_t)SEXP_LCASTP(v_dsc.mem)->b_addr, SEXP_free_r);
 
-				oscap_aligned_free(v_dsc.hdr);
+				SEXP_val_free(&v_dsc);
                                 break;
                         default:
                                 abort ();
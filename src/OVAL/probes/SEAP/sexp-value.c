@@ -28,16 +28,24 @@
 #include <string.h>
 
 #include "_sexp-atomic.h"
+#include "_sexp-arena.h"
 #include "_sexp-value.h"
 #include "debug_priv.h"
 
 int SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_type_t type)
 {
-	void *s_val = oscap_aligned_malloc(sizeof(SEXP_valhdr_t) + vmemsize, SEXP_VALP_ALIGN);
+	bool  arena = true;
+	void *s_val = SEXP_arena_alloc(sizeof(SEXP_valhdr_t) + vmemsize);
+
+	if (s_val == NULL) {
+		s_val = oscap_aligned_malloc(sizeof(SEXP_valhdr_t) + vmemsize, SEXP_VALP_ALIGN);
+		arena = false;
+	}
 
         SEXP_val_dsc (dst, (uintptr_t) s_val);
 
         dst->hdr->refs = 1;
+        dst->hdr->arena = arena;
         dst->hdr->size = vmemsize;
         dst->type      = type;
         dst->ptr       = SEXP_val_ptr (dst);
@@ -48,6 +56,14 @@ int SEXP_val_new (SEXP_val_t *dst, size_t vmemsize, SEXP_type_t type)
         return (0);
 }
 
+void SEXP_val_free (SEXP_val_t *dsc)
+{
+	if (dsc->hdr->arena)
+		SEXP_arena_dealloc(dsc->hdr);
+	else
+		oscap_aligned_free(dsc->hdr);
+}
+
 void SEXP_val_dsc (SEXP_val_t *dst, uintptr_t ptr)
 {
         dst->ptr  = ptr;
@@ -88,26 +104,51 @@ SEXP_numtype_t SEXP_rawval_number_type (SEXP_val_t *dsc)
 
 size_t SEXP_rawval_list_length (struct SEXP_val_list *list)
 {
-        size_t length;
-        register struct SEXP_val_lblk *lblk;
-
-        length = 0;
-        lblk   = SEXP_VALP_LBLK(list->b_addr);
+        return (list->length);
+}
 
-        while (lblk != NULL) {
-                length += lblk->real;
-                lblk    = SEXP_VALP_LBLK(lblk->nxsz);
+void SEXP_rawval_list_add (struct SEXP_val_list *list, const SEXP_t *s_exp)
+{
+        /*
+         * The caller holds the only reference to the list value,
+         * no other thread can clear l_addr in SEXP_list_rest.
+         */
+        if (list->l_addr != NULL) {
+                /*
+                 * None of the blocks is shared, append to the
+                 * last block in place.
+                 */
+                (void)SEXP_rawval_lblk_add1 ((uintptr_t)list->l_addr, s_exp);
+        } else {
+                /*
+                 * Some blocks may be shared with other lists,
+                 * SEXP_rawval_lblk_add copies them. The list
+                 * doesn't share any block afterwards.
+                 */
+                list->b_addr = (void *)SEXP_rawval_lblk_add ((uintptr_t)list->b_addr, s_exp);
+                list->l_addr = list->b_addr;
         }
 
-        return (length - list->offset);
+        /* add1 may have appended a new block */
+        list->l_addr = (void *)SEXP_rawval_lblk_last ((uintptr_t)list->l_addr);
+        ++list->length;
 }
 
 uintptr_t SEXP_rawval_lblk_new (uint8_t sz)
 {
         _A(sz < 16);
 
-	struct SEXP_val_lblk *lblk = malloc(sizeof(struct SEXP_val_lblk));
-	lblk->memb = malloc(sizeof(SEXP_t) * (1 << sz));
+	size_t size = sizeof(struct SEXP_val_lblk) + sizeof(SEXP_t) * (1 << sz);
+	struct SEXP_val_lblk *lblk = SEXP_arena_alloc(size);
+
+	if (lblk != NULL) {
+		lblk->arena = true;
+	} else {
+		lblk = malloc(size);
+		lblk->arena = false;
+	}
+
+	lblk->memb = (SEXP_t *)(lblk + 1);
 
         lblk->nxsz = ((uintptr_t)(NULL) & SEXP_LBLKP_MASK) | ((uintptr_t)sz & SEXP_LBLKS_MASK);
         lblk->refs = 1;
@@ -142,6 +183,14 @@ uintptr_t SEXP_rawval_lblk_incref (uintptr_t lblkp)
         return (lblkp);
 }
 
+static void SEXP_rawval_lblk_dealloc (struct SEXP_val_lblk *lblk)
+{
+	if (lblk->arena)
+		SEXP_arena_dealloc(lblk);
+	else
+		free(lblk);
+}
+
 int SEXP_rawval_lblk_decref (uintptr_t lblkp)
 {
         return (SEXP_atomic_dec_u16 (&SEXP_VALP_LBLK(lblkp)->refs) == 0);
@@ -197,7 +246,7 @@ uintptr_t SEXP_rawval_lblk_add (uintptr_t lblkp, const SEXP_t *s_exp)
                                  * than one list so we have to create a copy of the
                                  * rest of the list.
                                  */
-                                lb_ptr = SEXP_rawval_lblk_copy (lblkp, 0);
+                                lb_ptr = SEXP_rawval_lblk_copy ((uintptr_t)lblk, 0);
 
                                 if (lb_prev == 0)
                                         lb_head = lb_ptr;
@@ -210,7 +259,7 @@ uintptr_t SEXP_rawval_lblk_add (uintptr_t lblkp, const SEXP_t *s_exp)
                                 if (lb_prev != 0)
                                         SEXP_VALP_LBLK(lb_prev)->nxsz = (lb_ptr & SEXP_LBLKP_MASK) | (SEXP_VALP_LBLK(lb_prev)->nxsz & SEXP_LBLKS_MASK);
 
-                                SEXP_rawval_lblk_decref (lblkp);
+                                SEXP_rawval_lblk_decref ((uintptr_t)lblk);
 
                                 /*
                                  * Get the last block without checking refs
@@ -250,7 +299,7 @@ uintptr_t SEXP_rawval_lblk_add1 (uintptr_t lblkp, const SEXP_t *s_exp)
                 uintptr_t new_lb;
 
 		new_sz = lblk->nxsz & SEXP_LBLKS_MASK;
-		new_sz = new_sz == 15 ? 6 : new_sz + 1;
+		new_sz = SEXP_LBLK_NEXT_SZ(new_sz);
 
                 new_lb     = SEXP_rawval_lblk_new (new_sz);
                 lblk->nxsz = (new_lb & SEXP_LBLKP_MASK) | (lblk->nxsz & SEXP_LBLKS_MASK);
@@ -424,7 +473,7 @@ uintptr_t SEXP_rawval_list_copy (uintptr_t s_valp)
 {
         SEXP_val_t v_dsc_o, v_dsc_c;
 
-        if (SEXP_val_new (&v_dsc_c, sizeof (void *) + sizeof (uint16_t),
+        if (SEXP_val_new (&v_dsc_c, sizeof (struct SEXP_val_list),
                           SEXP_VALTYPE_LIST) != 0)
         {
                 /* TODO: handle this */
@@ -436,6 +485,12 @@ uintptr_t SEXP_rawval_list_copy (uintptr_t s_valp)
         SEXP_LCASTP(v_dsc_c.mem)->b_addr = (void *) SEXP_rawval_lblk_copy ((uintptr_t)SEXP_LCASTP(v_dsc_o.mem)->b_addr,
                                                                            (uintptr_t)SEXP_LCASTP(v_dsc_o.mem)->offset);
         SEXP_LCASTP(v_dsc_c.mem)->offset = 0;
+        SEXP_LCASTP(v_dsc_c.mem)->length = SEXP_LCASTP(v_dsc_o.mem)->length;
+
+        if (SEXP_LCASTP(v_dsc_c.mem)->b_addr != NULL)
+                SEXP_LCASTP(v_dsc_c.mem)->l_addr = (void *) SEXP_rawval_lblk_last ((uintptr_t)SEXP_LCASTP(v_dsc_c.mem)->b_addr);
+        else
+                SEXP_LCASTP(v_dsc_c.mem)->l_addr = NULL;
 
         return (SEXP_val_ptr (&v_dsc_c));
 }
@@ -478,7 +533,8 @@ uintptr_t SEXP_rawval_lblk_copy (uintptr_t lblkp, uint16_t n_skip)
                  * allocate new block
                  */
                 if (lb_new->real >= (1 << (cur_sz))) {
-                        lb_next = SEXP_rawval_lblk_new (++cur_sz);
+                        cur_sz  = SEXP_LBLK_NEXT_SZ(cur_sz);
+                        lb_next = SEXP_rawval_lblk_new (cur_sz);
                         lb_new->nxsz = (lb_next & SEXP_LBLKP_MASK) | (lb_new->nxsz & SEXP_LBLKS_MASK);
                         lb_new  = SEXP_VALP_LBLK(lb_next);
                         off_n   = 0;
@@ -517,8 +573,7 @@ void SEXP_rawval_lblk_free (uintptr_t lblkp, void (*func) (SEXP_t *))
                         func (lblk->memb + lblk->real);
                 }
 
-		free(lblk->memb);
-		free(lblk);
+		SEXP_rawval_lblk_dealloc(lblk);
 
                 if (next != NULL)
                         SEXP_rawval_lblk_free ((uintptr_t)next, func);
@@ -539,8 +594,7 @@ void SEXP_rawval_lblk_free1 (uintptr_t lblkp, void (*func) (SEXP_t *))
                         func (lblk->memb + lblk->real);
                 }
 
-		free(lblk->memb);
-		free(lblk);
+		SEXP_rawval_lblk_dealloc(lblk);
         }
 
         return;
@@ -24,12 +24,15 @@
 #define CRAPI_H
 
 #define CRAPI_IO_BUFSZ 4096
+/* read buffer of the multi-digest pass, allocated on the heap */
+#define CRAPI_MDIGEST_BUFSZ (256 * 1024)
 
 #ifndef _FILE_OFFSET_BITS
 # define _FILE_OFFSET_BITS 32
 #endif
 
 #include "digest.h"
+#include "digest_cache.h"
 
 int crapi_init (void *unused);
 
@@ -31,6 +31,7 @@
 #include <errno.h>
 #include <stdlib.h>
 #include <sys/types.h>
+#include <fcntl.h>
 
 #include "crapi.h"
 #include "digest.h"
@@ -50,138 +51,112 @@ int crapi_digest_fd (int fd, crapi_alg_t alg, void *dst, size_t *size)
 		return -1;
 	}
 
+	if (crapi_mdigest_fd_a (fd, 1, &alg, &dst, &size) != 0)
+		return -1;
+
+	/* unlike crapi_mdigest_fd(), a digest which can't be computed is an error here */
+	return (*size == 0 ? -1 : 0);
+}
+
+static int crapi_digest_ctbl_set (struct digest_ctbl_t *ctbl, crapi_alg_t alg)
+{
         switch (alg) {
 #ifdef OPENSCAP_ENABLE_MD5
         case CRAPI_DIGEST_MD5:
-                return crapi_md5_fd (fd, dst, size);
+                ctbl->init   = &crapi_md5_init;
+                ctbl->update = &crapi_md5_update;
+                ctbl->fini   = &crapi_md5_fini;
+                ctbl->free   = &crapi_md5_free;
+                return (0);
 #endif
 #ifdef OPENSCAP_ENABLE_SHA1
         case CRAPI_DIGEST_SHA1:
-                return crapi_sha1_fd (fd, dst, size);
+                ctbl->init   = &crapi_sha1_init;
+                ctbl->update = &crapi_sha1_update;
+                ctbl->fini   = &crapi_sha1_fini;
+                ctbl->free   = &crapi_sha1_free;
+                return (0);
 #endif
         case CRAPI_DIGEST_SHA224:
-                return crapi_sha224_fd (fd, dst, size);
+                ctbl->init   = &crapi_sha224_init;
+                ctbl->update = &crapi_sha224_update;
+                ctbl->fini   = &crapi_sha224_fini;
+                ctbl->free   = &crapi_sha224_free;
+                return (0);
         case CRAPI_DIGEST_SHA256:
-                return crapi_sha256_fd (fd, dst, size);
+                ctbl->init   = &crapi_sha256_init;
+                ctbl->update = &crapi_sha256_update;
+                ctbl->fini   = &crapi_sha256_fini;
+                ctbl->free   = &crapi_sha256_free;
+                return (0);
         case CRAPI_DIGEST_SHA384:
-                return crapi_sha384_fd (fd, dst, size);
+                ctbl->init   = &crapi_sha384_init;
+                ctbl->update = &crapi_sha384_update;
+                ctbl->fini   = &crapi_sha384_fini;
+                ctbl->free   = &crapi_sha384_free;
+                return (0);
         case CRAPI_DIGEST_SHA512:
-                return crapi_sha512_fd (fd, dst, size);
+                ctbl->init   = &crapi_sha512_init;
+                ctbl->update = &crapi_sha512_update;
+                ctbl->fini   = &crapi_sha512_fini;
+                ctbl->free   = &crapi_sha512_free;
+                return (0);
         case CRAPI_DIGEST_RMD160:
-                return crapi_rmd160_fd (fd, dst, size);
+                ctbl->init   = &crapi_rmd160_init;
+                ctbl->update = &crapi_rmd160_update;
+                ctbl->fini   = &crapi_rmd160_fini;
+                ctbl->free   = &crapi_rmd160_free;
+                return (0);
         }
 
         errno = EINVAL;
         return (-1);
 }
 
-int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t *size, ...*/)
+int crapi_mdigest_fd_a (int fd, int num, const crapi_alg_t alg[], void *dst[], size_t *size[])
 {
         register int i;
-        va_list ap;
-        struct digest_ctbl_t *ctbl = malloc(num * sizeof(struct digest_ctbl_t));
-
-        crapi_alg_t alg;
-        void       *dst;
-        size_t     *size;
-
-        uint8_t fd_buf[CRAPI_IO_BUFSZ];
+        struct digest_ctbl_t *ctbl;
+        uint8_t *fd_buf;
         ssize_t ret;
 
 	if (num <= 0 || fd <= 0) {
 		errno = EINVAL;
-		free(ctbl);
 		return -1;
 	}
-        for (i = 0; i < num; ++i)
-                ctbl[i].ctx = NULL;
 
-        va_start (ap, num);
+        ctbl   = calloc(num, sizeof(struct digest_ctbl_t));
+        fd_buf = malloc(CRAPI_MDIGEST_BUFSZ);
 
-        for (i = 0; i < num; ++i) {
-                alg  = va_arg (ap, crapi_alg_t);
-                dst  = va_arg (ap, void *);
-                size = va_arg (ap, size_t *);
+        if (ctbl == NULL || fd_buf == NULL) {
+                free(ctbl);
+                free(fd_buf);
+                errno = ENOMEM;
+                return -1;
+        }
 
-                switch (alg) {
-#ifdef OPENSCAP_ENABLE_MD5
-                case CRAPI_DIGEST_MD5:
-                        ctbl[i].init   = &crapi_md5_init;
-                        ctbl[i].update = &crapi_md5_update;
-                        ctbl[i].fini   = &crapi_md5_fini;
-                        ctbl[i].free   = &crapi_md5_free;
-                        break;
-#endif
-#ifdef OPENSCAP_ENABLE_SHA1
-                case CRAPI_DIGEST_SHA1:
-                        ctbl[i].init   = &crapi_sha1_init;
-                        ctbl[i].update = &crapi_sha1_update;
-                        ctbl[i].fini   = &crapi_sha1_fini;
-                        ctbl[i].free   = &crapi_sha1_free;
-                        break;
-#endif
-                case CRAPI_DIGEST_SHA224:
-                        ctbl[i].init   = &crapi_sha224_init;
-                        ctbl[i].update = &crapi_sha224_update;
-                        ctbl[i].fini   = &crapi_sha224_fini;
-                        ctbl[i].free   = &crapi_sha224_free;
-                        break;
-                case CRAPI_DIGEST_SHA256:
-                        ctbl[i].init   = &crapi_sha256_init;
-                        ctbl[i].update = &crapi_sha256_update;
-                        ctbl[i].fini   = &crapi_sha256_fini;
-                        ctbl[i].free   = &crapi_sha256_free;
-                        break;
-                case CRAPI_DIGEST_SHA384:
-                        ctbl[i].init   = &crapi_sha384_init;
-                        ctbl[i].update = &crapi_sha384_update;
-                        ctbl[i].fini   = &crapi_sha384_fini;
-                        ctbl[i].free   = &crapi_sha384_free;
-                        break;
-                case CRAPI_DIGEST_SHA512:
-                        ctbl[i].init   = &crapi_sha512_init;
-                        ctbl[i].update = &crapi_sha512_update;
-                        ctbl[i].fini   = &crapi_sha512_fini;
-                        ctbl[i].free   = &crapi_sha512_free;
-                        break;
-                case CRAPI_DIGEST_RMD160:
-                        ctbl[i].init   = &crapi_rmd160_init;
-                        ctbl[i].update = &crapi_rmd160_update;
-                        ctbl[i].fini   = &crapi_rmd160_fini;
-                        ctbl[i].free   = &crapi_rmd160_free;
-                        break;
-                default:
-                        va_end (ap);
+        for (i = 0; i < num; ++i) {
+                if (crapi_digest_ctbl_set (&ctbl[i], alg[i]) != 0)
                         goto fail;
-                }
-
-                if ((ctbl[i].ctx = ctbl[i].init (dst, size)) == NULL)
-			*size = 0;
+                if ((ctbl[i].ctx = ctbl[i].init (dst[i], size[i])) == NULL)
+			*size[i] = 0;
         }
 
-        va_end (ap);
+#if defined(POSIX_FADV_SEQUENTIAL)
+        /* the file is read once from the start to the end, let the kernel read ahead */
+        (void) posix_fadvise (fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
 
-        while ((ret = read (fd, fd_buf, sizeof fd_buf)) == sizeof fd_buf) {
-                for (i = 0; i < num; ++i) {
-			if (ctbl[i].ctx == NULL)
-				continue;
-                        if (ctbl[i].update (ctbl[i].ctx, fd_buf, sizeof fd_buf) != 0) {
-                                goto fail;
-                        }
+        /* all the digests are computed in a single pass over the file */
+        for (;;) {
+                ret = read (fd, fd_buf, CRAPI_MDIGEST_BUFSZ);
+                if (ret == 0)
+                        break;
+                if (ret < 0) {
+                        if (errno == EINTR)
+                                continue;
+                        goto fail;
                 }
-        }
-
-        switch (ret) {
-        case 0:
-                break;
-        case -1:
-                goto fail;
-        default:
-		if (ret <= 0) {
-			free(ctbl);
-			return -1;
-		}
-
                 for (i = 0; i < num; ++i) {
 			if (ctbl[i].ctx == NULL)
 				continue;
@@ -196,6 +171,7 @@ int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t
 			continue;
                 ctbl[i].fini (ctbl[i].ctx);
 	}
+        free(fd_buf);
         free(ctbl);
         return (0);
 fail:
@@ -203,6 +179,43 @@ fail:
                 if (ctbl[i].ctx != NULL)
                         ctbl[i].free (ctbl[i].ctx);
 
+        free(fd_buf);
         free(ctbl);
         return (-1);
 }
+
+int crapi_mdigest_fd (int fd, int num, ... /* crapi_alg_t alg, void *dst, size_t *size, ...*/)
+{
+        register int i;
+        va_list ap;
+        crapi_alg_t *alg;
+        void       **dst;
+        size_t     **size;
+        int ret;
+
+	if (num <= 0 || fd <= 0) {
+		errno = EINVAL;
+		return -1;
+	}
+
+        alg  = malloc(num * sizeof(crapi_alg_t));
+        dst  = malloc(num * sizeof(void *));
+        size = malloc(num * sizeof(size_t *));
+
+        va_start (ap, num);
+
+        for (i = 0; i < num; ++i) {
+                alg[i]  = va_arg (ap, crapi_alg_t);
+                dst[i]  = va_arg (ap, void *);
+                size[i] = va_arg (ap, size_t *);
+        }
+
+        va_end (ap);
+
+        ret = crapi_mdigest_fd_a (fd, num, alg, dst, size);
+
+        free(alg);
+        free(dst);
+        free(size);
+        return (ret);
+}
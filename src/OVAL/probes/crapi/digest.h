@@ -57,4 +57,10 @@ struct digest_ctbl_t {
 
 int crapi_mdigest_fd (int fd, int num, ... /*crapi_alg_t alg, void *dst, size_t *size, ...*/);
 
+/*
+ * Same as crapi_mdigest_fd(), the algorithms, destination buffers and their
+ * sizes are passed in arrays of num elements. The file is read only once.
+ */
+int crapi_mdigest_fd_a (int fd, int num, const crapi_alg_t alg[], void *dst[], size_t *size[]);
+
 #endif /* CRAPI_DIGEST_H */
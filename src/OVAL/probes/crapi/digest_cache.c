@@ -0,0 +1,374 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "debug_priv.h"
+#include "crapi.h"
+#include "digest.h"
+#include "digest_cache.h"
+
+#ifndef O_NOFOLLOW
+#define O_NOFOLLOW 0
+#endif
+
+#if defined(__APPLE__)
+# define ST_MTIME_NSEC(st) ((st)->st_mtimespec.tv_nsec)
+# define ST_CTIME_NSEC(st) ((st)->st_ctimespec.tv_nsec)
+#else
+# define ST_MTIME_NSEC(st) ((st)->st_mtim.tv_nsec)
+# define ST_CTIME_NSEC(st) ((st)->st_ctim.tv_nsec)
+#endif
+
+#define DIGEST_CACHE_MAGIC "oscap-digest-cache 1"
+#define DIGEST_CACHE_MAX_ALGS 8
+#define DIGEST_CACHE_MAX_DIGEST 64
+#define DIGEST_CACHE_ENTRY_MAX 2048
+/*
+ * Files modified less than this many seconds before they were hashed are not
+ * cached. A later change within the same timestamp granularity would leave
+ * the key unchanged.
+ */
+#define DIGEST_CACHE_SETTLE_SEC 2
+
+struct digest_cache_key {
+	uint64_t dev;
+	uint64_t ino;
+	uint64_t size;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+	int64_t ctime_sec;
+	int64_t ctime_nsec;
+};
+
+struct digest_cache_entry {
+	struct digest_cache_key key;
+	int count;
+	crapi_alg_t alg[DIGEST_CACHE_MAX_ALGS];
+	size_t len[DIGEST_CACHE_MAX_ALGS];
+	uint8_t digest[DIGEST_CACHE_MAX_ALGS][DIGEST_CACHE_MAX_DIGEST];
+};
+
+static void digest_cache_key_init(struct digest_cache_key *key, const struct stat *st)
+{
+	key->dev = (uint64_t)st->st_dev;
+	key->ino = (uint64_t)st->st_ino;
+	key->size = (uint64_t)st->st_size;
+	key->mtime_sec = (int64_t)st->st_mtime;
+	key->mtime_nsec = (int64_t)ST_MTIME_NSEC(st);
+	key->ctime_sec = (int64_t)st->st_ctime;
+	key->ctime_nsec = (int64_t)ST_CTIME_NSEC(st);
+}
+
+static bool digest_cache_key_eq(const struct digest_cache_key *a, const struct digest_cache_key *b)
+{
+	return a->dev == b->dev && a->ino == b->ino && a->size == b->size &&
+		a->mtime_sec == b->mtime_sec && a->mtime_nsec == b->mtime_nsec &&
+		a->ctime_sec == b->ctime_sec && a->ctime_nsec == b->ctime_nsec;
+}
+
+/*
+ * Anyone who can write to the directory can forge digests, so it has to be
+ * owned by us and mustn't be writable by others.
+ */
+char *crapi_digest_cache_dir(void)
+{
+	const char *dir = getenv(CRAPI_DIGEST_CACHE_ENV);
+	if (dir == NULL || *dir == '\0')
+		return NULL;
+
+	const char *root = getenv("OSCAP_PROBE_ROOT");
+	if (root != NULL && *root != '\0') {
+		const char *offline = getenv(CRAPI_DIGEST_CACHE_OFFLINE_ENV);
+		if (offline == NULL || strcmp(offline, "1") != 0)
+			return NULL;
+	}
+
+	struct stat st;
+	if (lstat(dir, &st) != 0) {
+		if (errno != ENOENT || mkdir(dir, 0700) != 0 || lstat(dir, &st) != 0) {
+			dW("Can't use the digest cache directory '%s': %s", dir, strerror(errno));
+			return NULL;
+		}
+	}
+	if (!S_ISDIR(st.st_mode) || st.st_uid != geteuid() || (st.st_mode & (S_IWGRP | S_IWOTH)) != 0) {
+		dW("Not using the digest cache directory '%s', it has to be a directory "
+		   "owned by the current user and not writable by others.", dir);
+		return NULL;
+	}
+	return strdup(dir);
+}
+
+static int digest_cache_path(char *buf, size_t buflen, const char *dir, const struct digest_cache_key *key, bool subdir)
+{
+	int ret;
+
+	if (subdir)
+		ret = snprintf(buf, buflen, "%s/%02x", dir, (unsigned int)(key->ino & 0xff));
+	else
+		ret = snprintf(buf, buflen, "%s/%02x/%" PRIx64 "-%" PRIx64, dir,
+			(unsigned int)(key->ino & 0xff), key->dev, key->ino);
+
+	return (ret < 0 || (size_t)ret >= buflen) ? -1 : 0;
+}
+
+static size_t digest_cache_alg_len(crapi_alg_t alg)
+{
+	switch (alg) {
+#ifdef OPENSCAP_ENABLE_MD5
+	case CRAPI_DIGEST_MD5:
+		return 16;
+#endif
+#ifdef OPENSCAP_ENABLE_SHA1
+	case CRAPI_DIGEST_SHA1:
+		return 20;
+#endif
+	case CRAPI_DIGEST_RMD160:
+		return 20;
+	case CRAPI_DIGEST_SHA224:
+		return 28;
+	case CRAPI_DIGEST_SHA256:
+		return 32;
+	case CRAPI_DIGEST_SHA384:
+		return 48;
+	case CRAPI_DIGEST_SHA512:
+		return 64;
+	}
+	return 0;
+}
+
+static int hex_value(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	return -1;
+}
+
+static int digest_cache_parse(char *data, struct digest_cache_entry *entry)
+{
+	char *save = NULL;
+	char *line = strtok_r(data, "\n", &save);
+
+	if (line == NULL || strcmp(line, DIGEST_CACHE_MAGIC) != 0)
+		return -1;
+
+	line = strtok_r(NULL, "\n", &save);
+	if (line == NULL || sscanf(line, "%" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNd64 " %" SCNd64 " %" SCNd64 " %" SCNd64,
+			&entry->key.dev, &entry->key.ino, &entry->key.size,
+			&entry->key.mtime_sec, &entry->key.mtime_nsec,
+			&entry->key.ctime_sec, &entry->key.ctime_nsec) != 7)
+		return -1;
+
+	entry->count = 0;
+	while ((line = strtok_r(NULL, "\n", &save)) != NULL) {
+		unsigned int alg;
+		char hex[DIGEST_CACHE_MAX_DIGEST * 2 + 2];
+		size_t hexlen, i;
+
+		if (entry->count == DIGEST_CACHE_MAX_ALGS)
+			return -1;
+		if (sscanf(line, "%u %129s", &alg, hex) != 2)
+			return -1;
+		hexlen = strlen(hex);
+		if (hexlen != digest_cache_alg_len((crapi_alg_t)alg) * 2 || hexlen == 0)
+			return -1;
+		for (i = 0; i < hexlen / 2; ++i) {
+			int hi = hex_value(hex[2 * i]);
+			int lo = hex_value(hex[2 * i + 1]);
+			if (hi < 0 || lo < 0)
+				return -1;
+			entry->digest[entry->count][i] = (uint8_t)(hi << 4 | lo);
+		}
+		entry->alg[entry->count] = (crapi_alg_t)alg;
+		entry->len[entry->count] = hexlen / 2;
+		++entry->count;
+	}
+	return 0;
+}
+
+static int digest_cache_load(const char *path, struct digest_cache_entry *entry)
+{
+	char data[DIGEST_CACHE_ENTRY_MAX + 1];
+	size_t datalen = 0;
+	struct stat st;
+	int fd, ret = -1;
+
+	fd = open(path, O_RDONLY | O_NOFOLLOW);
+	if (fd < 0)
+		return -1;
+
+	if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_uid != geteuid() ||
+	    st.st_size <= 0 || st.st_size > DIGEST_CACHE_ENTRY_MAX)
+		goto out;
+
+	while (datalen < (size_t)st.st_size) {
+		ssize_t r = read(fd, data + datalen, DIGEST_CACHE_ENTRY_MAX - datalen);
+		if (r < 0 && errno == EINTR)
+			continue;
+		if (r <= 0)
+			break;
+		datalen += (size_t)r;
+	}
+	data[datalen] = '\0';
+	ret = digest_cache_parse(data, entry);
+out:
+	close(fd);
+	return ret;
+}
+
+/* The entry is written to a temporary file first, readers never see a partial one. */
+static void digest_cache_store(const char *dir, const struct digest_cache_entry *entry)
+{
+	char path[PATH_MAX];
+	char tmp[PATH_MAX];
+	char data[DIGEST_CACHE_ENTRY_MAX];
+	int datalen, fd, i;
+	size_t j;
+
+	if (digest_cache_path(tmp, sizeof tmp, dir, &entry->key, true) != 0)
+		return;
+	if (mkdir(tmp, 0700) != 0 && errno != EEXIST)
+		return;
+	if (digest_cache_path(path, sizeof path, dir, &entry->key, false) != 0)
+		return;
+	if (strlen(tmp) + sizeof("/.tmp.XXXXXX") > sizeof tmp)
+		return;
+	strcat(tmp, "/.tmp.XXXXXX");
+
+	datalen = snprintf(data, sizeof data, DIGEST_CACHE_MAGIC "\n%" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRId64 " %" PRId64 " %" PRId64 " %" PRId64 "\n",
+		entry->key.dev, entry->key.ino, entry->key.size,
+		entry->key.mtime_sec, entry->key.mtime_nsec,
+		entry->key.ctime_sec, entry->key.ctime_nsec);
+	for (i = 0; i < entry->count; ++i) {
+		datalen += snprintf(data + datalen, sizeof data - datalen, "%u ", (unsigned int)entry->alg[i]);
+		for (j = 0; j < entry->len[i]; ++j)
+			datalen += snprintf(data + datalen, sizeof data - datalen, "%02x", entry->digest[i][j]);
+		datalen += snprintf(data + datalen, sizeof data - datalen, "\n");
+	}
+
+	fd = mkstemp(tmp);
+	if (fd < 0)
+		return;
+	if (write(fd, data, datalen) != datalen) {
+		close(fd);
+		unlink(tmp);
+		return;
+	}
+	if (close(fd) != 0 || rename(tmp, path) != 0)
+		unlink(tmp);
+}
+
+int crapi_mdigest_fd_cached (const char *dir, int fd, int num, const crapi_alg_t alg[], void *dst[], size_t *size[])
+{
+	char path[PATH_MAX];
+	struct stat st_before, st_after;
+	struct digest_cache_key key;
+	struct digest_cache_entry entry;
+	time_t started;
+	int i, j, found;
+
+	if (dir == NULL || num <= 0 || num > DIGEST_CACHE_MAX_ALGS)
+		return crapi_mdigest_fd_a(fd, num, alg, dst, size);
+
+	if (fstat(fd, &st_before) != 0 || !S_ISREG(st_before.st_mode))
+		return crapi_mdigest_fd_a(fd, num, alg, dst, size);
+
+	digest_cache_key_init(&key, &st_before);
+	if (digest_cache_path(path, sizeof path, dir, &key, false) != 0)
+		return crapi_mdigest_fd_a(fd, num, alg, dst, size);
+
+	/*
+	 * Lookup, all the requested digests have to be in the entry
+	 */
+	if (digest_cache_load(path, &entry) != 0 || !digest_cache_key_eq(&entry.key, &key))
+		entry.count = 0;
+
+	for (found = 0, i = 0; i < num; ++i) {
+		for (j = 0; j < entry.count; ++j) {
+			if (entry.alg[j] == alg[i] && entry.len[j] <= *size[i])
+				break;
+		}
+		if (j == entry.count)
+			break;
+		++found;
+	}
+
+	if (found == num) {
+		for (i = 0; i < num; ++i) {
+			for (j = 0; entry.alg[j] != alg[i]; ++j)
+				;
+			memcpy(dst[i], entry.digest[j], entry.len[j]);
+			*size[i] = entry.len[j];
+		}
+		return (0);
+	}
+
+	/*
+	 * Miss, compute the digests and store them if the file didn't change
+	 */
+	started = time(NULL);
+
+	if (crapi_mdigest_fd_a(fd, num, alg, dst, size) != 0)
+		return (-1);
+
+	if (fstat(fd, &st_after) != 0)
+		return (0);
+
+	digest_cache_key_init(&entry.key, &st_after);
+	if (!digest_cache_key_eq(&entry.key, &key) ||
+	    (int64_t)started - key.mtime_sec <= DIGEST_CACHE_SETTLE_SEC ||
+	    (int64_t)started - key.ctime_sec <= DIGEST_CACHE_SETTLE_SEC)
+		return (0);
+
+	/* digests of other algorithms in the entry are still valid */
+	for (i = 0; i < num; ++i) {
+		if (*size[i] == 0 || *size[i] != digest_cache_alg_len(alg[i]))
+			continue;
+		for (j = 0; j < entry.count && entry.alg[j] != alg[i]; ++j)
+			;
+		if (j == DIGEST_CACHE_MAX_ALGS)
+			continue;
+		if (j == entry.count)
+			++entry.count;
+		entry.alg[j] = alg[i];
+		entry.len[j] = *size[i];
+		memcpy(entry.digest[j], dst[i], *size[i]);
+	}
+
+	digest_cache_store(dir, &entry);
+	return (0);
+}
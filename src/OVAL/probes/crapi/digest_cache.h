@@ -0,0 +1,47 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#pragma once
+#ifndef CRAPI_DIGEST_CACHE_H
+#define CRAPI_DIGEST_CACHE_H
+
+#include <stddef.h>
+#include "digest.h"
+
+/* directory of the on-disk digest cache, the cache is disabled when unset */
+#define CRAPI_DIGEST_CACHE_ENV "OSCAP_PROBE_DIGEST_CACHE"
+/* the cache is not used with OSCAP_PROBE_ROOT unless this is set to 1 */
+#define CRAPI_DIGEST_CACHE_OFFLINE_ENV "OSCAP_PROBE_DIGEST_CACHE_OFFLINE"
+
+/*
+ * Returns a copy of the digest cache directory, or NULL if the cache
+ * shouldn't be used. The directory is created if it doesn't exist. Probes
+ * resolve it once when they are initialized, not for every file.
+ */
+char *crapi_digest_cache_dir(void);
+
+/*
+ * Same as crapi_mdigest_fd_a(), but the digests of a regular file are looked
+ * up in the on-disk digest cache in @dir first. The cache entries are keyed
+ * by the device, inode, size, mtime and ctime of the file and are only used
+ * when all of them match. Newly computed digests are stored in the cache. A
+ * NULL @dir disables the cache.
+ */
+int crapi_mdigest_fd_cached (const char *dir, int fd, int num, const crapi_alg_t alg[], void *dst[], size_t *size[]);
+
+#endif /* CRAPI_DIGEST_CACHE_H */
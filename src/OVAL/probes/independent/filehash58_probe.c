@@ -43,7 +43,6 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <limits.h>
-#include <pthread.h>
 #include <errno.h>
 #include <crapi/crapi.h>
 #include <probe/probe.h>
@@ -121,16 +120,32 @@ static int mem2hex (uint8_t *mem, size_t mlen, char *str, size_t slen)
 	return (0);
 }
 
-static int filehash58_cb(const char *prefix, const char *p, const char *f, const char *h, probe_ctx *ctx)
+static SEXP_t *filehash58_error_item(const char *filepath, const char *p, const char *f, const char *h)
+{
+	SEXP_t *itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
+		"filepath", OVAL_DATATYPE_STRING, filepath,
+		"path", OVAL_DATATYPE_STRING, p,
+		"filename", OVAL_DATATYPE_STRING, f,
+		"hash_type", OVAL_DATATYPE_STRING, h,
+		NULL);
+	probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+	return itm;
+}
+
+/*
+ * Collect an item for each of the hash types 'h' of the given file.
+ * The file is read only once, all the digests are computed together.
+ */
+static int filehash58_cb(const char *prefix, const char *p, const char *f, const char **h, int h_cnt, probe_ctx *ctx, const char *cache_dir)
 {
 	SEXP_t *itm;
 
 	char   pbuf[PATH_MAX+1];
 	size_t plen, flen;
 
-	int fd;
+	int fd, i;
 
-	if (f == NULL)
+	if (f == NULL || h_cnt == 0)
 		return (0);
 
 	/*
@@ -164,79 +179,83 @@ static int filehash58_cb(const char *prefix, const char *p, const char *f, const
 	}
 
 	if (fd < 0) {
-		strerror_r (errno, pbuf, PATH_MAX);
-		pbuf[PATH_MAX] = '\0';
+		int open_errno = errno;
 
-		itm = probe_item_create (OVAL_INDEPENDENT_FILE_HASH58, NULL,
-					"filepath", OVAL_DATATYPE_STRING, pbuf,
-					"path",     OVAL_DATATYPE_STRING, p,
-					"filename", OVAL_DATATYPE_STRING, f,
-					"hash_type",OVAL_DATATYPE_STRING, h,
-					NULL);
-		probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
-			"Can't open \"%s\": errno=%d, %s.", pbuf, errno, strerror (errno));
-		probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+		strerror_r (open_errno, pbuf, PATH_MAX);
+		pbuf[PATH_MAX] = '\0';
 
-		probe_item_collect(ctx, itm);
+		for (i = 0; i < h_cnt; ++i) {
+			itm = filehash58_error_item(pbuf, p, f, h[i]);
+			probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
+				"Can't open \"%s\": errno=%d, %s.", pbuf, open_errno, strerror (open_errno));
+			probe_item_collect(ctx, itm);
+		}
 		return 0;
 	}
 
-	uint8_t hash_dst[1025];
-	size_t hash_dstlen = sizeof(hash_dst);
-	char hash_str[2051];
-	crapi_alg_t hash_type;
-
-	hash_type = oscap_string_to_enum(CRAPI_ALG_MAP, h);
-	if (hash_type == 0) {
-		char *msg = oscap_sprintf("This version of OpenSCAP doesn't support the '%s' hash algorithm.", h);
-		dW(msg);
-		itm = probe_item_create (OVAL_INDEPENDENT_FILE_HASH58, NULL,
-			"filepath", OVAL_DATATYPE_STRING, pbuf,
-			"path", OVAL_DATATYPE_STRING, p,
-			"filename", OVAL_DATATYPE_STRING, f,
-			"hash_type", OVAL_DATATYPE_STRING, h,
-			NULL);
-		probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR, msg);
-		free(msg);
-		probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
-		probe_item_collect(ctx, itm);
-		close(fd);
-		return 0;
+	crapi_alg_t hash_type[h_cnt];
+	uint8_t hash_dst[h_cnt][64];
+	size_t hash_dstlen[h_cnt];
+	void *alg_dst[h_cnt];
+	size_t *alg_dstlen[h_cnt];
+	crapi_alg_t alg[h_cnt];
+	int alg_cnt = 0;
+	char hash_str[129];
+
+	for (i = 0; i < h_cnt; ++i) {
+		hash_type[i] = oscap_string_to_enum(CRAPI_ALG_MAP, h[i]);
+		if (hash_type[i] == 0)
+			continue;
+		hash_dstlen[i] = oscap_string_to_enum(CRAPI_ALG_MAP_SIZE, h[i]);
+		alg[alg_cnt] = hash_type[i];
+		alg_dst[alg_cnt] = hash_dst[i];
+		alg_dstlen[alg_cnt] = &hash_dstlen[i];
+		++alg_cnt;
 	}
 
-	hash_dstlen = oscap_string_to_enum(CRAPI_ALG_MAP_SIZE, h);
-
 	/*
-	 * Compute hash value
+	 * Compute hash values
 	 */
-	if (crapi_mdigest_fd(fd, 1, hash_type, hash_dst, &hash_dstlen) != 0) {
+	if (alg_cnt > 0 && crapi_mdigest_fd_cached(cache_dir, fd, alg_cnt, alg, alg_dst, alg_dstlen) != 0) {
 		close (fd);
 		return (-1);
 	}
 
 	close (fd);
 
-	hash_str[0] = '\0';
-	mem2hex(hash_dst, hash_dstlen, hash_str, sizeof(hash_str));
-
 	/*
-	 * Create and add the item
+	 * Create and add the items
 	 */
-	itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
-		"filepath", OVAL_DATATYPE_STRING, pbuf,
-		"path", OVAL_DATATYPE_STRING, p,
-		"filename", OVAL_DATATYPE_STRING, f,
-		"hash_type",OVAL_DATATYPE_STRING, h,
-		"hash", OVAL_DATATYPE_STRING, hash_str,
-		NULL);
+	for (i = 0; i < h_cnt; ++i) {
+		if (hash_type[i] == 0) {
+			char *msg = oscap_sprintf("This version of OpenSCAP doesn't support the '%s' hash algorithm.", h[i]);
+			dW(msg);
+			itm = filehash58_error_item(pbuf, p, f, h[i]);
+			probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR, msg);
+			free(msg);
+			probe_item_collect(ctx, itm);
+			continue;
+		}
 
-	if (hash_dstlen == 0) {
-		probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
-			"Unable to compute %s hash value of \"%s\".", h, pbuf);
-		probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
-	}
+		hash_str[0] = '\0';
+		mem2hex(hash_dst[i], hash_dstlen[i], hash_str, sizeof(hash_str));
 
-	probe_item_collect(ctx, itm);
+		itm = probe_item_create(OVAL_INDEPENDENT_FILE_HASH58, NULL,
+			"filepath", OVAL_DATATYPE_STRING, pbuf,
+			"path", OVAL_DATATYPE_STRING, p,
+			"filename", OVAL_DATATYPE_STRING, f,
+			"hash_type",OVAL_DATATYPE_STRING, h[i],
+			"hash", OVAL_DATATYPE_STRING, hash_str,
+			NULL);
+
+		if (hash_dstlen[i] == 0) {
+			probe_item_add_msg(itm, OVAL_MESSAGE_LEVEL_ERROR,
+				"Unable to compute %s hash value of \"%s\".", h[i], pbuf);
+			probe_item_setstatus(itm, SYSCHAR_STATUS_ERROR);
+		}
+
+		probe_item_collect(ctx, itm);
+	}
 
 	return (0);
 }
@@ -248,33 +267,17 @@ int filehash58_probe_offline_mode_supported()
 
 void *filehash58_probe_init(void)
 {
-	/*
-	 * Initialize mutex.
-	 */
-	pthread_mutex_t *filehash58_probe_mutex = malloc(sizeof(pthread_mutex_t));
-	switch (pthread_mutex_init(filehash58_probe_mutex, NULL)) {
-	case 0:
-		return ((void *)filehash58_probe_mutex);
-	default:
-		dD("Can't initialize mutex: errno=%u, %s.", errno, strerror (errno));
-		free(filehash58_probe_mutex);
-	}
-
-	return (NULL);
+	return crapi_digest_cache_dir();
 }
 
 void filehash58_probe_fini(void *arg)
 {
-	/*
-	 * Destroy mutex.
-	 */
-	pthread_mutex_t *filehash58_probe_mutex = (pthread_mutex_t *)arg;
-	(void) pthread_mutex_destroy(filehash58_probe_mutex);
-	free(filehash58_probe_mutex);
+	free(arg);
 }
 
 int filehash58_probe_main(probe_ctx *ctx, void *arg)
 {
+	const char *cache_dir = (const char *)arg;
 	SEXP_t *probe_in;
 	SEXP_t *path, *filename, *behaviors, *filepath, *hash_type;
 	char hash_type_str[128];
@@ -283,11 +286,6 @@ int filehash58_probe_main(probe_ctx *ctx, void *arg)
 	OVAL_FTS    *ofts;
 	OVAL_FTSENT *ofts_ent;
 
-	pthread_mutex_t *filehash58_probe_mutex = (pthread_mutex_t *)arg;
-	if (filehash58_probe_mutex == NULL) {
-		return (PROBE_EINIT);
-	}
-
 	probe_in  = probe_ctx_getobject(ctx);
 
 	path      = probe_obj_getent (probe_in, "path",      1);
@@ -310,29 +308,23 @@ int filehash58_probe_main(probe_ctx *ctx, void *arg)
 
 	probe_filebehaviors_canonicalize(&behaviors);
 
-	switch (pthread_mutex_lock(filehash58_probe_mutex)) {
-	case 0:
-		break;
-	default:
-		dD("Can't lock mutex(%p): %u, %s.", filehash58_probe_mutex, errno, strerror(errno));
-
-		err = PROBE_EFATAL;
-		goto cleanup;
-	}
-
 	const char *prefix = getenv("OSCAP_PROBE_ROOT");
 	if ((ofts = oval_fts_open_prefixed(prefix, path, filename, filepath, behaviors, probe_ctx_getresult(ctx))) != NULL) {
-		while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
-			/* find hash types to compare with entity, think "not satisfy" */
-			for (int i = 0; OVAL_FILEHASH58_HASH_TYPES[i] != NULL; i++) {
-				const char *oval_filehash58_hash_type = OVAL_FILEHASH58_HASH_TYPES[i];
-				SEXP_t *oval_filehash58_hash_type_sexp = SEXP_string_new(oval_filehash58_hash_type, strlen(oval_filehash58_hash_type));
-				if (probe_entobj_cmp(hash_type, oval_filehash58_hash_type_sexp) == OVAL_RESULT_TRUE) {
-					filehash58_cb(prefix, ofts_ent->path, ofts_ent->file, oval_filehash58_hash_type, ctx);
-				}
-
-				SEXP_free(oval_filehash58_hash_type_sexp);
+		/* find hash types to compare with entity, think "not satisfy" */
+		const char *hash_types[sizeof(OVAL_FILEHASH58_HASH_TYPES) / sizeof(OVAL_FILEHASH58_HASH_TYPES[0])];
+		int hash_types_cnt = 0;
+		for (int i = 0; OVAL_FILEHASH58_HASH_TYPES[i] != NULL; i++) {
+			const char *oval_filehash58_hash_type = OVAL_FILEHASH58_HASH_TYPES[i];
+			SEXP_t *oval_filehash58_hash_type_sexp = SEXP_string_new(oval_filehash58_hash_type, strlen(oval_filehash58_hash_type));
+			if (probe_entobj_cmp(hash_type, oval_filehash58_hash_type_sexp) == OVAL_RESULT_TRUE) {
+				hash_types[hash_types_cnt++] = oval_filehash58_hash_type;
 			}
+
+			SEXP_free(oval_filehash58_hash_type_sexp);
+		}
+
+		while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
+			filehash58_cb(prefix, ofts_ent->path, ofts_ent->file, hash_types, hash_types_cnt, ctx, cache_dir);
 			oval_ftsent_free(ofts_ent);
 		}
 
@@ -346,14 +338,5 @@ cleanup:
 	SEXP_free (filepath);
         SEXP_free (hash_type);
 
-	switch (pthread_mutex_unlock(filehash58_probe_mutex)) {
-	case 0:
-		break;
-	default:
-		dD("Can't unlock mutex(%p): %u, %s.", filehash58_probe_mutex, errno, strerror(errno));
-
-		err = PROBE_EFATAL;
-	}
-
 	return err;
 }
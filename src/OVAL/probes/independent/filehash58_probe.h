@@ -25,8 +25,8 @@
 
 #include "probe-api.h"
 
-int filehash58_probe_offline_mode_supported(void);
 void *filehash58_probe_init(void);
+int filehash58_probe_offline_mode_supported(void);
 int filehash58_probe_main(probe_ctx *ctx, void *arg);
 void filehash58_probe_fini(void *arg);
 
@@ -42,7 +42,6 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <limits.h>
-#include <pthread.h>
 #include <errno.h>
 #include <crapi/crapi.h>
 #include <probe/probe.h>
@@ -74,7 +73,7 @@ static int mem2hex (uint8_t *mem, size_t mlen, char *str, size_t slen)
         return (0);
 }
 
-static int filehash_cb (const char *prefix, const char *p, const char *f, probe_ctx *ctx, oval_schema_version_t over)
+static int filehash_cb (const char *prefix, const char *p, const char *f, probe_ctx *ctx, oval_schema_version_t over, const char *cache_dir)
 {
         SEXP_t *itm;
         char   pbuf[PATH_MAX+1];
@@ -139,12 +138,14 @@ static int filehash_cb (const char *prefix, const char *p, const char *f, probe_
                 size_t  sha1_dstlen = sizeof sha1_dst;
                 char    sha1_str[(sizeof sha1_dst * 2) + 1];
 
+                const crapi_alg_t alg[2]  = { CRAPI_DIGEST_MD5, CRAPI_DIGEST_SHA1 };
+                void             *dst[2]  = { md5_dst, sha1_dst };
+                size_t           *size[2] = { &md5_dstlen, &sha1_dstlen };
+
                 /*
                  * Compute hash values
                  */
-                if (crapi_mdigest_fd (fd, 2,
-                                      CRAPI_DIGEST_MD5,  md5_dst,  &md5_dstlen,
-                                      CRAPI_DIGEST_SHA1, sha1_dst, &sha1_dstlen) != 0)
+                if (crapi_mdigest_fd_cached (cache_dir, fd, 2, alg, dst, size) != 0)
                 {
                         close (fd);
                         return (-1);
@@ -188,47 +189,29 @@ int filehash_probe_offline_mode_supported()
 	return PROBE_OFFLINE_OWN;
 }
 
+/*
+ * The digest cache directory is looked up and checked once, the probe
+ * argument is the directory or NULL if the cache is not used.
+ */
 void *filehash_probe_init(void)
 {
-        /*
-         * Initialize mutex.
-         */
-	pthread_mutex_t *filehash_probe_mutex = malloc(sizeof(pthread_mutex_t));
-	switch (pthread_mutex_init(filehash_probe_mutex, NULL)) {
-        case 0:
-		return ((void *)filehash_probe_mutex);
-        default:
-                dD("Can't initialize mutex: errno=%u, %s.", errno, strerror (errno));
-		free(filehash_probe_mutex);
-        }
-
-
-        return (NULL);
+	return crapi_digest_cache_dir();
 }
 
 void filehash_probe_fini(void *arg)
 {
-        /*
-         * Destroy mutex.
-         */
-	pthread_mutex_t *filehash_probe_mutex = (pthread_mutex_t *)arg;
-	(void) pthread_mutex_destroy(filehash_probe_mutex);
-	free(filehash_probe_mutex);
+	free(arg);
 }
 
 int filehash_probe_main(probe_ctx *ctx, void *arg)
 {
+	const char *cache_dir = (const char *)arg;
         SEXP_t *path, *filename, *behaviors, *filepath, *probe_in;
 
 	OVAL_FTS    *ofts;
 	OVAL_FTSENT *ofts_ent;
 	oval_schema_version_t over;
 
-	pthread_mutex_t *filehash_probe_mutex = (pthread_mutex_t *)arg;
-	if (filehash_probe_mutex == NULL) {
-		return (PROBE_EINIT);
-        }
-
         probe_in  = probe_ctx_getobject(ctx);
 
         path      = probe_obj_getent (probe_in, "path",      1);
@@ -249,24 +232,10 @@ int filehash_probe_main(probe_ctx *ctx, void *arg)
 
 	probe_filebehaviors_canonicalize(&behaviors);
 
-	switch (pthread_mutex_lock(filehash_probe_mutex)) {
-        case 0:
-                break;
-        default:
-		dD("Can't lock mutex(%p): %u, %s.", filehash_probe_mutex, errno, strerror (errno));
-
-		SEXP_free (behaviors);
-		SEXP_free (path);
-		SEXP_free (filename);
-		SEXP_free (filepath);
-
-		return (PROBE_EFATAL);
-        }
-
 	const char *prefix = getenv("OSCAP_PROBE_ROOT");
 	if ((ofts = oval_fts_open_prefixed(prefix, path, filename, filepath, behaviors, probe_ctx_getresult(ctx))) != NULL) {
 		while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
-			filehash_cb(prefix, ofts_ent->path, ofts_ent->file, ctx, over);
+			filehash_cb(prefix, ofts_ent->path, ofts_ent->file, ctx, over, cache_dir);
 			oval_ftsent_free(ofts_ent);
 		}
 
@@ -278,14 +247,5 @@ int filehash_probe_main(probe_ctx *ctx, void *arg)
         SEXP_free (filename);
         SEXP_free (filepath);
 
-	switch (pthread_mutex_unlock(filehash_probe_mutex)) {
-        case 0:
-                break;
-        default:
-	dD("Can't unlock mutex(%p): %u, %s.", filehash_probe_mutex, errno, strerror (errno));
-
-		return (PROBE_EFATAL);
-        }
-
 	return 0;
 }
@@ -84,6 +84,7 @@
 #include <limits.h>
 #include "system_info_probe.h"
 #include "oscap_helpers.h"
+#include "oscap_pcre.h"
 
 #define _REGEX_RES_VECSIZE     12
 #define MAX_BUFFER_SIZE        4096
@@ -542,19 +543,19 @@ static char *_get_os_release_elem(char *os_release_data, const char *elem_name)
 
 	const char *error;
 	int erroffset, ovec[_REGEX_RES_VECSIZE] = {0};
-	pcre *re = pcre_compile(elem_re, PCRE_MULTILINE, &error, &erroffset, NULL);
+	struct oscap_pcre *re = oscap_pcre_acquire(elem_re, PCRE_MULTILINE, &error, &erroffset);
 	if (re == NULL)
 		goto finish;
 
 	char *ptr = NULL;
-	int rc = pcre_exec(re, NULL, os_release_data, len, 0, 0, ovec, _REGEX_RES_VECSIZE);
+	int rc = oscap_pcre_exec(re, os_release_data, len, 0, 0, ovec, _REGEX_RES_VECSIZE);
 	if (rc >= 0) {
 		/* ovec[0] and ovec[1] - are the start and the end of the whole pattern match (=".....")
 		 * ovec[2] and ovec[3] - are start and end char positions of the capture group (.*?) */
 		ptr = strndup(os_release_data+ovec[2], ovec[3]-ovec[2]);
 		ret = ptr;
 	}
-	pcre_free(re);
+	oscap_pcre_release(re);
 
 finish:
 	return ret;
@@ -43,6 +43,8 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <limits.h>
+#include <ctype.h>
+#include <stdbool.h>
 #include <pcre.h>
 
 #include "_seap.h"
@@ -53,6 +55,7 @@
 #include <oval_fts.h>
 #include "common/debug_priv.h"
 #include "common/util.h"
+#include "common/oscap_pcre.h"
 #include "textfilecontent54_probe.h"
 
 #define FILE_SEPARATOR '/'
@@ -113,19 +116,309 @@ static SEXP_t *create_item(const char *path, const char *filename, char *pattern
 struct pfdata {
 	char *pattern;
 	int re_opts;
+	bool line_local;
 	SEXP_t *instance_ent;
         probe_ctx *ctx;
-	pcre *compiled_regex;
+	struct oscap_pcre *compiled_regex;
 };
 
+/* size of the read buffer in the streaming mode */
+#define TFC54_CHUNK_SIZE (1024 * 1024)
+
+/*
+ * Returns true if no match of the pattern can contain a newline character
+ * and the pattern doesn't refer to the start or end of the whole file.
+ * Such pattern can be matched on the file line by line with the same
+ * result as on the whole file content. The check is conservative, it
+ * accepts only a plain subset of the PCRE syntax.
+ */
+static bool pattern_is_line_local(const char *pattern, int re_opts)
+{
+	const unsigned char *p;
+	bool anchored = false;
+
+	if (re_opts & (PCRE_DOTALL | PCRE_EXTENDED))
+		return false;
+
+	for (p = (const unsigned char *) pattern; *p != '\0'; ++p) {
+		if (*p < 0x20)
+			return false;
+		switch (*p) {
+		case '\\':
+			++p;
+			/* \d, \w, \S and \b can't match or cross a newline, \t is a tab */
+			if (*p == 'd' || *p == 'w' || *p == 'S' || *p == 'b' || *p == 'B' || *p == 't')
+				break;
+			if (*p == '\0' || !ispunct(*p))
+				return false;
+			break;
+		case '[':
+			/* negated and POSIX classes can match a newline */
+			if (p[1] == '^' || p[1] == ':')
+				return false;
+			break;
+		case '(':
+			/* allow only non-capturing groups out of the extended syntax, (*...) changes the newline convention */
+			if ((p[1] == '?' && p[2] != ':') || p[1] == '*')
+				return false;
+			break;
+		case '^':
+		case '$':
+			anchored = true;
+			break;
+		}
+	}
+	/* without the multiline option, ^ and $ refer to the whole file */
+	return !anchored || (re_opts & PCRE_MULTILINE);
+}
+
+struct tfc54_match {
+	const char *whole_path;
+	const char *path;
+	const char *file;
+	int cur_inst;
+	int ofs;
+};
+
+/*
+ * Match the pattern repeatedly on buf[0..len) and collect an item for
+ * each wanted instance. If 'last' is false, the buffer is a part of the
+ * file which ends with a newline and the search is continued in the next
+ * part, starting at 'owned'; matches starting at or after 'owned' are
+ * searched again there. The current offset is kept in m->ofs.
+ * Returns 0 on success, negative value on failure.
+ */
+static int match_buffer(struct pfdata *pfd, struct tfc54_match *m, const char *buf, size_t len,
+			size_t owned, bool last, oval_schema_version_t over)
+{
+	char **substrs = NULL;
+	int substr_cnt, options = last ? 0 : PCRE_NOTEOL;
+	bool checked = false;
+
+	do {
+		int want_instance;
+		SEXP_t *next_inst;
+
+		next_inst = SEXP_number_newi_32(m->cur_inst + 1);
+
+		if (probe_entobj_cmp(pfd->instance_ent, next_inst) == OVAL_RESULT_TRUE)
+			want_instance = 1;
+		else
+			want_instance = 0;
+
+		SEXP_free(next_inst);
+
+		/* the whole buffer was validated by the first call, skip it unless in the middle of a character */
+		int exec_opts = options;
+		if (checked && ((size_t) m->ofs >= len || ((unsigned char) buf[m->ofs] & 0xC0) != 0x80))
+			exec_opts |= PCRE_NO_UTF8_CHECK;
+
+		substr_cnt = oscap_get_substrings_n(buf, len, &m->ofs, exec_opts, pfd->compiled_regex, want_instance, &substrs);
+		checked = true;
+
+		if (substr_cnt < 0) {
+			SEXP_t *msg;
+			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
+				"Regular expression pattern match failed in file %s with error %d.",
+				m->whole_path, substr_cnt);
+			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
+			SEXP_free(msg);
+			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+			return -3;
+		}
+
+		if (substr_cnt == 0) {
+			/* nothing more in this part, the next part is searched from its start */
+			if (!last)
+				m->ofs = 0;
+			return 0;
+		}
+
+		/*
+		 * An empty match at the end of a part which isn't the last one
+		 * is a match at the start of the next line, that is found in
+		 * the next part with the correct context.
+		 */
+		if (!last && (size_t) m->ofs == len) {
+			if (want_instance) {
+				for (int k = 0; k < substr_cnt; ++k)
+					free(substrs[k]);
+				free(substrs);
+			}
+			m->ofs = 0;
+			return 0;
+		}
+
+		++m->cur_inst;
+
+		if (want_instance) {
+			int k;
+			SEXP_t *item;
+
+			item = create_item(m->path, m->file, pfd->pattern,
+					m->cur_inst, substrs, substr_cnt, over);
+
+                        probe_item_collect(pfd->ctx, item);
+
+			for (k = 0; k < substr_cnt; ++k)
+				free(substrs[k]);
+			free(substrs);
+		}
+
+		if (!last && (size_t) m->ofs >= owned) {
+			m->ofs -= owned;
+			return 0;
+		}
+	} while (!last || (size_t) m->ofs <= len);
+
+	return 0;
+}
+
+static void report_read_error(struct pfdata *pfd, const char *whole_path)
+{
+	SEXP_t *msg;
+
+	msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "read(): '%s' %s.", whole_path, strerror(errno));
+	probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
+	SEXP_free(msg);
+	probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+}
+
+/* Returns the offset after the last newline in buf[0..len), 0 if there is none. */
+static size_t last_line_end(const char *buf, size_t len)
+{
+	while (len > 0 && buf[len - 1] != '\n')
+		--len;
+	return len;
+}
+
+/*
+ * Match a pattern which can't span lines on the file read in parts of
+ * whole lines, so only a bounded amount of the file is held in memory.
+ * Each part but the last one overlaps the next one by its last line,
+ * which gives the matches at the part boundary the same context as in
+ * the whole file.
+ */
+static int process_stream(struct pfdata *pfd, struct tfc54_match *m, int fd, oval_schema_version_t over)
+{
+	size_t buf_size = TFC54_CHUNK_SIZE, buf_used = 0;
+	char *buf = malloc(buf_size);
+	bool eof = false;
+	int ret = 0;
+
+	if (buf == NULL)
+		return PROBE_ENOMEM;
+
+	while (!eof) {
+		if (buf_used == buf_size) {
+			/* a line longer than the buffer */
+			void *new_buf = realloc(buf, buf_size * 2);
+			if (new_buf == NULL) {
+				ret = PROBE_ENOMEM;
+				break;
+			}
+			buf = new_buf;
+			buf_size *= 2;
+		}
+
+		ssize_t rd = read(fd, buf + buf_used, buf_size - buf_used);
+		if (rd == -1) {
+			if (errno == EINTR)
+				continue;
+			report_read_error(pfd, m->whole_path);
+			ret = -2;
+			break;
+		}
+		if (rd == 0)
+			eof = true;
+
+		/* the content of the file ends at the first NUL character */
+		char *nul = memchr(buf + buf_used, '\0', rd);
+		buf_used += rd;
+		if (nul != NULL) {
+			buf_used = nul - buf;
+			eof = true;
+		}
+		if (eof)
+			break;
+
+		/* the part ends after the last complete line, the next part starts at that line */
+		size_t len = last_line_end(buf, buf_used);
+		if (len < 2)
+			continue;
+		size_t owned = last_line_end(buf, len - 1);
+		if (owned == 0)
+			continue;
+
+		if (m->ofs < (int) owned) {
+			ret = match_buffer(pfd, m, buf, len, owned, false, over);
+			if (ret != 0)
+				break;
+		} else {
+			m->ofs -= owned;
+		}
+
+		memmove(buf, buf + owned, buf_used - owned);
+		buf_used -= owned;
+	}
+
+	if (ret == 0)
+		ret = match_buffer(pfd, m, buf, buf_used, buf_used, true, over);
+
+	free(buf);
+	return ret;
+}
+
+/*
+ * Read the whole content of the file into a buffer sized by the reported
+ * file size. The file isn't mapped into memory: a file truncated while
+ * being matched would raise SIGBUS, whereas read() just returns less
+ * data. The size of procfs and sysfs files is unreliable, the buffer
+ * grows as needed.
+ */
+static int read_whole_file(struct pfdata *pfd, const char *whole_path, int fd, const struct stat *st,
+			   char **content, size_t *content_len)
+{
+	char *buf = NULL;
+	size_t buf_size, buf_used = 0;
+
+	buf_size = (st->st_size > 0 && st->st_size < INT_MAX) ? (size_t) st->st_size + 1 : 4096;
+	for (;;) {
+		if (buf_used == buf_size || buf == NULL) {
+			if (buf != NULL)
+				buf_size *= 2;
+			void *new_buf = realloc(buf, buf_size);
+			if (new_buf == NULL) {
+				dE("Can't re-allocate memory for file-processing buffer");
+				free(buf);
+				return PROBE_ENOMEM;
+			}
+			buf = new_buf;
+		}
+		ssize_t rd = read(fd, buf + buf_used, buf_size - buf_used);
+		if (rd == -1) {
+			if (errno == EINTR)
+				continue;
+			report_read_error(pfd, whole_path);
+			free(buf);
+			return -2;
+		}
+		if (rd == 0)
+			break;
+		buf_used += rd;
+	}
+
+	*content = buf;
+	*content_len = buf_used;
+	return 0;
+}
+
 static int process_file(const char *prefix, const char *path, const char *file, void *arg, oval_schema_version_t over)
 {
 	struct pfdata *pfd = (struct pfdata *) arg;
-	int ret = 0, path_len, file_len, cur_inst = 0, fd = -1, substr_cnt,
-		buf_size = 0, buf_used = 0, ofs = 0, buf_inc = 4096;
-	char **substrs = NULL;
+	int ret = 0, path_len, file_len, fd = -1;
 	char *whole_path = NULL, *whole_path_with_prefix = NULL, *buf = NULL;
-	SEXP_t *next_inst = NULL;
+	size_t buf_len = 0;
 	struct stat st;
 
 	if (file == NULL)
@@ -171,83 +464,29 @@ static int process_file(const char *prefix, const char *path, const char *file,
 		goto cleanup;
 	}
 
-	do {
-		buf_size += buf_inc;
-		void *new_buf = realloc(buf, buf_size);
-		if (new_buf == NULL) {
-			dE("Can't re-allocate memory for file-processing buffer");
-			ret = PROBE_ENOMEM;
-			goto cleanup;
-		}
-		buf = new_buf;
-		ret = read(fd, buf + buf_used, buf_inc);
-		if (ret == -1) {
-			SEXP_t *msg;
+	struct tfc54_match m = {
+		.whole_path = whole_path,
+		.path = path,
+		.file = file,
+		.cur_inst = 0,
+		.ofs = 0,
+	};
 
-			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "read(): '%s' %s.", whole_path, strerror(errno));
-			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
-			SEXP_free(msg);
-			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
-			ret = -2;
-			goto cleanup;
-		}
-		buf_used += ret;
-	} while (ret == buf_inc);
-
-	if (buf_used == buf_size) {
-		void *new_buf = realloc(buf, ++buf_size);
-		if (new_buf == NULL) {
-			dE("Can't re-allocate memory");
-			ret = PROBE_ENOMEM;
-			goto cleanup;
-		}
-		buf = new_buf;
+	if (pfd->line_local) {
+		ret = process_stream(pfd, &m, fd, over);
+		goto cleanup;
 	}
-	buf[buf_used++] = '\0';
 
-	do {
-		int want_instance;
-
-		next_inst = SEXP_number_newi_32(cur_inst + 1);
-
-		if (probe_entobj_cmp(pfd->instance_ent, next_inst) == OVAL_RESULT_TRUE)
-			want_instance = 1;
-		else
-			want_instance = 0;
-
-		SEXP_free(next_inst);
-		substr_cnt = oscap_get_substrings(buf, &ofs, pfd->compiled_regex, want_instance, &substrs);
-
-		if (substr_cnt < 0) {
-			SEXP_t *msg;
-			msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
-				"Regular expression pattern match failed in file %s with error %d.",
-				whole_path, substr_cnt);
-			probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
-			SEXP_free(msg);
-			probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
-			ret = -3;
-			goto cleanup;
-		}
-
-		if (substr_cnt > 0) {
-			++cur_inst;
-
-			if (want_instance) {
-				int k;
-				SEXP_t *item;
-
-				item = create_item(path, file, pfd->pattern,
-						cur_inst, substrs, substr_cnt, over);
+	ret = read_whole_file(pfd, whole_path, fd, &st, &buf, &buf_len);
+	if (ret != 0)
+		goto cleanup;
 
-                                probe_item_collect(pfd->ctx, item);
+	/* the content of the file ends at the first NUL character */
+	const char *nul = memchr(buf, '\0', buf_len);
+	if (nul != NULL)
+		buf_len = nul - buf;
 
-				for (k = 0; k < substr_cnt; ++k)
-					free(substrs[k]);
-				free(substrs);
-			}
-		}
-	} while (substr_cnt > 0 && ofs < buf_used);
+	ret = match_buffer(pfd, &m, buf, buf_len, buf_len, true, over);
 
  cleanup:
 	if (fd != -1)
@@ -257,7 +496,6 @@ static int process_file(const char *prefix, const char *path, const char *file,
 		free(whole_path);
 	free(whole_path_with_prefix);
 
-	/* coverity[leaked_storage] - substrs is not leaked */
 	return ret;
 }
 
@@ -339,8 +577,11 @@ int textfilecontent54_probe_main(probe_ctx *ctx, void *arg)
 			pfd.re_opts |= PCRE_DOTALL;
 	}
 
-	pfd.compiled_regex = pcre_compile(pfd.pattern, pfd.re_opts, &error,
-					  &errorffset, NULL);
+	pfd.line_local = pattern_is_line_local(pfd.pattern, pfd.re_opts);
+	dD("Pattern '%s' is%s matched line by line.", pfd.pattern, pfd.line_local ? "" : " not");
+
+	pfd.compiled_regex = oscap_pcre_acquire(pfd.pattern, pfd.re_opts, &error,
+					  &errorffset);
 	if (pfd.compiled_regex == NULL) {
 		SEXP_t *msg;
 
@@ -375,6 +616,6 @@ int textfilecontent54_probe_main(probe_ctx *ctx, void *arg)
 	if (pfd.pattern != NULL)
 		free(pfd.pattern);
 	if (pfd.compiled_regex != NULL)
-		pcre_free(pfd.compiled_regex);
+		oscap_pcre_release(pfd.compiled_regex);
 	return ret;
 }
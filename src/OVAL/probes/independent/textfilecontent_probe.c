@@ -72,6 +72,7 @@
 #include <oval_fts.h>
 #include "common/debug_priv.h"
 #include "common/util.h"
+#include "common/oscap_pcre.h"
 #include "textfilecontent_probe.h"
 
 #define FILE_SEPARATOR '/'
@@ -148,10 +149,10 @@ static int process_file(const char *prefix, const char *path, const char *filena
 
 // todo: move to probe_main()?
 	int erroffset = -1;
-	pcre *re = NULL;
+	struct oscap_pcre *re = NULL;
 	const char *error;
 
-	re = pcre_compile(pfd->pattern, PCRE_UTF8, &error, &erroffset, NULL);
+	re = oscap_pcre_acquire(pfd->pattern, PCRE_UTF8, &error, &erroffset);
 	if (re == NULL) {
 		return -1;
 	}
@@ -218,7 +219,7 @@ static int process_file(const char *prefix, const char *path, const char *filena
 	if (whole_path != NULL)
 		free(whole_path);
 	if (re != NULL)
-		pcre_free(re);
+		oscap_pcre_release(re);
 	free(whole_path_with_prefix);
 
 	return ret;
@@ -55,7 +55,10 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
 #include <limits.h>
+#include <pthread.h>
+#include <sys/stat.h>
 
 #include <libxml/tree.h>
 #include <libxml/parser.h>
@@ -76,39 +79,108 @@
 
 #define FILE_SEPARATOR '/'
 
+/* Maximum number of the parsed documents kept in the cache */
+#define XMLFILECONTENT_DOC_CACHE_MAX 32
+/* Maximum number of the compiled XPath expressions kept in the cache */
+#define XMLFILECONTENT_XPATH_CACHE_MAX 256
+
+#if defined(__APPLE__)
+# define ST_MTIME_NSEC(st) ((st)->st_mtimespec.tv_nsec)
+# define ST_CTIME_NSEC(st) ((st)->st_ctimespec.tv_nsec)
+#else
+# define ST_MTIME_NSEC(st) ((st)->st_mtim.tv_nsec)
+# define ST_CTIME_NSEC(st) ((st)->st_ctim.tv_nsec)
+#endif
+
+/*
+ * Namespace-stripped document, the file is parsed again if its
+ * stat data changes. The entry is referenced by the cache and by
+ * the objects which evaluate an expression on it, the lock serializes
+ * the evaluations on the document.
+ */
+struct xmlfilecontent_doc {
+	char *path;
+	dev_t dev;
+	ino_t ino;
+	off_t size;
+	time_t mtime;
+	long mtime_nsec;
+	time_t ctime;
+	long ctime_nsec;
+	xmlDoc *doc;
+	unsigned int refcnt;
+	pthread_mutex_t lock;
+	struct xmlfilecontent_doc *next;
+};
+
+/*
+ * Compiled XPath expression, referenced by the cache and by the objects
+ * which evaluate it.
+ */
+struct xmlfilecontent_xpath {
+	char *expr;
+	xmlXPathCompExpr *comp;
+	unsigned int refcnt;
+	struct xmlfilecontent_xpath *next;
+};
+
+/*
+ * Data shared by all the objects evaluated during the scan. The mutex
+ * protects the cache lists and the reference counts only, the XPath
+ * expressions are evaluated under the lock of the document.
+ */
+struct xmlfilecontent_global {
+	pthread_mutex_t mutex;
+	xsltStylesheet *stylesheet;
+	struct xmlfilecontent_doc *docs; /* most recently used first */
+	size_t doc_count;
+	struct xmlfilecontent_xpath *xpaths; /* most recently used first */
+	size_t xpath_count;
+};
+
 struct pfdata {
 	SEXP_t *filename_ent;
 	char *xpath;
         probe_ctx *ctx;
+	struct xmlfilecontent_global *g;
 };
 
 static void dummy_err_func(void * ctx, const char * msg, ...)
 {
 }
 
-int xmlfilecontent_probe_offline_mode_supported()
+/*
+ * Drop a reference to a cached document, the caller has to hold the mutex.
+ */
+static void doc_unref(struct xmlfilecontent_doc *d)
 {
-	return PROBE_OFFLINE_OWN;
+	if (--d->refcnt > 0)
+		return;
+	xmlFreeDoc(d->doc);
+	pthread_mutex_destroy(&d->lock);
+	free(d->path);
+	free(d);
 }
 
-void *xmlfilecontent_probe_init(void)
+/*
+ * Drop a reference to a cached XPath expression, the caller has to hold
+ * the mutex.
+ */
+static void xpath_unref(struct xmlfilecontent_xpath *x)
 {
-	/* init libxml */
-	//LIBXML_TEST_VERSION;
-	xmlInitParser();
-	xmlSetGenericErrorFunc(NULL, dummy_err_func);
-
-	return NULL;
+	if (--x->refcnt > 0)
+		return;
+	xmlXPathFreeCompExpr(x->comp);
+	free(x->expr);
+	free(x);
 }
 
-void xmlfilecontent_probe_fini(void *arg)
+int xmlfilecontent_probe_offline_mode_supported()
 {
-        (void)arg;
-	/* deinit libxml */
-	xmlCleanupParser();
+	return PROBE_OFFLINE_OWN;
 }
 
-static xmlDocPtr strip_ns(xmlDocPtr doc)
+static xsltStylesheetPtr strip_ns_stylesheet(void)
 {
 	const char template[] = 
 	"<xsl:stylesheet version=\"1.0\" xmlns:xsl=\"http://www.w3.org/1999/XSL/Transform\">"
@@ -134,21 +206,256 @@ static xmlDocPtr strip_ns(xmlDocPtr doc)
 		xmlFreeDoc(stylesheet_doc);
 		return NULL;
 	}
+	return stylesheet;
+}
+
+void *xmlfilecontent_probe_init(void)
+{
+	struct xmlfilecontent_global *g;
+
+	/* init libxml */
+	//LIBXML_TEST_VERSION;
+	xmlInitParser();
+	xmlSetGenericErrorFunc(NULL, dummy_err_func);
+
+	g = malloc(sizeof(struct xmlfilecontent_global));
+	pthread_mutex_init(&g->mutex, NULL);
+	g->stylesheet = strip_ns_stylesheet();
+	g->docs = NULL;
+	g->doc_count = 0;
+	g->xpaths = NULL;
+	g->xpath_count = 0;
+
+	return g;
+}
+
+void xmlfilecontent_probe_fini(void *arg)
+{
+	struct xmlfilecontent_global *g = arg;
+
+	if (g != NULL) {
+		while (g->docs != NULL) {
+			struct xmlfilecontent_doc *d = g->docs;
+			g->docs = d->next;
+			doc_unref(d);
+		}
+		while (g->xpaths != NULL) {
+			struct xmlfilecontent_xpath *x = g->xpaths;
+			g->xpaths = x->next;
+			xpath_unref(x);
+		}
+		if (g->stylesheet != NULL)
+			xsltFreeStylesheet(g->stylesheet);
+		pthread_mutex_destroy(&g->mutex);
+		free(g);
+	}
+
+	/* deinit libxml */
+	xmlCleanupParser();
+}
+
+static xmlDocPtr strip_ns(xsltStylesheetPtr stylesheet, xmlDocPtr doc)
+{
+	if (stylesheet == NULL)
+		return NULL;
 	xmlDocPtr result = xsltApplyStylesheet(stylesheet, doc, NULL);
 	if (result == NULL) {
 		fprintf(stderr, "Can't apply XSLT on the document\n");
 	}
-	xsltFreeStylesheet(stylesheet);
 	return result;
 }
 
+static bool doc_is_current(const struct xmlfilecontent_doc *d, const struct stat *st)
+{
+	return d->dev == st->st_dev && d->ino == st->st_ino && d->size == st->st_size &&
+		d->mtime == st->st_mtime && d->mtime_nsec == (long) ST_MTIME_NSEC(st) &&
+		d->ctime == st->st_ctime && d->ctime_nsec == (long) ST_CTIME_NSEC(st);
+}
+
+/*
+ * Find a cached document and take a reference to it, the caller has
+ * to hold the mutex.
+ */
+static struct xmlfilecontent_doc *doc_cache_get(struct xmlfilecontent_global *g, const char *path, const struct stat *st)
+{
+	struct xmlfilecontent_doc *d, *prev = NULL;
+
+	for (d = g->docs; d != NULL; prev = d, d = d->next) {
+		if (strcmp(d->path, path) != 0)
+			continue;
+		if (!doc_is_current(d, st))
+			return NULL;
+		if (prev != NULL) {
+			prev->next = d->next;
+			d->next = g->docs;
+			g->docs = d;
+		}
+		++d->refcnt;
+		return d;
+	}
+	return NULL;
+}
+
+/*
+ * Insert the document to the cache and take a reference to the new entry,
+ * the caller has to hold the mutex. A stale entry for the same path and
+ * the least recently used entry over the limit are dropped. Returns NULL
+ * if the entry can't be allocated, the document isn't owned by the cache
+ * then.
+ */
+static struct xmlfilecontent_doc *doc_cache_add(struct xmlfilecontent_global *g, const char *path,
+						const struct stat *st, xmlDocPtr doc)
+{
+	struct xmlfilecontent_doc *d, **dp;
+
+	d = malloc(sizeof(struct xmlfilecontent_doc));
+	if (d == NULL)
+		return NULL;
+	d->path = strdup(path);
+	if (d->path == NULL) {
+		free(d);
+		return NULL;
+	}
+
+	for (dp = &g->docs; *dp != NULL; dp = &(*dp)->next) {
+		if (strcmp((*dp)->path, path) == 0) {
+			struct xmlfilecontent_doc *stale = *dp;
+			*dp = stale->next;
+			doc_unref(stale);
+			--g->doc_count;
+			break;
+		}
+	}
+
+	d->dev = st->st_dev;
+	d->ino = st->st_ino;
+	d->size = st->st_size;
+	d->mtime = st->st_mtime;
+	d->mtime_nsec = (long) ST_MTIME_NSEC(st);
+	d->ctime = st->st_ctime;
+	d->ctime_nsec = (long) ST_CTIME_NSEC(st);
+	d->doc = doc;
+	d->refcnt = 2; /* the cache and the caller */
+	pthread_mutex_init(&d->lock, NULL);
+	d->next = g->docs;
+	g->docs = d;
+
+	if (++g->doc_count > XMLFILECONTENT_DOC_CACHE_MAX) {
+		struct xmlfilecontent_doc *lru;
+
+		for (dp = &g->docs; (*dp)->next != NULL; dp = &(*dp)->next)
+			;
+		lru = *dp;
+		*dp = NULL;
+		doc_unref(lru);
+		--g->doc_count;
+	}
+
+	return d;
+}
+
+/*
+ * Get the compiled XPath expression and take a reference to it, the caller
+ * has to hold the mutex. The least recently used expression over the limit
+ * is dropped. Returns NULL if the expression can't be compiled or the entry
+ * can't be allocated.
+ */
+static struct xmlfilecontent_xpath *xpath_cache_get(struct xmlfilecontent_global *g, const char *expr)
+{
+	struct xmlfilecontent_xpath *x, **xp, *prev = NULL;
+	xmlXPathCompExprPtr comp;
+
+	for (x = g->xpaths; x != NULL; prev = x, x = x->next) {
+		if (strcmp(x->expr, expr) != 0)
+			continue;
+		if (prev != NULL) {
+			prev->next = x->next;
+			x->next = g->xpaths;
+			g->xpaths = x;
+		}
+		++x->refcnt;
+		return x;
+	}
+
+	comp = xmlXPathCompile(BAD_CAST expr);
+	if (comp == NULL)
+		return NULL;
+
+	x = malloc(sizeof(struct xmlfilecontent_xpath));
+	if (x == NULL || (x->expr = strdup(expr)) == NULL) {
+		/* not cached, the caller can't own the expression either */
+		free(x);
+		xmlXPathFreeCompExpr(comp);
+		return NULL;
+	}
+	x->comp = comp;
+	x->refcnt = 2; /* the cache and the caller */
+	x->next = g->xpaths;
+	g->xpaths = x;
+
+	if (++g->xpath_count > XMLFILECONTENT_XPATH_CACHE_MAX) {
+		struct xmlfilecontent_xpath *lru;
+
+		for (xp = &g->xpaths; (*xp)->next != NULL; xp = &(*xp)->next)
+			;
+		lru = *xp;
+		*xp = NULL;
+		xpath_unref(lru);
+		--g->xpath_count;
+	}
+
+	return x;
+}
+
+/*
+ * Parse the file and remove the namespaces from it.
+ */
+static xmlDocPtr parse_file(struct pfdata *pfd, const char *path, const char *whole_path)
+{
+	xmlDoc *doc, *doc_no_ns;
+
+	doc = xmlParseFile(path);
+	if (doc == NULL) {
+                SEXP_t *msg;
+                msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "Can't parse '%s'.", whole_path);
+                probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
+                SEXP_free(msg);
+                probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+		return NULL;
+	}
+
+	/* Remove the namespace from the examined document. The XPath expressions
+	 * will be evaluated as if the namespace is ignored. Even though the
+	 * xmlfilecontent should use standardized XPath, existing content expects
+	 * this behavior.
+	 */
+	doc_no_ns = strip_ns(pfd->g->stylesheet, doc);
+	xmlFreeDoc(doc);
+	if (doc_no_ns == NULL) {
+		SEXP_t *msg;
+		msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
+			"Can't remove namespaces from '%s'.", whole_path);
+		probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
+		SEXP_free(msg);
+		probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
+		return NULL;
+	}
+
+	return doc_no_ns;
+}
+
 static int process_file(const char *prefix, const char *path, const char *filename, void *arg)
 {
 	struct pfdata *pfd = (struct pfdata *) arg;
 	int ret = 0, path_len, filename_len;
-	char *whole_path = NULL;
+	char *whole_path = NULL, *path_with_prefix = NULL;
+	struct xmlfilecontent_global *g = pfd->g;
+	struct stat st;
+	bool cacheable, doc_locked = false;
+	struct xmlfilecontent_doc *cached = NULL;
 	xmlDoc *doc = NULL;
 	xmlDoc *doc_no_ns = NULL;
+	struct xmlfilecontent_xpath *xpath = NULL;
 	xmlXPathContext *xpath_ctx = NULL;
 	xmlXPathObject *xpath_obj = NULL;
 	SEXP_t *item = NULL;
@@ -171,44 +478,75 @@ static int process_file(const char *prefix, const char *path, const char *filena
 
 	memcpy(whole_path + path_len, filename, filename_len + 1);
 
-	if (prefix == NULL) {
-		doc = xmlParseFile(whole_path);
-	} else {
-		char *path_with_prefix = oscap_path_join(prefix, whole_path);
-		doc = xmlParseFile(path_with_prefix);
-		free(path_with_prefix);
+	if (prefix == NULL)
+		path_with_prefix = strdup(whole_path);
+	else
+		path_with_prefix = oscap_path_join(prefix, whole_path);
+
+	/*
+	 * The parsed documents are shared by the objects querying the same
+	 * file, a file which can't be stat'ed is parsed for this object only.
+	 */
+	cacheable = stat(path_with_prefix, &st) == 0;
+	if (cacheable) {
+		pthread_mutex_lock(&g->mutex);
+		cached = doc_cache_get(g, path_with_prefix, &st);
+		pthread_mutex_unlock(&g->mutex);
 	}
 
-	if (doc == NULL) {
+	if (cached == NULL) {
+		doc_no_ns = parse_file(pfd, path_with_prefix, whole_path);
+		if (doc_no_ns == NULL) {
+			ret = -1;
+			goto cleanup;
+		}
+		if (cacheable) {
+			pthread_mutex_lock(&g->mutex);
+			cached = doc_cache_add(g, path_with_prefix, &st, doc_no_ns);
+			pthread_mutex_unlock(&g->mutex);
+			if (cached != NULL)
+				doc_no_ns = NULL;
+		}
+	}
+
+	pthread_mutex_lock(&g->mutex);
+	xpath = xpath_cache_get(g, pfd->xpath);
+	pthread_mutex_unlock(&g->mutex);
+	if (xpath == NULL) {
                 SEXP_t *msg;
-                msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "Can't parse '%s'.", whole_path);
+                msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "xmlXPathCompile() error: can't compile the XPath expression '%s'.", pfd->xpath);
                 probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
                 SEXP_free(msg);
                 probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
 
-		ret = -1;
+		ret = -3;
 		goto cleanup;
 	}
 
-	/* Remove the namespace from the examined document. The XPath expressions
-	 * will be evaluated as if the namespace is ignored. Even though the
-	 * xmlfilecontent should use standardized XPath, existing content expects
-	 * this behavior.
-	 */
-	doc_no_ns = strip_ns(doc);
-	if (doc_no_ns == NULL) {
-		SEXP_t *msg;
-		msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR,
-			"Can't remove namespaces from '%s'.", whole_path);
-		probe_cobj_add_msg(probe_ctx_getresult(pfd->ctx), msg);
-		SEXP_free(msg);
-		probe_cobj_set_flag(probe_ctx_getresult(pfd->ctx), SYSCHAR_FLAG_ERROR);
-		ret = -1;
-		goto cleanup;
+	/* Avoid 2 slashes */
+	if (path_len >= 1 && path[path_len - 1] == FILE_SEPARATOR) {
+		snprintf(filepath, PATH_MAX, "%s%s", path, filename);
+	} else {
+		snprintf(filepath, PATH_MAX, "%s%c%s", path, FILE_SEPARATOR, filename);
+	}
+
+        item = probe_item_create(OVAL_INDEPENDENT_XML_FILE_CONTENT, NULL,
+                                 "filepath", OVAL_DATATYPE_STRING, filepath,
+                                 "path",     OVAL_DATATYPE_STRING, path,
+                                 "filename", OVAL_DATATYPE_STRING, filename,
+                                 "xpath",    OVAL_DATATYPE_STRING, pfd->xpath,
+                                 NULL);
+
+	/* evaluate xpath, only one object at a time can use a cached document */
+	if (cached != NULL) {
+		pthread_mutex_lock(&cached->lock);
+		doc_locked = true;
+		doc = cached->doc;
+	} else {
+		doc = doc_no_ns;
 	}
 
-	/* evaluate xpath */
-	xpath_ctx = xmlXPathNewContext(doc_no_ns);
+	xpath_ctx = xmlXPathNewContext(doc);
 	if (xpath_ctx == NULL) {
                 SEXP_t *msg;
                 msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "xmlXPathNewContext() error.");
@@ -220,7 +558,7 @@ static int process_file(const char *prefix, const char *path, const char *filena
 		goto cleanup;
 	}
 
-	xpath_obj = xmlXPathEvalExpression(BAD_CAST pfd->xpath, xpath_ctx);
+	xpath_obj = xmlXPathCompiledEval(xpath->comp, xpath_ctx);
 	if (xpath_obj == NULL) {
                 SEXP_t *msg;
                 msg = probe_msg_creatf(OVAL_MESSAGE_LEVEL_ERROR, "xmlXPathEvalExpression() error");
@@ -232,20 +570,6 @@ static int process_file(const char *prefix, const char *path, const char *filena
 		goto cleanup;
 	}
 
-	/* Avoid 2 slashes */
-	if (path_len >= 1 && path[path_len - 1] == FILE_SEPARATOR) {
-		snprintf(filepath, PATH_MAX, "%s%s", path, filename);
-	} else {
-		snprintf(filepath, PATH_MAX, "%s%c%s", path, FILE_SEPARATOR, filename);
-	}
-
-        item = probe_item_create(OVAL_INDEPENDENT_XML_FILE_CONTENT, NULL,
-                                 "filepath", OVAL_DATATYPE_STRING, filepath,
-                                 "path",     OVAL_DATATYPE_STRING, path,
-                                 "filename", OVAL_DATATYPE_STRING, filename,
-                                 "xpath",    OVAL_DATATYPE_STRING, pfd->xpath,
-                                 NULL);
-
 	dD("xpath obj type: %d.", xpath_obj->type);
 	switch(xpath_obj->type) {
 	case XPATH_BOOLEAN:
@@ -325,6 +649,15 @@ static int process_file(const char *prefix, const char *path, const char *filena
 		break;
 	}
 
+	xmlXPathFreeObject(xpath_obj);
+	xpath_obj = NULL;
+	xmlXPathFreeContext(xpath_ctx);
+	xpath_ctx = NULL;
+	if (doc_locked) {
+		pthread_mutex_unlock(&cached->lock);
+		doc_locked = false;
+	}
+
         probe_item_collect(pfd->ctx, item);
         item = NULL;
  cleanup:
@@ -334,10 +667,19 @@ static int process_file(const char *prefix, const char *path, const char *filena
 		xmlXPathFreeObject(xpath_obj);
 	if (xpath_ctx != NULL)
 		xmlXPathFreeContext(xpath_ctx);
-	if (doc != NULL)
-		xmlFreeDoc(doc);
+	if (doc_locked)
+		pthread_mutex_unlock(&cached->lock);
+	if (cached != NULL || xpath != NULL) {
+		pthread_mutex_lock(&g->mutex);
+		if (cached != NULL)
+			doc_unref(cached);
+		if (xpath != NULL)
+			xpath_unref(xpath);
+		pthread_mutex_unlock(&g->mutex);
+	}
 	if (doc_no_ns != NULL)
 		xmlFreeDoc(doc_no_ns);
+	free(path_with_prefix);
 	if (whole_path != NULL)
 		free(whole_path);
 
@@ -352,8 +694,6 @@ int xmlfilecontent_probe_main(probe_ctx *ctx, void *arg)
 	OVAL_FTS    *ofts;
 	OVAL_FTSENT *ofts_ent;
 
-        (void)arg;
-
         probe_in = probe_ctx_getobject(ctx);
 
         path_ent = probe_obj_getent(probe_in, "path", 1);
@@ -389,6 +729,7 @@ int xmlfilecontent_probe_main(probe_ctx *ctx, void *arg)
 
 	pfd.filename_ent = filename_ent;
         pfd.ctx = ctx;
+	pfd.g = arg;
 
 	const char *prefix = getenv("OSCAP_PROBE_ROOT");
 
@@ -26,6 +26,8 @@
 
 #include <math.h>
 #include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
 #include <pcre.h>
 #include <yaml.h>
 #include <yaml-path.h>
@@ -35,6 +37,7 @@
 #include "debug_priv.h"
 #include "oval_fts.h"
 #include "list.h"
+#include "oscap_pcre.h"
 #include "probe/probe.h"
 
 #define OSCAP_YAML_STRING_TAG "tag:yaml.org,2002:str"
@@ -45,24 +48,233 @@
 
 #define OVECCOUNT 30 /* should be a multiple of 3 */
 
+/* Maximum number of the parsed files kept in the cache */
+#define YAMLFILECONTENT_STREAM_CACHE_MAX 8
+
+#if defined(__APPLE__)
+# define ST_MTIME_NSEC(st) ((st)->st_mtimespec.tv_nsec)
+# define ST_CTIME_NSEC(st) ((st)->st_ctimespec.tv_nsec)
+#else
+# define ST_MTIME_NSEC(st) ((st)->st_mtim.tv_nsec)
+# define ST_CTIME_NSEC(st) ((st)->st_ctim.tv_nsec)
+#endif
+
+/*
+ * Events of a parsed YAML document. The events are recorded once per file
+ * and replayed for each yamlpath queried on the file, the file is parsed
+ * again if its stat data changes. Both timestamps are compared with
+ * nanoseconds, a rewrite of the same size within a second would go
+ * unnoticed otherwise.
+ */
+struct yaml_stream {
+	char *path;           /* NULL if not cached */
+	dev_t dev;
+	ino_t ino;
+	off_t size;
+	time_t mtime;
+	long mtime_nsec;
+	time_t ctime;
+	long ctime_nsec;
+	yaml_event_t *events;
+	size_t count;
+	bool error;           /* the parser failed after the last event */
+	char *problem;
+	unsigned int refs;
+	struct yaml_stream *next;
+};
+
+/*
+ * Data shared by all the objects evaluated during the scan, the mutex
+ * protects the cache and the reference counts of the streams.
+ */
+struct yamlfilecontent_global {
+	pthread_mutex_t mutex;
+	struct yaml_stream *streams; /* most recently used first */
+	size_t count;
+};
+
 int yamlfilecontent_probe_offline_mode_supported()
 {
 	return PROBE_OFFLINE_OWN;
 }
 
+void *yamlfilecontent_probe_init(void)
+{
+	struct yamlfilecontent_global *g = malloc(sizeof(struct yamlfilecontent_global));
+
+	pthread_mutex_init(&g->mutex, NULL);
+	g->streams = NULL;
+	g->count = 0;
+
+	return g;
+}
+
+static void yaml_stream_free(struct yaml_stream *stream)
+{
+	for (size_t i = 0; i < stream->count; i++)
+		yaml_event_delete(&stream->events[i]);
+	free(stream->events);
+	free(stream->problem);
+	free(stream->path);
+	free(stream);
+}
+
+void yamlfilecontent_probe_fini(void *arg)
+{
+	struct yamlfilecontent_global *g = arg;
+
+	if (g == NULL)
+		return;
+	while (g->streams != NULL) {
+		struct yaml_stream *stream = g->streams;
+		g->streams = stream->next;
+		yaml_stream_free(stream);
+	}
+	pthread_mutex_destroy(&g->mutex);
+	free(g);
+}
+
+/*
+ * Record all the events of the input, up to the end of the stream or
+ * the first parser error. Returns NULL if the stream can't be allocated,
+ * running out of memory later is reported as a parser error.
+ */
+static struct yaml_stream *yaml_stream_read(yaml_parser_t *parser)
+{
+	struct yaml_stream *stream = calloc(1, sizeof(struct yaml_stream));
+	size_t alloc = 0;
+	yaml_event_t event;
+
+	if (stream == NULL)
+		return NULL;
+	stream->refs = 1;
+	do {
+		if (!yaml_parser_parse(parser, &event)) {
+			stream->error = true;
+			stream->problem = parser->problem ? strdup(parser->problem) : NULL;
+			break;
+		}
+		if (stream->count == alloc) {
+			size_t new_alloc = alloc ? alloc * 2 : 64;
+			yaml_event_t *events = realloc(stream->events, new_alloc * sizeof(yaml_event_t));
+			if (events == NULL) {
+				yaml_event_delete(&event);
+				stream->error = true;
+				stream->problem = strdup("out of memory");
+				break;
+			}
+			stream->events = events;
+			alloc = new_alloc;
+		}
+		stream->events[stream->count++] = event;
+	} while (event.type != YAML_STREAM_END_EVENT);
+
+	return stream;
+}
+
+/*
+ * Find a cached stream and take a reference to it.
+ */
+static struct yaml_stream *yaml_stream_cache_get(struct yamlfilecontent_global *g, const char *path, const struct stat *st)
+{
+	struct yaml_stream *stream, *prev = NULL;
+
+	pthread_mutex_lock(&g->mutex);
+	for (stream = g->streams; stream != NULL; prev = stream, stream = stream->next) {
+		if (strcmp(stream->path, path) != 0)
+			continue;
+		if (stream->dev != st->st_dev || stream->ino != st->st_ino ||
+		    stream->size != st->st_size ||
+		    stream->mtime != st->st_mtime || stream->mtime_nsec != ST_MTIME_NSEC(st) ||
+		    stream->ctime != st->st_ctime || stream->ctime_nsec != ST_CTIME_NSEC(st)) {
+			stream = NULL;
+			break;
+		}
+		if (prev != NULL) {
+			prev->next = stream->next;
+			stream->next = g->streams;
+			g->streams = stream;
+		}
+		stream->refs++;
+		break;
+	}
+	pthread_mutex_unlock(&g->mutex);
+
+	return stream;
+}
+
+static void yaml_stream_unref(struct yaml_stream *stream)
+{
+	if (--stream->refs == 0)
+		yaml_stream_free(stream);
+}
+
+/*
+ * Add the stream to the cache. A stale stream of the same path and the
+ * least recently used stream over the limit are dropped from the cache.
+ * The stream stays private to the caller if its path can't be copied.
+ */
+static void yaml_stream_cache_add(struct yamlfilecontent_global *g, const char *path, const struct stat *st, struct yaml_stream *stream)
+{
+	struct yaml_stream **sp;
+
+	stream->path = strdup(path);
+	if (stream->path == NULL)
+		return;
+	stream->dev = st->st_dev;
+	stream->ino = st->st_ino;
+	stream->size = st->st_size;
+	stream->mtime = st->st_mtime;
+	stream->mtime_nsec = ST_MTIME_NSEC(st);
+	stream->ctime = st->st_ctime;
+	stream->ctime_nsec = ST_CTIME_NSEC(st);
+
+	pthread_mutex_lock(&g->mutex);
+	for (sp = &g->streams; *sp != NULL; sp = &(*sp)->next) {
+		if (strcmp((*sp)->path, path) == 0) {
+			struct yaml_stream *stale = *sp;
+			*sp = stale->next;
+			yaml_stream_unref(stale);
+			--g->count;
+			break;
+		}
+	}
+
+	stream->refs++;
+	stream->next = g->streams;
+	g->streams = stream;
+
+	if (++g->count > YAMLFILECONTENT_STREAM_CACHE_MAX) {
+		for (sp = &g->streams; (*sp)->next != NULL; sp = &(*sp)->next)
+			;
+		struct yaml_stream *lru = *sp;
+		*sp = NULL;
+		yaml_stream_unref(lru);
+		--g->count;
+	}
+	pthread_mutex_unlock(&g->mutex);
+}
+
+static void yaml_stream_release(struct yamlfilecontent_global *g, struct yaml_stream *stream)
+{
+	pthread_mutex_lock(&g->mutex);
+	yaml_stream_unref(stream);
+	pthread_mutex_unlock(&g->mutex);
+}
+
 static bool match_regex(const char *pattern, const char *value)
 {
 	const char *errptr;
 	int erroroffset;
-	pcre *re = pcre_compile(pattern, 0, &errptr, &erroroffset, NULL);
+	struct oscap_pcre *re = oscap_pcre_acquire(pattern, 0, &errptr, &erroroffset);
 	if (re == NULL) {
 		dE("pcre_compile failed on pattern '%s': %s at %d", pattern,
 			errptr, erroroffset);
 		return false;
 	}
 	int ovector[OVECCOUNT];
-	int rc = pcre_exec(re, NULL, value, strlen(value), 0, 0, ovector, OVECCOUNT);
-	pcre_free(re);
+	int rc = oscap_pcre_exec(re, value, strlen(value), 0, 0, ovector, OVECCOUNT);
+	oscap_pcre_release(re);
 	if (rc > 0) {
 		return true;
 	}
@@ -190,7 +402,7 @@ do {                                                                     \
 	ret = -1;                                                            \
 } while (0)
 
-static int yaml_path_query(yaml_parser_t *parser, const char *yaml_path_cstr, struct oscap_list *values, probe_ctx *ctx)
+static int yaml_path_query(const struct yaml_stream *stream, const char *yaml_path_cstr, struct oscap_list *values, probe_ctx *ctx)
 {
 	int ret = 0;
 
@@ -201,7 +413,8 @@ static int yaml_path_query(yaml_parser_t *parser, const char *yaml_path_cstr, st
 		return ret;
 	};
 
-	yaml_event_t event;
+	yaml_parser_t parser;
+	yaml_event_t *event;
 	yaml_event_type_t event_type;
 	bool sequence = false;
 	bool mapping = false;
@@ -211,16 +424,23 @@ static int yaml_path_query(yaml_parser_t *parser, const char *yaml_path_cstr, st
 
 	struct oscap_htable *record = NULL;
 
-	do {
-		if (!yaml_parser_parse(parser, &event)) {
-			result_error("YAML parser error: %s", parser->problem);
-			goto cleanup;
-		}
+	/*
+	 * The events come from the recorded stream rather than from a parser.
+	 * yaml_path_filter_event() keeps its whole state in yaml_path and
+	 * decides on the event it is given only; it doesn't read further
+	 * events from the parser nor take ownership of the event. Replaying
+	 * the recorded events in their original order therefore gives the
+	 * same results as filtering them while parsing, and an initialized
+	 * parser without any input is enough to satisfy the interface.
+	 */
+	yaml_parser_initialize(&parser);
 
-		event_type = event.type;
+	for (size_t i = 0; i < stream->count; i++) {
+		event = &stream->events[i];
+		event_type = event->type;
 
-		if (yaml_path_filter_event(yaml_path, parser, &event) == YAML_PATH_FILTER_RESULT_OUT) {
-			goto next;
+		if (yaml_path_filter_event(yaml_path, &parser, event) == YAML_PATH_FILTER_RESULT_OUT) {
+			continue;
 		}
 
 		if (sequence) {
@@ -290,15 +510,15 @@ static int yaml_path_query(yaml_parser_t *parser, const char *yaml_path_cstr, st
 				if (!sequence) {
 					if (index++ % 2 == 0) {
 						free(key);
-						key = escape_key(strdup((const char *) event.data.scalar.value));
-						goto next;
+						key = escape_key(strdup((const char *) event->data.scalar.value));
+						continue;
 					}
 				}
 			}
 
-			SEXP_t *sexp = yaml_scalar_event_to_sexp(&event);
+			SEXP_t *sexp = yaml_scalar_event_to_sexp(event);
 			if (sexp == NULL) {
-				result_error("Can't convert '%s %s' to SEXP", event.data.scalar.tag, event.data.scalar.value);
+				result_error("Can't convert '%s %s' to SEXP", event->data.scalar.tag, event->data.scalar.value);
 				goto cleanup;
 			}
 
@@ -312,13 +532,14 @@ static int yaml_path_query(yaml_parser_t *parser, const char *yaml_path_cstr, st
 
 			oscap_list_add(field, sexp);
 		}
-next:
-		yaml_event_delete(&event);
-	} while (event_type != YAML_STREAM_END_EVENT);
+	}
+
+	if (stream->error) {
+		result_error("YAML parser error: %s", stream->problem);
+	}
 
 cleanup:
-	if (event.type != 0)
-		yaml_event_delete(&event);
+	yaml_parser_delete(&parser);
 	if (record)
 		oscap_list_add(values, record);
 	free(key);
@@ -337,7 +558,7 @@ static void values_free(struct oscap_htable *record)
 	oscap_htable_free(record, (oscap_destruct_func) record_free);
 }
 
-static int process_yaml(yaml_parser_t *parser, const char *yamlpath, SEXP_t *item, probe_ctx *ctx)
+static int process_yaml(const struct yaml_stream *stream, const char *yamlpath, SEXP_t *item, probe_ctx *ctx)
 {
 	int ret = 0;
 
@@ -346,7 +567,7 @@ static int process_yaml(yaml_parser_t *parser, const char *yamlpath, SEXP_t *ite
 
 	struct oscap_list *values = oscap_list_new();
 
-	if (yaml_path_query(parser, yamlpath, values, ctx)) {
+	if (yaml_path_query(stream, yamlpath, values, ctx)) {
 		ret = -1;
 		goto cleanup;
 	}
@@ -387,23 +608,42 @@ cleanup:
 	return ret;
 }
 
-static int process_yaml_file(const char *prefix, const char *path, const char *filename, const char *yamlpath, probe_ctx *ctx)
+static int process_yaml_file(struct yamlfilecontent_global *g, const char *prefix, const char *path, const char *filename, const char *yamlpath, probe_ctx *ctx)
 {
 	int ret = 0;
-
-	yaml_parser_t parser;
-	yaml_parser_initialize(&parser);
+	struct yaml_stream *stream = NULL;
+	struct stat st;
+	bool cacheable;
 
 	char *filepath = oscap_path_join(path, filename);
 	char *filepath_with_prefix = oscap_path_join(prefix, filepath);
 
-	FILE *yaml_file = fopen(filepath_with_prefix, "r");
-	if (yaml_file == NULL) {
-		result_error("Unable to open file '%s': %s", filepath_with_prefix, strerror(errno));
-		goto cleanup;
-	}
+	/* Files which can't be stat'ed are parsed for this object only */
+	cacheable = stat(filepath_with_prefix, &st) == 0;
+	if (cacheable)
+		stream = yaml_stream_cache_get(g, filepath_with_prefix, &st);
+
+	if (stream == NULL) {
+		FILE *yaml_file = fopen(filepath_with_prefix, "r");
+		if (yaml_file == NULL) {
+			result_error("Unable to open file '%s': %s", filepath_with_prefix, strerror(errno));
+			goto cleanup;
+		}
 
-	yaml_parser_set_input_file(&parser, yaml_file);
+		yaml_parser_t parser;
+		yaml_parser_initialize(&parser);
+		yaml_parser_set_input_file(&parser, yaml_file);
+		stream = yaml_stream_read(&parser);
+		yaml_parser_delete(&parser);
+		fclose(yaml_file);
+		if (stream == NULL) {
+			result_error("Unable to parse file '%s': %s", filepath_with_prefix, strerror(ENOMEM));
+			goto cleanup;
+		}
+
+		if (cacheable)
+			yaml_stream_cache_add(g, filepath_with_prefix, &st, stream);
+	}
 
 	SEXP_t *item = probe_item_create(
 		OVAL_INDEPENDENT_YAML_FILE_CONTENT,
@@ -416,16 +656,15 @@ static int process_yaml_file(const char *prefix, const char *path, const char *f
 		NULL
 	);
 
-	if (process_yaml(&parser, yamlpath, item, ctx)) {
+	if (process_yaml(stream, yamlpath, item, ctx)) {
 		SEXP_free(item);
 		ret = -1;
 		goto cleanup;
 	}
 
 cleanup:
-	if (yaml_file != NULL)
-		fclose(yaml_file);
-	yaml_parser_delete(&parser);
+	if (stream != NULL)
+		yaml_stream_release(g, stream);
 	free(filepath_with_prefix);
 	free(filepath);
 
@@ -439,6 +678,12 @@ static int process_yaml_content(const char *content, const char *yamlpath, probe
 	yaml_parser_t parser;
 	yaml_parser_initialize(&parser);
 	yaml_parser_set_input_string(&parser, (unsigned char *) content, strlen(content));
+	struct yaml_stream *stream = yaml_stream_read(&parser);
+	yaml_parser_delete(&parser);
+	if (stream == NULL) {
+		result_error("Unable to parse YAML content: %s", strerror(ENOMEM));
+		return ret;
+	}
 
 	SEXP_t *item = probe_item_create(
 		OVAL_INDEPENDENT_YAML_FILE_CONTENT,
@@ -448,14 +693,14 @@ static int process_yaml_content(const char *content, const char *yamlpath, probe
 		NULL
 	);
 
-	if (process_yaml(&parser, yamlpath, item, ctx)) {
+	if (process_yaml(stream, yamlpath, item, ctx)) {
 		SEXP_free(item);
 		ret = -1;
 		goto cleanup;
 	}
 
 cleanup:
-	yaml_parser_delete(&parser);
+	yaml_stream_free(stream);
 
 	return ret;
 }
@@ -487,7 +732,7 @@ int yamlfilecontent_probe_main(probe_ctx *ctx, void *arg)
 			while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
 				if (ofts_ent->fts_info == FTS_F
 					|| ofts_ent->fts_info == FTS_SL) {
-					process_yaml_file(prefix, ofts_ent->path, ofts_ent->file,
+					process_yaml_file(arg, prefix, ofts_ent->path, ofts_ent->file,
 						yamlpath_str, ctx);
 				}
 				oval_ftsent_free(ofts_ent);
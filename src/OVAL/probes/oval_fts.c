@@ -33,6 +33,7 @@
 #include <limits.h>
 #include <errno.h>
 #include <pcre.h>
+#include <pthread.h>
 
 #include "oscap_helpers.h"
 #include "fsdev.h"
@@ -40,6 +41,7 @@
 #include "probe/entcmp.h"
 #include "debug_priv.h"
 #include "oval_fts.h"
+#include "common/oscap_pcre.h"
 #if defined(OS_SOLARIS)
 #include "fts_sun.h"
 #include <sys/mntent.h>
@@ -53,6 +55,10 @@
 
 #undef OSCAP_FTS_DEBUG
 
+static void oval_fts_snapshot_discard(OVAL_FTS *ofts);
+static bool oval_fts_match_prefetch(void *arg, const FTSENT *fts_ent);
+static bool oval_fts_recurse_prefetch(void *arg, const FTSENT *fts_ent);
+
 static OVAL_FTS *OVAL_FTS_new()
 {
 	OVAL_FTS *ofts = calloc(1, sizeof(OVAL_FTS));
@@ -67,9 +73,15 @@ static OVAL_FTS *OVAL_FTS_new()
 static void OVAL_FTS_free(OVAL_FTS *ofts)
 {
 	if (ofts->ofts_match_path_fts != NULL)
-		fts_close(ofts->ofts_match_path_fts);
+		pfts_close(ofts->ofts_match_path_fts);
 	if (ofts->ofts_recurse_path_fts != NULL)
-		fts_close(ofts->ofts_recurse_path_fts);
+		pfts_close(ofts->ofts_recurse_path_fts);
+
+	if (ofts->ofts_walk != NULL)
+		oval_fts_snapshot_discard(ofts);
+	free(ofts->ofts_walk_path);
+	free(ofts->ofts_walk_plen);
+	oscap_pcre_release(ofts->ofts_path_regex);
 
 	free(ofts);
 	return;
@@ -90,11 +102,13 @@ static int pathlen_from_ftse(int fts_pathlen, int fts_namelen)
 	return pathlen;
 }
 
-static OVAL_FTSENT *OVAL_FTSENT_new(OVAL_FTS *ofts, FTSENT *fts_ent)
+static OVAL_FTSENT *OVAL_FTSENT_new(OVAL_FTS *ofts, unsigned int fts_info,
+				    const char *fts_path, int fts_pathlen,
+				    const char *fts_name, int fts_namelen)
 {
 	OVAL_FTSENT *ofts_ent = calloc(1, sizeof(OVAL_FTSENT));
 
-	ofts_ent->fts_info = fts_ent->fts_info;
+	ofts_ent->fts_info = fts_info;
 	/* The 'shift' variable stores length of the prefix if the prefix
 	 * is defined, otherwise it is set to 0. The value of 'shift' gives
 	 * us information how many characters of the path string are part of
@@ -103,22 +117,22 @@ static OVAL_FTSENT *OVAL_FTSENT_new(OVAL_FTS *ofts, FTSENT *fts_ent)
 	 */
 	const size_t shift = ofts->prefix ? strlen(ofts->prefix) : 0;
 	if (ofts->ofts_sfilename || ofts->ofts_sfilepath) {
-		ofts_ent->path_len = pathlen_from_ftse(fts_ent->fts_pathlen, fts_ent->fts_namelen) - shift;
+		ofts_ent->path_len = pathlen_from_ftse(fts_pathlen, fts_namelen) - shift;
 		if (ofts_ent->path_len > 0) {
 			ofts_ent->path = malloc(ofts_ent->path_len + 1);
-			strncpy(ofts_ent->path, fts_ent->fts_path + shift, ofts_ent->path_len);
+			strncpy(ofts_ent->path, fts_path + shift, ofts_ent->path_len);
 			ofts_ent->path[ofts_ent->path_len] = '\0';
 		} else {
 			ofts_ent->path_len = 1;
 			ofts_ent->path = strdup("/");
 		}
 
-		ofts_ent->file_len = fts_ent->fts_namelen;
-		ofts_ent->file = strdup(fts_ent->fts_name);
+		ofts_ent->file_len = fts_namelen;
+		ofts_ent->file = strdup(fts_name);
 	} else {
-		ofts_ent->path_len = fts_ent->fts_pathlen - shift;
+		ofts_ent->path_len = fts_pathlen - shift;
 		if (ofts_ent->path_len > 0) {
-			ofts_ent->path = strdup(fts_ent->fts_path + shift);
+			ofts_ent->path = strdup(fts_path + shift);
 		} else {
 			ofts_ent->path_len = 1;
 			ofts_ent->path = strdup("/");
@@ -142,6 +156,389 @@ static void OVAL_FTSENT_free(OVAL_FTSENT *ofts_ent)
 	return;
 }
 
+/*
+ * Recursion walk snapshot
+ *
+ * The entries visited by oval_fts_read_recurse_path() depend only on the
+ * starting directory and the recurse behaviors, not on the filename entity.
+ * A finished walk is kept in the snapshot and OVAL FTS iterators which start
+ * the same walk later replay it instead of reading the filesystem again.
+ * Only the name, level and fts_info of each entry are stored, the paths are
+ * rebuilt from the names during the replay.
+ */
+struct oval_fts_walk_ent {
+	size_t str;        /* offset of the name, or of the whole path at level 0 */
+	size_t str_len;
+	size_t name_len;
+	int level;
+	unsigned short info;
+};
+
+struct oval_fts_walk {
+	char *key;
+	struct oval_fts_walk_ent *ents;
+	size_t count;
+	size_t alloc;
+	char *strs;
+	size_t strs_len;
+	size_t strs_alloc;
+	int following;     /* OVAL_FTS.following at the end of the walk */
+	unsigned int refs;
+	struct oval_fts_walk *next;
+};
+
+static pthread_mutex_t oval_fts_snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int oval_fts_snapshot_refs = 0;
+static size_t oval_fts_snapshot_limit = 0;
+static size_t oval_fts_snapshot_size = 0;
+static struct oval_fts_walk *oval_fts_snapshot_walks = NULL;
+
+static size_t oval_fts_walk_size(const struct oval_fts_walk *walk)
+{
+	return sizeof(struct oval_fts_walk) +
+		walk->alloc * sizeof(struct oval_fts_walk_ent) + walk->strs_alloc;
+}
+
+static void oval_fts_walk_free(struct oval_fts_walk *walk)
+{
+	free(walk->key);
+	free(walk->ents);
+	free(walk->strs);
+	free(walk);
+}
+
+/* drop a reference to a walk, the snapshot lock has to be held */
+static void oval_fts_walk_release_locked(struct oval_fts_walk *walk)
+{
+	if (--walk->refs == 0)
+		oval_fts_walk_free(walk);
+}
+
+static void oval_fts_walk_release(struct oval_fts_walk *walk)
+{
+	pthread_mutex_lock(&oval_fts_snapshot_lock);
+	oval_fts_walk_release_locked(walk);
+	pthread_mutex_unlock(&oval_fts_snapshot_lock);
+}
+
+void oval_fts_snapshot_ref(void)
+{
+	pthread_mutex_lock(&oval_fts_snapshot_lock);
+	if (oval_fts_snapshot_refs++ == 0) {
+		const char *limit = getenv(OVAL_FTS_SNAPSHOT_ENV);
+		unsigned long mib = limit != NULL ? strtoul(limit, NULL, 10) : 0;
+
+		if (mib > (SIZE_MAX >> 20))
+			oval_fts_snapshot_limit = SIZE_MAX;
+		else
+			oval_fts_snapshot_limit = (size_t)mib << 20;
+
+		if (oval_fts_snapshot_limit > 0)
+			dI("Recursion walk snapshot enabled, limit: %lu MiB.", mib);
+	}
+	pthread_mutex_unlock(&oval_fts_snapshot_lock);
+}
+
+void oval_fts_snapshot_unref(void)
+{
+	pthread_mutex_lock(&oval_fts_snapshot_lock);
+	if (oval_fts_snapshot_refs > 0 && --oval_fts_snapshot_refs == 0) {
+		struct oval_fts_walk *walk = oval_fts_snapshot_walks;
+
+		while (walk != NULL) {
+			struct oval_fts_walk *next = walk->next;
+
+			oval_fts_walk_release_locked(walk);
+			walk = next;
+		}
+
+		oval_fts_snapshot_walks = NULL;
+		oval_fts_snapshot_size = 0;
+		oval_fts_snapshot_limit = 0;
+	}
+	pthread_mutex_unlock(&oval_fts_snapshot_lock);
+}
+
+static char *oval_fts_walk_key(OVAL_FTS *ofts, const char *root)
+{
+	return oscap_sprintf("%d:%d:%d:%d:%d:%llu:%s", ofts->direction,
+			     ofts->max_depth, ofts->recurse, ofts->filesystem,
+			     ofts->following,
+			     (unsigned long long)ofts->ofts_recurse_path_devid, root);
+}
+
+/*
+ * Rebuild the path of a walk entry the same way as fts does: the name is
+ * appended to the path of the last entry seen one level up.
+ */
+static const char *oval_fts_walk_path(OVAL_FTS *ofts, const struct oval_fts_walk_ent *ent, size_t *path_len)
+{
+	const char *str = ofts->ofts_walk->strs + ent->str;
+	size_t base = 0;
+
+	if (ent->level < 0 || ent->level > ofts->ofts_walk_depth)
+		return NULL;
+	if (ent->level > 0) {
+		base = ofts->ofts_walk_plen[ent->level - 1];
+		if (base > 0 && ofts->ofts_walk_path[base - 1] == '/')
+			--base;
+	}
+
+	if (ofts->ofts_walk_path_size < base + ent->str_len + 2) {
+		size_t size = (base + ent->str_len + 2) * 2;
+		char *path = realloc(ofts->ofts_walk_path, size);
+
+		if (path == NULL)
+			return NULL;
+		ofts->ofts_walk_path = path;
+		ofts->ofts_walk_path_size = size;
+	}
+	if (ofts->ofts_walk_plen_size <= ent->level) {
+		int size = (ent->level + 1) * 2;
+		size_t *plen = realloc(ofts->ofts_walk_plen, size * sizeof(size_t));
+
+		if (plen == NULL)
+			return NULL;
+		ofts->ofts_walk_plen = plen;
+		ofts->ofts_walk_plen_size = size;
+	}
+
+	if (ent->level > 0)
+		ofts->ofts_walk_path[base++] = '/';
+	memcpy(ofts->ofts_walk_path + base, str, ent->str_len);
+	ofts->ofts_walk_path[base + ent->str_len] = '\0';
+
+	ofts->ofts_walk_plen[ent->level] = base + ent->str_len;
+	ofts->ofts_walk_depth = ent->level + 1;
+
+	*path_len = base + ent->str_len;
+	return ofts->ofts_walk_path;
+}
+
+static void oval_fts_snapshot_discard(OVAL_FTS *ofts)
+{
+	if (ofts->ofts_walk != NULL) {
+		oval_fts_walk_release(ofts->ofts_walk);
+		ofts->ofts_walk = NULL;
+	}
+	ofts->ofts_walk_replay = false;
+}
+
+/* start recording a recursion walk from the given directory */
+static void oval_fts_snapshot_record_start(OVAL_FTS *ofts, const char *root)
+{
+	struct oval_fts_walk *walk;
+
+	pthread_mutex_lock(&oval_fts_snapshot_lock);
+	ofts->ofts_walk_limit = oval_fts_snapshot_limit;
+	pthread_mutex_unlock(&oval_fts_snapshot_lock);
+
+	if (ofts->ofts_walk_limit == 0)
+		return;
+
+	walk = calloc(1, sizeof(struct oval_fts_walk));
+	if (walk == NULL)
+		return;
+	walk->key = oval_fts_walk_key(ofts, root);
+	walk->refs = 1;
+
+	ofts->ofts_walk = walk;
+	ofts->ofts_walk_replay = false;
+	ofts->ofts_walk_depth = 0;
+}
+
+static void oval_fts_snapshot_record(OVAL_FTS *ofts, FTSENT *fts_ent)
+{
+	struct oval_fts_walk *walk = ofts->ofts_walk;
+	struct oval_fts_walk_ent *ent;
+	const char *str, *path;
+	size_t str_len, path_len;
+
+	if (walk == NULL || ofts->ofts_walk_replay)
+		return;
+
+	if (fts_ent->fts_level == 0) {
+		str = fts_ent->fts_path;
+		str_len = fts_ent->fts_pathlen;
+	} else {
+		str = fts_ent->fts_name;
+		str_len = fts_ent->fts_namelen;
+	}
+
+	if (walk->count == walk->alloc) {
+		size_t alloc = walk->alloc > 0 ? walk->alloc * 2 : 1024;
+		struct oval_fts_walk_ent *ents = realloc(walk->ents, alloc * sizeof(struct oval_fts_walk_ent));
+
+		if (ents == NULL)
+			goto discard;
+		walk->ents = ents;
+		walk->alloc = alloc;
+	}
+	if (walk->strs_len + str_len + 1 > walk->strs_alloc) {
+		size_t alloc = (walk->strs_len + str_len + 1) * 2;
+		char *strs = realloc(walk->strs, alloc);
+
+		if (strs == NULL)
+			goto discard;
+		walk->strs = strs;
+		walk->strs_alloc = alloc;
+	}
+	if (oval_fts_walk_size(walk) > ofts->ofts_walk_limit) {
+		dD("The walk from '%s' doesn't fit into the snapshot.", walk->key);
+		goto discard;
+	}
+
+	ent = &walk->ents[walk->count++];
+	ent->str = walk->strs_len;
+	ent->str_len = str_len;
+	ent->name_len = fts_ent->fts_namelen;
+	ent->level = fts_ent->fts_level;
+	ent->info = fts_ent->fts_info;
+	memcpy(walk->strs + walk->strs_len, str, str_len);
+	walk->strs[walk->strs_len + str_len] = '\0';
+	walk->strs_len += str_len + 1;
+
+	/* the replay has to produce exactly what fts returned */
+	path = oval_fts_walk_path(ofts, ent, &path_len);
+	if (path == NULL || path_len != (size_t)fts_ent->fts_pathlen
+	    || memcmp(path, fts_ent->fts_path, path_len) != 0
+	    || ent->name_len > path_len
+	    || memcmp(path + path_len - ent->name_len, fts_ent->fts_name, ent->name_len) != 0) {
+		dD("Can't rebuild the path of '%s', not recording the walk.", fts_ent->fts_path);
+		goto discard;
+	}
+	return;
+discard:
+	oval_fts_snapshot_discard(ofts);
+}
+
+/* the recorded walk reached its end, add it to the snapshot */
+static void oval_fts_snapshot_record_finish(OVAL_FTS *ofts)
+{
+	struct oval_fts_walk *walk = ofts->ofts_walk, *w;
+	size_t size;
+
+	if (walk == NULL || ofts->ofts_walk_replay)
+		return;
+
+	walk->following = ofts->following;
+	size = oval_fts_walk_size(walk);
+
+	pthread_mutex_lock(&oval_fts_snapshot_lock);
+	for (w = oval_fts_snapshot_walks; w != NULL; w = w->next) {
+		if (strcmp(w->key, walk->key) == 0)
+			break;
+	}
+	if (w == NULL && oval_fts_snapshot_refs > 0
+	    && size <= oval_fts_snapshot_limit - oval_fts_snapshot_size) {
+		walk->next = oval_fts_snapshot_walks;
+		oval_fts_snapshot_walks = walk;
+		oval_fts_snapshot_size += size;
+	} else {
+		oval_fts_walk_release_locked(walk);
+	}
+	pthread_mutex_unlock(&oval_fts_snapshot_lock);
+
+	ofts->ofts_walk = NULL;
+}
+
+/* look up a recorded walk for the next recursion, true if it is replayed */
+static bool oval_fts_snapshot_lookup(OVAL_FTS *ofts)
+{
+	struct oval_fts_walk *walk;
+	char *key;
+
+	if (ofts->ofts_walk != NULL)
+		return ofts->ofts_walk_replay;
+	if (ofts->ofts_recurse_path_fts != NULL)
+		return false;
+	if (ofts->direction != OVAL_RECURSE_DIRECTION_DOWN
+	    && (ofts->direction != OVAL_RECURSE_DIRECTION_NONE || ofts->ofts_sfilename == NULL))
+		return false;
+
+	pthread_mutex_lock(&oval_fts_snapshot_lock);
+	if (oval_fts_snapshot_walks == NULL) {
+		pthread_mutex_unlock(&oval_fts_snapshot_lock);
+		return false;
+	}
+	key = oval_fts_walk_key(ofts, ofts->ofts_match_path_fts_ent->fts_path);
+	for (walk = oval_fts_snapshot_walks; walk != NULL; walk = walk->next) {
+		if (strcmp(walk->key, key) == 0) {
+			walk->refs++;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&oval_fts_snapshot_lock);
+	free(key);
+
+	if (walk == NULL)
+		return false;
+
+	ofts->ofts_walk = walk;
+	ofts->ofts_walk_replay = true;
+	ofts->ofts_walk_pos = 0;
+	ofts->ofts_walk_depth = 0;
+
+	return true;
+}
+
+/* compare a file name with the filename entity */
+static bool oval_fts_filename_match(OVAL_FTS *ofts, const char *name)
+{
+	SEXP_t *stmp;
+	bool match = false;
+
+	stmp = SEXP_string_newf("%s", name);
+	switch (probe_entobj_cmp(ofts->ofts_sfilename, stmp)) {
+	case OVAL_RESULT_TRUE:
+		match = true;
+		break;
+	case OVAL_RESULT_ERROR:
+		probe_cobj_set_flag(ofts->result, SYSCHAR_FLAG_ERROR);
+		break;
+	default:
+		break;
+	}
+	SEXP_free(stmp);
+
+	return match;
+}
+
+/* find the next matching file or directory in a recorded walk */
+static OVAL_FTSENT *oval_fts_snapshot_read(OVAL_FTS *ofts)
+{
+	struct oval_fts_walk *walk = ofts->ofts_walk;
+	/* the condition below is correct because ofts_sfilepath is NULL here */
+	bool collect_dirs = (ofts->ofts_sfilename == NULL);
+
+	while (ofts->ofts_walk_pos < walk->count) {
+		const struct oval_fts_walk_ent *ent = &walk->ents[ofts->ofts_walk_pos++];
+		const char *path, *name;
+		size_t path_len;
+
+		path = oval_fts_walk_path(ofts, ent, &path_len);
+		if (path == NULL) {
+			dE("Can't rebuild a path of the recorded walk.");
+			break;
+		}
+		name = path + path_len - ent->name_len;
+
+		if (collect_dirs) {
+			if (ent->info == FTS_D
+			    && (ofts->max_depth == -1 || ent->level <= ofts->max_depth))
+				return OVAL_FTSENT_new(ofts, ent->info, path, path_len, name, ent->name_len);
+		} else {
+			if (ent->info != FTS_D && oval_fts_filename_match(ofts, name))
+				return OVAL_FTSENT_new(ofts, ent->info, path, path_len, name, ent->name_len);
+		}
+	}
+
+	ofts->following = walk->following;
+	oval_fts_snapshot_discard(ofts);
+
+	return NULL;
+}
+
 #if defined(OS_SOLARIS)
 #ifndef MNTTYPE_SMB
 #define MNTTYPE_SMB	"smb"
@@ -381,19 +778,19 @@ static char *extract_fixed_path_prefix(char *path)
 
 static int badpartial_check_slash(const char *pattern)
 {
-	pcre *regex;
+	struct oscap_pcre *regex;
 	const char *errptr = NULL;
 	int errofs = 0, fb, ret;
 
-	regex = pcre_compile(pattern + 1 /* skip '^' */, 0, &errptr, &errofs, NULL);
+	regex = oscap_pcre_acquire(pattern + 1 /* skip '^' */, 0, &errptr, &errofs);
 	if (regex == NULL) {
 		dE("Failed to validate the pattern: pcre_compile(): "
 		   "error: '%s', error offset: %d, pattern: '%s'.\n",
 		   errptr, errofs, pattern);
 		return -1;
 	}
-	ret = pcre_fullinfo(regex, NULL, PCRE_INFO_FIRSTBYTE, &fb);
-	pcre_free(regex);
+	ret = oscap_pcre_fullinfo(regex, PCRE_INFO_FIRSTBYTE, &fb);
+	oscap_pcre_release(regex);
 	regex = NULL;
 	if (ret != 0) {
 		dE("Failed to validate the pattern: pcre_fullinfo(): "
@@ -413,7 +810,7 @@ static int badpartial_check_slash(const char *pattern)
 #define TEST_PATH1 "/"
 #define TEST_PATH2 "x"
 
-static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
+static int badpartial_transform_pattern(char *pattern, struct oscap_pcre **regex_out)
 {
 	/*
 	  PCREPARTIAL(3)
@@ -438,7 +835,7 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 	const char *errptr = NULL;
 	char *s, *brkt_mark;
 	bool bracketed = false, found_regex = false;
-	pcre *regex;
+	struct oscap_pcre *regex;
 
 	/* The processing bellow builds upon the assumption that
 	   the pattern has been validated by pcre_compile() */
@@ -488,7 +885,7 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 	else
 		*s = '\0';
 
-	regex = pcre_compile(pattern, 0, &errptr, &errofs, NULL);
+	regex = oscap_pcre_acquire(pattern, 0, &errptr, &errofs);
 	if (regex == NULL) {
 		dW("Nonfatal failure: can't transform the pattern for partial "
 		   "match optimization, error: '%s', error offset: %d, "
@@ -496,10 +893,10 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 		return -1;
 	}
 
-	ret = pcre_exec(regex, NULL, test_path1, strlen(test_path1), 0,
+	ret = oscap_pcre_exec(regex, test_path1, strlen(test_path1), 0,
 		PCRE_PARTIAL, NULL, 0);
 	if (ret != PCRE_ERROR_PARTIAL && ret < 0) {
-		pcre_free(regex);
+		oscap_pcre_release(regex);
 		dW("Nonfatal failure: can't transform the pattern for partial "
 		   "match optimization, pcre_exec() return code: %d, pattern: "
 		   "'%s'.", ret, pattern);
@@ -508,6 +905,8 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 
 	if (regex_out != NULL)
 		*regex_out = regex;
+	else
+		oscap_pcre_release(regex);
 
 	return 0;
 }
@@ -515,14 +914,14 @@ static int badpartial_transform_pattern(char *pattern, pcre **regex_out)
 /* Verify that the path is usable and try to craft a regex to speed up
    the filesystem traversal. If the path to match is ill-designed, an
    ugly heuristic is employed to obtain something meaningfull. */
-static int process_pattern_match(const char *path, pcre **regex_out)
+static int process_pattern_match(const char *path, struct oscap_pcre **regex_out)
 {
 	int ret, errofs = 0;
 	char *pattern;
 	const char *test_path1 = TEST_PATH1;
 	//const char *test_path2 = TEST_PATH2;
 	const char *errptr = NULL;
-	pcre *regex;
+	struct oscap_pcre *regex;
 
 	if (path[0] != '^') {
 		/* Matching has to have a fixed starting point and thus
@@ -540,7 +939,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		pattern = strdup(path);
 	}
 
-	regex = pcre_compile(pattern, 0, &errptr, &errofs, NULL);
+	regex = oscap_pcre_acquire(pattern, 0, &errptr, &errofs);
 	if (regex == NULL) {
 		dE("Failed to validate the pattern: pcre_compile(): "
 		   "error offset: %d, error: '%s', pattern: '%s'.\n",
@@ -548,7 +947,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		free(pattern);
 		return -1;
 	}
-	ret = pcre_exec(regex, NULL, test_path1, strlen(test_path1), 0,
+	ret = oscap_pcre_exec(regex, test_path1, strlen(test_path1), 0,
 		PCRE_PARTIAL, NULL, 0);
 
 	switch (ret) {
@@ -564,14 +963,14 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 
 		dD("pcre_exec() returned PCRE_ERROR_PARTIAL for pattern '%s' "
 		   "and test path '%s'.\n", pattern, test_path1);
-		ret = pcre_exec(regex, NULL, test_path2, strlen(test_path2),
+		ret = oscap_pcre_exec(regex, test_path2, strlen(test_path2),
 			0, PCRE_PARTIAL, NULL, 0);
 		if (ret == PCRE_ERROR_PARTIAL || ret >= 0) {
 			dE("Failed to validate the pattern: test path '%s' "
 			   "matched by pattern '%s' - the pattern is too "
 			   "general, i.e. inefficient. This could take a "
 			   "lifetime to complete.\n", test_path2, pattern);
-			pcre_free(regex);
+			oscap_pcre_release(regex);
 			free(pattern);
 			return -2;
 		}
@@ -581,7 +980,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		dD("pcre_exec() returned PCRE_ERROR_BADPARTIAL for pattern "
 		   "'%s' and a test path '%s'. Falling back to "
 		   "pcre_fullinfo().\n", pattern, test_path1);
-		pcre_free(regex);
+		oscap_pcre_release(regex);
 		regex = NULL;
 
 		/* Fallback to first byte check to determin if
@@ -605,7 +1004,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		   "PCRE_ERROR_NOMATCH for pattern '%s' and a test path '%s'. "
 		   "This indicates the pattern doesn't match a leading '/'.\n",
 		   pattern, test_path1);
-		pcre_free(regex);
+		oscap_pcre_release(regex);
 		free(pattern);
 		return -2;
 	default:
@@ -619,14 +1018,14 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 			   their OVAL definitions that use ".*" as
 			   'path' and then uncomment this.
 
-			ret = pcre_exec(regex, NULL, test_path2, strlen(test_path2),
+			ret = oscap_pcre_exec(regex, test_path2, strlen(test_path2),
 					0, PCRE_PARTIAL, NULL, 0);
 			if (ret == PCRE_ERROR_PARTIAL || ret >= 0) {
 				dE("Failed to validate the pattern: test path '%s' "
 				   "matched by pattern '%s' - the pattern is too "
 				   "general, i.e. inefficient. This could take a "
 				   "lifetime to complete.\n", test_path2, pattern);
-				pcre_free(regex);
+				oscap_pcre_release(regex);
 				free(pattern);
 				return -2;
 			}
@@ -637,7 +1036,7 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		dE("Failed to validate the pattern: pcre_exec() return "
 		   "code: %d, pattern '%s', test path '%s'.\n", ret,
 		   pattern, test_path1);
-		pcre_free(regex);
+		oscap_pcre_release(regex);
 		free(pattern);
 		return -1;
 	}
@@ -649,6 +1048,8 @@ static int process_pattern_match(const char *path, pcre **regex_out)
 		   "pattern: '%s'.", pattern);
 		if (regex_out != NULL)
 			*regex_out = regex;
+		else
+			oscap_pcre_release(regex);
 	}
 
 	free(pattern);
@@ -685,7 +1086,7 @@ OVAL_FTS *oval_fts_open_prefixed(const char *prefix, SEXP_t *path, SEXP_t *filen
 
 	uint32_t path_op;
 	bool nilfilename = false;
-	pcre *regex = NULL;
+	struct oscap_pcre *regex = NULL;
 	struct stat st;
 
 	if ((path != NULL || filename != NULL || filepath == NULL)
@@ -844,15 +1245,21 @@ OVAL_FTS *oval_fts_open_prefixed(const char *prefix, SEXP_t *path, SEXP_t *filen
 			   errno, strerror(errno));
 		}
 		free((void *) paths[0]);
+		oscap_pcre_release(regex);
 		return NULL;
 	}
 
 	ofts = OVAL_FTS_new();
 	ofts->prefix = prefix;
+	/* set before pfts_open(), the read-ahead threads match against it */
+	ofts->ofts_path_regex = regex;
 
 	/* reset errno as fts_open() doesn't do it itself. */
 	errno = 0;
-	ofts->ofts_match_path_fts = fts_open((char * const *) paths, mtc_fts_options, NULL);
+	/* an exact path is matched by the root itself, nothing to read ahead */
+	ofts->ofts_match_path_fts = pfts_open((char * const *) paths, mtc_fts_options,
+		path_op != OVAL_OPERATION_EQUALS ? pfts_threads() : 0,
+		oval_fts_match_prefetch, ofts);
 	free((void *) paths[0]);
 	/* fts_open() doesn't return NULL for all errors (e.g. nonexistent paths),
 	   so check errno to detect it. Far from being perfect. */
@@ -864,12 +1271,6 @@ OVAL_FTS *oval_fts_open_prefixed(const char *prefix, SEXP_t *path, SEXP_t *filen
 
 	ofts->ofts_recurse_path_fts_opts = rec_fts_options;
 	ofts->ofts_path_op = path_op;
-	if (regex != NULL) {
-		const char *errptr = NULL;
-
-		ofts->ofts_path_regex = regex;
-		ofts->ofts_path_regex_extra = pcre_study(regex, 0, &errptr);
-	}
 
 	if (filesystem == OVAL_RECURSE_FS_LOCAL) {
 #if defined(OS_SOLARIS)
@@ -881,7 +1282,7 @@ OVAL_FTS *oval_fts_open_prefixed(const char *prefix, SEXP_t *path, SEXP_t *filen
 			/* One dummy read to get rid of an uninitialized
 			 * value in the FTS data before calling
 			 * fts_close() on it. */
-			fts_read(ofts->ofts_match_path_fts);
+			pfts_read(ofts->ofts_match_path_fts);
 			oval_fts_close(ofts);
 			return (NULL);
 		}
@@ -890,10 +1291,10 @@ OVAL_FTS *oval_fts_open_prefixed(const char *prefix, SEXP_t *path, SEXP_t *filen
 		/* store the device id for future comparison */
 		FTSENT *fts_ent;
 
-		fts_ent = fts_read(ofts->ofts_match_path_fts);
+		fts_ent = pfts_read(ofts->ofts_match_path_fts);
 		if (fts_ent != NULL) {
 			ofts->ofts_recurse_path_devid = fts_ent->fts_statp->st_dev;
-			fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_AGAIN);
+			pfts_set(ofts->ofts_match_path_fts, fts_ent, FTS_AGAIN);
 		}
 	}
 
@@ -923,7 +1324,7 @@ OVAL_FTS *oval_fts_open_prefixed(const char *prefix, SEXP_t *path, SEXP_t *filen
 	return (ofts);
 }
 
-static inline int _oval_fts_is_local(OVAL_FTS *ofts, FTSENT *fts_ent) {
+static inline int _oval_fts_is_local(OVAL_FTS *ofts, const FTSENT *fts_ent) {
 # if defined(OS_SOLARIS)
 	/* pseudo filesystems will be skipped */
 	/* don't recurse into remote fs if local is specified */
@@ -941,6 +1342,49 @@ static inline int _oval_fts_is_local(OVAL_FTS *ofts, FTSENT *fts_ent) {
 #endif
 }
 
+/*
+ * Read-ahead hints for the pfts walks, called from the read-ahead threads.
+ * They mirror the conditions under which the walks below skip a directory.
+ */
+static bool oval_fts_match_prefetch(void *arg, const FTSENT *fts_ent)
+{
+	OVAL_FTS *ofts = arg;
+
+	if (_oval_fts_is_local(ofts, fts_ent))
+		return false;
+	if (ofts->filesystem == OVAL_RECURSE_FS_DEFINED
+	    && ofts->ofts_recurse_path_devid != fts_ent->fts_statp->st_dev)
+		return false;
+	if (ofts->ofts_path_regex != NULL) {
+		const size_t shift = ofts->prefix ? strlen(ofts->prefix) : 0;
+		int svec[3];
+
+		if (oscap_pcre_exec(ofts->ofts_path_regex,
+			      fts_ent->fts_path+shift, fts_ent->fts_pathlen-shift, 0, PCRE_PARTIAL,
+			      svec, sizeof(svec) / sizeof(svec[0])) == PCRE_ERROR_NOMATCH)
+			return false;
+	}
+
+	return true;
+}
+
+static bool oval_fts_recurse_prefetch(void *arg, const FTSENT *fts_ent)
+{
+	OVAL_FTS *ofts = arg;
+
+	if (ofts->max_depth != -1 && fts_ent->fts_level > ofts->max_depth)
+		return false;
+	if (!(ofts->recurse & OVAL_RECURSE_DIRS))
+		return false;
+	if (_oval_fts_is_local(ofts, fts_ent))
+		return false;
+	if (ofts->filesystem == OVAL_RECURSE_FS_DEFINED
+	    && ofts->ofts_recurse_path_devid != fts_ent->fts_statp->st_dev)
+		return false;
+
+	return true;
+}
+
 /* find the first matching path or filepath */
 static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 {
@@ -950,7 +1394,7 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 
 	/* iterate until a match is found or all elements have been traversed */
 	for (;;) {
-		fts_ent = fts_read(ofts->ofts_match_path_fts);
+		fts_ent = pfts_read(ofts->ofts_match_path_fts);
 		if (fts_ent == NULL)
 			return NULL;
 		switch (fts_ent->fts_info) {
@@ -958,7 +1402,7 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 			continue;
 		case FTS_DC:
 			dW("Filesystem tree cycle detected at '%s'.", fts_ent->fts_path);
-			fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
+			pfts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
 			continue;
 		}
 
@@ -973,19 +1417,19 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 #if defined(OSCAP_FTS_DEBUG)
 			dD("Only the target of a symlink gets reported, skipping '%s'.", fts_ent->fts_path, fts_ent->fts_name);
 #endif
-			fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_FOLLOW);
+			pfts_set(ofts->ofts_match_path_fts, fts_ent, FTS_FOLLOW);
 			continue;
 		}
 		if (_oval_fts_is_local(ofts, fts_ent)) {
 			dI("Don't recurse into non-local filesystems, skipping '%s'.", fts_ent->fts_path);
-			fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+			pfts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
 			continue;
 		}
 		/* don't recurse beyond the initial filesystem */
 		if (ofts->filesystem == OVAL_RECURSE_FS_DEFINED
 		    && (fts_ent->fts_info == FTS_D || fts_ent->fts_info == FTS_SL)
 		    && ofts->ofts_recurse_path_devid != fts_ent->fts_statp->st_dev) {
-			fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+			pfts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
 			continue;
 		}
 
@@ -994,14 +1438,14 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 		if (ofts->ofts_path_regex != NULL && fts_ent->fts_info == FTS_D) {
 			int ret, svec[3];
 
-			ret = pcre_exec(ofts->ofts_path_regex, ofts->ofts_path_regex_extra,
+			ret = oscap_pcre_exec(ofts->ofts_path_regex,
 					fts_ent->fts_path+shift, fts_ent->fts_pathlen-shift, 0, PCRE_PARTIAL,
 					svec, sizeof(svec) / sizeof(svec[0]));
 			if (ret < 0) {
 				switch (ret) {
 				case PCRE_ERROR_NOMATCH:
 					dD("Partial match optimization: PCRE_ERROR_NOMATCH, skipping.");
-					fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
+					pfts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
 					continue;
 				case PCRE_ERROR_PARTIAL:
 					dD("Partial match optimization: PCRE_ERROR_PARTIAL, continuing.");
@@ -1050,7 +1494,7 @@ static FTSENT *oval_fts_read_match_path(OVAL_FTS *ofts)
 	    ofts->ofts_sfilename == NULL &&
 	    ofts->ofts_sfilepath == NULL)
 	{
-		fts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
+		pfts_set(ofts->ofts_match_path_fts, fts_ent, FTS_SKIP);
 	}
 
 	return fts_ent;
@@ -1085,8 +1529,10 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 #endif
 			/* reset errno as fts_open() doesn't do it itself. */
 			errno = 0;
-			ofts->ofts_recurse_path_fts = fts_open(paths,
-				ofts->ofts_recurse_path_fts_opts, NULL);
+			ofts->ofts_recurse_path_fts = pfts_open(paths,
+				ofts->ofts_recurse_path_fts_opts,
+				ofts->direction == OVAL_RECURSE_DIRECTION_DOWN ? pfts_threads() : 0,
+				oval_fts_recurse_prefetch, ofts);
 			/* fts_open() doesn't return NULL for all errors
 			   (e.g. nonexistent paths), so check errno to detect it.
 			   Far from being perfect. */
@@ -1098,20 +1544,23 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 					paths[0], ofts->ofts_recurse_path_fts_opts);
 #endif
 				if (ofts->ofts_recurse_path_fts != NULL) {
-					fts_close(ofts->ofts_recurse_path_fts);
+					pfts_close(ofts->ofts_recurse_path_fts);
 					ofts->ofts_recurse_path_fts = NULL;
 				}
 				return (NULL);
 			}
+
+			oval_fts_snapshot_record_start(ofts, paths[0]);
 		}
 
 		/* iterate until a match is found or all elements have been traversed */
 		while (out_fts_ent == NULL) {
 			FTSENT *fts_ent;
 
-			fts_ent = fts_read(ofts->ofts_recurse_path_fts);
+			fts_ent = pfts_read(ofts->ofts_recurse_path_fts);
 			if (fts_ent == NULL) {
-				fts_close(ofts->ofts_recurse_path_fts);
+				oval_fts_snapshot_record_finish(ofts);
+				pfts_close(ofts->ofts_recurse_path_fts);
 				ofts->ofts_recurse_path_fts = NULL;
 
 				return NULL;
@@ -1122,7 +1571,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				continue;
 			case FTS_DC:
 				dW("Filesystem tree cycle detected at '%s'.", fts_ent->fts_path);
-				fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+				pfts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 				continue;
 			}
 
@@ -1132,6 +1581,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 			   "fts_info: %u.\n", fts_ent->fts_path, fts_ent->fts_pathlen,
 			   fts_ent->fts_name, fts_ent->fts_namelen, fts_ent->fts_info);
 #endif
+			oval_fts_snapshot_record(ofts, fts_ent);
 
 			/* collect matching target */
 			if (collect_dirs) {
@@ -1139,33 +1589,16 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				    && (ofts->max_depth == -1 || fts_ent->fts_level <= ofts->max_depth))
 					out_fts_ent = fts_ent;
 			} else {
-				if (fts_ent->fts_info != FTS_D) {
-					SEXP_t *stmp;
-
-					stmp = SEXP_string_newf("%s", fts_ent->fts_name);
-					oval_result_t result = probe_entobj_cmp(ofts->ofts_sfilename, stmp);
-					switch (result){
-						case OVAL_RESULT_TRUE:
-							out_fts_ent = fts_ent;
-							break;
-
-						case OVAL_RESULT_ERROR:
-							probe_cobj_set_flag(ofts->result, SYSCHAR_FLAG_ERROR);
-							break;
-
-						default:
-							break;
-					}
-
-					SEXP_free(stmp);
-				}
+				if (fts_ent->fts_info != FTS_D
+				    && oval_fts_filename_match(ofts, fts_ent->fts_name))
+					out_fts_ent = fts_ent;
 			}
 
 			if (fts_ent->fts_level > 0) { /* don't skip fts root */
 				/* limit recursion depth */
 				if (ofts->direction == OVAL_RECURSE_DIRECTION_NONE
 				    || (ofts->max_depth != -1 && fts_ent->fts_level > ofts->max_depth)) {
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+					pfts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 					continue;
 				}
 
@@ -1173,17 +1606,17 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				switch (fts_ent->fts_info) {
 				case FTS_D:
 					if (!(ofts->recurse & OVAL_RECURSE_DIRS) && !(ofts->recurse & OVAL_RECURSE_SYMLINKS && ofts->following)) {
-						fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+						pfts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 						continue;
 					}
 					ofts->following = 0;
 					break;
 				case FTS_SL:
 					if (!(ofts->recurse & OVAL_RECURSE_SYMLINKS)) {
-						fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+						pfts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 						continue;
 					}
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
+					pfts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
 					ofts->following = 1;
 					break;
 				default:
@@ -1191,14 +1624,14 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				}
 			}
 			if (_oval_fts_is_local(ofts, fts_ent)) {
-				fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+				pfts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 				continue;
 			}
 			/* don't recurse beyond the initial filesystem */
 			if (ofts->filesystem == OVAL_RECURSE_FS_DEFINED
 			    && (fts_ent->fts_info == FTS_D || fts_ent->fts_info == FTS_SL)
 			    && ofts->ofts_recurse_path_devid != fts_ent->fts_statp->st_dev) {
-				fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+				pfts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 				continue;
 			}
 		}
@@ -1225,8 +1658,8 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				/* fts_open() doesn't return NULL for all errors
 				   (e.g. nonexistent paths), so check errno to
 				   detect it. Far from being perfect. */
-				ofts->ofts_recurse_path_fts = fts_open(paths,
-					ofts->ofts_recurse_path_fts_opts, NULL);
+				ofts->ofts_recurse_path_fts = pfts_open(paths,
+					ofts->ofts_recurse_path_fts_opts, 0, NULL, NULL);
 				if (ofts->ofts_recurse_path_fts == NULL || errno != 0) {
 					dE("fts_open() failed, errno: %d \"%s\".",
 						errno, strerror(errno));
@@ -1235,7 +1668,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 						paths[0], ofts->ofts_recurse_path_fts_opts);
 #endif
 					if (ofts->ofts_recurse_path_fts != NULL) {
-						fts_close(ofts->ofts_recurse_path_fts);
+						pfts_close(ofts->ofts_recurse_path_fts);
 						ofts->ofts_recurse_path_fts = NULL;
 					}
 					return (NULL);
@@ -1246,7 +1679,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 			while (out_fts_ent == NULL) {
 				FTSENT *fts_ent;
 
-				fts_ent = fts_read(ofts->ofts_recurse_path_fts);
+				fts_ent = pfts_read(ofts->ofts_recurse_path_fts);
 				if (fts_ent == NULL)
 					break;
 
@@ -1280,7 +1713,7 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 					/* only fts root is collected */
 					if (fts_ent->fts_level == 0 && fts_ent->fts_info == FTS_D) {
 						out_fts_ent = fts_ent;
-						fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+						pfts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 						break;
 					}
 				} else {
@@ -1295,16 +1728,16 @@ static FTSENT *oval_fts_read_recurse_path(OVAL_FTS *ofts)
 				}
 
 				if (fts_ent->fts_info == FTS_SL)
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
+					pfts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_FOLLOW);
 				/* limit recursion only to fts root */
 				else if (fts_ent->fts_level > 0)
-					fts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
+					pfts_set(ofts->ofts_recurse_path_fts, fts_ent, FTS_SKIP);
 			}
 
 			if (out_fts_ent != NULL)
 				break;
 
-			fts_close(ofts->ofts_recurse_path_fts);
+			pfts_close(ofts->ofts_recurse_path_fts);
 			ofts->ofts_recurse_path_fts = NULL;
 
 			if (!strcmp(ofts->ofts_recurse_path_curpth, "/"))
@@ -1354,9 +1787,16 @@ OVAL_FTSENT *oval_fts_read(OVAL_FTS *ofts)
 			}
 			break;
 		} else {
-			fts_ent = oval_fts_read_recurse_path(ofts);
-			if (fts_ent != NULL)
-				break;
+			if (oval_fts_snapshot_lookup(ofts)) {
+				OVAL_FTSENT *ofts_ent = oval_fts_snapshot_read(ofts);
+
+				if (ofts_ent != NULL)
+					return ofts_ent;
+			} else {
+				fts_ent = oval_fts_read_recurse_path(ofts);
+				if (fts_ent != NULL)
+					break;
+			}
 
 			ofts->ofts_match_path_fts_ent = NULL;
 
@@ -1367,7 +1807,9 @@ OVAL_FTSENT *oval_fts_read(OVAL_FTS *ofts)
 		}
 	}
 
-	return OVAL_FTSENT_new(ofts, fts_ent);
+	return OVAL_FTSENT_new(ofts, fts_ent->fts_info,
+			       fts_ent->fts_path, fts_ent->fts_pathlen,
+			       fts_ent->fts_name, fts_ent->fts_namelen);
 }
 
 void oval_ftsent_free(OVAL_FTSENT *ofts_ent)
@@ -1380,11 +1822,6 @@ int oval_fts_close(OVAL_FTS *ofts)
 	if (ofts->ofts_recurse_path_pthcpy != NULL)
 		free(ofts->ofts_recurse_path_pthcpy);
 
-	if (ofts->ofts_path_regex)
-		pcre_free(ofts->ofts_path_regex);
-	if (ofts->ofts_path_regex_extra)
-		pcre_free(ofts->ofts_path_regex_extra);
-
 	if (ofts->ofts_spath != NULL)
 		SEXP_free(ofts->ofts_spath);
 	if (ofts->ofts_sfilename != NULL)
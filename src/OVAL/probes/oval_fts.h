@@ -24,6 +24,9 @@
 
 #include "oscap_platforms.h"
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #include <sexp.h>
 #if defined(OS_SOLARIS) || defined(OS_AIX)
 #include "fts_sun.h"
@@ -32,6 +35,7 @@
 #endif
 #include <pcre.h>
 #include "fsdev.h"
+#include "pfts.h"
 
 #define ENT_GET_AREF(ent, dst, attr_name, mandatory)			\
 	do {								\
@@ -68,18 +72,17 @@
 
 typedef struct {
 	/* oval_fts_read_match_path() state */
-	FTS *ofts_match_path_fts;
+	PFTS *ofts_match_path_fts;
 	FTSENT *ofts_match_path_fts_ent;
 	/* oval_fts_read_recurse_path() state */
-	FTS *ofts_recurse_path_fts;
+	PFTS *ofts_recurse_path_fts;
 	int ofts_recurse_path_fts_opts;
 	int ofts_recurse_path_curdepth;
 	char *ofts_recurse_path_pthcpy;
 	char *ofts_recurse_path_curpth;
 	dev_t ofts_recurse_path_devid;
 
-	pcre       *ofts_path_regex;
-	pcre_extra *ofts_path_regex_extra;
+	struct oscap_pcre *ofts_path_regex;
 	uint32_t ofts_path_op;
 
 	SEXP_t *ofts_spath;
@@ -95,6 +98,17 @@ typedef struct {
 
 	fsdev_t *localdevs;
 	const char *prefix;
+
+	/* recursion walk snapshot state, see oval_fts_snapshot_ref() */
+	struct oval_fts_walk *ofts_walk;
+	bool ofts_walk_replay;
+	size_t ofts_walk_pos;
+	size_t ofts_walk_limit;
+	char *ofts_walk_path;
+	size_t ofts_walk_path_size;
+	size_t *ofts_walk_plen;
+	int ofts_walk_plen_size;
+	int ofts_walk_depth;
 } OVAL_FTS;
 
 #define OVAL_RECURSE_DIRECTION_NONE 0 /* default */
@@ -108,6 +122,9 @@ typedef struct {
 #define OVAL_RECURSE_SYMLINKS_AND_DIRS (OVAL_RECURSE_SYMLINKS|OVAL_RECURSE_DIRS) /* default */
 #define OVAL_RECURSE_FILES_AND_DIRS    (OVAL_RECURSE_FILES|OVAL_RECURSE_SYMLINKS)
 
+/* maximum size of the recursion walk snapshot in MiB, disabled when unset */
+#define OVAL_FTS_SNAPSHOT_ENV "OSCAP_PROBE_FTS_SNAPSHOT"
+
 #define OVAL_RECURSE_FS_LOCAL   0
 #define OVAL_RECURSE_FS_DEFINED 1
 #define OVAL_RECURSE_FS_ALL     2 /* default */
@@ -130,4 +147,14 @@ int          oval_fts_close(OVAL_FTS *ofts);
 
 void oval_ftsent_free(OVAL_FTSENT *ofts_ent);
 
+/*
+ * The recursion walks done by OVAL FTS iterators are recorded and replayed
+ * by later iterators with the same starting directory and behaviors while
+ * at least one reference to the snapshot is held. The snapshot is enabled
+ * by the OSCAP_PROBE_FTS_SNAPSHOT environment variable and it is dropped
+ * when the last reference goes away.
+ */
+void oval_fts_snapshot_ref(void);
+void oval_fts_snapshot_unref(void);
+
 #endif /* OVAL_FTS_H */
@@ -0,0 +1,764 @@
+/**
+ * @file   pfts.c
+ * @brief  fts with parallel directory read-ahead
+ */
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * The walk itself is done by the thread calling pfts_read() in the same
+ * order as fts_read() would do it. Listing a directory and calling lstat()
+ * on its entries is the expensive part, so each directory found is put on
+ * a shared stack from which the worker threads take the directories and
+ * read them ahead of the walk. The stack makes the workers follow the
+ * depth-first order of the walk. When the walk enters a directory which
+ * hasn't been read yet, it reads it itself, or waits for the worker which
+ * is reading it. Directories which are skipped by the walk are dropped
+ * together with everything read ahead below them.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include "debug_priv.h"
+#include "pfts.h"
+
+/* maximum number of directories read ahead and not entered yet */
+#define PFTS_READAHEAD   1024
+#define PFTS_THREADS_MAX 64
+
+#define PFTS_OPTIONS (FTS_PHYSICAL | FTS_NOCHDIR | FTS_COMFOLLOW | FTS_XDEV)
+
+#define ISDOT(a) (a[0] == '.' && (!a[1] || (a[1] == '.' && !a[2])))
+
+struct pfts_list;
+
+struct pfts_ent {
+	struct pfts_list *list;   /* listing of the directory if scheduled */
+	bool prefetch;
+	struct stat st;
+	FTSENT fts;               /* has to be the last member, fts_name and fts_path follow it */
+};
+
+#define PFTS_LIST_NEW     0
+#define PFTS_LIST_QUEUED  1
+#define PFTS_LIST_READING 2
+#define PFTS_LIST_DONE    3
+
+struct pfts_list {
+	unsigned int refs;
+	int state;
+	bool cancelled;
+	bool entered;             /* entered by the walk, not counted as read-ahead */
+	int error;                /* errno of opendir() or of reading the listing */
+	char *path;
+	size_t pathlen;
+	short level;
+	dev_t dev;
+	ino_t ino;
+	struct pfts_list *parent;
+	struct pfts_ent **ents;
+	size_t count;
+	struct pfts_list *next;   /* stack of the directories to read */
+};
+
+struct pfts_frame {
+	struct pfts_ent *dir;
+	struct pfts_list *list;
+	size_t idx;
+};
+
+struct pfts {
+	FTS *fts;                 /* plain fts walk */
+	int options;
+	pfts_prefetch_t prefetch;
+	void *arg;
+
+	struct pfts_ent *root;
+	struct pfts_ent *cur;
+	dev_t rootdev;
+	bool started;
+	bool finished;
+
+	struct pfts_frame *frames;
+	size_t nframes;
+	size_t aframes;
+
+	unsigned int nthreads;
+	unsigned int running;
+	bool spawned;
+	pthread_t *threads;
+
+	pthread_mutex_t lock;
+	pthread_cond_t work;
+	pthread_cond_t done;
+	struct pfts_list *stack;
+	size_t ready;
+	bool stop;
+};
+
+static struct pfts_ent *pfts_ent_new(const char *path, size_t pathlen,
+				     const char *name, size_t namelen, short level)
+{
+	struct pfts_ent *ent;
+	size_t size;
+
+	size = offsetof(struct pfts_ent, fts.fts_name) + namelen + 1 + pathlen + 1;
+	if (size < sizeof(struct pfts_ent))
+		size = sizeof(struct pfts_ent);
+
+	ent = calloc(1, size);
+	if (ent == NULL)
+		return NULL;
+
+	memcpy(ent->fts.fts_name, name, namelen);
+	ent->fts.fts_name[namelen] = '\0';
+	ent->fts.fts_path = ent->fts.fts_name + namelen + 1;
+	memcpy(ent->fts.fts_path, path, pathlen);
+	ent->fts.fts_path[pathlen] = '\0';
+
+	ent->fts.fts_accpath = ent->fts.fts_path;
+	ent->fts.fts_pathlen = pathlen;
+	ent->fts.fts_namelen = namelen;
+	ent->fts.fts_level = level;
+	ent->fts.fts_instr = FTS_NOINSTR;
+	ent->fts.fts_statp = &ent->st;
+
+	return ent;
+}
+
+/* is the directory one of the directories the walk is in */
+static bool pfts_cycle(PFTS *pfts, const struct pfts_ent *ent)
+{
+	for (size_t i = 0; i < pfts->nframes; ++i) {
+		const FTSENT *dir = &pfts->frames[i].dir->fts;
+
+		if (dir->fts_dev == ent->fts.fts_dev && dir->fts_ino == ent->fts.fts_ino)
+			return true;
+	}
+	return false;
+}
+
+/* same as fts_stat(), cycles are checked only when called from the walk */
+static unsigned short pfts_stat(PFTS *pfts, struct pfts_ent *ent, bool follow)
+{
+	struct stat *sbp = &ent->st;
+
+	if (follow) {
+		if (stat(ent->fts.fts_accpath, sbp) != 0) {
+			int saved_errno = errno;
+
+			if (lstat(ent->fts.fts_accpath, sbp) == 0) {
+				errno = 0;
+				return FTS_SLNONE;
+			}
+			ent->fts.fts_errno = saved_errno;
+			goto err;
+		}
+	} else if (lstat(ent->fts.fts_accpath, sbp) != 0) {
+		ent->fts.fts_errno = errno;
+err:
+		memset(sbp, 0, sizeof(struct stat));
+		return FTS_NS;
+	}
+
+	if (S_ISDIR(sbp->st_mode)) {
+		ent->fts.fts_dev = sbp->st_dev;
+		ent->fts.fts_ino = sbp->st_ino;
+		ent->fts.fts_nlink = sbp->st_nlink;
+
+		if (ISDOT(ent->fts.fts_name))
+			return FTS_DOT;
+		if (pfts != NULL && pfts_cycle(pfts, ent))
+			return FTS_DC;
+		return FTS_D;
+	}
+	if (S_ISLNK(sbp->st_mode))
+		return FTS_SL;
+	if (S_ISREG(sbp->st_mode))
+		return FTS_F;
+	return FTS_DEFAULT;
+}
+
+static struct pfts_list *pfts_list_new(struct pfts_ent *dir, struct pfts_list *parent)
+{
+	struct pfts_list *list = calloc(1, sizeof(struct pfts_list));
+
+	if (list == NULL)
+		return NULL;
+
+	list->path = strdup(dir->fts.fts_path);
+	if (list->path == NULL) {
+		free(list);
+		return NULL;
+	}
+	list->pathlen = dir->fts.fts_pathlen;
+	list->level = dir->fts.fts_level;
+	list->dev = dir->fts.fts_dev;
+	list->ino = dir->fts.fts_ino;
+	list->refs = 1;
+	list->state = PFTS_LIST_NEW;
+	if (parent != NULL) {
+		list->parent = parent;
+		parent->refs++;
+	}
+
+	return list;
+}
+
+static void pfts_list_cancel(PFTS *pfts, struct pfts_list *list);
+
+/* free the entries of a listing, the lock has to be held */
+static void pfts_list_release(PFTS *pfts, struct pfts_list *list)
+{
+	for (size_t i = 0; i < list->count; ++i) {
+		struct pfts_ent *ent = list->ents[i];
+
+		if (ent->list != NULL)
+			pfts_list_cancel(pfts, ent->list);
+		free(ent);
+	}
+	free(list->ents);
+	list->ents = NULL;
+	list->count = 0;
+}
+
+static void pfts_list_unref(PFTS *pfts, struct pfts_list *list)
+{
+	while (list != NULL && --list->refs == 0) {
+		struct pfts_list *parent = list->parent;
+
+		pfts_list_release(pfts, list);
+		free(list->path);
+		free(list);
+		list = parent;
+	}
+}
+
+/* drop the owner's reference, the lock has to be held */
+static void pfts_list_cancel(PFTS *pfts, struct pfts_list *list)
+{
+	list->cancelled = true;
+	if (list->state == PFTS_LIST_DONE) {
+		if (!list->entered) {
+			pfts->ready--;
+			pthread_cond_broadcast(&pfts->work);
+		}
+		pfts_list_release(pfts, list);
+	}
+	pfts_list_unref(pfts, list);
+}
+
+/* list a directory and stat its entries like fts_build() does */
+static void pfts_list_read(struct pfts_list *list)
+{
+	DIR *dir;
+	struct dirent *de;
+	char *path = NULL;
+	size_t path_size = 0, alloc = 0;
+	size_t base = list->pathlen;
+
+	if (base > 0 && list->path[base - 1] == '/')
+		--base;
+
+	dir = opendir(list->path);
+	if (dir == NULL) {
+		list->error = errno != 0 ? errno : EIO;
+		return;
+	}
+
+	for (;;) {
+		struct pfts_ent *ent;
+		size_t namelen, pathlen;
+
+		errno = 0;
+		de = readdir(dir);
+		if (de == NULL) {
+			list->error = errno;
+			break;
+		}
+		if (ISDOT(de->d_name))
+			continue;
+
+		namelen = strlen(de->d_name);
+		pathlen = base + 1 + namelen;
+		if (pathlen + 1 > path_size) {
+			char *tmp = realloc(path, pathlen + 1 + 256);
+
+			if (tmp == NULL) {
+				list->error = ENOMEM;
+				break;
+			}
+			path = tmp;
+			path_size = pathlen + 1 + 256;
+		}
+		memcpy(path, list->path, base);
+		path[base] = '/';
+		memcpy(path + base + 1, de->d_name, namelen + 1);
+
+		if (list->count == alloc) {
+			size_t n = alloc > 0 ? alloc * 2 : 32;
+			struct pfts_ent **ents = realloc(list->ents, n * sizeof(struct pfts_ent *));
+
+			if (ents == NULL) {
+				list->error = ENOMEM;
+				break;
+			}
+			list->ents = ents;
+			alloc = n;
+		}
+
+		ent = pfts_ent_new(path, pathlen, de->d_name, namelen, list->level + 1);
+		if (ent == NULL) {
+			list->error = ENOMEM;
+			break;
+		}
+		ent->fts.fts_info = pfts_stat(NULL, ent, false);
+		list->ents[list->count++] = ent;
+	}
+
+	closedir(dir);
+	free(path);
+
+	/* an incomplete listing is reported as unreadable, not as a shorter one */
+	if (list->error != 0) {
+		for (size_t i = 0; i < list->count; ++i)
+			free(list->ents[i]);
+		free(list->ents);
+		list->ents = NULL;
+		list->count = 0;
+	}
+}
+
+/* decide which subdirectories are worth reading ahead */
+static void pfts_list_mark(PFTS *pfts, struct pfts_list *list)
+{
+	if (pfts->nthreads == 0)
+		return;
+
+	for (size_t i = 0; i < list->count; ++i) {
+		struct pfts_ent *ent = list->ents[i];
+		const struct pfts_list *l;
+
+		if (ent->fts.fts_info != FTS_D)
+			continue;
+		if ((pfts->options & FTS_XDEV) && ent->fts.fts_dev != pfts->rootdev)
+			continue;
+		for (l = list; l != NULL; l = l->parent) {
+			if (l->dev == ent->fts.fts_dev && l->ino == ent->fts.fts_ino)
+				break;
+		}
+		if (l != NULL)
+			continue;
+		if (pfts->prefetch != NULL && !pfts->prefetch(pfts->arg, &ent->fts))
+			continue;
+		ent->prefetch = true;
+	}
+}
+
+/* the listing was read, the lock has to be held */
+static void pfts_list_done(PFTS *pfts, struct pfts_list *list)
+{
+	bool pushed = false;
+
+	list->state = PFTS_LIST_DONE;
+	pthread_cond_broadcast(&pfts->done);
+
+	if (list->cancelled) {
+		pfts_list_release(pfts, list);
+		return;
+	}
+	if (!list->entered)
+		pfts->ready++;
+
+	/* push in the reverse order, the first subdirectory is read first */
+	for (size_t i = list->count; i > 0; --i) {
+		struct pfts_ent *ent = list->ents[i - 1];
+		struct pfts_list *child;
+
+		if (!ent->prefetch)
+			continue;
+		child = pfts_list_new(ent, list);
+		if (child == NULL)
+			continue;
+		child->state = PFTS_LIST_QUEUED;
+		child->refs++;
+		child->next = pfts->stack;
+		pfts->stack = child;
+		ent->list = child;
+		pushed = true;
+	}
+	if (pushed)
+		pthread_cond_broadcast(&pfts->work);
+}
+
+static void *pfts_worker(void *arg)
+{
+	PFTS *pfts = arg;
+
+#if defined(HAVE_PTHREAD_SETNAME_NP)
+# if defined(OS_APPLE)
+	pthread_setname_np("pfts_worker");
+# else
+	pthread_setname_np(pthread_self(), "pfts_worker");
+# endif
+#endif
+
+	pthread_mutex_lock(&pfts->lock);
+	for (;;) {
+		struct pfts_list *list;
+
+		while (!pfts->stop && (pfts->stack == NULL || pfts->ready >= PFTS_READAHEAD))
+			pthread_cond_wait(&pfts->work, &pfts->lock);
+		if (pfts->stop)
+			break;
+
+		list = pfts->stack;
+		pfts->stack = list->next;
+		list->next = NULL;
+
+		if (list->cancelled || list->state != PFTS_LIST_QUEUED) {
+			pfts_list_unref(pfts, list);
+			continue;
+		}
+
+		list->state = PFTS_LIST_READING;
+		pthread_mutex_unlock(&pfts->lock);
+
+		pfts_list_read(list);
+		pfts_list_mark(pfts, list);
+
+		pthread_mutex_lock(&pfts->lock);
+		pfts_list_done(pfts, list);
+		pfts_list_unref(pfts, list);
+	}
+	pthread_mutex_unlock(&pfts->lock);
+
+	return NULL;
+}
+
+static void pfts_spawn(PFTS *pfts)
+{
+	int saved_errno = errno;
+
+	pfts->spawned = true;
+	pfts->threads = calloc(pfts->nthreads, sizeof(pthread_t));
+	if (pfts->threads == NULL)
+		return;
+
+	for (unsigned int i = 0; i < pfts->nthreads; ++i) {
+		if (pthread_create(&pfts->threads[pfts->running], NULL, pfts_worker, pfts) != 0) {
+			dW("Can't start a read-ahead thread, continuing with %u.", pfts->running);
+			break;
+		}
+		pfts->running++;
+	}
+	errno = saved_errno;
+}
+
+/* get the listing of a directory the walk is entering */
+static struct pfts_list *pfts_enter(PFTS *pfts, struct pfts_ent *dir)
+{
+	struct pfts_list *list;
+
+	if (pfts->nthreads > 0 && !pfts->spawned)
+		pfts_spawn(pfts);
+
+	pthread_mutex_lock(&pfts->lock);
+	list = dir->list;
+	if (list == NULL) {
+		list = pfts_list_new(dir, pfts->nframes > 0 ? pfts->frames[pfts->nframes - 1].list : NULL);
+		if (list == NULL) {
+			pthread_mutex_unlock(&pfts->lock);
+			return NULL;
+		}
+		dir->list = list;
+	}
+
+	if (list->state == PFTS_LIST_DONE && !list->entered) {
+		pfts->ready--;
+		pthread_cond_broadcast(&pfts->work);
+	}
+	list->entered = true;
+
+	if (list->state == PFTS_LIST_NEW || list->state == PFTS_LIST_QUEUED) {
+		/* a queued listing is skipped by the workers from now on */
+		list->state = PFTS_LIST_READING;
+		pthread_mutex_unlock(&pfts->lock);
+
+		pfts_list_read(list);
+		pfts_list_mark(pfts, list);
+
+		pthread_mutex_lock(&pfts->lock);
+		pfts_list_done(pfts, list);
+	}
+	while (list->state != PFTS_LIST_DONE)
+		pthread_cond_wait(&pfts->done, &pfts->lock);
+	pthread_mutex_unlock(&pfts->lock);
+
+	return list;
+}
+
+/* the walk won't enter the directory (again) */
+static void pfts_drop(PFTS *pfts, struct pfts_ent *ent)
+{
+	if (ent->list == NULL)
+		return;
+
+	pthread_mutex_lock(&pfts->lock);
+	pfts_list_cancel(pfts, ent->list);
+	ent->list = NULL;
+	pthread_mutex_unlock(&pfts->lock);
+}
+
+static FTSENT *pfts_emit(PFTS *pfts, struct pfts_ent *ent)
+{
+	if (ent->fts.fts_info == FTS_D && pfts_cycle(pfts, ent)) {
+		ent->fts.fts_info = FTS_DC;
+		pfts_drop(pfts, ent);
+	}
+	pfts->cur = ent;
+
+	return &ent->fts;
+}
+
+PFTS *pfts_open(char * const *paths, int options, unsigned int threads,
+		pfts_prefetch_t prefetch, void *arg)
+{
+	PFTS *pfts;
+	const char *path, *name;
+	size_t pathlen;
+
+	pfts = calloc(1, sizeof(PFTS));
+	if (pfts == NULL)
+		return NULL;
+
+	if (threads == 0 || paths[0] == NULL || paths[1] != NULL
+	    || (options & ~PFTS_OPTIONS) != 0
+	    || !(options & FTS_PHYSICAL) || !(options & FTS_NOCHDIR)) {
+		pfts->fts = fts_open(paths, options, NULL);
+		if (pfts->fts == NULL) {
+			free(pfts);
+			return NULL;
+		}
+		return pfts;
+	}
+
+	path = paths[0];
+	pathlen = strlen(path);
+	if (pathlen == 0) {
+		free(pfts);
+		errno = ENOENT;
+		return NULL;
+	}
+	/* the name of a root is its last path component, see fts_load() */
+	name = strrchr(path, '/');
+	if (name != NULL && (name != path || name[1] != '\0'))
+		++name;
+	else
+		name = path;
+
+	pfts->root = pfts_ent_new(path, pathlen, name, strlen(name), FTS_ROOTLEVEL);
+	if (pfts->root == NULL) {
+		free(pfts);
+		return NULL;
+	}
+	pfts->root->fts.fts_info = pfts_stat(pfts, pfts->root, options & FTS_COMFOLLOW);
+	pfts->rootdev = pfts->root->fts.fts_dev;
+
+	pfts->options = options;
+	pfts->prefetch = prefetch;
+	pfts->arg = arg;
+	pfts->nthreads = threads > PFTS_THREADS_MAX ? PFTS_THREADS_MAX : threads;
+	pthread_mutex_init(&pfts->lock, NULL);
+	pthread_cond_init(&pfts->work, NULL);
+	pthread_cond_init(&pfts->done, NULL);
+
+	return pfts;
+}
+
+FTSENT *pfts_read(PFTS *pfts)
+{
+	struct pfts_ent *cur;
+	int instr;
+
+	if (pfts->fts != NULL)
+		return fts_read(pfts->fts);
+
+	if (pfts->finished)
+		return NULL;
+	if (!pfts->started) {
+		pfts->started = true;
+		pfts->cur = pfts->root;
+		return &pfts->root->fts;
+	}
+
+	cur = pfts->cur;
+	instr = cur->fts.fts_instr;
+	cur->fts.fts_instr = FTS_NOINSTR;
+
+	if (instr == FTS_AGAIN) {
+		cur->fts.fts_info = pfts_stat(pfts, cur, false);
+		return &cur->fts;
+	}
+	if (instr == FTS_FOLLOW
+	    && (cur->fts.fts_info == FTS_SL || cur->fts.fts_info == FTS_SLNONE)) {
+		cur->fts.fts_info = pfts_stat(pfts, cur, true);
+		return &cur->fts;
+	}
+
+	if (cur->fts.fts_info == FTS_D) {
+		if (instr == FTS_SKIP
+		    || ((pfts->options & FTS_XDEV) && cur->fts.fts_dev != pfts->rootdev)) {
+			pfts_drop(pfts, cur);
+		} else {
+			struct pfts_list *list = pfts_enter(pfts, cur);
+
+			if (list == NULL) {
+				pfts->finished = true;
+				return NULL;
+			}
+			if (list->error != 0) {
+				cur->fts.fts_errno = list->error;
+				cur->fts.fts_info = FTS_DNR;
+				pfts_drop(pfts, cur);
+				return &cur->fts;
+			}
+			if (list->count > 0) {
+				if (pfts->nframes == pfts->aframes) {
+					size_t n = pfts->aframes > 0 ? pfts->aframes * 2 : 16;
+					struct pfts_frame *frames = realloc(pfts->frames, n * sizeof(struct pfts_frame));
+
+					if (frames == NULL) {
+						pfts->finished = true;
+						return NULL;
+					}
+					pfts->frames = frames;
+					pfts->aframes = n;
+				}
+				pfts->frames[pfts->nframes].dir = cur;
+				pfts->frames[pfts->nframes].list = list;
+				pfts->frames[pfts->nframes].idx = 0;
+				pfts->nframes++;
+
+				return pfts_emit(pfts, list->ents[0]);
+			}
+			pfts_drop(pfts, cur);
+		}
+	}
+
+	/* move to the next entry, leaving the finished directories */
+	while (pfts->nframes > 0) {
+		struct pfts_frame *frame = &pfts->frames[pfts->nframes - 1];
+
+		if (++frame->idx < frame->list->count)
+			return pfts_emit(pfts, frame->list->ents[frame->idx]);
+
+		pfts->nframes--;
+		pfts_drop(pfts, frame->dir);
+	}
+
+	pfts->finished = true;
+	pfts->cur = NULL;
+	errno = 0;
+
+	return NULL;
+}
+
+int pfts_set(PFTS *pfts, FTSENT *fts_ent, int instr)
+{
+	if (pfts->fts != NULL)
+		return fts_set(pfts->fts, fts_ent, instr);
+
+	if (instr != FTS_NOINSTR && instr != FTS_AGAIN
+	    && instr != FTS_FOLLOW && instr != FTS_SKIP) {
+		errno = EINVAL;
+		return 1;
+	}
+	fts_ent->fts_instr = instr;
+
+	return 0;
+}
+
+int pfts_close(PFTS *pfts)
+{
+	int ret = 0;
+
+	if (pfts == NULL)
+		return 0;
+
+	if (pfts->fts != NULL) {
+		ret = fts_close(pfts->fts);
+		free(pfts);
+		return ret;
+	}
+
+	pthread_mutex_lock(&pfts->lock);
+	pfts->stop = true;
+	pthread_cond_broadcast(&pfts->work);
+	pthread_mutex_unlock(&pfts->lock);
+
+	for (unsigned int i = 0; i < pfts->running; ++i)
+		pthread_join(pfts->threads[i], NULL);
+
+	pthread_mutex_lock(&pfts->lock);
+	while (pfts->stack != NULL) {
+		struct pfts_list *list = pfts->stack;
+
+		pfts->stack = list->next;
+		pfts_list_unref(pfts, list);
+	}
+	if (pfts->root->list != NULL)
+		pfts_list_cancel(pfts, pfts->root->list);
+	pthread_mutex_unlock(&pfts->lock);
+
+	pthread_cond_destroy(&pfts->done);
+	pthread_cond_destroy(&pfts->work);
+	pthread_mutex_destroy(&pfts->lock);
+
+	free(pfts->root);
+	free(pfts->frames);
+	free(pfts->threads);
+	free(pfts);
+
+	return ret;
+}
+
+unsigned int pfts_threads(void)
+{
+	const char *threads = getenv(PFTS_THREADS_ENV);
+	unsigned long n;
+
+	if (threads == NULL)
+		return 0;
+
+	n = strtoul(threads, NULL, 10);
+
+	return n > PFTS_THREADS_MAX ? PFTS_THREADS_MAX : (unsigned int)n;
+}
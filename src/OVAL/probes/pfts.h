@@ -0,0 +1,88 @@
+/**
+ * @file   pfts.h
+ * @brief  fts with parallel directory read-ahead
+ */
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#pragma once
+#ifndef PFTS_H
+#define PFTS_H
+
+#include <stdbool.h>
+#include "oscap_platforms.h"
+#if defined(OS_SOLARIS) || defined(OS_AIX)
+#include "fts_sun.h"
+#else
+#include <fts.h>
+#endif
+
+/**
+ * Number of read-ahead threads used by the OVAL FTS walks, the plain
+ * fts walker is used when unset or 0.
+ */
+#define PFTS_THREADS_ENV "OSCAP_PROBE_FTS_THREADS"
+
+/**
+ * Walk handle, a wrapper around FTS.
+ */
+typedef struct pfts PFTS;
+
+/**
+ * Read-ahead hint called from the worker threads for each directory found.
+ * Return false if the directory is not going to be entered by the walk.
+ * The callback has to be thread safe, it mustn't modify the entry.
+ */
+typedef bool (*pfts_prefetch_t)(void *arg, const FTSENT *fts_ent);
+
+/**
+ * Open a walk, the arguments are the same as for fts_open().
+ * With threads > 0, a single root path and the FTS_PHYSICAL|FTS_NOCHDIR
+ * options (optionally with FTS_COMFOLLOW and FTS_XDEV), the directories are
+ * read ahead by the given number of threads. The entries are still returned
+ * in the order of fts_read(), except that the post-order FTS_DP entries
+ * aren't returned at all. Otherwise fts_open() is used.
+ * @param prefetch optional read-ahead hint
+ * @param arg argument of the read-ahead hint
+ */
+PFTS *pfts_open(char * const *paths, int options, unsigned int threads,
+		pfts_prefetch_t prefetch, void *arg);
+
+/**
+ * Read the next entry, see fts_read().
+ */
+FTSENT *pfts_read(PFTS *pfts);
+
+/**
+ * Set an instruction for the entry returned last, see fts_set().
+ * FTS_AGAIN, FTS_FOLLOW and FTS_SKIP are supported.
+ */
+int pfts_set(PFTS *pfts, FTSENT *fts_ent, int instr);
+
+/**
+ * Close the walk and free all the entries.
+ */
+int pfts_close(PFTS *pfts);
+
+/**
+ * Number of read-ahead threads requested by OSCAP_PROBE_FTS_THREADS.
+ */
+unsigned int pfts_threads(void);
+
+#endif /* PFTS_H */
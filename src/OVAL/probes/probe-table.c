@@ -250,16 +250,16 @@ static const probe_table_entry_t probe_table[] = {
 	{OVAL_INDEPENDENT_XML_FILE_CONTENT, xmlfilecontent_probe_init, xmlfilecontent_probe_main, xmlfilecontent_probe_fini, xmlfilecontent_probe_offline_mode_supported},
 #endif
 #ifdef OPENSCAP_PROBE_INDEPENDENT_YAMLFILECONTENT
-	{OVAL_INDEPENDENT_YAML_FILE_CONTENT, NULL, yamlfilecontent_probe_main, NULL, yamlfilecontent_probe_offline_mode_supported},
+	{OVAL_INDEPENDENT_YAML_FILE_CONTENT, yamlfilecontent_probe_init, yamlfilecontent_probe_main, yamlfilecontent_probe_fini, yamlfilecontent_probe_offline_mode_supported},
 #endif
 #ifdef OPENSCAP_PROBE_LINUX_DPKGINFO
 	{OVAL_LINUX_DPKG_INFO, dpkginfo_probe_init, dpkginfo_probe_main, dpkginfo_probe_fini, dpkginfo_probe_offline_mode_supported},
 #endif
 #ifdef OPENSCAP_PROBE_LINUX_IFLISTENERS
-	{OVAL_LINUX_IFLISTENERS, NULL, iflisteners_probe_main, NULL, NULL},
+	{OVAL_LINUX_IFLISTENERS, iflisteners_probe_init, iflisteners_probe_main, iflisteners_probe_fini, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_LINUX_INETLISTENINGSERVERS
-	{OVAL_LINUX_INET_LISTENING_SERVERS, NULL, inetlisteningservers_probe_main, NULL, NULL},
+	{OVAL_LINUX_INET_LISTENING_SERVERS, inetlisteningservers_probe_init, inetlisteningservers_probe_main, inetlisteningservers_probe_fini, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_LINUX_PARTITION
 	{OVAL_LINUX_PARTITION, NULL, partition_probe_main, NULL, patition_probe_offline_mode_supported},
@@ -283,10 +283,10 @@ static const probe_table_entry_t probe_table[] = {
 	{OVAL_LINUX_SELINUXSECURITYCONTEXT, NULL, selinuxsecuritycontext_probe_main, NULL, selinuxsecuritycontext_probe_offline_mode_supported},
 #endif
 #ifdef OPENSCAP_PROBE_LINUX_SYSTEMDUNITDEPENDENCY
-	{OVAL_LINUX_SYSTEMDUNITDEPENDENCY, NULL, systemdunitdependency_probe_main, NULL, systemdunitdependency_probe_offline_mode_supported},
+	{OVAL_LINUX_SYSTEMDUNITDEPENDENCY, systemdunitdependency_probe_init, systemdunitdependency_probe_main, systemdunitdependency_probe_fini, systemdunitdependency_probe_offline_mode_supported},
 #endif
 #ifdef OPENSCAP_PROBE_LINUX_SYSTEMDUNITPROPERTY
-	{OVAL_LINUX_SYSTEMDUNITPROPERTY, NULL, systemdunitproperty_probe_main, NULL, systemdunitproperty_probe_offline_mode_supported},
+	{OVAL_LINUX_SYSTEMDUNITPROPERTY, systemdunitproperty_probe_init, systemdunitproperty_probe_main, systemdunitproperty_probe_fini, systemdunitproperty_probe_offline_mode_supported},
 #endif
 #ifdef OPENSCAP_PROBE_SOLARIS_ISAINFO
 	{OVAL_SOLARIS_ISAINFO, NULL, isainfo_probe_main, NULL, NULL},
@@ -310,10 +310,10 @@ static const probe_table_entry_t probe_table[] = {
 	{OVAL_UNIX_PASSWORD, NULL, password_probe_main, NULL, password_probe_offline_mode_supported},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_PROCESS
-	{OVAL_UNIX_PROCESS, NULL, process_probe_main, NULL, NULL},
+	{OVAL_UNIX_PROCESS, process_probe_init, process_probe_main, process_probe_fini, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_PROCESS58
-	{OVAL_UNIX_PROCESS58, NULL, process58_probe_main, NULL, process58_probe_offline_mode_supported},
+	{OVAL_UNIX_PROCESS58, process58_probe_init, process58_probe_main, process58_probe_fini, process58_probe_offline_mode_supported},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_ROUTINGTABLE
 	{OVAL_UNIX_ROUTINGTABLE, NULL, routingtable_probe_main, NULL, NULL},
@@ -328,7 +328,7 @@ static const probe_table_entry_t probe_table[] = {
 	{OVAL_UNIX_SYMLINK, NULL, symlink_probe_main, NULL, symlink_probe_offline_mode_supported},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_SYSCTL
-	{OVAL_UNIX_SYSCTL, NULL, sysctl_probe_main, NULL, NULL},
+	{OVAL_UNIX_SYSCTL, sysctl_probe_init, sysctl_probe_main, sysctl_probe_fini, NULL},
 #endif
 #ifdef OPENSCAP_PROBE_UNIX_UNAME
 	{OVAL_UNIX_UNAME, NULL, uname_probe_main, NULL, NULL},
@@ -382,6 +382,32 @@ probe_offline_mode_function_t probe_table_get_offline_mode_function(oval_subtype
 	return entry->probe_offline_mode_function;
 }
 
+int probe_table_get_max_inflight(oval_subtype_t type)
+{
+	/*
+	 * Only the probes whose main function keeps no state between the
+	 * requests may evaluate several objects at once. The others get one
+	 * request at a time.
+	 *
+	 * The rpmverify probes stay serial: all requests share the rpm
+	 * transaction set and database iterators of the probe, which librpm
+	 * doesn't allow to be used from several threads, so the whole
+	 * collection runs under the probe mutex and the requests in flight
+	 * would only wait for it.
+	 */
+	switch (type) {
+	case OVAL_INDEPENDENT_FILE_HASH:
+	case OVAL_INDEPENDENT_FILE_HASH58:
+	case OVAL_INDEPENDENT_TEXT_FILE_CONTENT:
+	case OVAL_INDEPENDENT_TEXT_FILE_CONTENT_54:
+	case OVAL_INDEPENDENT_ENVIRONMENT_VARIABLE58:
+	case OVAL_UNIX_SYMLINK:
+		return PROBE_TABLE_MAXINFLIGHT;
+	default:
+		return 1;
+	}
+}
+
 void probe_table_list(FILE *output)
 {
 	const probe_table_entry_t *entry = probe_table;
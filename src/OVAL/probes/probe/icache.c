@@ -488,36 +488,55 @@ int probe_icache_nop(probe_icache_t *cache)
 }
 
 #define PROBE_RESULT_MEMCHECK_CTRESHOLD  1000  /* item count */
+#define PROBE_RESULT_MEMCHECK_INTERVAL    256  /* item count between two samples */
 
 /**
  * Returns 0 if the memory constraints are not reached. Otherwise, 1 is returned.
  * In case of an error, -1 is returned.
+ *
+ * Reading the memory usage means parsing procfs, so it is sampled only once
+ * per PROBE_RESULT_MEMCHECK_INTERVAL items and the result of the last sample
+ * is returned in between. Once the limit is reached no more items are added,
+ * the item count stops growing and the result stays in effect for the rest
+ * of the collected object.
  */
-static int probe_cobj_memcheck(size_t item_cnt, double max_ratio)
+static int probe_cobj_memcheck(struct probe_ctx *ctx, size_t item_cnt)
 {
-	if (item_cnt > PROBE_RESULT_MEMCHECK_CTRESHOLD) {
-		struct proc_memusage mu_proc;
-		struct sys_memusage  mu_sys;
-		double c_ratio;
+	if (item_cnt <= PROBE_RESULT_MEMCHECK_CTRESHOLD)
+		return (0);
 
-		if (oscap_proc_memusage (&mu_proc) != 0)
-			return (-1);
+	if (item_cnt < ctx->memcheck_next)
+		return (ctx->memcheck_ret);
+
+	struct proc_memusage mu_proc;
+	struct sys_memusage  mu_sys;
+	double c_ratio;
+
+	ctx->memcheck_next = item_cnt + PROBE_RESULT_MEMCHECK_INTERVAL;
+	ctx->memcheck_ret  = 0;
+
+	if (oscap_proc_memusage (&mu_proc) != 0)
+		return (-1);
 
+	/* the total amount of memory doesn't change during the collection */
+	if (ctx->memcheck_total == 0) {
 		if (oscap_sys_memusage (&mu_sys) != 0)
 			return (-1);
+		ctx->memcheck_total = mu_sys.mu_total;
+	}
 
-		c_ratio = (double)mu_proc.mu_rss/(double)(mu_sys.mu_total);
-
-		if (c_ratio > max_ratio) {
-			dW("Memory usage ratio limit reached! limit=%f, current=%f, used=%ld MB, free=%ld MB, total=%ld MB, count of items=%ld",
-			max_ratio, c_ratio, mu_proc.mu_rss / 1024, mu_sys.mu_realfree / 1024, mu_sys.mu_total / 1024, item_cnt);
-			errno = ENOMEM;
-			return (1);
-		}
+	c_ratio = (double)mu_proc.mu_rss/(double)(ctx->memcheck_total);
 
+	if (c_ratio > ctx->max_mem_ratio || (ctx->max_mem_rss > 0 && mu_proc.mu_rss > ctx->max_mem_rss)) {
+		if (oscap_sys_memusage (&mu_sys) != 0)
+			return (-1);
+		dW("Memory usage limit reached! ratio limit=%f, current=%f, limit=%zu MB, used=%zu MB, free=%zu MB, total=%zu MB, count of items=%zu",
+		ctx->max_mem_ratio, c_ratio, ctx->max_mem_rss / 1024, mu_proc.mu_rss / 1024, mu_sys.mu_realfree / 1024, mu_sys.mu_total / 1024, item_cnt);
+		errno = ENOMEM;
+		ctx->memcheck_ret = 1;
 	}
 
-	return (0);
+	return (ctx->memcheck_ret);
 }
 
 /**
@@ -549,7 +568,7 @@ int probe_item_collect(struct probe_ctx *ctx, SEXP_t *item)
 	cobj_itemcnt = SEXP_list_length(cobj_content);
 	SEXP_free(cobj_content);
 
-	memcheck_ret = probe_cobj_memcheck(cobj_itemcnt, ctx->max_mem_ratio);
+	memcheck_ret = probe_cobj_memcheck(ctx, cobj_itemcnt);
 	if (memcheck_ret == -1) {
 		dE("Failed to check available memory");
 		return -1;
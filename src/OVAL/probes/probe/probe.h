@@ -83,7 +83,11 @@ struct probe_ctx {
         SEXP_t         *filters;   /**< object filters (OVAL 5.8 and higher) */
         probe_icache_t *icache;    /**< item cache */
 	int offline_mode;
-	double max_mem_ratio;
+	double max_mem_ratio;      /**< limit of process RSS to total memory ratio */
+	size_t max_mem_rss;        /**< limit of process RSS in kB, 0 if not set */
+	size_t memcheck_next;      /**< item count at which the memory usage is sampled next */
+	size_t memcheck_total;     /**< total system memory in kB, 0 until sampled */
+	int    memcheck_ret;       /**< result of the last memory usage sample */
 };
 
 typedef enum {
@@ -59,6 +59,19 @@
 #include "probe_main.h"
 #include "seap-descriptor.h"
 #include "probe-table.h"
+#ifndef OS_WINDOWS
+#include "oval_fts.h"
+#endif
+#if defined(OPENSCAP_PROBE_LINUX_RPMINFO) || defined(OPENSCAP_PROBE_LINUX_RPMVERIFY) || \
+    defined(OPENSCAP_PROBE_LINUX_RPMVERIFYFILE) || defined(OPENSCAP_PROBE_LINUX_RPMVERIFYPACKAGE)
+#include "unix/linux/rpm-helper.h"
+#define PROBE_RPM_SNAPSHOT
+#endif
+#if defined(OS_LINUX) && (defined(OPENSCAP_PROBE_UNIX_PROCESS) || defined(OPENSCAP_PROBE_UNIX_PROCESS58) || \
+    defined(OPENSCAP_PROBE_LINUX_IFLISTENERS) || defined(OPENSCAP_PROBE_LINUX_INETLISTENINGSERVERS))
+#include "unix/proc-snapshot.h"
+#define PROBE_PROC_SNAPSHOT
+#endif
 
 static int fail(int err, const char *who, int line)
 {
@@ -91,6 +104,14 @@ static SEXP_t *probe_reset(SEXP_t *arg0, void *arg1)
 
         probe->rcache = probe_rcache_new();
         probe->ncache = probe_ncache_new();
+#if defined(PROBE_RPM_SNAPSHOT)
+	/* the packages may have changed since the snapshot was read */
+	rpm_snapshot_invalidate();
+#endif
+#if defined(PROBE_PROC_SNAPSHOT)
+	/* and so may have the processes */
+	proc_snapshot_invalidate();
+#endif
 
         return(NULL);
 }
@@ -160,6 +181,9 @@ static void probe_common_main_cleanup(void *arg)
 	if (fini_function != NULL) {
 		fini_function(probe->probe_arg);
 	}
+#ifndef OS_WINDOWS
+	oval_fts_snapshot_unref();
+#endif
 
 	probe_rcache_free(probe->rcache);
 	probe_icache_free(probe->icache);
@@ -248,6 +272,10 @@ void *probe_common_main(void *arg)
 	if (init_function != NULL) {
 		probe.probe_arg = init_function();
 	}
+#ifndef OS_WINDOWS
+	/* keep the recursion walk snapshot while the probe is running */
+	oval_fts_snapshot_ref();
+#endif
 
 	pthread_cleanup_push(probe_common_main_cleanup, (void *) &probe);
 
@@ -25,6 +25,7 @@
 #endif
 
 #include "_seap.h"
+#include "_sexp-arena.h"
 #include <stdio.h>
 #include <fcntl.h>
 #include <stdlib.h>
@@ -55,6 +56,8 @@ extern int chroot(const char *);
 /* default max. memory usage ratio - used/total */
 /* can be overridden by environment variable OSCAP_PROBE_MEMORY_USAGE_RATIO */
 #define OSCAP_PROBE_MEMORY_USAGE_RATIO_DEFAULT 0.33
+/* absolute limit in MiB, set by environment variable OSCAP_PROBE_MEMORY_LIMIT */
+#define OSCAP_PROBE_MEMORY_LIMIT_DEFAULT 0
 
 extern bool  OSCAP_GSYM(varref_handling);
 extern void *OSCAP_GSYM(probe_arg);
@@ -1065,6 +1068,7 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 	} else {
                 struct probe_ctx pctx;
 		SEXP_t *varrefs, *mask;
+		SEXP_arena_t *arena = NULL;
 
 		pctx.offline_mode = probe->selected_offline_mode;
 
@@ -1075,6 +1079,16 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 			if (max_ratio > 0)
 				pctx.max_mem_ratio = max_ratio;
 		}
+		pctx.max_mem_rss = OSCAP_PROBE_MEMORY_LIMIT_DEFAULT;
+		char *max_rss_str = getenv("OSCAP_PROBE_MEMORY_LIMIT");
+		if (max_rss_str != NULL) {
+			unsigned long long max_rss = strtoull(max_rss_str, NULL, 10);
+			if (max_rss > 0)
+				pctx.max_mem_rss = (size_t) max_rss * 1024;
+		}
+		pctx.memcheck_next = 0;
+		pctx.memcheck_total = 0;
+		pctx.memcheck_ret = 0;
 
 		/* simple object */
                 pctx.icache  = probe->icache;
@@ -1090,6 +1104,16 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 		probe_main_function_t probe_main_function = probe_table_get_main_function(subtype);
 		const char *subtype_str = oval_subtype_get_text(subtype);
 
+		/*
+		 * Optionally carve the values created while collecting the items
+		 * from an arena. The collected items may outlive it in the caches,
+		 * an arena chunk is released when the last value in it is freed,
+		 * so it's opt-in: short-lived values sharing a chunk with an item
+		 * stay allocated as long as the item.
+		 */
+		if (getenv("OSCAP_PROBE_ARENA") != NULL)
+			arena = SEXP_arena_new();
+
 		if (varrefs == NULL || !OSCAP_GSYM(varref_handling)) {
                         /*
                          * Prepare the collected object
@@ -1111,7 +1135,9 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 
 
 			dI("I will run %s_probe_main:", subtype_str);
+			SEXP_arena_bind(arena);
 			*ret = probe_main_function(&pctx, probe->probe_arg);
+			SEXP_arena_bind(NULL);
 
 			pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, &__unused_oldstate);
 
@@ -1135,6 +1161,7 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 				SEXP_free(pctx.filters);
 				SEXP_free(probe_in);
 				SEXP_free(mask);
+				SEXP_arena_free(arena);
 				*ret = PROBE_EUNKNOWN;
 				return (NULL);
 			}
@@ -1154,7 +1181,9 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
                                  * Run the main function of the probe implementation
                                  */
 			dI("I will run %s_probe_main:", subtype_str);
+			SEXP_arena_bind(arena);
 			*ret = probe_main_function(&pctx, probe->probe_arg);
+			SEXP_arena_bind(NULL);
 
                                 /*
                                  * Synchronize
@@ -1174,6 +1203,7 @@ SEXP_t *probe_worker(probe_t *probe, SEAP_msg_t *msg_in, int *ret)
 		}
 
                 SEXP_free(pctx.filters);
+		SEXP_arena_free(arena);
 	}
 
 	SEXP_free(probe_in);
@@ -27,6 +27,9 @@
 #include <stdio.h>
 #include "probe-api.h"
 
+/* Maximal number of requests sent to a probe which supports pipelining */
+#define PROBE_TABLE_MAXINFLIGHT 32
+
 typedef void *(*probe_init_function_t)(void);
 typedef int (*probe_main_function_t)(probe_ctx *ctx, void *arg);
 typedef void (*probe_fini_function_t)(void *probe_arg);
@@ -36,6 +39,7 @@ OSCAP_API probe_init_function_t probe_table_get_init_function(oval_subtype_t typ
 OSCAP_API probe_main_function_t probe_table_get_main_function(oval_subtype_t type);
 OSCAP_API probe_fini_function_t probe_table_get_fini_function(oval_subtype_t type);
 OSCAP_API probe_offline_mode_function_t probe_table_get_offline_mode_function(oval_subtype_t type);
+OSCAP_API int probe_table_get_max_inflight(oval_subtype_t type);
 
 OSCAP_API void probe_table_list(FILE *output);
 OSCAP_API int probe_table_size(void);
@@ -2,9 +2,11 @@
  * Author: Pierre Chifflier <chifflier@edenwall.com>
  */
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <iostream>
+#include <vector>
 #include <stdlib.h>
 
 #include <apt-pkg/init.h>
@@ -13,7 +15,6 @@
 #include <apt-pkg/fileutl.h>
 #include <apt-pkg/mmap.h>
 #include <apt-pkg/pkgcache.h>
-#include <apt-pkg/pkgrecords.h>
 #include <apt-pkg/pkgsystem.h>
 #include <apt-pkg/cachefile.h>
 
@@ -26,6 +27,20 @@ static pkgCacheFile *cgCache = NULL;
 
 static MMap *dpkg_mmap = NULL;
 
+/*
+ * Installed package of any architecture. The entries are sorted by name,
+ * the package of the native architecture first, then by the architecture
+ * of the package, which may differ from the arch of its version ("all").
+ */
+struct dpkginfo_entry {
+        struct dpkginfo_reply_t *reply;
+        string pkg_arch;
+        bool native;
+};
+
+/* Read-only once built */
+static vector<struct dpkginfo_entry> pkg_index;
+
 static int opencache (void) {
         if (pkgInitConfig (*_config) == false) return 0;
 
@@ -47,29 +62,10 @@ static int opencache (void) {
         return 1;
 }
 
-struct dpkginfo_reply_t * dpkginfo_get_by_name(const char *name, int *err)
+static struct dpkginfo_reply_t *dpkginfo_reply_new(pkgCache::PkgIterator &Pkg, pkgCache::VerIterator &V1)
 {
-        pkgCache &cache = *cgCache->GetPkgCache();
-        pkgRecords Recs (cache);
         struct dpkginfo_reply_t *reply = NULL;
 
-        // Locate the package
-        pkgCache::PkgIterator Pkg = cache.FindPkg(name);
-        if (Pkg.end() == true) {
-                /* not found, clear error flag */
-                if (err) *err = 0;
-                return NULL;
-        }
-
-        pkgCache::VerIterator V1 = Pkg.CurrentVer();
-        if (V1.end() == true) {
-                /* not installed, clear error flag */
-                /* FIXME this should be different that not found */
-                if (err) *err = 0;
-                return NULL;
-        }
-        pkgRecords::Parser &P = Recs.Lookup(V1.FileList());
-
         /* split epoch, version and release */
         string evr = V1.VerStr();
         string epoch, version, release;
@@ -112,14 +108,107 @@ struct dpkginfo_reply_t * dpkginfo_get_by_name(const char *name, int *err)
         return reply;
 }
 
-void dpkginfo_free_reply(struct dpkginfo_reply_t *reply)
+static void dpkginfo_free_reply(struct dpkginfo_reply_t *reply)
 {
         if (reply) {
                 free(reply->name);
+                free(reply->arch);
+                free(reply->epoch);
+                free(reply->release);
+                free(reply->version);
+                free(reply->evr);
                 delete reply;
         }
 }
 
+static bool dpkginfo_name_less(const struct dpkginfo_entry &a, const char *name)
+{
+        return strcmp(a.reply->name, name) < 0;
+}
+
+static bool dpkginfo_entry_less(const struct dpkginfo_entry &a, const struct dpkginfo_entry &b)
+{
+        int cmp = strcmp(a.reply->name, b.reply->name);
+
+        if (cmp != 0)
+                return cmp < 0;
+        if (a.native != b.native)
+                return a.native;
+        return a.pkg_arch < b.pkg_arch;
+}
+
+/*
+ * Index the installed packages of all the architectures, so that the
+ * multiarch packages are found by the name scans and "name:arch" lookups.
+ */
+static void build_index(void)
+{
+        pkgCache &cache = *cgCache->GetPkgCache();
+
+        for (pkgCache::GrpIterator Grp = cache.GrpBegin(); Grp.end() == false; ++Grp) {
+                pkgCache::PkgIterator Native = Grp.FindPkg("native");
+
+                for (pkgCache::PkgIterator Pkg = Grp.PackageList(); Pkg.end() == false; Pkg = Grp.NextPkg(Pkg)) {
+                        pkgCache::VerIterator V1 = Pkg.CurrentVer();
+                        if (V1.end() == true)
+                                continue;
+
+                        struct dpkginfo_entry entry;
+                        entry.reply = dpkginfo_reply_new(Pkg, V1);
+                        entry.pkg_arch = Pkg.Arch();
+                        entry.native = Native.end() == false && Pkg == Native;
+                        pkg_index.push_back(entry);
+                }
+        }
+
+        sort(pkg_index.begin(), pkg_index.end(), dpkginfo_entry_less);
+}
+
+/*
+ * A name without an architecture refers to the package of the native
+ * architecture, as with FindPkg(). A qualified name is resolved by FindPkg()
+ * itself, which knows the architecture aliases ("native", "all", "any"),
+ * and the resolved package is then looked up in the index. FindPkg() only
+ * reads the cache so it is safe to call from several threads.
+ */
+const struct dpkginfo_reply_t *dpkginfo_get_by_name(const char *name, int *err)
+{
+        string pkg_name(name), pkg_arch;
+        bool native = true;
+
+        /* not found or not installed, clear error flag */
+        /* FIXME this should be different that not found */
+        if (err) *err = 0;
+
+        if (strchr(name, ':') != NULL) {
+                pkgCache::PkgIterator Pkg = cgCache->GetPkgCache()->FindPkg(name);
+                if (Pkg.end() == true)
+                        return NULL;
+                pkg_name = Pkg.Name();
+                pkg_arch = Pkg.Arch();
+                native = false;
+        }
+
+        vector<struct dpkginfo_entry>::const_iterator it =
+                lower_bound(pkg_index.begin(), pkg_index.end(), pkg_name.c_str(), dpkginfo_name_less);
+        for (; it != pkg_index.end() && pkg_name == it->reply->name; ++it) {
+                if (native ? it->native : it->pkg_arch == pkg_arch)
+                        return it->reply;
+        }
+
+        return NULL;
+}
+
+size_t dpkginfo_get_count(void)
+{
+        return pkg_index.size();
+}
+
+const struct dpkginfo_reply_t *dpkginfo_get_by_index(size_t i)
+{
+        return pkg_index[i].reply;
+}
+
 int dpkginfo_init()
 {
         cgCache = new pkgCacheFile;
@@ -128,6 +217,8 @@ int dpkginfo_init()
                         return -1;
                 }
 
+        build_index();
+
         return 0;
 }
 
@@ -143,6 +234,10 @@ int dpkginfo_fini()
         delete dpkg_mmap;
         dpkg_mmap = NULL;
 
+        for (size_t i = 0; i < pkg_index.size(); i++)
+                dpkginfo_free_reply(pkg_index[i].reply);
+        pkg_index.clear();
+
         return 0;
 }
 
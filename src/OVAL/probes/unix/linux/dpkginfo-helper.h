@@ -22,6 +22,8 @@
 #ifndef __DPKGINFO_HELPER__
 #define __DPKGINFO_HELPER__
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -38,9 +40,16 @@ struct dpkginfo_reply_t {
 int dpkginfo_init();
 int dpkginfo_fini();
 
-struct dpkginfo_reply_t * dpkginfo_get_by_name(const char *name, int *err);
+/*
+ * The installed packages are indexed by dpkginfo_init(), the index can be
+ * read from several threads at once. The replies are owned by the index.
+ */
+const struct dpkginfo_reply_t *dpkginfo_get_by_name(const char *name, int *err);
+
+/* Number of the installed packages of all the architectures, sorted by name */
+size_t dpkginfo_get_count(void);
 
-void dpkginfo_free_reply(struct dpkginfo_reply_t *reply);
+const struct dpkginfo_reply_t *dpkginfo_get_by_index(size_t i);
 
 #ifdef __cplusplus
 }
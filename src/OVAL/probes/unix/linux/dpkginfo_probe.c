@@ -58,14 +58,18 @@
 #include "public/oval_schema_version.h"
 
 #include <probe/probe.h>
+#include "probe/entcmp.h"
 
 #include "dpkginfo-helper.h"
 
 #include "dpkginfo_probe.h"
 
+/*
+ * The installed packages are indexed once in dpkginfo_init(), the index
+ * isn't modified afterwards so it can be read without a lock.
+ */
 struct dpkginfo_global {
         int init_done;
-        pthread_mutex_t mutex;
 };
 
 static struct dpkginfo_global g_dpkg = {
@@ -78,8 +82,6 @@ int dpkginfo_probe_offline_mode_supported(void) {
 
 void *dpkginfo_probe_init(void)
 {
-        pthread_mutex_init (&(g_dpkg.mutex), NULL);
-
         g_dpkg.init_done = dpkginfo_init();
         if (g_dpkg.init_done < 0) {
                 dE("dpkginfo_init has failed.");
@@ -90,19 +92,36 @@ void *dpkginfo_probe_init(void)
 
 void dpkginfo_probe_fini (void *ptr)
 {
-        struct dpkginfo_global *d = (struct dpkginfo_global *)ptr;
-
         dpkginfo_fini();
-        pthread_mutex_destroy (&(d->mutex));
 
         return;
 }
 
+static void dpkginfo_collect(probe_ctx *ctx, const struct dpkginfo_reply_t *reply, oval_datatype_t evr_string_type)
+{
+        SEXP_t *item;
+
+        dD("%s: element found version %s", reply->name, reply->evr);
+        item = probe_item_create (OVAL_LINUX_DPKG_INFO, NULL,
+                        "name", OVAL_DATATYPE_STRING, reply->name,
+                        "arch", OVAL_DATATYPE_STRING, reply->arch,
+                        "epoch", OVAL_DATATYPE_STRING, reply->epoch,
+                        "release", OVAL_DATATYPE_STRING, reply->release,
+                        "version", OVAL_DATATYPE_STRING, reply->version,
+                        "evr", evr_string_type, reply->evr,
+                        NULL);
+
+        probe_item_collect(ctx, item);
+}
+
 int dpkginfo_probe_main (probe_ctx *ctx, void *arg)
 {
 	SEXP_t *val, *item, *ent, *obj;
         char *request_st = NULL;
-        struct dpkginfo_reply_t *dpkginfo_reply = NULL;
+        const struct dpkginfo_reply_t *dpkginfo_reply = NULL;
+        oval_operation_t op;
+        oval_datatype_t evr_string_type;
+        oval_schema_version_t oval_version;
         int errflag;
 
 	if (arg == NULL) {
@@ -133,6 +152,7 @@ int dpkginfo_probe_main (probe_ctx *ctx, void *arg)
         SEXP_free (val);
 
         if (request_st == NULL) {
+                SEXP_free (ent);
                 switch (errno) {
                 case EINVAL:
                         dD("%s: invalid value type", "name");
@@ -147,10 +167,49 @@ int dpkginfo_probe_main (probe_ctx *ctx, void *arg)
                 }
         }
 
+        val = probe_ent_getattrval (ent, "operation");
+
+        if (val == NULL) {
+                op = OVAL_OPERATION_EQUALS;
+        } else {
+                op = (oval_operation_t) SEXP_number_geti_32 (val);
+                SEXP_free (val);
+        }
+
+        oval_version = probe_obj_get_platform_schema_version(obj);
+        if (oval_schema_version_cmp(oval_version, OVAL_SCHEMA_VERSION(5.11.1)) >= 0) {
+                evr_string_type = OVAL_DATATYPE_DEBIAN_EVR_STRING;
+        } else {
+                evr_string_type = OVAL_DATATYPE_EVR_STRING;
+        }
+
+        /*
+         * Only an exact name can be looked up in the index, the name of
+         * every installed package is compared for the other operations.
+         */
+        if (op != OVAL_OPERATION_EQUALS) {
+                size_t i, count = dpkginfo_get_count();
+
+                for (i = 0; i < count; ++i) {
+                        SEXP_t *name;
+
+                        dpkginfo_reply = dpkginfo_get_by_index(i);
+                        name = SEXP_string_new(dpkginfo_reply->name, strlen(dpkginfo_reply->name));
+
+                        if (probe_entobj_cmp(ent, name) == OVAL_RESULT_TRUE)
+                                dpkginfo_collect(ctx, dpkginfo_reply, evr_string_type);
+
+                        SEXP_free(name);
+                }
+
+                SEXP_free(ent);
+                free(request_st);
+
+                return (0);
+        }
+
         /* get info from debian apt cache */
-        pthread_mutex_lock (&(g_dpkg.mutex));
         dpkginfo_reply = dpkginfo_get_by_name(request_st, &errflag);
-        pthread_mutex_unlock (&(g_dpkg.mutex));
 
         if (dpkginfo_reply == NULL) {
                 switch (errflag) {
@@ -171,31 +230,7 @@ int dpkginfo_probe_main (probe_ctx *ctx, void *arg)
 		}
                 }
         } else { /* Ok */
-                int i;
-                int num_items = 1; /* FIXME */
-		oval_datatype_t evr_string_type;
-		oval_schema_version_t oval_version = probe_obj_get_platform_schema_version(obj);
-		if (oval_schema_version_cmp(oval_version, OVAL_SCHEMA_VERSION(5.11.1)) >= 0) {
-			evr_string_type = OVAL_DATATYPE_DEBIAN_EVR_STRING;
-		} else {
-			evr_string_type = OVAL_DATATYPE_EVR_STRING;
-		}
-
-                for (i = 0; i < num_items; ++i) {
-                        dD("%s: element found version %s", dpkginfo_reply->name, dpkginfo_reply->evr);
-                        item = probe_item_create (OVAL_LINUX_DPKG_INFO, NULL,
-                                        "name", OVAL_DATATYPE_STRING, dpkginfo_reply->name,
-                                        "arch", OVAL_DATATYPE_STRING, dpkginfo_reply->arch,
-                                        "epoch", OVAL_DATATYPE_STRING, dpkginfo_reply->epoch,
-                                        "release", OVAL_DATATYPE_STRING, dpkginfo_reply->release,
-                                        "version", OVAL_DATATYPE_STRING, dpkginfo_reply->version,
-					"evr", evr_string_type, dpkginfo_reply->evr,
-                                        NULL);
-
-			probe_item_collect(ctx, item);
-
-                        dpkginfo_free_reply(dpkginfo_reply);
-                }
+                dpkginfo_collect(ctx, dpkginfo_reply, evr_string_type);
         }
 
 	SEXP_free(ent);
@@ -25,6 +25,8 @@
 
 #include "probe-api.h"
 
+void *inetlisteningservers_probe_init(void);
 int inetlisteningservers_probe_main(probe_ctx *ctx, void *arg);
+void inetlisteningservers_probe_fini(void *arg);
 
 #endif /* OPENSCAP_INETLISTENINGSERVERS_PROBE_H */
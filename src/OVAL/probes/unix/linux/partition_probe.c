@@ -66,6 +66,7 @@
 #include <pcre.h>
 
 #include "common/debug_priv.h"
+#include "common/oscap_pcre.h"
 #include "partition_probe.h"
 
 #ifndef MTAB_PATH
@@ -346,7 +347,7 @@ int partition_probe_main(probe_ctx *ctx, void *probe_arg)
                 char buffer[MTAB_LINE_MAX];
                 struct mntent mnt_ent, *mnt_entp;
 
-                pcre *re = NULL;
+                struct oscap_pcre *re = NULL;
                 const char *estr = NULL;
                 int eoff = -1;
 #if defined(HAVE_BLKID_GET_TAG_VALUE)
@@ -358,7 +359,7 @@ int partition_probe_main(probe_ctx *ctx, void *probe_arg)
                 }
 #endif
                 if (mnt_op == OVAL_OPERATION_PATTERN_MATCH) {
-                        re = pcre_compile(mnt_path, PCRE_UTF8, &estr, &eoff, NULL);
+                        re = oscap_pcre_acquire(mnt_path, PCRE_UTF8, &estr, &eoff);
 
                         if (re == NULL) {
                                 endmntent(mnt_fp);
@@ -398,8 +399,8 @@ int partition_probe_main(probe_ctx *ctx, void *probe_arg)
                         } else if (mnt_op == OVAL_OPERATION_PATTERN_MATCH) {
                                 int rc;
 
-                                rc = pcre_exec(re, NULL, mnt_entp->mnt_dir,
-                                               strlen(mnt_entp->mnt_dir), 0, 0, NULL, 0);
+                                rc = oscap_pcre_exec(re, mnt_entp->mnt_dir,
+                                                     strlen(mnt_entp->mnt_dir), 0, 0, NULL, 0);
 
                                 if (rc == 0) {
 	                                if (
@@ -417,8 +418,7 @@ int partition_probe_main(probe_ctx *ctx, void *probe_arg)
 
                 endmntent(mnt_fp);
 
-                if (mnt_op == OVAL_OPERATION_PATTERN_MATCH)
-                        pcre_free(re);
+                oscap_pcre_release(re);
 #if defined(HAVE_BLKID_GET_TAG_VALUE)
                 blkid_put_cache(blkcache);
 #endif
@@ -24,6 +24,14 @@
 #include <config.h>
 #endif
 
+#include <regex.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "probe/entcmp.h"
+#include "oscap_helpers.h"
+
 #ifdef RPM46_FOUND
 int rpmErrorCb (rpmlogRec rec, rpmlogCallbackData data)
 {
@@ -51,3 +59,333 @@ void rpmLibsPreload()
 	const char* rcfiles = "";
 	rpmReadConfigFiles(rcfiles, NULL);
 }
+
+static const char g_keyid_regex_string[] = "Key ID [a-fA-F0-9]{16}";
+
+static pthread_mutex_t g_snapshot_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct rpm_snapshot *g_snapshots = NULL;
+static struct rpm_snapshot *g_stale_snapshots = NULL;
+static unsigned int g_snapshot_refs = 0;
+
+static void rpm_pkg_free(struct rpm_pkg *pkg)
+{
+	free(pkg->name);
+	free(pkg->epoch);
+	free(pkg->version);
+	free(pkg->release);
+	free(pkg->arch);
+	free(pkg->evr);
+	free(pkg->signature_keyid);
+	free(pkg->extended_name);
+}
+
+static void rpm_snapshot_free(struct rpm_snapshot *snap)
+{
+	size_t i;
+
+	for (i = 0; i < snap->count; ++i)
+		rpm_pkg_free(&snap->pkgs[i]);
+
+	oscap_htable_free(snap->names, free);
+	free(snap->by_name);
+	free(snap->pkgs);
+	free(snap->root);
+	free(snap);
+}
+
+static void pkgh2pkg(Header h, struct rpm_pkg *pkg, regex_t *keyid_regex)
+{
+	errmsg_t rpmerr;
+	char *str, *sid = NULL;
+	const char *epoch_override;
+	regmatch_t keyid_match[1];
+
+	pkg->name = headerFormat(h, "%{NAME}", &rpmerr);
+	pkg->arch = headerFormat(h, "%{ARCH}", &rpmerr);
+	pkg->epoch = headerFormat(h, "%{EPOCH}", &rpmerr);
+	pkg->release = headerFormat(h, "%{RELEASE}", &rpmerr);
+	pkg->version = headerFormat(h, "%{VERSION}", &rpmerr);
+
+	epoch_override = oscap_streq(pkg->epoch, "(none)") ? "0" : pkg->epoch;
+	pkg->evr = oscap_sprintf("%s:%s-%s", epoch_override, pkg->version, pkg->release);
+	pkg->extended_name = oscap_sprintf("%s-%s:%s-%s.%s", pkg->name, epoch_override,
+		pkg->version, pkg->release, pkg->arch);
+
+	str = headerFormat(h, "%|SIGGPG?{%{SIGGPG:pgpsig}}:{%{SIGPGP:pgpsig}}|", &rpmerr);
+
+	if (regexec(keyid_regex, str, 1, keyid_match, 0) != 0) {
+		dD("Failed to extract the Key ID value: regex=\"%s\", string=\"%s\"",
+		   g_keyid_regex_string, str);
+	} else if (keyid_match[0].rm_so >= 0 && keyid_match[0].rm_eo >= 0) {
+		size_t keyid_start = keyid_match[0].rm_so + strlen("Key ID ");
+		size_t keyid_length = keyid_match[0].rm_eo - keyid_start;
+
+		sid = str + keyid_start;
+		sid[keyid_length] = '\0';
+	}
+
+	pkg->signature_keyid = strdup(sid != NULL ? sid : "0");
+	free(str);
+}
+
+static int rpm_pkg_name_cmp(const void *a, const void *b)
+{
+	const struct rpm_pkg *pa = *(const struct rpm_pkg **)a;
+	const struct rpm_pkg *pb = *(const struct rpm_pkg **)b;
+	int ret = strcmp(pa->name, pb->name);
+
+	if (ret != 0)
+		return ret;
+	return (pa->instance > pb->instance) - (pa->instance < pb->instance);
+}
+
+static struct rpm_snapshot *rpm_snapshot_new(rpmts ts, const char *root)
+{
+	rpmdbMatchIterator match;
+	Header pkgh;
+	regex_t keyid_regex;
+	size_t alloc = 0, i;
+	struct rpm_snapshot *snap;
+
+	if (regcomp(&keyid_regex, g_keyid_regex_string, REG_EXTENDED) != 0) {
+		dE("regcomp(%s) failed.", g_keyid_regex_string);
+		return NULL;
+	}
+
+	snap = calloc(1, sizeof(struct rpm_snapshot));
+	if (snap == NULL) {
+		regfree(&keyid_regex);
+		goto fail;
+	}
+	snap->root = strdup(root);
+	snap->names = oscap_htable_new();
+	if (snap->root == NULL || snap->names == NULL) {
+		regfree(&keyid_regex);
+		goto fail;
+	}
+
+	match = rpmtsInitIterator(ts, RPMDBI_PACKAGES, NULL, 0);
+	while (match != NULL && (pkgh = rpmdbNextIterator(match)) != NULL) {
+		if (snap->count == alloc) {
+			size_t new_alloc = alloc ? alloc * 2 : 1024;
+			struct rpm_pkg *pkgs = realloc(snap->pkgs, new_alloc * sizeof(struct rpm_pkg));
+
+			if (pkgs == NULL) {
+				rpmdbFreeIterator(match);
+				regfree(&keyid_regex);
+				goto fail;
+			}
+			snap->pkgs = pkgs;
+			alloc = new_alloc;
+		}
+		pkgh2pkg(pkgh, &snap->pkgs[snap->count], &keyid_regex);
+		snap->pkgs[snap->count].instance = rpmdbGetIteratorOffset(match);
+		++snap->count;
+	}
+	rpmdbFreeIterator(match);
+	regfree(&keyid_regex);
+
+	/* index the packages by name, the instances of one name are adjacent */
+	snap->by_name = malloc((snap->count + 1) * sizeof(struct rpm_pkg *));
+	if (snap->by_name == NULL)
+		goto fail;
+	for (i = 0; i < snap->count; ++i)
+		snap->by_name[i] = &snap->pkgs[i];
+	qsort(snap->by_name, snap->count, sizeof(struct rpm_pkg *), rpm_pkg_name_cmp);
+
+	for (i = 0; i < snap->count; ++i) {
+		if (i > 0 && strcmp(snap->by_name[i - 1]->name, snap->by_name[i]->name) == 0)
+			continue;
+		size_t *idx = malloc(sizeof(size_t));
+		if (idx == NULL)
+			goto fail;
+		*idx = i;
+		if (!oscap_htable_add(snap->names, snap->by_name[i]->name, idx)) {
+			free(idx);
+			goto fail;
+		}
+	}
+
+	dD("Read %zu packages from the rpm database in '%s'.", snap->count, root);
+	return snap;
+fail:
+	dW("Can't allocate the snapshot of the rpm database in '%s', "
+	   "the packages will be read from the database directly.", root);
+	if (snap != NULL)
+		rpm_snapshot_free(snap);
+	return NULL;
+}
+
+void rpm_snapshot_ref(void)
+{
+	pthread_mutex_lock(&g_snapshot_mutex);
+	++g_snapshot_refs;
+	pthread_mutex_unlock(&g_snapshot_mutex);
+}
+
+static void rpm_snapshot_free_list(struct rpm_snapshot **list)
+{
+	while (*list != NULL) {
+		struct rpm_snapshot *next = (*list)->next;
+		rpm_snapshot_free(*list);
+		*list = next;
+	}
+}
+
+void rpm_snapshot_unref(void)
+{
+	pthread_mutex_lock(&g_snapshot_mutex);
+	if (g_snapshot_refs > 0 && --g_snapshot_refs == 0) {
+		rpm_snapshot_free_list(&g_snapshots);
+		rpm_snapshot_free_list(&g_stale_snapshots);
+	}
+	pthread_mutex_unlock(&g_snapshot_mutex);
+}
+
+void rpm_snapshot_invalidate(void)
+{
+	pthread_mutex_lock(&g_snapshot_mutex);
+	if (g_snapshot_refs == 0) {
+		rpm_snapshot_free_list(&g_snapshots);
+	} else {
+		/* a running probe may still use them, free them with the last reference */
+		while (g_snapshots != NULL) {
+			struct rpm_snapshot *next = g_snapshots->next;
+			g_snapshots->next = g_stale_snapshots;
+			g_stale_snapshots = g_snapshots;
+			g_snapshots = next;
+		}
+	}
+	pthread_mutex_unlock(&g_snapshot_mutex);
+}
+
+struct rpm_snapshot *rpm_snapshot_get(rpmts ts)
+{
+	struct rpm_snapshot *snap;
+	const char *root = rpmtsRootDir(ts);
+
+	if (root == NULL)
+		root = "/";
+
+	pthread_mutex_lock(&g_snapshot_mutex);
+	for (snap = g_snapshots; snap != NULL; snap = snap->next) {
+		if (strcmp(snap->root, root) == 0)
+			break;
+	}
+	if (snap == NULL) {
+		snap = rpm_snapshot_new(ts, root);
+		if (snap != NULL) {
+			snap->next = g_snapshots;
+			g_snapshots = snap;
+		}
+	}
+	pthread_mutex_unlock(&g_snapshot_mutex);
+
+	return snap;
+}
+
+size_t rpm_snapshot_find(struct rpm_snapshot *snap, const char *name, struct rpm_pkg ***first)
+{
+	size_t *idx = oscap_htable_get(snap->names, name);
+	size_t i;
+
+	if (idx == NULL)
+		return 0;
+
+	for (i = *idx; i < snap->count && strcmp(snap->by_name[i]->name, name) == 0; ++i)
+		;
+	*first = &snap->by_name[*idx];
+	return i - *idx;
+}
+
+Header rpm_snapshot_header(rpmts ts, const struct rpm_pkg *pkg, rpmdbMatchIterator *mi)
+{
+	unsigned int instance = pkg->instance;
+
+	*mi = rpmtsInitIterator(ts, RPMDBI_PACKAGES, &instance, sizeof(instance));
+	if (*mi == NULL)
+		return NULL;
+
+	return rpmdbNextIterator(*mi);
+}
+
+static bool rpm_pkg_ent_matches(SEXP_t *ent, const char *value)
+{
+	SEXP_t *val;
+	bool ret = true;
+
+	if (ent == NULL)
+		return true;
+
+	/* a value which can't be converted to the type of the entity doesn't match */
+	val = probe_entval_from_cstr(probe_ent_getdatatype(ent), value, strlen(value));
+	if (val == NULL || probe_entobj_cmp(ent, val) != OVAL_RESULT_TRUE)
+		ret = false;
+	SEXP_free(val);
+
+	return ret;
+}
+
+rpmdbMatchIterator rpm_snapshot_iterator(rpmts ts, struct rpm_snapshot *snap,
+		SEXP_t *name_ent, SEXP_t *epoch_ent, SEXP_t *version_ent, SEXP_t *release_ent, SEXP_t *arch_ent)
+{
+	rpmdbMatchIterator match;
+	unsigned int *instances = NULL;
+	size_t count = 0, i;
+
+	if (snap != NULL)
+		instances = malloc(sizeof(unsigned int) * (snap->count + 1));
+	/* without the snapshot walk the whole rpmdb, the callers filter the packages */
+	if (instances == NULL)
+		return rpmtsInitIterator(ts, RPMDBI_PACKAGES, NULL, 0);
+
+	for (i = 0; i < snap->count; ++i) {
+		const struct rpm_pkg *pkg = &snap->pkgs[i];
+
+		if (rpm_pkg_ent_matches(name_ent, pkg->name) &&
+		    rpm_pkg_ent_matches(epoch_ent, pkg->epoch) &&
+		    rpm_pkg_ent_matches(version_ent, pkg->version) &&
+		    rpm_pkg_ent_matches(release_ent, pkg->release) &&
+		    rpm_pkg_ent_matches(arch_ent, pkg->arch))
+			instances[count++] = pkg->instance;
+	}
+
+	/* an iterator without any instances appended would walk the whole rpmdb */
+	if (count == 0) {
+		free(instances);
+		return NULL;
+	}
+
+	match = rpmtsInitIterator(ts, RPMDBI_PACKAGES, NULL, 0);
+	if (match != NULL && rpmdbAppendIterator(match, instances, count) != 0)
+		match = rpmdbFreeIterator(match);
+
+	free(instances);
+	return match;
+}
+
+int rpm_pkg_walk(rpmts ts, int (*callback)(const struct rpm_pkg *pkg, Header h, void *arg), void *arg)
+{
+	rpmdbMatchIterator match;
+	Header pkgh;
+	regex_t keyid_regex;
+	struct rpm_pkg pkg;
+	int ret = 0;
+
+	if (regcomp(&keyid_regex, g_keyid_regex_string, REG_EXTENDED) != 0) {
+		dE("regcomp(%s) failed.", g_keyid_regex_string);
+		return -1;
+	}
+
+	match = rpmtsInitIterator(ts, RPMDBI_PACKAGES, NULL, 0);
+	while (ret >= 0 && match != NULL && (pkgh = rpmdbNextIterator(match)) != NULL) {
+		pkgh2pkg(pkgh, &pkg, &keyid_regex);
+		pkg.instance = rpmdbGetIteratorOffset(match);
+		ret = callback(&pkg, pkgh, arg);
+		rpm_pkg_free(&pkg);
+	}
+	rpmdbFreeIterator(match);
+	regfree(&keyid_regex);
+
+	return ret < 0 ? ret : 0;
+}
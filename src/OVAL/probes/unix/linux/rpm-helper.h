@@ -34,7 +34,9 @@
 
 #include <pthread.h>
 #include "common/util.h"
+#include "common/list.h"
 #include "common/debug_priv.h"
+#include <probe-api.h>
 #include "pthread.h"
 
 struct rpm_probe_global {
@@ -98,4 +100,89 @@ int rpmVerifyFile(const rpmts ts, const rpmfi fi,
  */
 void rpmLibsPreload(void);
 
+/**
+ * Installed package as recorded in the rpm database snapshot
+ */
+struct rpm_pkg {
+	char *name;
+	char *epoch;
+	char *version;
+	char *release;
+	char *arch;
+	char *evr;
+	char *signature_keyid;
+	char *extended_name;
+	unsigned int instance; /**< rpmdb header instance */
+};
+
+/**
+ * Snapshot of the installed packages shared by the rpm probes. It is read
+ * from the rpm database once per root directory and it is not modified
+ * afterwards, so it can be queried concurrently without the probe locks.
+ */
+struct rpm_snapshot {
+	char *root;
+	struct rpm_pkg *pkgs;      /**< packages in the rpmdb order */
+	struct rpm_pkg **by_name;  /**< packages sorted by name */
+	size_t count;
+	struct oscap_htable *names; /**< name -> index to by_name */
+	struct rpm_snapshot *next;
+};
+
+/**
+ * Take a reference to the shared snapshots, called from the probe init
+ * functions. The snapshots are freed when the last reference is dropped.
+ */
+void rpm_snapshot_ref(void);
+void rpm_snapshot_unref(void);
+
+/**
+ * Drop the snapshots, the next rpm_snapshot_get() reads the rpm database
+ * again. Called when the probes are reset, the snapshots which may still
+ * be in use are freed with the last reference.
+ */
+void rpm_snapshot_invalidate(void);
+
+/**
+ * Get the snapshot of the rpm database opened by the transaction set.
+ * It's created on the first call, the caller has to hold the lock of ts.
+ * @return NULL if the snapshot can't be created, the callers then read the
+ * rpm database directly
+ */
+struct rpm_snapshot *rpm_snapshot_get(rpmts ts);
+
+/**
+ * Find the packages of the given name
+ * @param first set to the first package, the rest of them follows in by_name
+ * @return number of the packages
+ */
+size_t rpm_snapshot_find(struct rpm_snapshot *snap, const char *name, struct rpm_pkg ***first);
+
+/**
+ * Read the header of a package from the rpm database. The header is valid
+ * until the returned iterator is freed with rpmdbFreeIterator().
+ */
+Header rpm_snapshot_header(rpmts ts, const struct rpm_pkg *pkg, rpmdbMatchIterator *mi);
+
+/**
+ * Create an rpmdb iterator over the packages of the snapshot which satisfy
+ * the given entities. The entities which are NULL aren't checked. Unlike
+ * an iterator filtered with rpmdbSetIteratorRE(), it reads only the headers
+ * of the matching packages. If snap is NULL, or the instances can't be
+ * allocated, the iterator walks the whole rpmdb and the caller has to filter
+ * the packages itself. The caller has to hold the lock of ts.
+ * @return NULL if there is no such package
+ */
+rpmdbMatchIterator rpm_snapshot_iterator(rpmts ts, struct rpm_snapshot *snap,
+		SEXP_t *name_ent, SEXP_t *epoch_ent, SEXP_t *version_ent, SEXP_t *release_ent, SEXP_t *arch_ent);
+
+/**
+ * Read the packages from the rpm database one by one, used instead of the
+ * snapshot when it can't be allocated. The package and its header are valid
+ * only during the callback, a negative return value of the callback stops
+ * the walk. The caller has to hold the lock of ts.
+ * @return 0 on success, -1 on error or the negative value of the callback
+ */
+int rpm_pkg_walk(rpmts ts, int (*callback)(const struct rpm_pkg *pkg, Header h, void *arg), void *arg);
+
 #endif
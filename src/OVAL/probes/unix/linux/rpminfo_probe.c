@@ -77,204 +77,65 @@ struct rpminfo_req {
         oval_operation_t op;
 };
 
-struct rpminfo_rep {
-        char *name;
-        char *arch;
-        char *epoch;
-        char *release;
-        char *version;
-        char *evr;
-        char *signature_keyid;
-	char extended_name[1024];
-};
-
 #define RPMINFO_LOCK	RPM_MUTEX_LOCK(&g_rpm->mutex)
 
 #define RPMINFO_UNLOCK	RPM_MUTEX_UNLOCK(&g_rpm->mutex)
 
-static const char g_keyid_regex_string[] = "Key ID [a-fA-F0-9]{16}";
-
-static void __rpminfo_rep_free (struct rpminfo_rep *ptr)
-{
-        free (ptr->name);
-        free (ptr->arch);
-        free (ptr->epoch);
-        free (ptr->release);
-        free (ptr->version);
-        free (ptr->evr);
-        free (ptr->signature_keyid);
-}
-
-static void pkgh2rep(Header h, struct rpminfo_rep *r, regex_t *keyid_regex)
-{
-        errmsg_t rpmerr;
-        char *str, *sid;
-	char *epoch_override = NULL;
-        size_t len;
-	regmatch_t keyid_match[1];
-
-	if (h == NULL || r == NULL) {
-		return;
-	}
-
-        r->name = headerFormat (h, "%{NAME}", &rpmerr);
-        r->arch = headerFormat (h, "%{ARCH}", &rpmerr);
-        r->epoch = headerFormat (h, "%{EPOCH}", &rpmerr);
-        r->release = headerFormat (h, "%{RELEASE}", &rpmerr);
-        r->version = headerFormat (h, "%{VERSION}", &rpmerr);
-	epoch_override = oscap_streq(r->epoch, "(none)") ? "0" : r->epoch;
-	snprintf(r->extended_name, 1024, "%s-%s:%s-%s.%s", r->name, epoch_override, r->version, r->release, r->arch);
-
-	len = (strlen(epoch_override) +
-               strlen (r->release) +
-               strlen (r->version) + 2);
-
-        str = malloc (sizeof (char) * (len + 1));
-        snprintf (str, len + 1, "%s:%s-%s",
-		epoch_override,
-                  r->version,
-                  r->release);
-
-        r->evr = str;
-
-        str = headerFormat (h, "%|SIGGPG?{%{SIGGPG:pgpsig}}:{%{SIGPGP:pgpsig}}|", &rpmerr);
-
-	if (regexec(keyid_regex, str, 1, keyid_match, 0) != 0) {
-		sid = NULL;
-		dD("Failed to extract the Key ID value: regex=\"%s\", string=\"%s\"",
-		   g_keyid_regex_string, str);
-	} else {
-		size_t keyid_start, keyid_length;
-
-		if (keyid_match[0].rm_so < 0 || keyid_match[0].rm_eo < 0)
-			sid = NULL;
-		else {
-			keyid_start = keyid_match[0].rm_so + strlen("Key ID ");
-			keyid_length = keyid_match[0].rm_eo - keyid_start;
-			sid = str + keyid_start;
-			sid[keyid_length] = '\0';
-		}
-	}
-
-        r->signature_keyid = strdup(sid != NULL ? sid : "0");
-        free (str);
-}
-
 /*
  * req - Structure containing the name of the package.
- * rep - Pointer to rpminfo_rep structure pointer. An
- *       array of rpminfo_rep structures will be allocated
- *       here.
+ * rep - Pointer to an array of package pointers which
+ *       will be allocated here. The packages belong to
+ *       the shared rpm database snapshot.
+ * snap - The shared rpm database snapshot.
  *
  * The return value on error is -1. Otherwise the number of
- * rpminfo_rep structures allocated in *rep is returned.
+ * packages in *rep is returned.
  */
-static int get_rpminfo(struct rpminfo_req *req, struct rpminfo_rep **rep, struct rpm_probe_global *g_rpm)
+static int get_rpminfo(struct rpminfo_req *req, struct rpm_pkg ***rep, struct rpm_snapshot *snap)
 {
-	rpmdbMatchIterator match;
-	Header pkgh;
-	int ret = 0, i;
-	regex_t keyid_regex;
-
-	if (regcomp(&keyid_regex, g_keyid_regex_string, REG_EXTENDED) != 0) {
-		dE("regcomp(%s) failed.", g_keyid_regex_string);
+	struct rpm_pkg **first;
+	regex_t name_regex;
+	size_t i;
+	int ret = 0;
+
+	switch (req->op) {
+	case OVAL_OPERATION_EQUALS:
+		ret = rpm_snapshot_find(snap, req->name, &first);
+		*rep = malloc(sizeof(struct rpm_pkg *) * (ret + 1));
+		if (*rep == NULL)
+			return -1;
+		memcpy(*rep, first, sizeof(struct rpm_pkg *) * ret);
+		break;
+	case OVAL_OPERATION_NOT_EQUAL:
+		*rep = malloc(sizeof(struct rpm_pkg *) * (snap->count + 1));
+		if (*rep == NULL)
+			return -1;
+		for (i = 0; i < snap->count; ++i)
+			(*rep)[ret++] = &snap->pkgs[i];
+		break;
+	case OVAL_OPERATION_PATTERN_MATCH:
+		/* the same as the RPMMIRE_REGEX filter of an rpmdb iterator */
+		if (regcomp(&name_regex, req->name, REG_EXTENDED | REG_NOSUB) != 0) {
+			dD("regcomp(%s) failed.", req->name);
+			return -1;
+		}
+		*rep = malloc(sizeof(struct rpm_pkg *) * (snap->count + 1));
+		if (*rep == NULL) {
+			regfree(&name_regex);
+			return -1;
+		}
+		for (i = 0; i < snap->count; ++i) {
+			if (regexec(&name_regex, snap->pkgs[i].name, 0, NULL, 0) == 0)
+				(*rep)[ret++] = &snap->pkgs[i];
+		}
+		regfree(&name_regex);
+		break;
+	default:
+		/* not supported */
 		return -1;
 	}
 
-        RPMINFO_LOCK;
-
-        ret = -1;
-
-        switch (req->op) {
-        case OVAL_OPERATION_EQUALS:
-		match = rpmtsInitIterator(g_rpm->rpmts, RPMTAG_NAME, (const void *)req->name, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                ret = rpmdbGetIteratorCount (match);
-
-                break;
-	case OVAL_OPERATION_NOT_EQUAL:
-		match = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_GLOB, "*") != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
-
-                break;
-        case OVAL_OPERATION_PATTERN_MATCH:
-		match = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
-
-                if (match == NULL) {
-                        ret = 0;
-                        goto ret;
-                }
-
-                if (rpmdbSetIteratorRE (match, RPMTAG_NAME, RPMMIRE_REGEX,
-                                        (const char *)req->name) != 0)
-                {
-                        ret = -1;
-                        goto ret;
-                }
-
-                break;
-        default:
-                /* not supported */
-                ret = -1;
-                goto ret;
-        }
-
-        if (ret != -1) {
-                /*
-                 * We can allocate all memory needed now because we know the number
-                 * of results.
-                 */
-                void *new_rep = realloc (*rep, sizeof (struct rpminfo_rep) * ret);
-                if (new_rep == NULL) {
-                        ret = -2;
-                        goto ret;
-                }
-                (*rep) = new_rep;
-                for (i = 0; i < ret; ++i) {
-                        pkgh = rpmdbNextIterator (match);
-
-                        if (pkgh != NULL)
-			pkgh2rep(pkgh, (*rep) + i, &keyid_regex);
-                        else {
-                                /* XXX: emit warning */
-                                memset((*rep) + i, 0, sizeof(struct rpminfo_rep));
-                                break;
-                        }
-                }
-        } else {
-                ret = 0;
-
-                while ((pkgh = rpmdbNextIterator (match)) != NULL) {
-                        void *new_rep = realloc (*rep, sizeof (struct rpminfo_rep) * ++ret);
-                        if (new_rep == NULL) {
-                                ret = -2;
-                                goto ret;
-                        }
-                        (*rep) = new_rep;
-                        pkgh2rep(pkgh, (*rep) + (ret - 1), &keyid_regex);
-                }
-        }
-
-	match = rpmdbFreeIterator (match);
-ret:
-        RPMINFO_UNLOCK;
-
-	regfree(&keyid_regex);
-        return (ret);
+	return (ret);
 }
 
 int rpminfo_probe_offline_mode_supported()
@@ -296,6 +157,7 @@ void *rpminfo_probe_init(void)
 
 	g_rpm->rpmts = rpmtsCreate();
 	pthread_mutex_init (&(g_rpm->mutex), NULL);
+	rpm_snapshot_ref();
 
 	return ((void *)g_rpm);
 }
@@ -316,6 +178,7 @@ void rpminfo_probe_fini (void *ptr)
 	if (r->rpmts == NULL)
 		return;
 
+        rpm_snapshot_unref();
         rpmtsFree(r->rpmts);
         pthread_mutex_destroy (&(r->mutex));
 
@@ -323,79 +186,143 @@ void rpminfo_probe_fini (void *ptr)
         return;
 }
 
-static int collect_rpm_files(SEXP_t *item, const struct rpminfo_rep *rep, struct rpm_probe_global *g_rpm)
+static void collect_rpm_header_files(SEXP_t *item, Header pkgh, struct rpm_probe_global *g_rpm)
 {
 	SEXP_t *value;
-	rpmdbMatchIterator ts;
-	Header pkgh;
 	rpmfi fi;
 	rpmTag tag[2] = { RPMTAG_BASENAMES, RPMTAG_DIRNAMES };
-	int i, ret = 0;
-
-	ts = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
-	if (ts == NULL) {
-		return -1;
+	int i;
+
+	/*
+	 * Inspect package files & directories
+	 */
+	for (i = 0; i < 2; ++i) {
+		fi = rpmfiNew(g_rpm->rpmts, pkgh, tag[i], 1);
+
+		while (rpmfiNext(fi) != -1) {
+			const char *filepath;
+			filepath = rpmfiFN(fi);
+			value = probe_entval_from_cstr(
+					OVAL_DATATYPE_STRING,
+					filepath,
+					strlen(filepath)
+					);
+			if (value != NULL) {
+				probe_item_ent_add(item, "filepath", NULL, value);
+				SEXP_free(value);
+			}
+		}
+		rpmfiFree(fi);
 	}
+}
 
-	if (rpmdbSetIteratorRE(ts, RPMTAG_NAME, RPMMIRE_STRCMP, rep->name) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	char *epoch_override = oscap_streq(rep->epoch, "(none)") ? "0" : rep->epoch;
-	if (rpmdbSetIteratorRE(ts, RPMTAG_EPOCH, RPMMIRE_STRCMP, epoch_override) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	if (rpmdbSetIteratorRE(ts, RPMTAG_VERSION, RPMMIRE_STRCMP, rep->version) != 0) {
-		ret = -1;
-		goto cleanup;
-	}
-	if (rpmdbSetIteratorRE(ts, RPMTAG_RELEASE, RPMMIRE_STRCMP, rep->release) != 0) {
+static int collect_rpm_files(SEXP_t *item, const struct rpm_pkg *pkg, struct rpm_probe_global *g_rpm)
+{
+	rpmdbMatchIterator match;
+	Header pkgh;
+	int ret = 0;
+
+	RPMINFO_LOCK;
+
+	pkgh = rpm_snapshot_header(g_rpm->rpmts, pkg, &match);
+	if (pkgh == NULL) {
 		ret = -1;
 		goto cleanup;
 	}
-	if (rpmdbSetIteratorRE(ts, RPMTAG_ARCH, RPMMIRE_STRCMP, rep->arch) != 0) {
-		ret = -1;
-		goto cleanup;
+
+	collect_rpm_header_files(item, pkgh, g_rpm);
+cleanup:
+	match = rpmdbFreeIterator(match);
+	RPMINFO_UNLOCK;
+	return ret;
+}
+
+struct rpminfo_collect_ctx {
+	probe_ctx *ctx;
+	SEXP_t *probe_in;
+	SEXP_t *name_ent;
+	oval_schema_version_t over;
+	struct rpm_probe_global *g_rpm;
+};
+
+/*
+ * Create and collect the item of the package if its name matches.
+ * pkgh - The header of the package if the caller holds it, the lock
+ *        of the rpmdb is held then.
+ *
+ * The return value is -1 if the item can't be collected, 0 otherwise.
+ */
+static int rpminfo_collect_pkg(struct rpminfo_collect_ctx *cc, const struct rpm_pkg *pkg, Header pkgh)
+{
+	SEXP_t *name, *item;
+
+	name = SEXP_string_newf("%s", pkg->name);
+
+	if (probe_entobj_cmp(cc->name_ent, name) != OVAL_RESULT_TRUE) {
+		SEXP_free(name);
+		return 0;
 	}
 
-	while ((pkgh = rpmdbNextIterator(ts)) != NULL) {
+	item = probe_item_create(OVAL_LINUX_RPM_INFO, NULL,
+				 "name",    OVAL_DATATYPE_SEXP, name,
+				 "arch",    OVAL_DATATYPE_STRING, pkg->arch,
+				 "epoch",   OVAL_DATATYPE_STRING, pkg->epoch,
+				 "release", OVAL_DATATYPE_STRING, pkg->release,
+				 "version", OVAL_DATATYPE_STRING, pkg->version,
+				 "evr",     OVAL_DATATYPE_EVR_STRING, pkg->evr,
+				 "signature_keyid", OVAL_DATATYPE_STRING, pkg->signature_keyid,
+				 NULL);
+
+	/* OVAL 5.10 added extended_name and filepaths behavior */
+	if (oval_schema_version_cmp(cc->over, OVAL_SCHEMA_VERSION(5.10)) >= 0) {
+		SEXP_t *value, *bh_value;
+		value = probe_entval_from_cstr(
+				OVAL_DATATYPE_STRING,
+				pkg->extended_name,
+				strlen(pkg->extended_name)
+		);
+		probe_item_ent_add(item, "extended_name", NULL, value);
+		SEXP_free(value);
+
 		/*
-		 * Inspect package files & directories
+		 * Parse behaviors
 		 */
-		for (i = 0; i < 2; ++i) {
-			fi = rpmfiNew(g_rpm->rpmts, pkgh, tag[i], 1);
-
-			while (rpmfiNext(fi) != -1) {
-				const char *filepath;
-				filepath = rpmfiFN(fi);
-				value = probe_entval_from_cstr(
-						OVAL_DATATYPE_STRING,
-						filepath,
-						strlen(filepath)
-						);
-				if (value != NULL) {
-					probe_item_ent_add(item, "filepath", NULL, value);
-					SEXP_free(value);
+		value = probe_obj_getent(cc->probe_in, "behaviors", 1);
+		if (value != NULL) {
+			bh_value = probe_ent_getattrval(value, "filepaths");
+			if (bh_value != NULL) {
+				if (SEXP_strcmp(bh_value, "true") == 0) {
+					/* collect package files */
+					if (pkgh != NULL)
+						collect_rpm_header_files(item, pkgh, cc->g_rpm);
+					else
+						collect_rpm_files(item, pkg, cc->g_rpm);
 				}
+				SEXP_free(bh_value);
 			}
-			rpmfiFree(fi);
+			SEXP_free(value);
 		}
-
 	}
-cleanup:
-	ts = rpmdbFreeIterator(ts);
-	return ret;
+
+	SEXP_free(name);
+
+	return probe_item_collect(cc->ctx, item) < 0 ? -1 : 0;
+}
+
+static int rpminfo_collect_header(const struct rpm_pkg *pkg, Header pkgh, void *arg)
+{
+	return rpminfo_collect_pkg(arg, pkg, pkgh);
 }
 
 int rpminfo_probe_main(probe_ctx *ctx, void *arg)
 {
 	SEXP_t *val, *item, *ent, *probe_in;
 	oval_schema_version_t over;
+	struct rpm_snapshot *snap;
 	int rpmret, i;
 
         struct rpminfo_req request_st;
-        struct rpminfo_rep *reply_st;
+        struct rpm_pkg **reply_st;
 
 	// arg is NULL if regex compilation failed
 	if (arg == NULL) {
@@ -478,10 +405,32 @@ int rpminfo_probe_main(probe_ctx *ctx, void *arg)
 
         reply_st  = NULL;
 
+	struct rpminfo_collect_ctx cc = {
+		.ctx = ctx,
+		.probe_in = probe_in,
+		.name_ent = ent,
+		.over = over,
+		.g_rpm = g_rpm,
+	};
+
+	RPMINFO_LOCK;
+	snap = rpm_snapshot_get(g_rpm->rpmts);
+	if (snap == NULL) {
+		/* the snapshot can't be allocated, read the packages one by one */
+		rpmret = rpm_pkg_walk(g_rpm->rpmts, rpminfo_collect_header, &cc);
+		RPMINFO_UNLOCK;
+
+		SEXP_free(ent);
+		free(request_st.name);
+		return rpmret < 0 ? PROBE_EUNKNOWN : 0;
+	}
+	RPMINFO_UNLOCK;
+
         /* get info from RPM db */
-	switch (rpmret = get_rpminfo(&request_st, &reply_st, g_rpm)) {
+	switch (rpmret = get_rpminfo(&request_st, &reply_st, snap)) {
         case 0: /* Not found */
                 dI("Package \"%s\" not found.", request_st.name);
+                free (reply_st);
                 break;
         case -1: /* Error */
                 dD("get_rpminfo failed");
@@ -496,69 +445,16 @@ int rpminfo_probe_main(probe_ctx *ctx, void *arg)
         default: /* Ok */
                 _A(rpmret   >= 0);
                 _A(reply_st != NULL);
-                {
-                        SEXP_t *name;
-
-                        for (i = 0; i < rpmret; ++i) {
-				name = SEXP_string_newf("%s", reply_st[i].name);
-
-				if (probe_entobj_cmp(ent, name) != OVAL_RESULT_TRUE) {
-					SEXP_free(name);
-					continue;
-				}
-
-                                item = probe_item_create(OVAL_LINUX_RPM_INFO, NULL,
-                                                         "name",    OVAL_DATATYPE_SEXP, name,
-                                                         "arch",    OVAL_DATATYPE_STRING, reply_st[i].arch,
-                                                         "epoch",   OVAL_DATATYPE_STRING, reply_st[i].epoch,
-                                                         "release", OVAL_DATATYPE_STRING, reply_st[i].release,
-                                                         "version", OVAL_DATATYPE_STRING, reply_st[i].version,
-                                                         "evr",     OVAL_DATATYPE_EVR_STRING, reply_st[i].evr,
-                                                         "signature_keyid", OVAL_DATATYPE_STRING, reply_st[i].signature_keyid,
-                                                         NULL);
-
-				/* OVAL 5.10 added extended_name and filepaths behavior */
-				if (oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10)) >= 0) {
-					SEXP_t *value, *bh_value;
-					value = probe_entval_from_cstr(
-							OVAL_DATATYPE_STRING,
-							reply_st[i].extended_name,
-							strlen(reply_st[i].extended_name)
-					);
-					probe_item_ent_add(item, "extended_name", NULL, value);
-					SEXP_free(value);
-
-					/*
-					 * Parse behaviors
-					 */
-					value = probe_obj_getent(probe_in, "behaviors", 1);
-					if (value != NULL) {
-						bh_value = probe_ent_getattrval(value, "filepaths");
-						if (bh_value != NULL) {
-							if (SEXP_strcmp(bh_value, "true") == 0) {
-								/* collect package files */
-								collect_rpm_files(item, &reply_st[i], g_rpm);
-
-							}
-							SEXP_free(bh_value);
-						}
-						SEXP_free(value);
-					}
-
-				}
-
 
-				SEXP_free(name);
-                                __rpminfo_rep_free (&(reply_st[i]));
-
-				if (probe_item_collect(ctx, item) < 0) {
-					SEXP_free(ent);
-					return PROBE_EUNKNOWN;
-				}
-                        }
-
-                        free (reply_st);
+                for (i = 0; i < rpmret; ++i) {
+			if (rpminfo_collect_pkg(&cc, reply_st[i], NULL) != 0) {
+				free(reply_st);
+				SEXP_free(ent);
+				return PROBE_EUNKNOWN;
+			}
                 }
+
+                free (reply_st);
         }
 
 	SEXP_free(ent);
@@ -50,6 +50,7 @@
 /* SEAP */
 #include <probe-api.h>
 #include "debug_priv.h"
+#include "common/oscap_pcre.h"
 #include "probe/entcmp.h"
 
 #include <probe/probe.h>
@@ -80,10 +81,11 @@ static int rpmverify_collect(probe_ctx *ctx,
 		void (*callback)(probe_ctx *, struct rpmverify_res *),
 		struct rpm_probe_global *g_rpm)
 {
+	struct rpm_snapshot *snap;
 	rpmdbMatchIterator match;
         rpmVerifyAttrs omit = (rpmVerifyAttrs)(flags & RPMVERIFY_RPMATTRMASK);
 	Header pkgh;
-        pcre *re = NULL;
+        struct oscap_pcre *re = NULL;
 	int  ret = -1;
 
         /* pre-compile regex if needed */
@@ -91,7 +93,7 @@ static int rpmverify_collect(probe_ctx *ctx,
                 const char *errmsg;
                 int erroff;
 
-                re = pcre_compile(file, PCRE_UTF8, &errmsg,  &erroff, NULL);
+                re = oscap_pcre_acquire(file, PCRE_UTF8, &errmsg, &erroff);
 
                 if (re == NULL) {
                         /* TODO */
@@ -101,6 +103,8 @@ static int rpmverify_collect(probe_ctx *ctx,
 
         RPMVERIFY_LOCK;
 
+        snap = rpm_snapshot_get(g_rpm->rpmts);
+
         switch (name_op) {
         case OVAL_OPERATION_EQUALS:
 		match = rpmtsInitIterator(g_rpm->rpmts, RPMTAG_NAME, (const void *)name, 0);
@@ -114,7 +118,7 @@ static int rpmverify_collect(probe_ctx *ctx,
 
                 break;
 	case OVAL_OPERATION_NOT_EQUAL:
-		match = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
+		match = rpm_snapshot_iterator(g_rpm->rpmts, snap, name_ent, NULL, NULL, NULL, NULL);
 
                 if (match == NULL) {
                         ret = 0;
@@ -129,7 +133,7 @@ static int rpmverify_collect(probe_ctx *ctx,
 
                 break;
         case OVAL_OPERATION_PATTERN_MATCH:
-		match = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
+		match = rpm_snapshot_iterator(g_rpm->rpmts, snap, name_ent, NULL, NULL, NULL, NULL);
 
                 if (match == NULL) {
                         ret = 0;
@@ -212,8 +216,7 @@ static int rpmverify_collect(probe_ctx *ctx,
 	match = rpmdbFreeIterator (match);
         ret   = 0;
 ret:
-        if (re != NULL)
-                pcre_free(re);
+        oscap_pcre_release(re);
 
         RPMVERIFY_UNLOCK;
         return (ret);
@@ -238,6 +241,7 @@ void *rpmverify_probe_init(void)
 	g_rpm->rpmts = rpmtsCreate();
 
 	pthread_mutex_init(&(g_rpm->mutex), NULL);
+	rpm_snapshot_ref();
         return ((void *)g_rpm);
 }
 
@@ -254,6 +258,7 @@ void rpmverify_probe_fini(void *ptr)
 	if (r == NULL)
 		return;
 
+	rpm_snapshot_unref();
 	rpmtsFree(r->rpmts);
 	pthread_mutex_destroy (&(r->mutex));
 	free(r);
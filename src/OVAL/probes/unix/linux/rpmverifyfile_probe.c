@@ -53,6 +53,7 @@
 /* SEAP */
 #include <probe-api.h>
 #include "debug_priv.h"
+#include "common/oscap_pcre.h"
 #include "probe/entcmp.h"
 
 #include <probe/probe.h>
@@ -156,14 +157,14 @@ static int _compare_file_with_current_file(oval_operation_t file_op, const char
 	} else if (file_op == OVAL_OPERATION_PATTERN_MATCH) {
 		const char *errmsg;
 		int erroff;
-		pcre *re = pcre_compile(file, PCRE_UTF8, &errmsg,  &erroff, NULL);
+		struct oscap_pcre *re = oscap_pcre_acquire(file, PCRE_UTF8, &errmsg, &erroff);
 		if (re == NULL) {
 			dE("pcre_compile pattern='%s': %s", file, errmsg);
 			ret = -1;
 			goto cleanup;
 		}
-		int pcre_ret = pcre_exec(re, NULL, current_file, strlen(current_file), 0, 0, NULL, 0);
-		pcre_free(re);
+		int pcre_ret = oscap_pcre_exec(re, current_file, strlen(current_file), 0, 0, NULL, 0);
+		oscap_pcre_release(re);
 		if (pcre_ret == 0) {
 			/* match */
 			*result_file = oscap_strdup(current_file);
@@ -255,7 +256,9 @@ static int rpmverify_collect(probe_ctx *ctx,
 		 */
 		match = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_INSTFILENAMES, file, 0);
 	} else {
-		match = rpmtsInitIterator(g_rpm->rpmts, RPMDBI_PACKAGES, NULL, 0);
+		struct rpm_snapshot *snap = rpm_snapshot_get(g_rpm->rpmts);
+		match = rpm_snapshot_iterator(g_rpm->rpmts, snap,
+				name_ent, epoch_ent, version_ent, release_ent, arch_ent);
 	}
 	if (match == NULL) {
 		ret = 0;
@@ -358,6 +361,7 @@ void *rpmverifyfile_probe_init(void)
 	g_rpm->rpmts = rpmtsCreate();
 
 	pthread_mutex_init(&(g_rpm->mutex), NULL);
+	rpm_snapshot_ref();
 
 	return ((void *)g_rpm);
 }
@@ -375,6 +379,7 @@ void rpmverifyfile_probe_fini(void *ptr)
 	if (r == NULL)
 		return;
 
+	rpm_snapshot_unref();
 	rpmtsFree(r->rpmts);
 	pthread_mutex_destroy (&(r->mutex));
 	free(r);
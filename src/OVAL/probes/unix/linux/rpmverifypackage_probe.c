@@ -152,6 +152,7 @@ static int rpmverify_collect(probe_ctx *ctx,
 			int (*callback)(probe_ctx *, struct rpmverify_res *),
 			struct verifypackage_global *g_rpm)
 {
+	struct rpm_snapshot *snap;
 	rpmdbMatchIterator match;
 	Header pkgh;
 	int  ret = -1;
@@ -162,7 +163,10 @@ static int rpmverify_collect(probe_ctx *ctx,
 
 	RPMVERIFY_LOCK;
 
-	match = rpmtsInitIterator (g_rpm->rpm.rpmts, RPMDBI_PACKAGES, NULL, 0);
+	snap = rpm_snapshot_get(g_rpm->rpm.rpmts);
+
+	match = rpm_snapshot_iterator(g_rpm->rpm.rpmts, snap,
+			name_ent, epoch_ent, version_ent, release_ent, arch_ent);
 	if (match == NULL) {
 		ret = 0;
 		goto ret;
@@ -345,6 +349,7 @@ void *rpmverifypackage_probe_init(void)
 	}
 
 	g_rpm->rpm.rpmts = rpmtsCreate();
+	rpm_snapshot_ref();
 
 	if (CHROOT_IS_SET()) {
 		CHROOT_LEAVE();
@@ -380,6 +385,7 @@ void rpmverifypackage_probe_fini(void *ptr)
 	if (r->rpm.rpmts == NULL)
 		return;
 
+	rpm_snapshot_unref();
 	rpmtsFree(r->rpm.rpmts);
 	pthread_mutex_destroy (&(r->rpm.mutex));
 
@@ -0,0 +1,693 @@
+/**
+ * @file   systemdshared.c
+ * @brief  functionality shared between systemdunitproperty and systemdunitdependency tests
+ * @author
+ */
+
+/*
+ * Copyright 2014 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ *
+ * Authors:
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <dbus/dbus.h>
+#include "common/debug_priv.h"
+#include "common/list.h"
+#include "oscap_helpers.h"
+#include "systemdshared.h"
+
+/* Maximum number of the GetAll calls waiting for a reply */
+#define SYSTEMD_PENDING_MAX 64
+
+// Old versions of libdbus API don't have DBusBasicValue and DBus8ByteStruct
+// as a public typedefs.
+// These two typedefs were copied from libdbus 1.8 branch, see
+// http://cgit.freedesktop.org/dbus/dbus/tree/dbus/dbus-types.h?h=dbus-1.8#n137
+typedef struct
+{
+	dbus_uint32_t first32;
+	dbus_uint32_t second32;
+} _DBus8ByteStruct;
+
+typedef union
+{
+	unsigned char bytes[8]; /**< as 8 individual bytes */
+	dbus_int16_t  i16;   /**< as int16 */
+	dbus_uint16_t u16;   /**< as int16 */
+	dbus_int32_t  i32;   /**< as int32 */
+	dbus_uint32_t u32;   /**< as int32 */
+	dbus_bool_t   bool_val; /**< as boolean */
+#ifdef DBUS_HAVE_INT64
+	dbus_int64_t  i64;   /**< as int64 */
+	dbus_uint64_t u64;   /**< as int64 */
+#endif
+	_DBus8ByteStruct eight; /**< as 8-byte struct */
+	double dbl;          /**< as double */
+	unsigned char byt;   /**< as byte */
+	char *str;           /**< as char* (string, object path or signature) */
+	int fd;              /**< as Unix file descriptor */
+} _DBusBasicValue;
+
+/*
+ * Units of the scan, the mutex guards the whole cache. The units are
+ * never freed before the cache is dropped and their properties don't
+ * change once read, so they can be used without the mutex.
+ */
+struct systemd_units {
+	DBusConnection *conn;
+	bool listed;
+	struct systemd_unit **units;   /* ListUnits order */
+	size_t count;
+	struct oscap_htable *by_name;  /* listed and loaded units */
+};
+
+static pthread_mutex_t g_units_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct systemd_units g_units;
+static unsigned int g_units_refs = 0;
+
+static char *get_path_by_unit(DBusConnection *conn, const char *unit)
+{
+	DBusMessage *msg = NULL;
+	DBusPendingCall *pending = NULL;
+	_DBusBasicValue path;
+	char *ret = NULL;
+
+	msg = dbus_message_new_method_call(
+		"org.freedesktop.systemd1",
+		"/org/freedesktop/systemd1",
+		"org.freedesktop.systemd1.Manager",
+		// LoadUnit is similar to GetUnit except it will load the unit file
+		// if it hasn't been loaded yet.
+		"LoadUnit"
+	);
+	if (msg == NULL) {
+		dD("Failed to create dbus_message via dbus_message_new_method_call!");
+		goto cleanup;
+	}
+
+	DBusMessageIter args;
+
+	dbus_message_iter_init_append(msg, &args);
+	if (!dbus_message_iter_append_basic(&args, DBUS_TYPE_STRING, &unit)) {
+		dD("Failed to append unit '%s' string parameter to dbus message!", unit);
+		goto cleanup;
+	}
+
+	if (!dbus_connection_send_with_reply(conn, msg, &pending, -1)) {
+		dD("Failed to send message via dbus!");
+		goto cleanup;
+	}
+	if (pending == NULL) {
+		dD("Invalid dbus pending call!");
+		goto cleanup;
+	}
+
+	dbus_connection_flush(conn);
+	dbus_message_unref(msg); msg = NULL;
+
+	dbus_pending_call_block(pending);
+	msg = dbus_pending_call_steal_reply(pending);
+	if (msg == NULL) {
+		dD("Failed to steal dbus pending call reply.");
+		goto cleanup;
+	}
+	dbus_pending_call_unref(pending); pending = NULL;
+
+	if (!dbus_message_iter_init(msg, &args)) {
+		dD("Failed to initialize iterator over received dbus message.");
+		goto cleanup;
+	}
+
+	if (dbus_message_iter_get_arg_type(&args) != DBUS_TYPE_OBJECT_PATH) {
+		dD("Expected string argument in reply. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&args)));
+		goto cleanup;
+	}
+
+	dbus_message_iter_get_basic(&args, &path);
+	ret = oscap_strdup(path.str);
+	dbus_message_unref(msg); msg = NULL;
+
+cleanup:
+	if (pending != NULL)
+		dbus_pending_call_unref(pending);
+
+	if (msg != NULL)
+		dbus_message_unref(msg);
+
+	return ret;
+}
+
+static struct systemd_unit *unit_new(const char *name, const char *path)
+{
+	struct systemd_unit *unit = calloc(1, sizeof(struct systemd_unit));
+
+	unit->name = oscap_strdup(name);
+	unit->path = oscap_strdup(path);
+
+	return unit;
+}
+
+static void unit_free(struct systemd_unit *unit)
+{
+	for (size_t i = 0; i < unit->count; i++) {
+		for (size_t j = 0; j < unit->properties[i].count; j++)
+			free(unit->properties[i].values[j]);
+		free(unit->properties[i].values);
+		free(unit->properties[i].name);
+	}
+	free(unit->properties);
+	free(unit->path);
+	free(unit->name);
+	free(unit);
+}
+
+static int list_units(struct systemd_units *g)
+{
+	DBusMessage *msg = NULL;
+	DBusPendingCall *pending = NULL;
+	char ret = 1;
+
+	msg = dbus_message_new_method_call(
+		"org.freedesktop.systemd1",
+		"/org/freedesktop/systemd1",
+		"org.freedesktop.systemd1.Manager",
+		"ListUnits"
+	);
+	if (msg == NULL) {
+		dD("Failed to create dbus_message via dbus_message_new_method_call!");
+		goto cleanup;
+	}
+
+	DBusMessageIter args, unit_iter;
+
+	// the args should be empty for this call
+	dbus_message_iter_init_append(msg, &args);
+
+	if (!dbus_connection_send_with_reply(g->conn, msg, &pending, -1)) {
+		dD("Failed to send message via dbus!");
+		goto cleanup;
+	}
+	if (pending == NULL) {
+		dD("Invalid dbus pending call!");
+		goto cleanup;
+	}
+
+	dbus_connection_flush(g->conn);
+	dbus_message_unref(msg); msg = NULL;
+
+	dbus_pending_call_block(pending);
+	msg = dbus_pending_call_steal_reply(pending);
+	if (msg == NULL) {
+		dD("Failed to steal dbus pending call reply.");
+		goto cleanup;
+	}
+	dbus_pending_call_unref(pending); pending = NULL;
+
+	if (!dbus_message_iter_init(msg, &args)) {
+		dD("Failed to initialize iterator over received dbus message.");
+		goto cleanup;
+	}
+
+	if (dbus_message_iter_get_arg_type(&args) != DBUS_TYPE_ARRAY) {
+		dD("Expected array of structs in reply. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&args)));
+		goto cleanup;
+	}
+
+	dbus_message_iter_recurse(&args, &unit_iter);
+	for (; dbus_message_iter_get_arg_type(&unit_iter) != DBUS_TYPE_INVALID; dbus_message_iter_next(&unit_iter)) {
+		if (dbus_message_iter_get_arg_type(&unit_iter) != DBUS_TYPE_STRUCT) {
+			dD("Expected unit struct as elements in returned array. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&unit_iter)));
+			goto cleanup;
+		}
+
+		DBusMessageIter unit_field;
+		dbus_message_iter_recurse(&unit_iter, &unit_field);
+
+		if (dbus_message_iter_get_arg_type(&unit_field) != DBUS_TYPE_STRING) {
+			dD("Expected string as the first element in the unit struct. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&unit_field)));
+			goto cleanup;
+		}
+
+		_DBusBasicValue name, path;
+		dbus_message_iter_get_basic(&unit_field, &name);
+
+		// the unit object path is the 7th field of the struct
+		path.str = NULL;
+		for (int i = 0; i < 6; i++) {
+			if (!dbus_message_iter_next(&unit_field))
+				break;
+		}
+		if (dbus_message_iter_get_arg_type(&unit_field) == DBUS_TYPE_OBJECT_PATH)
+			dbus_message_iter_get_basic(&unit_field, &path);
+
+		if (oscap_htable_get(g->by_name, name.str) != NULL)
+			continue;
+
+		struct systemd_unit *unit = unit_new(name.str, path.str);
+		g->units = realloc(g->units, (g->count + 1) * sizeof(struct systemd_unit *));
+		g->units[g->count++] = unit;
+		oscap_htable_add(g->by_name, unit->name, unit);
+	}
+
+	dbus_message_unref(msg); msg = NULL;
+
+	ret = 0;
+
+cleanup:
+	if (pending != NULL)
+		dbus_pending_call_unref(pending);
+
+	if (msg != NULL)
+		dbus_message_unref(msg);
+
+	return ret;
+}
+
+static char *dbus_value_to_string(DBusMessageIter *iter)
+{
+	const int arg_type = dbus_message_iter_get_arg_type(iter);
+	if (dbus_type_is_basic(arg_type)) {
+		_DBusBasicValue value;
+		dbus_message_iter_get_basic(iter, &value);
+
+		switch (arg_type)
+		{
+			case DBUS_TYPE_BYTE:
+				return oscap_sprintf("%c", value.byt);
+
+			case DBUS_TYPE_BOOLEAN:
+				return oscap_strdup(value.bool_val ? "true" : "false");
+
+			case DBUS_TYPE_INT16:
+				return oscap_sprintf("%i", value.i16);
+
+			case DBUS_TYPE_UINT16:
+				return oscap_sprintf("%u", value.u16);
+
+			case DBUS_TYPE_INT32:
+				return oscap_sprintf("%i", value.i32);
+
+			case DBUS_TYPE_UINT32:
+				return oscap_sprintf("%u", value.u32);
+
+#ifdef DBUS_HAVE_INT64
+			case DBUS_TYPE_INT64:
+				return oscap_sprintf("%li", value.i64);
+
+			case DBUS_TYPE_UINT64:
+				return oscap_sprintf("%lu", value.u64);
+#endif
+
+			case DBUS_TYPE_DOUBLE:
+				return oscap_sprintf("%g", value.dbl);
+
+			case DBUS_TYPE_STRING:
+			case DBUS_TYPE_OBJECT_PATH:
+			case DBUS_TYPE_SIGNATURE:
+				return oscap_strdup(value.str);
+
+			// non-basic types
+			//case DBUS_TYPE_ARRAY:
+			//case DBUS_TYPE_STRUCT:
+			//case DBUS_TYPE_DICT_ENTRY:
+			//case DBUS_TYPE_VARIANT:
+
+			//case DBUS_TYPE_UNIX_FD:
+			//	return oscap_sprintf("%i", value.fd);
+
+			default:
+				dD("Encountered unknown dbus basic type!");
+				return oscap_strdup("error, unknown basic type!");
+		}
+	}
+	else if (arg_type == DBUS_TYPE_ARRAY) {
+		DBusMessageIter array;
+		dbus_message_iter_recurse(iter, &array);
+
+		char *ret = NULL;
+		do {
+			char *element = dbus_value_to_string(&array);
+
+			if (element == NULL)
+				continue;
+
+			char *old_ret = ret;
+			if (old_ret == NULL)
+				ret = oscap_sprintf("%s", element);
+			else
+				ret = oscap_sprintf("%s, %s", old_ret, element);
+
+			free(old_ret);
+			free(element);
+		}
+		while (dbus_message_iter_next(&array));
+
+		return ret;
+	}/*
+	else if (arg_type == DBUS_TYPE_VARIANT) {
+		DBusMessageIter inner;
+		dbus_message_iter_recurse(iter, &inner);
+		return dbus_value_to_string(&inner);
+	}*/
+
+	return NULL;
+}
+
+static DBusPendingCall *send_get_all(DBusConnection *conn, const char *unit_path)
+{
+	DBusMessage *msg = NULL;
+	DBusPendingCall *pending = NULL;
+
+	if (unit_path == NULL)
+		return NULL;
+
+	msg = dbus_message_new_method_call(
+		"org.freedesktop.systemd1",
+		unit_path,
+		"org.freedesktop.DBus.Properties",
+		"GetAll"
+	);
+	if (msg == NULL) {
+		dD("Failed to create dbus_message via dbus_message_new_method_call!");
+		return NULL;
+	}
+
+	DBusMessageIter args;
+
+	const char *interface = "org.freedesktop.systemd1.Unit";
+
+	dbus_message_iter_init_append(msg, &args);
+	if (!dbus_message_iter_append_basic(&args, DBUS_TYPE_STRING, &interface)) {
+		dD("Failed to append interface '%s' string parameter to dbus message!", interface);
+		dbus_message_unref(msg);
+		return NULL;
+	}
+
+	if (!dbus_connection_send_with_reply(conn, msg, &pending, -1)) {
+		dD("Failed to send message via dbus!");
+		pending = NULL;
+	} else if (pending == NULL) {
+		dD("Invalid dbus pending call!");
+	}
+	dbus_message_unref(msg);
+
+	return pending;
+}
+
+static void unit_add_property(struct systemd_unit *unit, const char *name, char *value)
+{
+	struct systemd_property *property;
+
+	if (unit->count == 0 || strcmp(unit->properties[unit->count - 1].name, name) != 0) {
+		unit->properties = realloc(unit->properties, (unit->count + 1) * sizeof(struct systemd_property));
+		property = &unit->properties[unit->count++];
+		property->name = oscap_strdup(name);
+		property->values = NULL;
+		property->count = 0;
+	} else {
+		property = &unit->properties[unit->count - 1];
+	}
+
+	property->values = realloc(property->values, (property->count + 1) * sizeof(char *));
+	property->values[property->count++] = value;
+}
+
+/*
+ * Wait for the reply of the GetAll call and store the properties.
+ */
+static void read_get_all(DBusPendingCall *pending, struct systemd_unit *unit)
+{
+	DBusMessage *msg = NULL;
+
+	unit->loaded = true;
+	if (pending == NULL)
+		return;
+
+	dbus_pending_call_block(pending);
+	msg = dbus_pending_call_steal_reply(pending);
+	dbus_pending_call_unref(pending);
+	if (msg == NULL) {
+		dD("Failed to steal dbus pending call reply.");
+		return;
+	}
+
+	DBusMessageIter args, property_iter;
+
+	if (!dbus_message_iter_init(msg, &args)) {
+		dD("Failed to initialize iterator over received dbus message.");
+		goto cleanup;
+	}
+
+	if (dbus_message_iter_get_arg_type(&args) != DBUS_TYPE_ARRAY && dbus_message_iter_get_element_type(&args) != DBUS_TYPE_DICT_ENTRY) {
+		dD("Expected array of dict_entry argument in reply. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&args)));
+		goto cleanup;
+	}
+
+	dbus_message_iter_recurse(&args, &property_iter);
+	do {
+		DBusMessageIter dict_entry, value_variant;
+		dbus_message_iter_recurse(&property_iter, &dict_entry);
+
+		if (dbus_message_iter_get_arg_type(&dict_entry) != DBUS_TYPE_STRING) {
+			dD("Expected string as key in dict_entry. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&dict_entry)));
+			goto cleanup;
+		}
+
+		_DBusBasicValue value;
+		dbus_message_iter_get_basic(&dict_entry, &value);
+		const char *property_name = value.str;
+
+		if (dbus_message_iter_next(&dict_entry) == false) {
+			dW("Expected another field in dict_entry.");
+			goto cleanup;
+		}
+
+		if (dbus_message_iter_get_arg_type(&dict_entry) != DBUS_TYPE_VARIANT) {
+			dD("Expected variant as value in dict_entry. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&dict_entry)));
+			goto cleanup;
+		}
+
+		dbus_message_iter_recurse(&dict_entry, &value_variant);
+
+		const int arg_type = dbus_message_iter_get_arg_type(&value_variant);
+		// DBUS_TYPE_ARRAY is a special case, we keep each element as one value
+		if (arg_type == DBUS_TYPE_ARRAY) {
+			DBusMessageIter array;
+			dbus_message_iter_recurse(&value_variant, &array);
+
+			do {
+				char *element = dbus_value_to_string(&array);
+				if (element == NULL)
+					continue;
+
+				unit_add_property(unit, property_name, element);
+			}
+			while (dbus_message_iter_next(&array));
+		}
+		else {
+			unit_add_property(unit, property_name, dbus_value_to_string(&value_variant));
+		}
+	}
+	while (dbus_message_iter_next(&property_iter));
+
+cleanup:
+	dbus_message_unref(msg);
+}
+
+/*
+ * Read the properties of the units, at most SYSTEMD_PENDING_MAX calls are
+ * waiting for a reply at a time. The caller has to hold the mutex.
+ */
+static void load_properties(struct systemd_units *g, struct systemd_unit **units, size_t count)
+{
+	DBusPendingCall *pending[SYSTEMD_PENDING_MAX];
+	size_t sent = 0, done = 0;
+
+	while (done < count) {
+		while (sent < count && sent - done < SYSTEMD_PENDING_MAX) {
+			pending[sent % SYSTEMD_PENDING_MAX] = send_get_all(g->conn, units[sent]->path);
+			++sent;
+		}
+		dbus_connection_flush(g->conn);
+		read_get_all(pending[done % SYSTEMD_PENDING_MAX], units[done]);
+		++done;
+	}
+}
+
+static DBusConnection *connect_dbus()
+{
+	DBusConnection *conn = NULL;
+
+	DBusError err;
+	dbus_error_init(&err);
+
+	const char *prefix = getenv("OSCAP_PROBE_ROOT");
+	if (prefix != NULL) {
+		char dbus_address[PATH_MAX] = {0};
+		snprintf(dbus_address, PATH_MAX, "unix:path=%s/run/dbus/system_bus_socket", prefix);
+		setenv("DBUS_SYSTEM_BUS_ADDRESS", dbus_address, 0);
+		/* We won't overwrite DBUS_SYSTEM_BUS_ADDRESS so that
+		 * user could have a way to define some non-standard system bus socket location */
+	}
+
+	conn = dbus_bus_get(DBUS_BUS_SYSTEM, &err);
+	if (dbus_error_is_set(&err)) {
+		dD("Failed to get DBUS_BUS_SYSTEM connection - %s", err.message);
+		goto cleanup;
+	}
+	if (conn == NULL) {
+		dD("DBusConnection == NULL!");
+		goto cleanup;
+	}
+
+	dbus_bus_register(conn, &err);
+	if (dbus_error_is_set(&err)) {
+		dD("Failed to register on dbus - %s", err.message);
+		goto cleanup;
+	}
+
+cleanup:
+	dbus_error_free(&err);
+
+	return conn;
+}
+
+/*
+ * Connect and list the units if it wasn't done yet, the caller has to
+ * hold the mutex.
+ */
+static int systemd_units_init(struct systemd_units *g)
+{
+	if (g->conn == NULL) {
+		g->conn = connect_dbus();
+		if (g->conn == NULL)
+			return -1;
+	}
+	if (!g->listed) {
+		if (list_units(g) != 0)
+			return 1;
+		g->listed = true;
+	}
+	return 0;
+}
+
+void systemd_units_ref(void)
+{
+	pthread_mutex_lock(&g_units_mutex);
+	if (g_units_refs++ == 0) {
+		g_units.conn = NULL;
+		g_units.listed = false;
+		g_units.units = NULL;
+		g_units.count = 0;
+		g_units.by_name = oscap_htable_new();
+	}
+	pthread_mutex_unlock(&g_units_mutex);
+}
+
+void systemd_units_unref(void)
+{
+	pthread_mutex_lock(&g_units_mutex);
+	if (g_units_refs > 0 && --g_units_refs == 0) {
+		oscap_htable_free(g_units.by_name, (oscap_destruct_func) unit_free);
+		free(g_units.units);
+		// Connections retrieved via dbus_bus_get shall not be closed,
+		// these connections are shared.
+		if (g_units.conn != NULL)
+			dbus_connection_unref(g_units.conn);
+		memset(&g_units, 0, sizeof(g_units));
+	}
+	pthread_mutex_unlock(&g_units_mutex);
+}
+
+int get_all_systemd_units(int(*callback)(const char *, void *), void *cbarg)
+{
+	int ret;
+
+	pthread_mutex_lock(&g_units_mutex);
+	ret = systemd_units_init(&g_units);
+	pthread_mutex_unlock(&g_units_mutex);
+	if (ret != 0)
+		return ret;
+
+	/* The list doesn't change once it's read */
+	for (size_t i = 0; i < g_units.count; i++) {
+		if (callback(g_units.units[i]->name, cbarg) != 0)
+			return 1;
+	}
+	return 0;
+}
+
+int systemd_units_prefetch(char * const *units, size_t count)
+{
+	struct systemd_unit **load;
+	size_t nload = 0;
+
+	if (count == 0)
+		return 0;
+	load = malloc(count * sizeof(struct systemd_unit *));
+	if (load == NULL)
+		return -1;
+
+	pthread_mutex_lock(&g_units_mutex);
+	if (systemd_units_init(&g_units) == 0) {
+		for (size_t i = 0; i < count; i++) {
+			struct systemd_unit *unit = oscap_htable_get(g_units.by_name, units[i]);
+			if (unit != NULL && !unit->loaded)
+				load[nload++] = unit;
+		}
+		load_properties(&g_units, load, nload);
+	}
+	pthread_mutex_unlock(&g_units_mutex);
+	free(load);
+	return 0;
+}
+
+const struct systemd_unit *systemd_unit_get(const char *name)
+{
+	struct systemd_unit *unit = NULL;
+
+	pthread_mutex_lock(&g_units_mutex);
+	if (systemd_units_init(&g_units) != 0)
+		goto cleanup;
+
+	unit = oscap_htable_get(g_units.by_name, name);
+	if (unit == NULL) {
+		char *path = get_path_by_unit(g_units.conn, name);
+		if (path == NULL)
+			goto cleanup;
+		unit = unit_new(name, path);
+		free(path);
+		oscap_htable_add(g_units.by_name, unit->name, unit);
+	}
+	if (!unit->loaded)
+		load_properties(&g_units, &unit, 1);
+
+cleanup:
+	pthread_mutex_unlock(&g_units_mutex);
+	return unit;
+}
@@ -36,90 +36,17 @@
 #include "probe/entcmp.h"
 #include "systemdshared.h"
 #include "common/list.h"
+#include "oscap_helpers.h"
+#include <stdlib.h>
 #include <string.h>
 #include "systemdunitdependency_probe.h"
 
-static void get_all_dependencies_by_unit(DBusConnection *conn, const char *unit, SEXP_t *item, struct oscap_htable *visited_units);
-
-static char *get_property_by_unit_path(DBusConnection *conn, const char *unit_path, const char *property)
-{
-	DBusMessage *msg = NULL;
-	DBusPendingCall *pending = NULL;
-	char *ret = NULL;
-
-	msg = dbus_message_new_method_call(
-		"org.freedesktop.systemd1",
-		unit_path,
-		"org.freedesktop.DBus.Properties",
-		"Get"
-	);
-	if (msg == NULL) {
-		dD("Failed to create dbus_message via dbus_message_new_method_call!");
-		goto cleanup;
-	}
-
-	DBusMessageIter args, value_iter;
-
-	const char *interface = "org.freedesktop.systemd1.Unit";
-
-	dbus_message_iter_init_append(msg, &args);
-	if (!dbus_message_iter_append_basic(&args, DBUS_TYPE_STRING, &interface)) {
-		dD("Failed to append interface '%s' string parameter to dbus message!", interface);
-		goto cleanup;
-	}
-	if (!dbus_message_iter_append_basic(&args, DBUS_TYPE_STRING, &property)) {
-		dD("Failed to append property '%s' string parameter to dbus message!", property);
-		goto cleanup;
-	}
-
-	if (!dbus_connection_send_with_reply(conn, msg, &pending, -1)) {
-		dD("Failed to send message via dbus!");
-		goto cleanup;
-	}
-	if (pending == NULL) {
-		dD("Invalid dbus pending call!");
-		goto cleanup;
-	}
-
-	dbus_connection_flush(conn);
-	dbus_message_unref(msg); msg = NULL;
-
-	dbus_pending_call_block(pending);
-	msg = dbus_pending_call_steal_reply(pending);
-	if (msg == NULL) {
-		dD("Failed to steal dbus pending call reply.");
-		goto cleanup;
-	}
-	dbus_pending_call_unref(pending); pending = NULL;
-
-	if (!dbus_message_iter_init(msg, &args)) {
-		dD("Failed to initialize iterator over received dbus message.");
-		goto cleanup;
-	}
-
-	if (dbus_message_iter_get_arg_type(&args) != DBUS_TYPE_VARIANT)
-	{
-		dD("Expected variant argument in reply. Instead received: %s.", dbus_message_type_to_string(dbus_message_iter_get_arg_type(&args)));
-		goto cleanup;
-	}
-
-	dbus_message_iter_recurse(&args, &value_iter);
-	ret = dbus_value_to_string(&value_iter);
-
-	dbus_message_unref(msg); msg = NULL;
-
-cleanup:
-	if (pending != NULL)
-		dbus_pending_call_unref(pending);
-
-	if (msg != NULL)
-		dbus_message_unref(msg);
-
-	return ret;
-}
+static void get_all_dependencies_by_unit(const char *unit, SEXP_t *item, struct oscap_htable *visited_units);
 
 struct unit_callback_vars {
-	DBusConnection *dbus_conn;
+	char **units;
+	size_t count;
+	bool nomem;
 	probe_ctx *ctx;
 	SEXP_t *unit_entity;
 };
@@ -151,26 +78,26 @@ static int add_unit_dependency(const char *dependency, SEXP_t *item, struct osca
 	return 0;
 }
 
-static void process_unit_property(const char *property, DBusConnection *conn, const char *path, SEXP_t *item, struct oscap_htable *visited_units)
+static void process_unit_property(const char *property, const struct systemd_unit *unit, SEXP_t *item, struct oscap_htable *visited_units)
 {
-	char *values_s = get_property_by_unit_path(conn, path, property);
-	if (values_s) {
-		char **values = oscap_split(values_s, ", ");
-		for (int i = 0; values[i] != NULL; ++i) {
-			if (oscap_strcmp(values[i], "") == 0) {
+	for (size_t i = 0; i < unit->count; i++) {
+		if (strcmp(unit->properties[i].name, property) != 0)
+			continue;
+
+		char * const *values = unit->properties[i].values;
+		for (size_t j = 0; j < unit->properties[i].count; ++j) {
+			if (oscap_strcmp(values[j], "") == 0) {
 				continue;
 			}
 
-			if (add_unit_dependency(values[i], item, visited_units) == 0) {
-				get_all_dependencies_by_unit(conn, values[i], item, visited_units);
+			if (add_unit_dependency(values[j], item, visited_units) == 0) {
+				get_all_dependencies_by_unit(values[j], item, visited_units);
 			}
 		}
-		free(values);
 	}
-	free(values_s);
 }
 
-static void get_all_dependencies_by_unit(DBusConnection *conn, const char *unit, SEXP_t *item, struct oscap_htable *visited_units)
+static void get_all_dependencies_by_unit(const char *unit, SEXP_t *item, struct oscap_htable *visited_units)
 {
 	if (!unit || strcmp(unit, "(null)") == 0)
 		return;
@@ -179,12 +106,12 @@ static void get_all_dependencies_by_unit(DBusConnection *conn, const char *unit,
 	if (!is_unit_name_a_target(unit))
 		return;
 
-	char *path = get_path_by_unit(conn, unit);
-
-	process_unit_property("Requires", conn, path, item, visited_units);
-	process_unit_property("Wants", conn, path, item, visited_units);
+	const struct systemd_unit *u = systemd_unit_get(unit);
+	if (u == NULL)
+		return;
 
-	free(path);
+	process_unit_property("Requires", u, item, visited_units);
+	process_unit_property("Wants", u, item, visited_units);
 }
 
 static int unit_callback(const char *unit, void *cbarg)
@@ -192,24 +119,38 @@ static int unit_callback(const char *unit, void *cbarg)
 	struct unit_callback_vars *vars = (struct unit_callback_vars *)cbarg;
 	SEXP_t *se_unit = SEXP_string_new(unit, strlen(unit));
 
-	if (probe_entobj_cmp(vars->unit_entity, se_unit) != OVAL_RESULT_TRUE) {
-		/* Do nothing, continue with the next unit */
-		SEXP_free(se_unit);
-		return 0;
+	if (probe_entobj_cmp(vars->unit_entity, se_unit) == OVAL_RESULT_TRUE) {
+		char **units = realloc(vars->units, (vars->count + 1) * sizeof(char *));
+		char *name = oscap_strdup(unit);
+
+		if (units == NULL || name == NULL) {
+			if (units != NULL)
+				vars->units = units;
+			free(name);
+			SEXP_free(se_unit);
+			vars->nomem = true;
+			return 1;
+		}
+		vars->units = units;
+		vars->units[vars->count++] = name;
 	}
+	SEXP_free(se_unit);
+	return 0;
+}
 
+static void collect_unit(const char *unit, struct unit_callback_vars *vars)
+{
+	SEXP_t *se_unit = SEXP_string_new(unit, strlen(unit));
 	SEXP_t *item = probe_item_create(OVAL_LINUX_SYSTEMDUNITDEPENDENCY, NULL,
 					 "unit", OVAL_DATATYPE_SEXP, se_unit,
 					 NULL);
 
 	struct oscap_htable *visited_units = oscap_htable_new();
-	get_all_dependencies_by_unit(vars->dbus_conn, unit, item, visited_units);
+	get_all_dependencies_by_unit(unit, item, visited_units);
 	oscap_htable_free(visited_units, NULL);
 
 	probe_item_collect(vars->ctx, item);
 	SEXP_free(se_unit);
-
-	return 0;
 }
 
 int systemdunitdependency_probe_offline_mode_supported(void)
@@ -230,14 +171,18 @@ int systemdunitdependency_probe_main(probe_ctx *ctx, void *probe_arg)
 		return PROBE_EOPNOTSUPP;
 	}
 
-	DBusError dbus_error;
-	DBusConnection *dbus_conn;
+	unit_entity = probe_obj_getent(probe_in, "unit", 1);
+
+	struct unit_callback_vars vars;
 
-	dbus_error_init(&dbus_error);
-	dbus_conn = connect_dbus();
+	vars.units = NULL;
+	vars.count = 0;
+	vars.nomem = false;
+	vars.ctx = ctx;
+	vars.unit_entity = unit_entity;
 
-	if (dbus_conn == NULL) {
-		dbus_error_free(&dbus_error);
+	if (get_all_systemd_units(unit_callback, &vars) == -1) {
+		SEXP_free(unit_entity);
 		SEXP_t *msg = probe_msg_creat(OVAL_MESSAGE_LEVEL_INFO, "DBus connection failed, could not identify systemd units.");
 		probe_cobj_set_flag(probe_ctx_getresult(ctx), ctx->offline_mode == PROBE_OFFLINE_NONE ? SYSCHAR_FLAG_ERROR : SYSCHAR_FLAG_NOT_COLLECTED);
 		probe_cobj_add_msg(probe_ctx_getresult(ctx), msg);
@@ -245,19 +190,53 @@ int systemdunitdependency_probe_main(probe_ctx *ctx, void *probe_arg)
 		return 0;
 	}
 
-	unit_entity = probe_obj_getent(probe_in, "unit", 1);
+	int ret = 0;
+	char **targets = NULL;
+	size_t target_count = 0;
 
-	struct unit_callback_vars vars;
+	if (vars.nomem) {
+		ret = PROBE_ENOMEM;
+		goto cleanup;
+	}
 
-	vars.dbus_conn = dbus_conn;
-	vars.ctx = ctx;
-	vars.unit_entity = unit_entity;
+	/* Read the properties of all the matching targets at once */
+	if (vars.count > 0) {
+		targets = malloc(vars.count * sizeof(char *));
+		if (targets == NULL) {
+			ret = PROBE_ENOMEM;
+			goto cleanup;
+		}
+	}
+	for (size_t i = 0; i < vars.count; i++) {
+		if (is_unit_name_a_target(vars.units[i]))
+			targets[target_count++] = vars.units[i];
+	}
+	if (systemd_units_prefetch(targets, target_count) != 0) {
+		ret = PROBE_ENOMEM;
+		goto cleanup;
+	}
 
-	get_all_systemd_units(dbus_conn, unit_callback, &vars);
+	for (size_t i = 0; i < vars.count; i++)
+		collect_unit(vars.units[i], &vars);
+
+cleanup:
+	free(targets);
+	for (size_t i = 0; i < vars.count; i++)
+		free(vars.units[i]);
+	free(vars.units);
 
 	SEXP_free(unit_entity);
-	dbus_error_free(&dbus_error);
-	disconnect_dbus(dbus_conn);
 
-        return 0;
+        return ret;
+}
+
+void *systemdunitdependency_probe_init(void)
+{
+	systemd_units_ref();
+	return NULL;
+}
+
+void systemdunitdependency_probe_fini(void *arg)
+{
+	systemd_units_unref();
 }
@@ -27,6 +27,10 @@
 
 int systemdunitproperty_probe_offline_mode_supported(void);
 
+void *systemdunitproperty_probe_init(void);
+
 int systemdunitproperty_probe_main(probe_ctx *ctx, void *arg);
 
+void systemdunitproperty_probe_fini(void *arg);
+
 #endif /* OPENSCAP_SYSTEMDUNITPROPERTY_PROBE_H */
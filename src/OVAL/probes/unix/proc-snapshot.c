@@ -0,0 +1,498 @@
+/**
+ * @file   proc-snapshot.c
+ * @brief  snapshot of the /proc process table shared by the process probes
+ */
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "oscap_platforms.h"
+
+#if defined(OS_LINUX)
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <limits.h>
+#include <ctype.h>
+#include <unistd.h>
+#ifdef HAVE_STDIO_EXT_H
+# include <stdio_ext.h>
+#endif
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#include "common/debug_priv.h"
+#include "common/oscap_buffer.h"
+#include "proc-snapshot.h"
+
+#define CHUNK_SIZE 1024
+
+static pthread_mutex_t g_snapshot_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct proc_snapshot *g_snapshots = NULL;
+static struct proc_snapshot *g_stale_snapshots = NULL;
+static unsigned int g_snapshot_refs = 0;
+
+static void proc_snapshot_free(struct proc_snapshot *snap)
+{
+	for (size_t i = 0; i < snap->count; ++i)
+		free(snap->procs[i].cmdline);
+	free(snap->procs);
+	free(snap->sockets);
+	free(snap->root);
+	free(snap);
+}
+
+static void read_boot_time(struct proc_snapshot *snap)
+{
+	char buf[PATH_MAX];
+	FILE *sf;
+	int line;
+
+	snprintf(buf, sizeof(buf), "%s/proc/stat", snap->root);
+	sf = fopen(buf, "rt");
+	if (sf == NULL)
+		return;
+
+	line = 0;
+	__fsetlocking(sf, FSETLOCKING_BYCALLER);
+	while (fgets(buf, sizeof(buf), sf)) {
+		if (line == 0) {
+			line++;
+			continue;
+		}
+		if (memcmp(buf, "btime", 5) == 0) {
+			sscanf(buf, "btime %lu", &snap->boot);
+			break;
+		}
+	}
+	fclose(sf);
+}
+
+/* parse the stat file, returns false for kernel threads and unparsable files */
+static bool read_stat(const char *root, int pid, struct proc_entry *p)
+{
+	char buf[PATH_MAX], *tmp;
+	int fd, len, pgrp, tpgid;
+	unsigned flags;
+	unsigned long minflt, cminflt, majflt, cmajflt;
+	long cutime, cstime, cnice, nthreads, itrealvalue;
+
+	snprintf(buf, PATH_MAX, "%s/proc/%d/stat", root, pid);
+	fd = open(buf, O_RDONLY, 0);
+	if (fd < 0)
+		return false;
+	len = read(fd, buf, sizeof buf - 1);
+	close(fd);
+	if (len < 40)
+		return false;
+	buf[len] = 0;
+	tmp = strrchr(buf, ')');
+	if (tmp)
+		*tmp = 0;
+	else
+		return false;
+	memset(p->comm, 0, sizeof(p->comm));
+	sscanf(buf, "%d (%15c", &p->ppid, p->comm);
+	sscanf(tmp+2,	"%c %d %d %d %d %d "
+			"%u %lu %lu %lu %lu "
+			"%lu %lu %lu %ld %ld "
+			"%ld %ld %ld %llu",
+		&p->state, &p->ppid, &pgrp, &p->session, &p->tty_nr, &tpgid,
+		&flags, &minflt, &cminflt, &majflt, &cmajflt,
+		&p->utime, &p->stime, &cutime, &cstime, &p->priority,
+		&cnice, &nthreads, &itrealvalue, &p->start
+	);
+
+	// Skip kthreads
+	return p->ppid != 2;
+}
+
+static void read_uids(const char *root, struct proc_entry *p)
+{
+	char buf[PATH_MAX];
+	FILE *sf;
+
+	p->ruid = -1;
+	p->euid = -1;
+	p->loginuid = -1;
+
+	snprintf(buf, sizeof(buf), "%s/proc/%d/status", root, p->pid);
+	sf = fopen(buf, "rt");
+	if (sf) {
+		int line = 0;
+		__fsetlocking(sf, FSETLOCKING_BYCALLER);
+		while (fgets(buf, sizeof(buf), sf)) {
+			if (line == 0) {
+				line++;
+				continue;
+			}
+			if (memcmp(buf, "Uid:", 4) == 0) {
+				sscanf(buf, "Uid: %d %d", &p->ruid, &p->euid);
+				break;
+			}
+		}
+		fclose(sf);
+	}
+
+	snprintf(buf, sizeof(buf), "%s/proc/%d/loginuid", root, p->pid);
+	sf = fopen(buf, "rt");
+	if (sf) {
+		if (fscanf(sf, "%u", &p->loginuid) < 1) {
+			dW("fscanf failed from %s", buf);
+		}
+		fclose(sf);
+	}
+}
+
+/**
+ * Parse /proc/%d/cmdline file
+ * @return ps-like command line or NULL
+ */
+static char *read_cmdline(const char *root, int pid, struct oscap_buffer *buffer)
+{
+	char filepath[PATH_MAX];
+	int fd;
+
+	snprintf(filepath, PATH_MAX, "%s/proc/%d/cmdline", root, pid);
+	fd = open(filepath, O_RDONLY, 0);
+	if (fd < 0) {
+		return NULL;
+	}
+
+	oscap_buffer_clear(buffer);
+
+	for(;;) {
+		char chunk[CHUNK_SIZE];
+		// Read data, store to buffer
+		ssize_t read_size = read(fd, chunk, CHUNK_SIZE);
+		if (read_size < 0) {
+			close(fd);
+			return NULL;
+		}
+		oscap_buffer_append_binary_data(buffer, chunk, read_size);
+
+		// If reach end of file, then end the loop
+		if (CHUNK_SIZE != read_size) {
+			break;
+		}
+	}
+
+	close(fd);
+
+	int length = oscap_buffer_get_length(buffer);
+	char* buffer_mem = oscap_buffer_get_raw(buffer);
+
+	if ( length == 0 ) { // empty file
+		return NULL;
+	}
+
+	// Skip multiple trailing zeros
+	int i = length - 1;
+	while ( (i > 0) && (buffer_mem[i] == '\0') ) {
+		--i;
+	}
+
+	// Program and args are separated by '\0'
+	// Replace them with spaces ' '
+	while( i >= 0 ){
+		char chr = buffer_mem[i];
+		if ( ( chr == '\0') || ( chr == '\n' ) ) {
+			buffer_mem[i] = ' ';
+		} else if ( !isprint(chr) ) { // "ps" replace non-printable characters with '.' (LC_ALL=C)
+			buffer_mem[i] = '.';
+		}
+		--i;
+	}
+
+	return strdup(buffer_mem);
+}
+
+static struct proc_snapshot *proc_snapshot_new(const char *root)
+{
+	char buf[PATH_MAX];
+	struct proc_snapshot *snap;
+	struct oscap_buffer *cmdline_buffer;
+	struct dirent *ent;
+	size_t alloc = 0;
+	DIR *d;
+
+	snap = calloc(1, sizeof(struct proc_snapshot));
+	if (snap == NULL)
+		return NULL;
+	snap->root = strdup(root);
+	if (snap->root == NULL) {
+		free(snap);
+		return NULL;
+	}
+
+	snprintf(buf, PATH_MAX, "%s/proc", root);
+	d = opendir(buf);
+	if (d == NULL) {
+		dD("Can't open '%s': %s", buf, strerror(errno));
+		return snap;
+	}
+	snap->readable = true;
+
+	read_boot_time(snap);
+	cmdline_buffer = oscap_buffer_new();
+
+	while (( ent = readdir(d) )) {
+		struct proc_entry p;
+		int pid;
+
+		// Skip non-process dir entries
+		if(*ent->d_name<'0' || *ent->d_name>'9')
+			continue;
+		errno = 0;
+		pid = strtol(ent->d_name, NULL, 10);
+		if (errno || pid == 2) // skip err & kthreads
+			continue;
+
+		memset(&p, 0, sizeof(p));
+		p.pid = pid;
+		if (!read_stat(root, pid, &p))
+			continue;
+		read_uids(root, &p);
+		if (p.state != 'Z')
+			p.cmdline = read_cmdline(root, pid, cmdline_buffer);
+
+		if (snap->count == alloc) {
+			void *new_procs;
+
+			alloc = alloc > 0 ? alloc * 2 : 256;
+			new_procs = realloc(snap->procs, alloc * sizeof(struct proc_entry));
+			if (new_procs == NULL) {
+				free(p.cmdline);
+				break;
+			}
+			snap->procs = new_procs;
+		}
+		snap->procs[snap->count++] = p;
+	}
+	closedir(d);
+	oscap_buffer_free(cmdline_buffer);
+
+	dD("Read %zu processes from '%s/proc'.", snap->count, root);
+	return snap;
+}
+
+static void proc_snapshot_free_list(struct proc_snapshot **list)
+{
+	while (*list != NULL) {
+		struct proc_snapshot *next = (*list)->next;
+		proc_snapshot_free(*list);
+		*list = next;
+	}
+}
+
+static void proc_snapshot_invalidate_locked(void)
+{
+	if (g_snapshot_refs == 0) {
+		proc_snapshot_free_list(&g_snapshots);
+		return;
+	}
+	/* a running probe may still use them, free them with the last reference */
+	while (g_snapshots != NULL) {
+		struct proc_snapshot *next = g_snapshots->next;
+		g_snapshots->next = g_stale_snapshots;
+		g_stale_snapshots = g_snapshots;
+		g_snapshots = next;
+	}
+}
+
+void proc_snapshot_ref(void)
+{
+	pthread_mutex_lock(&g_snapshot_mutex);
+	/* the initialized probe reads the processes again */
+	proc_snapshot_invalidate_locked();
+	++g_snapshot_refs;
+	pthread_mutex_unlock(&g_snapshot_mutex);
+}
+
+void proc_snapshot_invalidate(void)
+{
+	pthread_mutex_lock(&g_snapshot_mutex);
+	proc_snapshot_invalidate_locked();
+	pthread_mutex_unlock(&g_snapshot_mutex);
+}
+
+void proc_snapshot_unref(void)
+{
+	pthread_mutex_lock(&g_snapshot_mutex);
+	if (g_snapshot_refs > 0 && --g_snapshot_refs == 0) {
+		proc_snapshot_free_list(&g_snapshots);
+		proc_snapshot_free_list(&g_stale_snapshots);
+	}
+	pthread_mutex_unlock(&g_snapshot_mutex);
+}
+
+struct proc_snapshot *proc_snapshot_get(const char *root)
+{
+	struct proc_snapshot *snap;
+
+	if (root == NULL)
+		root = "";
+
+	pthread_mutex_lock(&g_snapshot_mutex);
+	for (snap = g_snapshots; snap != NULL; snap = snap->next) {
+		if (strcmp(snap->root, root) == 0)
+			break;
+	}
+	if (snap == NULL) {
+		snap = proc_snapshot_new(root);
+		if (snap != NULL) {
+			snap->next = g_snapshots;
+			g_snapshots = snap;
+		}
+	}
+	pthread_mutex_unlock(&g_snapshot_mutex);
+
+	return snap;
+}
+
+static int proc_socket_cmp(const void *a, const void *b)
+{
+	const struct proc_socket *sa = a, *sb = b;
+
+	if (sa->inode != sb->inode)
+		return sa->inode < sb->inode ? -1 : 1;
+	if (sa->proc != sb->proc)
+		return sa->proc < sb->proc ? -1 : 1;
+	return 0;
+}
+
+/* get the socket inodes the process has open */
+static void read_sockets(struct proc_snapshot *snap, size_t proc, size_t *alloc)
+{
+	char buf[PATH_MAX];
+	struct dirent *ent;
+	DIR *f;
+
+	snprintf(buf, PATH_MAX, "%s/proc/%d/fd", snap->root, snap->procs[proc].pid);
+	f = opendir(buf);
+	if (f == NULL) {
+		if (errno == EACCES) {
+			/* Need DAC_OVERRIDE permission */
+			snap->fd_denied = true;
+		}
+		// Process might have ended or something - ignore it
+		return;
+	}
+	// For each file in the fd dir...
+	while (( ent = readdir(f) )) {
+		char line[PATH_MAX], ln[PATH_MAX], *s, *e;
+		unsigned long inode;
+		int lnlen;
+
+		if (ent->d_name[0] == '.')
+			continue;
+		snprintf(ln, PATH_MAX, "%s/%s", buf, ent->d_name);
+		if ((lnlen = readlink(ln, line, sizeof(line)-1)) < 0)
+			continue;
+		line[lnlen] = 0;
+
+		// Only look at the socket entries
+		if (memcmp(line, "socket:", 7) == 0) {
+			// Type 1 sockets
+			s = strchr(line+7, '[');
+			if (s == NULL)
+				continue;
+			s++;
+			e = strchr(s, ']');
+			if (e == NULL)
+				continue;
+			*e = 0;
+		} else if (memcmp(line, "[0000]:", 7) == 0) {
+			// Type 2 sockets
+			s = line + 8;
+		} else
+			continue;
+		errno = 0;
+		inode = strtoul(s, NULL, 10);
+		if (errno)
+			continue;
+
+		if (snap->nsockets == *alloc) {
+			size_t n = *alloc > 0 ? *alloc * 2 : 1024;
+			void *new_sockets = realloc(snap->sockets, n * sizeof(struct proc_socket));
+
+			if (new_sockets == NULL)
+				break;
+			snap->sockets = new_sockets;
+			*alloc = n;
+		}
+		snap->sockets[snap->nsockets].inode = inode;
+		snap->sockets[snap->nsockets].proc = proc;
+		snap->nsockets++;
+	}
+	closedir(f);
+}
+
+void proc_snapshot_read_sockets(struct proc_snapshot *snap)
+{
+	size_t alloc = 0;
+
+	pthread_mutex_lock(&g_snapshot_mutex);
+	if (!snap->sockets_read) {
+		for (size_t i = 0; i < snap->count; ++i)
+			read_sockets(snap, i, &alloc);
+		qsort(snap->sockets, snap->nsockets, sizeof(struct proc_socket), proc_socket_cmp);
+		snap->sockets_read = true;
+		dD("Read %zu socket inodes of %zu processes.", snap->nsockets, snap->count);
+	}
+	pthread_mutex_unlock(&g_snapshot_mutex);
+}
+
+bool proc_snapshot_is_current(const struct proc_snapshot *snap, const struct proc_entry *p)
+{
+	struct proc_entry now;
+
+	/* a pid reused by another process has a different start time */
+	if (!read_stat(snap->root, p->pid, &now))
+		return false;
+
+	return now.start == p->start;
+}
+
+const struct proc_entry *proc_snapshot_find_socket(const struct proc_snapshot *snap, unsigned long inode)
+{
+	size_t lo = 0, hi = snap->nsockets;
+
+	/* the first entry with the inode, the sockets are sorted by process */
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (snap->sockets[mid].inode < inode)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo < snap->nsockets && snap->sockets[lo].inode == inode)
+		return &snap->procs[snap->sockets[lo].proc];
+
+	return NULL;
+}
+
+#endif /* OS_LINUX */
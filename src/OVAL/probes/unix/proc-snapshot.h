@@ -0,0 +1,122 @@
+/**
+ * @file   proc-snapshot.h
+ * @brief  snapshot of the /proc process table shared by the process probes
+ */
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef OPENSCAP_PROC_SNAPSHOT_H
+#define OPENSCAP_PROC_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Process as read from /proc/<pid>/stat, status, loginuid and cmdline.
+ * Kernel threads aren't recorded.
+ */
+struct proc_entry {
+	int pid;
+	int ppid;
+	char state;
+	char comm[16];            /**< command name from the stat file */
+	char *cmdline;            /**< ps-like command line, NULL if empty or unreadable */
+	int session;
+	int tty_nr;
+	long priority;
+	unsigned long utime;
+	unsigned long stime;
+	unsigned long long start; /**< start time in clock ticks after boot */
+	int ruid;                 /**< -1 if unknown */
+	int euid;                 /**< -1 if unknown */
+	unsigned int loginuid;    /**< (unsigned int)-1 if unknown */
+};
+
+/**
+ * Socket inode found in /proc/<pid>/fd.
+ */
+struct proc_socket {
+	unsigned long inode;
+	size_t proc;              /**< index to the procs array */
+};
+
+/**
+ * Snapshot of the process table shared by the process, process58,
+ * inetlisteningservers and iflisteners probes. It is read once per root
+ * directory and probe initialization, so all the objects of a probe see the
+ * processes at the same point in time. The open sockets are read on the
+ * first request only.
+ */
+struct proc_snapshot {
+	char *root;
+	bool readable;            /**< /proc could be listed */
+	unsigned long boot;       /**< btime from /proc/stat */
+	struct proc_entry *procs; /**< processes in the /proc order */
+	size_t count;
+
+	bool sockets_read;
+	bool fd_denied;           /**< some /proc/<pid>/fd couldn't be listed for EACCES */
+	struct proc_socket *sockets; /**< sorted by inode, then by process */
+	size_t nsockets;
+
+	struct proc_snapshot *next;
+};
+
+/**
+ * Take a reference to the shared snapshots, called from the probe init
+ * functions. The existing snapshots aren't handed out anymore, the next
+ * proc_snapshot_get() reads the processes again. The snapshots are freed
+ * when the last reference is dropped.
+ */
+void proc_snapshot_ref(void);
+void proc_snapshot_unref(void);
+
+/**
+ * Drop the snapshots, the next proc_snapshot_get() reads the processes
+ * again. Called when the probes are reset, the snapshots which may still
+ * be in use are freed with the last reference.
+ */
+void proc_snapshot_invalidate(void);
+
+/**
+ * Get the snapshot of the processes under root ("" for the running system),
+ * read it if there is none yet. Returns NULL on memory errors only.
+ */
+struct proc_snapshot *proc_snapshot_get(const char *root);
+
+/**
+ * Read the socket inodes of all the processes if they weren't read yet.
+ */
+void proc_snapshot_read_sockets(struct proc_snapshot *snap);
+
+/**
+ * Check that the process recorded in the snapshot still runs under its pid,
+ * i.e. the pid hasn't been reused by another process since the snapshot was
+ * read. Attributes which are read by pid after the snapshot are valid only
+ * if this holds after reading them.
+ */
+bool proc_snapshot_is_current(const struct proc_snapshot *snap, const struct proc_entry *p);
+
+/**
+ * Find the first process, in the /proc order, which has the socket open.
+ * proc_snapshot_read_sockets() has to be called first.
+ */
+const struct proc_entry *proc_snapshot_find_socket(const struct proc_snapshot *snap, unsigned long inode);
+
+#endif /* OPENSCAP_PROC_SNAPSHOT_H */
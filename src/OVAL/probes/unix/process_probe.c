@@ -56,6 +56,9 @@
 #include "probe/entcmp.h"
 #include "common/debug_priv.h"
 #include "process_probe.h"
+#if defined(OS_LINUX)
+#include "proc-snapshot.h"
+#endif
 #include "oscap_helpers.h"
 
 #if defined(OS_FREEBSD)
@@ -122,61 +125,6 @@ static void report_finding(struct result_info *res, probe_ctx *ctx)
 
 static unsigned long ticks, boot;
 
-static void get_boot_time(void)
-{
-	char buf[100];
-	FILE *sf;
-	int line;
-
-	boot = 0;
-	sf = fopen("/proc/stat", "rt");
-	if (sf == NULL)
-		return;
-
-	line = 0;
-	__fsetlocking(sf, FSETLOCKING_BYCALLER);
-	while (fgets(buf, sizeof(buf), sf)) {
-		if (line == 0) {
-			line++;
-			continue;
-		}
-		if (memcmp(buf, "btime", 5) == 0) {
-			sscanf(buf, "btime %lu", &boot);
-			break;
-		}
-	}
-	fclose(sf);
-}
-
-static int get_uids(int pid, struct result_info *r)
-{
-	char buf[100];
-	FILE *sf;
-
-	r->ruid = -1;
-	r->user_id = -1;
-
-	snprintf(buf, sizeof(buf), "/proc/%d/status", pid);
-	sf = fopen(buf, "rt");
-	if (sf) {
-		int line = 0;
-		__fsetlocking(sf, FSETLOCKING_BYCALLER);
-		while (fgets(buf, sizeof(buf), sf)) {
-			if (line == 0) {
-				line++;
-				continue;
-			}
-			if (memcmp(buf, "Uid:", 4) == 0) {
-				sscanf(buf, "Uid: %d %d", &r->ruid, &r->user_id);
-				break;
-			}
-		}
-		fclose(sf);
-	}
-
-	return 0;
-}
-
 static char *convert_time(unsigned long long t, char *tbuf, int tb_size)
 {
 	unsigned d,h,m,s;
@@ -198,74 +146,29 @@ static char *convert_time(unsigned long long t, char *tbuf, int tb_size)
 static int read_process(SEXP_t *cmd_ent, probe_ctx *ctx)
 {
 	int err = 1;
-	DIR *d;
-	struct dirent *ent;
+	struct proc_snapshot *snap;
 
-	d = opendir("/proc");
-	if (d == NULL)
+	snap = proc_snapshot_get("");
+	if (snap == NULL || !snap->readable)
 		return err;
 
 	// Get the time tick hertz
 	ticks = (unsigned long)sysconf(_SC_CLK_TCK);
-	get_boot_time();
+	boot = snap->boot;
 
-	// Scan the directories
-	while (( ent = readdir(d) )) {
-		int fd, len;
-		char buf[256];
-		char *tmp, cmd[16], state, tty_dev[128];
-		int pid, ppid, pgrp, session, tty_nr, tpgid;
-		unsigned flags, sched_policy;
-		unsigned long minflt, cminflt, majflt, cmajflt, uutime, ustime;
-		long cutime, cstime, priority, cnice, nthreads, itrealvalue;
-		unsigned long long start;
+	// Scan the processes
+	for (size_t i = 0; i < snap->count; ++i) {
+		const struct proc_entry *p = &snap->procs[i];
+		char tty_dev[128];
+		unsigned sched_policy;
 		SEXP_t *cmd_sexp;
 
-		// Skip non-process dir entries
-		if(*ent->d_name<'0' || *ent->d_name>'9')
-			continue;
-		errno = 0;
-		pid = strtol(ent->d_name, NULL, 10);
-		if (errno || pid == 2) // skip err & kthreads
-			continue;
-
-		// Parse up the stat file for the proc
-		snprintf(buf, 32, "/proc/%d/stat", pid);
-		fd = open(buf, O_RDONLY, 0);
-		if (fd < 0)
-			continue;
-		len = read(fd, buf, sizeof buf - 1);
-		close(fd);
-		if (len < 40)
-			continue;
-		buf[len] = 0;
-		tmp = strrchr(buf, ')');
-		if (tmp)
-			*tmp = 0;
-		else
-			continue;
-		memset(cmd, 0, sizeof(cmd));
-		sscanf(buf, "%d (%15c", &ppid, cmd);
-		sscanf(tmp+2,	"%c %d %d %d %d %d "
-				"%u %lu %lu %lu %lu "
-				"%lu %lu %lu %ld %ld "
-				"%ld %ld %ld %llu",
-			&state, &ppid, &pgrp, &session, &tty_nr, &tpgid,
-			&flags, &minflt, &cminflt, &majflt, &cmajflt,
-			&uutime, &ustime, &cutime, &cstime, &priority,
-			&cnice, &nthreads, &itrealvalue, &start
-		);
-
-		// Skip kthreads
-		if (ppid == 2)
-			continue;
-
 		err = 0; // If we get this far, no permission problems
-		dI("Have command: %s", cmd);
-		cmd_sexp = SEXP_string_newf("%s", cmd);
+		dI("Have command: %s", p->comm);
+		cmd_sexp = SEXP_string_newf("%s", p->comm);
 		if (probe_entobj_cmp(cmd_ent, cmd_sexp) == OVAL_RESULT_TRUE) {
 			struct result_info r;
-			unsigned long t = uutime/ticks + ustime/ticks;
+			unsigned long t = p->utime/ticks + p->stime/ticks;
 			char tbuf[32], sbuf[32];
 			int tday,tyear;
 			time_t s_time;
@@ -273,7 +176,7 @@ static int read_process(SEXP_t *cmd_ent, probe_ctx *ctx)
 			const char *fmt;
 
 			// Now get scheduler policy
-			sched_policy = sched_getscheduler(pid);
+			sched_policy = sched_getscheduler(p->pid);
 			switch (sched_policy) {
 				case SCHED_OTHER:
 					r.scheduling_class = "TS";
@@ -302,7 +205,7 @@ static int read_process(SEXP_t *cmd_ent, probe_ctx *ctx)
 			now = localtime(&s_time);
 			tyear = now->tm_year;
 			tday = now->tm_yday;
-			s_time = boot + (start / ticks);
+			s_time = boot + (p->start / ticks);
 			proc = localtime(&s_time);
 
 			// Select format based on how long we've been running
@@ -318,22 +221,27 @@ static int read_process(SEXP_t *cmd_ent, probe_ctx *ctx)
 				fmt = "%H:%M:%S";
 			strftime(sbuf, sizeof(sbuf), fmt, proc);
 
-			r.command = cmd;
+			r.command = p->comm;
 			r.exec_time = convert_time(t, tbuf, sizeof(tbuf));
-			r.pid = pid;
-			r.ppid = ppid;
-			r.priority = priority;
+			r.pid = p->pid;
+			r.ppid = p->ppid;
+			r.priority = p->priority;
 			r.start_time = sbuf;
 
-                        dev_to_tty(tty_dev, sizeof(tty_dev), (dev_t) tty_nr, pid, ABBREV_DEV);
+                        dev_to_tty(tty_dev, sizeof(tty_dev), (dev_t) p->tty_nr, p->pid, ABBREV_DEV);
                         r.tty = tty_dev;
 
-			get_uids(pid, &r);
-			report_finding(&r, ctx);
+			r.ruid = p->ruid;
+			r.user_id = p->euid;
+
+			/* the scheduler policy and tty were read by pid */
+			if (proc_snapshot_is_current(snap, p))
+				report_finding(&r, ctx);
+			else
+				dD("Process %d has changed since the snapshot, skipping it.", p->pid);
 		}
 		SEXP_free(cmd_sexp);
 	}
-        closedir(d);
 
 	return err;
 }
@@ -675,3 +583,18 @@ int process_probe_main(probe_ctx *ctx, void *arg)
 	return 0;
 }
 #endif /* __linux */
+
+void *process_probe_init(void)
+{
+#if defined(OS_LINUX)
+	proc_snapshot_ref();
+#endif
+	return NULL;
+}
+
+void process_probe_fini(void *arg)
+{
+#if defined(OS_LINUX)
+	proc_snapshot_unref();
+#endif
+}
@@ -49,39 +49,259 @@
 #if defined(OS_LINUX)
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
 #include <string.h>
 #include <ctype.h>
 #include <errno.h>
 #include <limits.h>
+#include <pthread.h>
+#include <sys/stat.h>
 #include "oval_fts.h"
 #include "common/debug_priv.h"
 
 #define PROC_SYS_DIR "/proc/sys"
 #define PROC_SYS_MAXDEPTH 7
+#define SYSCTL_VALUE_MAX 8192
 
-int sysctl_probe_main(probe_ctx *ctx, void *probe_arg)
+#define SYSCTL_SKIP  0 /* not collected, e.g. a write-only file */
+#define SYSCTL_OK    1
+#define SYSCTL_ERROR 2
+
+struct sysctl_value {
+	char *mib;
+	char *data;
+	long  len;
+	int   status;
+};
+
+/*
+ * Values of all the sysctls. They are read by the first object which
+ * can't be answered by a direct lookup and reused for the rest of the
+ * session, so /proc/sys is walked at most once.
+ */
+struct sysctl_probe_global {
+	pthread_mutex_t      mutex;
+	bool                 loaded;
+	bool                 error;  /* the walk of /proc/sys wasn't complete */
+	struct sysctl_value *values;
+	size_t               count;
+};
+
+void *sysctl_probe_init(void)
 {
-        OVAL_FTS    *ofts;
-        OVAL_FTSENT *ofts_ent;
+	struct sysctl_probe_global *g = calloc(1, sizeof(struct sysctl_probe_global));
 
-        SEXP_t *name_entity, *probe_in;
-        SEXP_t *r0, *r1, *r2, *r3;
-        SEXP_t *ent_attrs, *bh_entity, *path_entity, *filename_entity;
-        oval_schema_version_t over;
-        int over_cmp;
+	pthread_mutex_init(&g->mutex, NULL);
+
+	return (g);
+}
+
+void sysctl_probe_fini(void *arg)
+{
+	struct sysctl_probe_global *g = arg;
+
+	if (g == NULL)
+		return;
+
+	for (size_t i = 0; i < g->count; ++i) {
+		free(g->values[i].mib);
+		free(g->values[i].data);
+	}
+	free(g->values);
+	pthread_mutex_destroy(&g->mutex);
+	free(g);
+}
 
+/* read a sysctl value, skip the same files as the sysctl utility does */
+static int sysctl_read(const char *mibpath, char *sysval, long *len)
+{
 	const char *ipv6_conf_path = "/proc/sys/net/ipv6/conf/";
-	size_t ipv6_conf_path_len = strlen(ipv6_conf_path);
+	struct stat file_stat;
+	FILE *fp;
+	long l;
 
-        probe_in    = probe_ctx_getobject(ctx);
-        name_entity = probe_obj_getent(probe_in, "name", 1);
-        over        = probe_obj_get_platform_schema_version(probe_in);
-        over_cmp    = oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10));
+	/* Skip write-only files, eg. /proc/sys/net/ipv4/route/flush */
+	if (stat(mibpath, &file_stat) == -1) {
+		dE("Stat failed on %s: %u, %s", mibpath, errno, strerror(errno));
+		return (SYSCTL_SKIP);
+	}
+	/* the sysctl utility uses same condition in sysctl.c in ReadSetting() */
+	if ((file_stat.st_mode & S_IRUSR) == 0) {
+		dD("Skipping write-only file %s", mibpath);
+		return (SYSCTL_SKIP);
+	}
 
-        if (name_entity == NULL) {
-                dE("Missing \"name\" entity in the input object");
-                return (PROBE_ENOENT);
-        }
+	fp = fopen(mibpath, "r");
+
+	if (fp == NULL) {
+		dE("Can't read sysctl value from \"%s\": %u, %s",
+		   mibpath, errno, strerror(errno));
+		return (SYSCTL_ERROR);
+	}
+
+	l = fread(sysval, 1, SYSCTL_VALUE_MAX - 1, fp);
+
+	if (ferror(fp)) {
+		/* Linux 4.1.0 introduced a per-NIC IPv6 stable_secret file.
+		 * The stable_secret file cannot be read until it is set,
+		 * so we skip it when it is not readable. Otherwise we collect it.
+		 */
+		if (strncmp(mibpath, ipv6_conf_path, strlen(ipv6_conf_path)) == 0 &&
+				strcmp(strrchr(mibpath, '/') + 1, "stable_secret") == 0) {
+			dD("Skipping file %s", mibpath);
+			fclose(fp);
+			return (SYSCTL_SKIP);
+		}
+		dE("An error ocured when reading from \"%s\" (fp=%p): l=%ld, %u, %s",
+		   mibpath, fp, l, errno, strerror(errno));
+		fclose(fp);
+		return (SYSCTL_ERROR);
+	}
+
+	fclose(fp);
+
+	/* Skip empty values as sysctl tool does.
+	 * See https://bugzilla.redhat.com/show_bug.cgi?id=1473207
+	 */
+	if (l == 0) {
+		dD("Skipping file '%s' because it has no value.", mibpath);
+		return (SYSCTL_SKIP);
+	}
+
+	*len = l;
+
+	return (SYSCTL_OK);
+}
+
+static void sysctl_collect(probe_ctx *ctx, const char *mib, int status,
+                           const char *data, long l, int over_cmp)
+{
+	SEXP_t *item, *se_mib;
+	char    sysval[SYSCTL_VALUE_MAX];
+	char   *sysvals[512];
+	long    i;
+	size_t  s;
+
+	if (status == SYSCTL_SKIP)
+		return;
+
+	if (status == SYSCTL_ERROR) {
+		item = probe_item_create(OVAL_UNIX_SYSCTL, NULL, NULL);
+		probe_item_setstatus(item, SYSCHAR_STATUS_ERROR);
+		probe_item_collect(ctx, item);
+		return;
+	}
+
+	memcpy(sysval, data, l);
+
+	/*
+	 * sanitize the value
+	 *  - only printable and whitespace chars allowed
+	 *  - remove the last '\n'
+	 */
+	sysvals[0] = sysval;
+
+	for(s = 0, i = 0; i < l && s < sizeof sysvals/sizeof(char *) - 1; ++i) {
+		if ((!isprint(sysval[i]) && !isspace(sysval[i]))
+		    || (over_cmp >= 0 && sysval[i] == '\n' /* OVAL 5.10 and above */))
+		{
+			sysval[i] = '\0';
+			sysvals[++s] = sysval + i + 1;
+		}
+	}
+
+	if (sysval[l - 1] == '\n')
+		sysval[l - 1] = '\0';
+	else
+		sysval[l] = '\0';
+
+	if (strlen(sysvals[s]) == 0)
+		sysvals[s] = NULL;
+	else
+		sysvals[++s] = NULL;
+
+	se_mib = SEXP_string_new(mib, strlen(mib));
+
+	if (over_cmp >= 0) {
+		/* Only in OVAL 5.10 and above */
+		item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
+		                         "name",  OVAL_DATATYPE_SEXP,   se_mib,
+		                         "value", OVAL_DATATYPE_STRING_M, sysvals,
+		                         NULL);
+	} else {
+		item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
+		                         "name",  OVAL_DATATYPE_SEXP,   se_mib,
+		                         "value", OVAL_DATATYPE_STRING, sysval,
+		                         NULL);
+	}
+
+	SEXP_free(se_mib);
+	probe_item_collect(ctx, item);
+}
+
+/*
+ * Direct access for the "equals" operation. The name is mapped to a path
+ * below path, trying each dot as a separator, as the names of the
+ * components can contain dots too, e.g. net.ipv4.conf.eth0.100.forwarding
+ */
+static void sysctl_lookup(probe_ctx *ctx, char *path, size_t pathlen, const char *name,
+                          const char *mib, int depth, int over_cmp)
+{
+	const char *dot = name;
+	struct stat st;
+
+	for (;;) {
+		size_t complen;
+
+		dot = strchr(dot, '.');
+		complen = dot != NULL ? (size_t)(dot - name) : strlen(name);
+
+		if (complen > 0 && pathlen + 1 + complen < PATH_MAX
+		    && !(complen == 1 && name[0] == '.')
+		    && !(complen == 2 && name[0] == '.' && name[1] == '.')) {
+			path[pathlen] = '/';
+			memcpy(path + pathlen + 1, name, complen);
+			path[pathlen + 1 + complen] = '\0';
+
+			if (dot == NULL) {
+				if (stat(path, &st) == 0 && !S_ISDIR(st.st_mode)) {
+					char sysval[SYSCTL_VALUE_MAX];
+					long l = 0;
+					int status;
+
+					dD("MIB: %s", mib);
+					status = sysctl_read(path, sysval, &l);
+					sysctl_collect(ctx, mib, status, sysval, l, over_cmp);
+				}
+			} else if (depth < PROC_SYS_MAXDEPTH
+			           && stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+				sysctl_lookup(ctx, path, pathlen + 1 + complen, dot + 1,
+				              mib, depth + 1, over_cmp);
+			}
+		}
+
+		if (dot == NULL)
+			break;
+		++dot;
+	}
+
+	path[pathlen] = '\0';
+}
+
+/*
+ * Walk /proc/sys and read all the values, the lock has to be held. The
+ * errors of the walk are remembered in g->error and reported for each
+ * object answered from the snapshot, not only for the one which loaded it.
+ */
+static int sysctl_snapshot_load(struct sysctl_probe_global *g)
+{
+        OVAL_FTS    *ofts;
+        OVAL_FTSENT *ofts_ent;
+
+        SEXP_t *r0, *r1, *r2, *r3, *result;
+        SEXP_t *ent_attrs, *bh_entity, *path_entity, *filename_entity;
+        size_t alloc = 0;
 
         /*
          * prepare behaviors
@@ -117,42 +337,40 @@ int sysctl_probe_main(probe_ctx *ctx, void *probe_arg)
 
         /*
          * collect sysctls
-         *  XXX: use direct access for the "equals" op
          */
-        ofts = oval_fts_open_prefixed(NULL, path_entity, filename_entity, NULL, bh_entity, probe_ctx_getresult(ctx));
+        result = probe_cobj_new(SYSCHAR_FLAG_UNKNOWN, NULL, NULL, NULL);
+        ofts = oval_fts_open_prefixed(NULL, path_entity, filename_entity, NULL, bh_entity, result);
+
+	SEXP_free(path_entity);
+	SEXP_free(filename_entity);
+	SEXP_free(bh_entity);
 
         if (ofts == NULL) {
                 dE("oval_fts_open_prefixed(%s, %s) failed", PROC_SYS_DIR, ".\\+");
-		SEXP_free(path_entity);
-		SEXP_free(filename_entity);
-		SEXP_free(bh_entity);
-		SEXP_free(name_entity);
-
-                return (PROBE_EFATAL);
+                SEXP_free(result);
+                return (-1);
         }
 
         while ((ofts_ent = oval_fts_read(ofts)) != NULL) {
-                SEXP_t *se_mib;
+                struct sysctl_value *value;
                 char    mibpath[PATH_MAX], *mib;
+                char    sysval[SYSCTL_VALUE_MAX];
                 size_t  miblen;
-		struct stat file_stat;
+                long    l = 0;
+                int     status;
 
                 snprintf(mibpath, sizeof mibpath, "%s/%s", ofts_ent->path, ofts_ent->file);
+                oval_ftsent_free(ofts_ent);
 
-		/* Skip write-only files, eg. /proc/sys/net/ipv4/route/flush */
-		if (stat(mibpath, &file_stat) == -1) {
-			dE("Stat failed on %s: %u, %s", mibpath, errno, strerror(errno));
-			oval_ftsent_free(ofts_ent);
-			continue;
-		}
-		/* the sysctl utility uses same condition in sysctl.c in ReadSetting() */
-		if ((file_stat.st_mode & S_IRUSR) == 0) {
-			dD("Skipping write-only file %s", mibpath);
-			oval_ftsent_free(ofts_ent);
-			continue;
-		}
+                status = sysctl_read(mibpath, sysval, &l);
+                if (status == SYSCTL_SKIP)
+                        continue;
 
-                mib    = strdup(mibpath + strlen(PROC_SYS_DIR) + 1);
+                mib = strdup(mibpath + strlen(PROC_SYS_DIR) + 1);
+                if (mib == NULL) {
+                        g->error = true;
+                        continue;
+                }
                 miblen = strlen(mib);
 
                 while (miblen > 0) {
@@ -161,128 +379,126 @@ int sysctl_probe_main(probe_ctx *ctx, void *probe_arg)
                         --miblen;
                 }
 
-                dD("MIB: %s", mib);
-                se_mib = SEXP_string_new(mib, strlen(mib));
-                free(mib);
+                if (g->count == alloc) {
+                        size_t n = alloc > 0 ? alloc * 2 : 1024;
+                        struct sysctl_value *values = realloc(g->values, n * sizeof(struct sysctl_value));
 
-                if (probe_entobj_cmp(name_entity, se_mib) == OVAL_RESULT_TRUE) {
-                        FILE   *fp;
-                        SEXP_t *item;
-                        char    sysval[8192];
-                        char   *sysvals[512];
-                        long i, l;
-                        size_t s;
-
-                        dD("MIB match");
-
-                        /*
-                         * read sysctl value
-                         */
-                        fp = fopen(mibpath, "r");
-
-                        if (fp == NULL) {
-                                dE("Can't read sysctl value from \"%s\": %u, %s",
-                                   mibpath, errno, strerror(errno));
-                                goto fail_item;
+                        if (values == NULL) {
+                                free(mib);
+                                g->error = true;
+                                continue;
                         }
+                        g->values = values;
+                        alloc = n;
+                }
 
-                        l = fread(sysval, 1, sizeof sysval - 1, fp);
-
-                        if (ferror(fp)) {
-				/* Linux 4.1.0 introduced a per-NIC IPv6 stable_secret file.
-				 * The stable_secret file cannot be read until it is set,
-				 * so we skip it when it is not readable. Otherwise we collect it.
-				 */
-				if (strncmp(ofts_ent->path, ipv6_conf_path, ipv6_conf_path_len) == 0 &&
-						strcmp(ofts_ent->file, "stable_secret") == 0) {
-					dD("Skipping file %s", mibpath);
-					oval_ftsent_free(ofts_ent);
-					SEXP_free(se_mib);
-					fclose(fp);
-					continue;
-				} else {
-					dE("An error ocured when reading from \"%s\" (fp=%p): l=%ld, %u, %s",
-						mibpath, fp, l, errno, strerror(errno));
-					goto fail_item;
-				}
-                        }
+                value = &g->values[g->count++];
+                value->mib    = mib;
+                value->status = status;
+                value->len    = l;
+                value->data   = NULL;
 
-                        fclose(fp);
+                if (status == SYSCTL_OK) {
+                        value->data = malloc(l);
+                        if (value->data != NULL)
+                                memcpy(value->data, sysval, l);
+                        else
+                                value->status = SYSCTL_ERROR;
+                }
+        }
 
-			/* Skip empty values as sysctl tool does.
-			 * See https://bugzilla.redhat.com/show_bug.cgi?id=1473207
-			 */
-			if (l == 0) {
-				dD("Skipping file '%s' because it has no value.", mibpath);
-				oval_ftsent_free(ofts_ent);
-				SEXP_free(se_mib);
-				continue;
-			}
+        oval_fts_close(ofts);
+        if (probe_cobj_get_flag(result) == SYSCHAR_FLAG_ERROR)
+                g->error = true;
+        SEXP_free(result);
+        g->loaded = true;
 
-                        /*
-                         * sanitize the value
-                         *  - only printable and whitespace chars allowed
-                         *  - remove the last '\n'
-                         */
-                        sysvals[0] = sysval;
-
-                        for(s = 0, i = 0; i < l && s < sizeof sysvals/sizeof(char *) - 1; ++i) {
-	                        if ((!isprint(sysval[i]) && !isspace(sysval[i]))
-	                            || (over_cmp >= 0 && sysval[i] == '\n' /* OVAL 5.10 and above */))
-                                {
-                                        sysval[i] = '\0';
-                                        sysvals[++s] = sysval + i + 1;
-                                }
-                        }
+        return (0);
+}
 
-                        if (sysval[l - 1] == '\n')
-                                sysval[l - 1] = '\0';
-                        else
-                                sysval[l] = '\0';
+int sysctl_probe_main(probe_ctx *ctx, void *probe_arg)
+{
+        struct sysctl_probe_global *g = probe_arg;
+        SEXP_t *name_entity, *probe_in;
+        oval_schema_version_t over;
+        int over_cmp;
 
-                        if (strlen(sysvals[s]) == 0)
-                                sysvals[s] = NULL;
-                        else
-                                sysvals[++s] = NULL;
-
-                        if (over_cmp >= 0) {
-	                        /* Only in OVAL 5.10 and above */
-	                        item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
-	                                                 "name",  OVAL_DATATYPE_SEXP,   se_mib,
-	                                                 "value", OVAL_DATATYPE_STRING_M, sysvals,
-	                                                 NULL);
-                        } else {
-	                        item = probe_item_create(OVAL_UNIX_SYSCTL, NULL,
-	                                                 "name",  OVAL_DATATYPE_SEXP,   se_mib,
-	                                                 "value", OVAL_DATATYPE_STRING, sysval,
-	                                                 NULL);
-                        }
+        probe_in    = probe_ctx_getobject(ctx);
+        name_entity = probe_obj_getent(probe_in, "name", 1);
+        over        = probe_obj_get_platform_schema_version(probe_in);
+        over_cmp    = oval_schema_version_cmp(over, OVAL_SCHEMA_VERSION(5.10));
 
-                        goto add_item;
-                fail_item:
-                        if (fp != NULL)
-                                fclose(fp);
+        if (name_entity == NULL) {
+                dE("Missing \"name\" entity in the input object");
+                return (PROBE_ENOENT);
+        }
+
+	if (probe_ent_getoperation(name_entity, OVAL_OPERATION_EQUALS) == OVAL_OPERATION_EQUALS
+	    && !probe_ent_attrexists(name_entity, "var_ref")) {
+		SEXP_t *name_val = probe_ent_getval(name_entity);
+		char *name = name_val != NULL ? SEXP_string_cstr(name_val) : NULL;
+
+		SEXP_free(name_val);
+
+		/*
+		 * The components are separated by dots, a name with a slash
+		 * doesn't name any sysctl and mustn't reach a file outside
+		 * of /proc/sys, it's left to the comparison with the snapshot.
+		 */
+		if (name != NULL && strchr(name, '/') == NULL) {
+			char path[PATH_MAX] = PROC_SYS_DIR;
+
+			sysctl_lookup(ctx, path, strlen(PROC_SYS_DIR), name, name, 0, over_cmp);
+			free(name);
+			SEXP_free(name_entity);
+
+			return (0);
+		}
+		free(name);
+	}
+
+	pthread_mutex_lock(&g->mutex);
+	if (!g->loaded && sysctl_snapshot_load(g) != 0) {
+		pthread_mutex_unlock(&g->mutex);
+		SEXP_free(name_entity);
+
+		return (PROBE_EFATAL);
+	}
+	pthread_mutex_unlock(&g->mutex);
+
+	if (g->error)
+		probe_cobj_set_flag(probe_ctx_getresult(ctx), SYSCHAR_FLAG_ERROR);
+
+        for (size_t i = 0; i < g->count; ++i) {
+                const struct sysctl_value *value = &g->values[i];
+                SEXP_t *se_mib;
+
+                se_mib = SEXP_string_new(value->mib, strlen(value->mib));
 
-			item = probe_item_create(OVAL_UNIX_SYSCTL, NULL, NULL);
-                        probe_item_setstatus(item, SYSCHAR_STATUS_ERROR);
-                add_item:
-                        probe_item_collect(ctx, item);
+                if (probe_entobj_cmp(name_entity, se_mib) == OVAL_RESULT_TRUE) {
+                        dD("MIB match: %s", value->mib);
+                        sysctl_collect(ctx, value->mib, value->status,
+                                       value->data, value->len, over_cmp);
                 }
 
-                oval_ftsent_free(ofts_ent);
                 SEXP_free(se_mib);
         }
 
-        oval_fts_close(ofts);
-	SEXP_free(path_entity);
-	SEXP_free(filename_entity);
-	SEXP_free(bh_entity);
 	SEXP_free(name_entity);
 
         return (0);
 }
 
 #elif defined(OS_FREEBSD)
+void *sysctl_probe_init(void)
+{
+	return (NULL);
+}
+
+void sysctl_probe_fini(void *arg)
+{
+}
+
 int sysctl_probe_main(probe_ctx *ctx, void *probe_arg)
 {
 	FILE *fp;
@@ -361,6 +577,15 @@ int sysctl_probe_main(probe_ctx *ctx, void *probe_arg)
 	return (0);
 }
 #else
+void *sysctl_probe_init(void)
+{
+	return (NULL);
+}
+
+void sysctl_probe_fini(void *arg)
+{
+}
+
 int sysctl_probe_main(probe_ctx *ctx, void *probe_arg)
 {
         return(PROBE_EOPNOTSUPP);
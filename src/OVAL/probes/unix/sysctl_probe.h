@@ -25,6 +25,8 @@
 
 #include "probe-api.h"
 
+void *sysctl_probe_init(void);
 int sysctl_probe_main(probe_ctx *ctx, void *arg);
+void sysctl_probe_fini(void *arg);
 
 #endif /* OPENSCAP_SYSCTL_PROBE_H */
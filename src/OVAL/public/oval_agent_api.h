@@ -73,6 +73,16 @@ OSCAP_API struct oval_definition_model* oval_agent_get_definition_model(oval_age
  */
 OSCAP_API void oval_agent_set_product_name(oval_agent_session_t *, char *);
 
+/**
+ * Set the number of threads used to collect OVAL objects. Objects which
+ * don't depend on other objects through variables or sets are collected
+ * concurrently by probes of different types before the definitions are
+ * evaluated, the other objects are collected after the objects they depend
+ * on. The evaluation itself and the produced results are not affected.
+ * @param workers number of threads, 0 or 1 means serial collection
+ */
+OSCAP_API void oval_agent_set_eval_workers(oval_agent_session_t *ag_sess, unsigned int workers);
+
 /**
  * Probe the system and evaluate specified definition
  * @return 0 on success; -1 error; 1 warning
@@ -231,6 +231,17 @@ OSCAP_API int oval_session_export(struct oval_session *session);
  */
 OSCAP_API void oval_session_set_export_system_characteristics(struct oval_session *session, bool export);
 
+/**
+ * Set number of threads used to collect OVAL objects during evaluation.
+ * Objects of different types are then collected concurrently, the results
+ * are the same as with serial collection.
+ *
+ * @memberof oval_session
+ * @param session an \ref oval_session
+ * @param workers number of threads, 0 or 1 means serial collection (default)
+ */
+OSCAP_API void oval_session_set_eval_workers(struct oval_session *session, unsigned int workers);
+
 /**
  * Set property of remote content.
  * @memberof oval_session
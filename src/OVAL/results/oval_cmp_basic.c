@@ -27,11 +27,11 @@
 
 #include <math.h>
 #include <string.h>
-#include <pcre.h>
 
 #include "oval_types.h"
 #include "common/_error.h"
 #include "common/debug_priv.h"
+#include "common/oscap_pcre.h"
 #include "oval_cmp_basic_impl.h"
 
 oval_result_t oval_boolean_cmp(const bool state, const bool syschar, oval_operation_t operation)
@@ -124,18 +124,18 @@ static oval_result_t strregcomp(const char *pattern, const char *test_str)
 {
 	int ret;
 	oval_result_t result = OVAL_RESULT_ERROR;
-	pcre *re;
+	struct oscap_pcre *re;
 	const char *err;
 	int errofs;
 
-	re = pcre_compile(pattern, PCRE_UTF8, &err, &errofs, NULL);
+	re = oscap_pcre_acquire(pattern, PCRE_UTF8, &err, &errofs);
 	if (re == NULL) {
 		dE("Unable to compile regex pattern '%s', "
 				"pcre_compile() returned error (offset: %d): '%s'.\n", pattern, errofs, err);
 		return OVAL_RESULT_ERROR;
 	}
 
-	ret = pcre_exec(re, NULL, test_str, strlen(test_str), 0, 0, NULL, 0);
+	ret = oscap_pcre_exec(re, test_str, strlen(test_str), 0, 0, NULL, 0);
 	if (ret > -1 ) {
 		result = OVAL_RESULT_TRUE;
 	} else if (ret == -1) {
@@ -146,7 +146,7 @@ static oval_result_t strregcomp(const char *pattern, const char *test_str)
 		result = OVAL_RESULT_ERROR;
 	}
 
-	pcre_free(re);
+	oscap_pcre_release(re);
 	return result;
 }
 
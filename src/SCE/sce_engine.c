@@ -61,6 +61,9 @@
 #include <limits.h>
 #include <unistd.h>
 #include <libgen.h>
+#include <poll.h>
+#include <signal.h>
+#include <errno.h>
 
 #define SCE_SCRIPT "oscap-run-sce-script"
 
@@ -273,13 +276,25 @@ struct sce_parameters
 {
 	char* xccdf_directory;
 	struct sce_session* session;
+	struct oscap_list* jobs;		///< prefetched scripts, in the order of evaluation
+	unsigned int max_jobs;			///< scripts allowed to run at the same time
+	unsigned int running_jobs;
 };
 
+struct sce_job;
+static void _sce_job_free(struct sce_job *job);
+
 struct sce_parameters* sce_parameters_new(void)
 {
 	struct sce_parameters *ret = malloc(sizeof(struct sce_parameters));
 	ret->xccdf_directory = NULL;
 	ret->session = NULL;
+	ret->jobs = oscap_list_new();
+	ret->running_jobs = 0;
+
+	const char *max_jobs = getenv("OSCAP_SCE_JOBS");
+	const long max_jobs_value = max_jobs != NULL ? strtol(max_jobs, NULL, 10) : 1;
+	ret->max_jobs = max_jobs_value > 1 && max_jobs_value <= UINT_MAX ? (unsigned int) max_jobs_value : 1;
 
 	return ret;
 }
@@ -291,6 +306,7 @@ void sce_parameters_free(struct sce_parameters* v)
 
 	free(v->xccdf_directory);
 	sce_session_free(v->session);
+	oscap_list_free(v->jobs, (oscap_destruct_func) _sce_job_free);
 
 	free(v);
 }
@@ -324,38 +340,53 @@ void sce_parameters_allocate_session(struct sce_parameters* v)
 	sce_parameters_set_session(v, sce_session_new());
 }
 
-static void _pipe_try_read_into_string(int fd, struct oscap_string *string, bool *eof)
+/*
+ * Read what is available in the pipe, returns false on EOF or error.
+ */
+static bool _pipe_read_into_string(int fd, struct oscap_string *string)
 {
-	// FIXME: Read by larger chunks in the future
-	char readbuf;
+	char readbuf[4096];
 	while (true) {
-		const int read_status = read(fd, &readbuf, 1);
-		if (read_status == 1) {  // successful read
-			if (readbuf == '&') {
+		const ssize_t read_status = read(fd, readbuf, sizeof(readbuf) - 1);
+		if (read_status > 0) {  // successful read
+			readbuf[read_status] = '\0';
+			char *start = readbuf;
+			char *amp;
+			while ((amp = strchr(start, '&')) != NULL) {
 				// & is a special case, we have to "escape" it manually
 				// (all else will eventually get handled by libxml)
+				*amp = '\0';
+				oscap_string_append_string(string, start);
 				oscap_string_append_string(string, "&amp;");
-			} else {
-				oscap_string_append_char(string, readbuf);
+				start = amp + 1;
 			}
+			oscap_string_append_string(string, start);
 		}
 		else if (read_status == 0) {  // EOF
-			*eof = true;
-			break;
+			return false;
+		}
+		else if (errno == EINTR) {
+			continue;
 		}
 		else {
-			if (errno == EAGAIN) {
-				// NOOP, we are waiting for more input
-				break;
-			}
-			else {
-				*eof = true;  // signal EOF to exit the loops
-				break;
-			}
+			// EAGAIN means we are waiting for more input,
+			// anything else is reported as EOF to exit the loops
+			return errno == EAGAIN || errno == EWOULDBLOCK;
 		}
 	}
 }
 
+static int _pipe_set_flags(int fd)
+{
+	const int flags = fcntl(fd, F_GETFL, 0);
+	if (flags == -1 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) == -1)
+		return -1;
+	// the scripts started later mustn't inherit the pipes of this one
+	const int fd_flags = fcntl(fd, F_GETFD, 0);
+	if (fd_flags == -1 || fcntl(fd, F_SETFD, fd_flags | FD_CLOEXEC) == -1)
+		return -1;
+	return 0;
+}
 
 static void free_env_values(char **env_values, size_t index_of_first_env_value_not_compiled_in, size_t real_env_values_count) {
 	for (size_t i = index_of_first_env_value_not_compiled_in; i < real_env_values_count; i++) {
@@ -364,52 +395,16 @@ static void free_env_values(char **env_values, size_t index_of_first_env_value_n
 	free(env_values);
 }
 
+static const size_t index_of_first_env_value_not_compiled_in = 10;
 
-xccdf_test_result_type_t sce_engine_eval_rule(struct xccdf_policy *policy, const char *rule_id, const char *id, const char *href,
-		struct xccdf_value_binding_iterator *value_binding_it,
-		struct xccdf_check_import_iterator *check_import_it,
-		void *usr)
+/*
+ * Bound values in KEY=VALUE form, ready to be passed as environment variables.
+ * The array is NULL terminated, the count doesn't include the terminator.
+ */
+static char **_sce_env_values_new(struct xccdf_value_binding_iterator *value_binding_it, size_t *count)
 {
-	struct sce_parameters* parameters = (struct sce_parameters*)usr;
-	const char* xccdf_directory = parameters->xccdf_directory;
-	bool use_sce_wrapper = false; // use osca-run-sce-script ?
-
-	char* tmp_href = oscap_sprintf("%s/%s", xccdf_directory, href);
-
-	if (access(tmp_href, F_OK))
-	{
-		// we only do this check to provide helpful error message
-		// there is an inherent race condition, the file might
-		// not exist anymore at the time we execve it!
-
-		// the script hasn't been found, perhaps another sce instance
-		// with a different XCCDF directory can find it?
-		oscap_seterr(OSCAP_EFAMILY_SCE, "SCE couldn't find script file '%s'. "
-				"Expected location: '%s'.", href, tmp_href);
-		free(tmp_href);
-		return XCCDF_RESULT_NOT_CHECKED;
-	}
-
-	if (access(tmp_href, F_OK | X_OK))
-	{
-		// use the sce wrapper if it's not possible to acquire +x rights
-		use_sce_wrapper = true;
-		dI("%s isn't executable, oscap-run-sce-script will be used.", tmp_href);
-	}
-
-	// all the result codes are shifted by 100, because otherwise syntax errors in scripts
-	// or even their nonexistence would cause XCCDF_RESULT_PASS to be the result
-
-	char* argvp[3] = {
-		tmp_href,
-		tmp_href, // the second tmp_href is added in case we use the wrapper (oscap-run-sce-script)
-		NULL      // which need the path of the script to eval as first parameter.
-	};
-
-	// bound values in KEY=VALUE form, ready to be passed as environment variables
 	char ** env_values = malloc(10 * sizeof(char * ));
 	size_t env_value_count = 10;
-	const size_t index_of_first_env_value_not_compiled_in = 10;
 
 	env_values[0] = "PATH=/bin:/sbin:/usr/bin:/usr/local/bin:/usr/sbin";
 
@@ -431,7 +426,7 @@ xccdf_test_result_type_t sce_engine_eval_rule(struct xccdf_policy *policy, const
 		if (new_env_values == NULL) {
 			dE("Unable to re-allocate memory");
 			free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
-			return XCCDF_RESULT_ERROR;
+			return NULL;
 		}
 		env_values = new_env_values;
 
@@ -512,220 +507,496 @@ xccdf_test_result_type_t sce_engine_eval_rule(struct xccdf_policy *policy, const
 	if (new_env_values == NULL) {
 		dE("Unable to re-allocate memory");
 		free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
-		return XCCDF_RESULT_ERROR;
+		return NULL;
 	}
 	env_values = new_env_values;
 	env_values[env_value_count] = NULL;
 
+	*count = env_value_count;
+	return env_values;
+}
+
+/*
+ * A script execution. The jobs are started either when they are prefetched
+ * or when the check is evaluated, and they are waited for when the check is
+ * evaluated; the output of each script is captured separately and the
+ * results are recorded in the order of the evaluation.
+ */
+struct sce_job
+{
+	char *script;                           ///< full path of the script
+	bool use_sce_wrapper;                   ///< use oscap-run-sce-script ?
+	char **env_values;                      ///< NULL terminated
+	size_t env_value_count;
+	pid_t pid;                              ///< 0 until the script is started
+	int stdout_fd;                          ///< -1 after EOF
+	int stderr_fd;                          ///< -1 after EOF
+	struct oscap_string *stdout_string;
+	struct oscap_string *stderr_string;
+	int wstatus;
+	bool done;                              ///< the script has exited
+};
+
+static void _sce_job_init(struct sce_job *job, char *script, char **env_values, size_t env_value_count)
+{
+	memset(job, 0, sizeof(struct sce_job));
+	job->script = script;
+	job->env_values = env_values;
+	job->env_value_count = env_value_count;
+	job->stdout_fd = -1;
+	job->stderr_fd = -1;
+
+	if (access(script, F_OK | X_OK))
+	{
+		// use the sce wrapper if it's not possible to acquire +x rights
+		job->use_sce_wrapper = true;
+		dI("%s isn't executable, oscap-run-sce-script will be used.", script);
+	}
+}
+
+/*
+ * The job takes the ownership of script and env_values, unless
+ * it can't be allocated.
+ */
+static struct sce_job *_sce_job_new(char *script, char **env_values, size_t env_value_count)
+{
+	struct sce_job *job = malloc(sizeof(struct sce_job));
+	if (job == NULL)
+		return NULL;
+	_sce_job_init(job, script, env_values, env_value_count);
+	return job;
+}
+
+static void _sce_job_clear(struct sce_job *job)
+{
+	if (job->pid != 0 && !job->done) {
+		// nobody is interested in the result anymore
+		kill(job->pid, SIGTERM);
+		if (job->stdout_fd != -1)
+			close(job->stdout_fd);
+		if (job->stderr_fd != -1)
+			close(job->stderr_fd);
+		waitpid(job->pid, NULL, 0);
+	}
+	oscap_string_free(job->stdout_string);
+	oscap_string_free(job->stderr_string);
+	free_env_values(job->env_values, index_of_first_env_value_not_compiled_in, job->env_value_count);
+	free(job->script);
+}
+
+static void _sce_job_free(struct sce_job *job)
+{
+	_sce_job_clear(job);
+	free(job);
+}
+
+static bool _sce_job_matches(const struct sce_job *job, const char *script, char **env_values, size_t env_value_count)
+{
+	if (strcmp(job->script, script) != 0 || job->env_value_count != env_value_count)
+		return false;
+	for (size_t i = index_of_first_env_value_not_compiled_in; i < env_value_count; ++i) {
+		if (strcmp(job->env_values[i], env_values[i]) != 0)
+			return false;
+	}
+	return true;
+}
+
+static int _sce_job_start(struct sce_parameters *parameters, struct sce_job *job)
+{
+	// all the result codes are shifted by 100, because otherwise syntax errors in scripts
+	// or even their nonexistence would cause XCCDF_RESULT_PASS to be the result
+
+	char* argvp[3] = {
+		job->script,
+		job->script, // the second script is added in case we use the wrapper (oscap-run-sce-script)
+		NULL         // which need the path of the script to eval as first parameter.
+	};
+
 	// We open a pipe for communication with the forked process
 	int stdout_pipefd[2];
 	int stderr_pipefd[2];
-	if (pipe(stdout_pipefd) == -1 || pipe(stderr_pipefd) == -1)
-	{
+	if (pipe(stdout_pipefd) == -1) {
 		dE("Error in pipe");
-		free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
-		return XCCDF_RESULT_ERROR;
+		return -1;
+	}
+	if (pipe(stderr_pipefd) == -1) {
+		dE("Error in pipe");
+		close(stdout_pipefd[0]);
+		close(stdout_pipefd[1]);
+		return -1;
+	}
+
+	if (_pipe_set_flags(stdout_pipefd[0]) == -1 || _pipe_set_flags(stderr_pipefd[0]) == -1) {
+		oscap_seterr(OSCAP_EFAMILY_SCE, "Failed to set flags of stdout and stderr pipes: %s",
+				strerror(errno));
+		close(stdout_pipefd[0]);
+		close(stdout_pipefd[1]);
+		close(stderr_pipefd[0]);
+		close(stderr_pipefd[1]);
+		return -1;
 	}
 
 	// FIXME: We definitely want to impose security restrictions in the forked child process in the future.
 	//        This would prevent scripts from writing to files or deleting them.
 
 	int fork_result = fork();
-	if (fork_result >= 0)
+	if (fork_result < 0) {
+		close(stdout_pipefd[0]);
+		close(stdout_pipefd[1]);
+		close(stderr_pipefd[0]);
+		close(stderr_pipefd[1]);
+		return -1;
+	}
+
+	if (fork_result == 0)
 	{
-		// fork successful
+		// we won't read from the pipes, so close the reading fd
+		close(stdout_pipefd[0]);
+		close(stderr_pipefd[0]);
 
-		if (fork_result == 0)
-		{
-			// we won't read from the pipes, so close the reading fd
-			close(stdout_pipefd[0]);
-			close(stderr_pipefd[0]);
-
-			// forward stdout and stderr to our custom opened pipes
-			dup2(stdout_pipefd[1], fileno(stdout));
-			dup2(stderr_pipefd[1], fileno(stderr));
-
-			// we duplicated the file descriptors twice, we can close the original
-			// ones now, stdout and stderr will be closed properly after the execved
-			// script/executable finishes
-			close(stdout_pipefd[1]);
-			close(stderr_pipefd[1]);
-
-			// before we execute the script, lets make sure we get SIGTERM when
-			// oscap is killed, crashes or otherwise terminates
+		// forward stdout and stderr to our custom opened pipes
+		dup2(stdout_pipefd[1], fileno(stdout));
+		dup2(stderr_pipefd[1], fileno(stderr));
+
+		// we duplicated the file descriptors twice, we can close the original
+		// ones now, stdout and stderr will be closed properly after the execved
+		// script/executable finishes
+		close(stdout_pipefd[1]);
+		close(stderr_pipefd[1]);
+
+		// before we execute the script, lets make sure we get SIGTERM when
+		// oscap is killed, crashes or otherwise terminates
 #if defined(PR_SET_PDEATHSIG)
-			// requires Linux 2.1.57 or later
-			prctl(PR_SET_PDEATHSIG, SIGTERM);
+		// requires Linux 2.1.57 or later
+		prctl(PR_SET_PDEATHSIG, SIGTERM);
 #elif defined(OS_FREEBSD)
-			int sig = SIGTERM;
-			procctl(P_PID, getpid(), PROC_PDEATHSIG_CTL, &sig);
+		int sig = SIGTERM;
+		procctl(P_PID, getpid(), PROC_PDEATHSIG_CTL, &sig);
 #else
-			// TODO: Please provide alternatives
+		// TODO: Please provide alternatives
 #endif
 
-			// we are the child process
-			if(use_sce_wrapper) {
+		// we are the child process
+		if (job->use_sce_wrapper) {
 #if defined(OS_FREEBSD)
-				size_t k;
+			size_t k;
 
-				// Setup environment beforehand as FreeBSD does not have execvpe()
-				for (k = 0; k < env_value_count; k++) {
-					putenv(env_values[k]);
-				}
+			// Setup environment beforehand as FreeBSD does not have execvpe()
+			for (k = 0; k < job->env_value_count; k++) {
+				putenv(job->env_values[k]);
+			}
 
-				execvp("oscap-run-sce-script", argvp);
+			execvp("oscap-run-sce-script", argvp);
 #else
-				execvpe("oscap-run-sce-script", argvp, env_values);
+			execvpe("oscap-run-sce-script", argvp, job->env_values);
 #endif
-			} else {
-				execve(tmp_href, argvp, env_values);
-			}
+		} else {
+			execve(job->script, argvp, job->env_values);
+		}
 
-			free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
+		// no need to check the return value of execve, if it returned at all we are in trouble
+		printf("Unexpected error when executing script '%s'. Error message follows.\n", job->script);
+		perror("execve");
 
-			// no need to check the return value of execve, if it returned at all we are in trouble
-			printf("Unexpected error when executing script '%s'. Error message follows.\n", href);
-			perror("execve");
+		// the parent process considers us a script check, we have to return a value that will mean XCCDF_RESULT_ERROR
+		exit(103);
+	}
 
-			// the parent process considers us a script check, we have to return a value that will mean XCCDF_RESULT_ERROR
-			exit(103);
-		}
-		else
-		{
-			// we won't write to the pipes, so close the writing fd
-			close(stdout_pipefd[1]);
-			close(stderr_pipefd[1]);
-
-			const int flag_stdout = fcntl(stdout_pipefd[0], F_GETFL, 0);
-			if (flag_stdout == -1) {
-				oscap_seterr(OSCAP_EFAMILY_SCE, "Failed to obtain status of stdout pipe: %s",
-						strerror(errno));
-				free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
-				return XCCDF_RESULT_ERROR;
-			}
-			int retval = fcntl(stdout_pipefd[0], F_SETFL, flag_stdout | O_NONBLOCK);
-			if (retval == -1) {
-				oscap_seterr(OSCAP_EFAMILY_SCE,
-						"Failed to set nonblocking flag on stdout pipe: %s",
-						strerror(errno));
-				free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
-				return XCCDF_RESULT_ERROR;
-			}
+	// we won't write to the pipes, so close the writing fd
+	close(stdout_pipefd[1]);
+	close(stderr_pipefd[1]);
 
-			const int flag_stderr = fcntl(stderr_pipefd[0], F_GETFL, 0);
-			if (flag_stderr == -1) {
-				oscap_seterr(OSCAP_EFAMILY_SCE,
-						"Failed to obtain status of stderr pipe: %s",
-						strerror(errno));
-				free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
-				return XCCDF_RESULT_ERROR;
-			}
-			retval = fcntl(stderr_pipefd[0], F_SETFL, flag_stderr | O_NONBLOCK);
-			if (retval == -1) {
-				oscap_seterr(OSCAP_EFAMILY_SCE,
-						"Failed to set nonblocking flag on stderr pipe: %s",
-						strerror(errno));
-				free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
-				return XCCDF_RESULT_ERROR;
-			}
+	job->pid = fork_result;
+	job->stdout_fd = stdout_pipefd[0];
+	job->stderr_fd = stderr_pipefd[0];
+	job->stdout_string = oscap_string_new();
+	job->stderr_string = oscap_string_new();
+	parameters->running_jobs++;
 
-			// we have to read from both pipes at the same time to avoid stalling
-			struct oscap_string *stdout_string = oscap_string_new();
-			struct oscap_string *stderr_string = oscap_string_new();
+	return 0;
+}
 
-			bool stdout_eof = false;
-			bool stderr_eof = false;
+/*
+ * Start the prefetched jobs which weren't started yet, as long as there is
+ * a free slot.
+ */
+static void _sce_jobs_start_queued(struct sce_parameters *parameters)
+{
+	struct oscap_iterator *it = oscap_iterator_new(parameters->jobs);
+	while (parameters->running_jobs < parameters->max_jobs && oscap_iterator_has_more(it)) {
+		struct sce_job *job = oscap_iterator_next(it);
+		if (job->pid == 0 && _sce_job_start(parameters, job) != 0)
+			break;  // try again later
+	}
+	oscap_iterator_free(it);
+}
 
-			while (!stdout_eof || !stderr_eof) {
-				if (!stdout_eof)
-					_pipe_try_read_into_string(stdout_pipefd[0], stdout_string, &stdout_eof);
+static void _sce_job_add_pollfds(struct sce_job *job, struct pollfd *fds, struct sce_job **owners, size_t *nfds)
+{
+	if (job->pid == 0 || job->done)
+		return;
+	int job_fds[2] = { job->stdout_fd, job->stderr_fd };
+	for (size_t i = 0; i < 2; ++i) {
+		if (job_fds[i] == -1)
+			continue;
+		fds[*nfds].fd = job_fds[i];
+		fds[*nfds].events = POLLIN;
+		fds[*nfds].revents = 0;
+		owners[*nfds] = job;
+		(*nfds)++;
+	}
+}
 
-				if (!stderr_eof)
-					_pipe_try_read_into_string(stderr_pipefd[0], stderr_string, &stderr_eof);
+static void _sce_job_reap(struct sce_parameters *parameters, struct sce_job *job)
+{
+	if (job->done || job->stdout_fd != -1 || job->stderr_fd != -1)
+		return;
 
-				// sleep for 10ms to avoid wasting CPU
-				usleep(10 * 1000);
-			}
+	// both pipes are closed, the script has exited or is about to
+	while (waitpid(job->pid, &job->wstatus, 0) == -1 && errno == EINTR)
+		;
+	job->done = true;
+	parameters->running_jobs--;
+}
 
-			close(stdout_pipefd[0]);
-			close(stderr_pipefd[0]);
+/*
+ * Wait until the given job exits. The output of all the running jobs is read
+ * meanwhile, so that none of them stalls on a full pipe, and the prefetched
+ * jobs are started as the running ones exit.
+ */
+static void _sce_jobs_wait(struct sce_parameters *parameters, struct sce_job *target)
+{
+	// target isn't in the list anymore
+	const size_t max_fds = 2 * (oscap_list_get_itemcount(parameters->jobs) + 1);
+	struct pollfd *fds = malloc(max_fds * sizeof(struct pollfd));
+	struct sce_job **owners = malloc(max_fds * sizeof(struct sce_job *));
+	struct pollfd target_fds[2];
+	struct sce_job *target_owners[2];
+	bool all_jobs = true;
+
+	if (fds == NULL || owners == NULL) {
+		// read the output of the target only, the other jobs are waited for later
+		free(fds);
+		free(owners);
+		fds = target_fds;
+		owners = target_owners;
+		all_jobs = false;
+	}
 
-			char *stdout_buffer = oscap_string_bequeath(stdout_string);
-			char *stderr_buffer = oscap_string_bequeath(stderr_string);
+	while (!target->done) {
+		size_t nfds = 0;
+		_sce_job_add_pollfds(target, fds, owners, &nfds);
+		if (all_jobs) {
+			struct oscap_iterator *it = oscap_iterator_new(parameters->jobs);
+			while (oscap_iterator_has_more(it))
+				_sce_job_add_pollfds(oscap_iterator_next(it), fds, owners, &nfds);
+			oscap_iterator_free(it);
+		}
 
-			// we are the parent process
-			int wstatus;
-			waitpid(fork_result, &wstatus, 0);
+		if (poll(fds, nfds, -1) == -1) {
+			if (errno == EINTR)
+				continue;
+			dE("Failed to poll the script output: %s", strerror(errno));
+			// give up reading, the script gets EPIPE on next write
+			if (target->stdout_fd != -1)
+				close(target->stdout_fd);
+			if (target->stderr_fd != -1)
+				close(target->stderr_fd);
+			target->stdout_fd = target->stderr_fd = -1;
+			_sce_job_reap(parameters, target);
+			break;
+		}
 
-			// we subtract 100 here to shift the exit code to xccdf_test_result_type_t enum range
-			int raw_result = WEXITSTATUS(wstatus) - 100;
-			if (raw_result <= 0 || raw_result > XCCDF_RESULT_FIXED)
-			{
-				// the script returned invalid exit code, we need to safeguard us against that
-				raw_result = XCCDF_RESULT_ERROR;
+		for (size_t i = 0; i < nfds; ++i) {
+			if (fds[i].revents == 0)
+				continue;
+			struct sce_job *job = owners[i];
+			bool is_stdout = fds[i].fd == job->stdout_fd;
+			if (!_pipe_read_into_string(fds[i].fd, is_stdout ? job->stdout_string : job->stderr_string)) {
+				close(fds[i].fd);
+				if (is_stdout)
+					job->stdout_fd = -1;
+				else
+					job->stderr_fd = -1;
+				_sce_job_reap(parameters, job);
 			}
+		}
 
-			struct sce_session* session = sce_parameters_get_session(parameters);
-			if (session)
-			{
-				struct sce_check_result* check_result = sce_check_result_new();
-				sce_check_result_set_href(check_result, tmp_href);
-				char *base_name = oscap_basename(tmp_href);
-				sce_check_result_set_basename(check_result, base_name);
-				free(base_name);
-				sce_check_result_set_stdout(check_result, stdout_buffer);
-				sce_check_result_set_stderr(check_result, stderr_buffer);
-				sce_check_result_set_exit_code(check_result, WEXITSTATUS(wstatus));
-				sce_check_result_set_xccdf_result(check_result, (xccdf_test_result_type_t)raw_result);
-
-				for (size_t i = 0; i < env_value_count; ++i)
-				{
-					sce_check_result_add_environment_variable(check_result, env_values[i]);
-				}
-
-				sce_session_add_check_result(session, check_result);
-			}
+		if (all_jobs)
+			_sce_jobs_start_queued(parameters);
+	}
 
-			free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
+	if (all_jobs) {
+		free(fds);
+		free(owners);
+	}
+}
 
-			// lets interpret the check imports passed to us
-			xccdf_check_import_iterator_reset(check_import_it);
-			while (xccdf_check_import_iterator_has_more(check_import_it))
-			{
-				struct xccdf_check_import * check_import = xccdf_check_import_iterator_next(check_import_it);
-				const char *name = xccdf_check_import_get_name(check_import);
-
-				if (strcmp(name, "stdout") == 0)
-				{
-					xccdf_check_import_set_content(check_import, stdout_buffer);
-				}
-				else if (strcmp(name, "stderr") == 0)
-				{
-					xccdf_check_import_set_content(check_import, stderr_buffer);
-				}
-			}
+xccdf_test_result_type_t sce_engine_eval_rule(struct xccdf_policy *policy, const char *rule_id, const char *id, const char *href,
+		struct xccdf_value_binding_iterator *value_binding_it,
+		struct xccdf_check_import_iterator *check_import_it,
+		void *usr)
+{
+	struct sce_parameters* parameters = (struct sce_parameters*)usr;
+	const char* xccdf_directory = parameters->xccdf_directory;
 
-			free(tmp_href);
-			free(stdout_buffer);
-			free(stderr_buffer);
+	char* tmp_href = oscap_sprintf("%s/%s", xccdf_directory, href);
 
-			return (xccdf_test_result_type_t)raw_result;
+	if (access(tmp_href, F_OK))
+	{
+		// we only do this check to provide helpful error message
+		// there is an inherent race condition, the file might
+		// not exist anymore at the time we execve it!
+
+		// the script hasn't been found, perhaps another sce instance
+		// with a different XCCDF directory can find it?
+		oscap_seterr(OSCAP_EFAMILY_SCE, "SCE couldn't find script file '%s'. "
+				"Expected location: '%s'.", href, tmp_href);
+		free(tmp_href);
+		return XCCDF_RESULT_NOT_CHECKED;
+	}
+
+	size_t env_value_count = 0;
+	char **env_values = _sce_env_values_new(value_binding_it, &env_value_count);
+	if (env_values == NULL) {
+		free(tmp_href);
+		return XCCDF_RESULT_ERROR;
+	}
+
+	// pick up the script if it was prefetched
+	struct sce_job *job = NULL;
+	struct oscap_iterator *it = oscap_iterator_new(parameters->jobs);
+	while (oscap_iterator_has_more(it)) {
+		struct sce_job *prefetched = oscap_iterator_next(it);
+		if (_sce_job_matches(prefetched, tmp_href, env_values, env_value_count)) {
+			job = oscap_iterator_detach(it);
+			break;
 		}
 	}
-	else
-	{
+	oscap_iterator_free(it);
+
+	struct sce_job local_job;
+	if (job == NULL) {
+		job = _sce_job_new(tmp_href, env_values, env_value_count);
+		if (job == NULL) {
+			// run the script without the job list, the same as the serial evaluation
+			job = &local_job;
+			_sce_job_init(job, tmp_href, env_values, env_value_count);
+		}
+	} else {
+		free(tmp_href);
 		free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
+	}
 
-		close(stdout_pipefd[0]);
-		close(stdout_pipefd[1]);
-		close(stderr_pipefd[0]);
-		close(stderr_pipefd[1]);
+	if (job->pid == 0 && _sce_job_start(parameters, job) != 0) {
+		if (job == &local_job)
+			_sce_job_clear(job);
+		else
+			_sce_job_free(job);
 		return XCCDF_RESULT_ERROR;
 	}
+
+	_sce_jobs_wait(parameters, job);
+
+	char *stdout_buffer = oscap_string_bequeath(job->stdout_string);
+	char *stderr_buffer = oscap_string_bequeath(job->stderr_string);
+	job->stdout_string = NULL;
+	job->stderr_string = NULL;
+
+	// we subtract 100 here to shift the exit code to xccdf_test_result_type_t enum range
+	int raw_result = WEXITSTATUS(job->wstatus) - 100;
+	if (raw_result <= 0 || raw_result > XCCDF_RESULT_FIXED)
+	{
+		// the script returned invalid exit code, we need to safeguard us against that
+		raw_result = XCCDF_RESULT_ERROR;
+	}
+
+	struct sce_session* session = sce_parameters_get_session(parameters);
+	if (session)
+	{
+		struct sce_check_result* check_result = sce_check_result_new();
+		sce_check_result_set_href(check_result, job->script);
+		char *base_name = oscap_basename(job->script);
+		sce_check_result_set_basename(check_result, base_name);
+		free(base_name);
+		sce_check_result_set_stdout(check_result, stdout_buffer);
+		sce_check_result_set_stderr(check_result, stderr_buffer);
+		sce_check_result_set_exit_code(check_result, WEXITSTATUS(job->wstatus));
+		sce_check_result_set_xccdf_result(check_result, (xccdf_test_result_type_t)raw_result);
+
+		for (size_t i = 0; i < job->env_value_count; ++i)
+		{
+			sce_check_result_add_environment_variable(check_result, job->env_values[i]);
+		}
+
+		sce_session_add_check_result(session, check_result);
+	}
+
+	if (job == &local_job)
+		_sce_job_clear(job);
+	else
+		_sce_job_free(job);
+
+	// lets interpret the check imports passed to us
+	xccdf_check_import_iterator_reset(check_import_it);
+	while (xccdf_check_import_iterator_has_more(check_import_it))
+	{
+		struct xccdf_check_import * check_import = xccdf_check_import_iterator_next(check_import_it);
+		const char *name = xccdf_check_import_get_name(check_import);
+
+		if (strcmp(name, "stdout") == 0)
+		{
+			xccdf_check_import_set_content(check_import, stdout_buffer);
+		}
+		else if (strcmp(name, "stderr") == 0)
+		{
+			xccdf_check_import_set_content(check_import, stderr_buffer);
+		}
+	}
+
+	free(stdout_buffer);
+	free(stderr_buffer);
+
+	return (xccdf_test_result_type_t)raw_result;
+}
+
+static void *sce_engine_query(void *usr, xccdf_policy_engine_query_t query_type, void *query_data)
+{
+	struct sce_parameters *parameters = (struct sce_parameters *) usr;
+	if (query_type != POLICY_ENGINE_QUERY_PREFETCH_CHECK || parameters->max_jobs < 2)
+		return NULL;
+
+	const struct xccdf_policy_engine_prefetch *prefetch = (const struct xccdf_policy_engine_prefetch *) query_data;
+	char *script = oscap_sprintf("%s/%s", parameters->xccdf_directory, prefetch->href);
+	if (access(script, F_OK)) {
+		// the evaluation reports it
+		free(script);
+		return NULL;
+	}
+
+	size_t env_value_count = 0;
+	char **env_values = _sce_env_values_new(prefetch->value_binding_it, &env_value_count);
+	if (env_values == NULL) {
+		free(script);
+		return NULL;
+	}
+
+	struct sce_job *job = _sce_job_new(script, env_values, env_value_count);
+	if (job == NULL) {
+		// not prefetched, the script runs when the check is evaluated
+		free(script);
+		free_env_values(env_values, index_of_first_env_value_not_compiled_in, env_value_count);
+		return NULL;
+	}
+
+	oscap_list_add(parameters->jobs, job);
+	_sce_jobs_start_queued(parameters);
+	return NULL;
 }
 
 bool xccdf_policy_model_register_engine_sce(struct xccdf_policy_model * model, struct sce_parameters *parameters)
 {
-	return xccdf_policy_model_register_engine_and_query_callback(model,
-		"http://open-scap.org/page/SCE", sce_engine_eval_rule, (void*)parameters, NULL);
+	return xccdf_policy_model_register_engine_with_flags(model,
+		"http://open-scap.org/page/SCE", sce_engine_eval_rule, (void*)parameters, sce_engine_query,
+		XCCDF_POLICY_ENGINE_PREFETCH);
 }
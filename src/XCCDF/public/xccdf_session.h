@@ -159,6 +159,16 @@ OSCAP_API void xccdf_session_set_signature_enforcement(struct xccdf_session *ses
  */
 OSCAP_API void xccdf_session_set_thin_results(struct xccdf_session *session, bool thin_result);
 
+/**
+ * Set number of threads used to collect OVAL objects.
+ * Objects of the OVAL definitions referenced by the selected rules are then
+ * collected concurrently by probes of different types before the rules are
+ * evaluated. The results are the same as with serial collection.
+ * @memberof xccdf_session
+ * @param workers number of threads, 0 or 1 means serial collection (default)
+ */
+OSCAP_API void xccdf_session_set_oval_eval_workers(struct xccdf_session *session, unsigned int workers);
+
 /**
  * Set requested datastream_id for this session. This datastream_id is later
  * passed down to @ref ds_sds_index_select_checklist to determine target component.
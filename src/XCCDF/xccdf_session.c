@@ -49,6 +49,10 @@
 #include "DS/rds_priv.h"
 #include "DS/sds_priv.h"
 #include "OVAL/results/oval_results_impl.h"
+#include "OVAL/oval_agent_api_impl.h"
+#if defined(OVAL_PROBES_ENABLED)
+# include "OVAL/oval_collection_cache.h"
+#endif
 #include "source/xslt_priv.h"
 #include "source/signature_priv.h"
 #include "XCCDF/xccdf_impl.h"
@@ -99,6 +103,8 @@ struct xccdf_session {
 		struct oscap_htable *result_sources;    ///< mapping 'filepath' to oscap_source for OVAL results
 		struct oscap_htable *results_mapping;    ///< mapping OVAL filename to filepath for OVAL results
 		struct oscap_htable *arf_report_mapping;    ///< mapping OVAL filename to ARF report ID for OVAL results
+		unsigned int eval_workers;		///< Number of threads collecting OVAL objects.
+		struct oval_collection_cache *collection_cache;///< Objects collected by any of the OVAL sessions, incl. CPE ones
 	} oval;
 	struct {
 		char *arf_file;				///< Path to ARF file to export
@@ -162,6 +168,9 @@ struct xccdf_session *xccdf_session_new_from_source(struct oscap_source *source)
 	session->signature_ctx = oscap_signature_ctx_new();
 	session->xccdf.base_score = 0;
 	session->oval.progress = download_progress_empty_calllback;
+#if defined(OVAL_PROBES_ENABLED)
+	session->oval.collection_cache = oval_collection_cache_new();
+#endif
 	session->check_engine_plugins = oscap_list_new();
 	session->loading_flags = XCCDF_SESSION_LOAD_ALL;
 	session->rules = oscap_list_new();
@@ -345,6 +354,9 @@ void xccdf_session_free(struct xccdf_session *session)
 	oscap_source_free(session->xccdf.result_source);
 	if (session->xccdf.policy_model != NULL)
 		xccdf_policy_model_free(session->xccdf.policy_model);
+#if defined(OVAL_PROBES_ENABLED)
+	oval_collection_cache_free(session->oval.collection_cache);
+#endif
 	free(session->ds.user_datastream_id);
 	free(session->ds.user_component_id);
 	free(session->ds.user_benchmark_id);
@@ -409,6 +421,11 @@ void xccdf_session_set_thin_results(struct xccdf_session *session, bool thin_res
 	session->export.thin_results = thin_results;
 }
 
+void xccdf_session_set_oval_eval_workers(struct xccdf_session *session, unsigned int workers)
+{
+	session->oval.eval_workers = workers;
+}
+
 void xccdf_session_set_datastream_id(struct xccdf_session *session, const char *datastream_id)
 {
 	free(session->ds.user_datastream_id);
@@ -891,6 +908,7 @@ int xccdf_session_load_cpe(struct xccdf_session *session)
 	// to apply the thin results settings to them.
 	struct cpe_session *cpe_session = xccdf_policy_model_get_cpe_session(session->xccdf.policy_model);
 	cpe_session_set_thin_results(cpe_session, session->export.thin_results);
+	cpe_session_set_collection_cache(cpe_session, session->oval.collection_cache);
 
 	/* Use custom CPE dict if given */
 	if (session->user_cpe != NULL) {
@@ -1137,6 +1155,10 @@ int xccdf_session_load_oval(struct xccdf_session *session)
 	struct oval_content_resource **contents = NULL;
 
 	_xccdf_session_free_oval_agents(session);
+#if defined(OVAL_PROBES_ENABLED)
+	/* The system might have been changed by remediation since the last load */
+	oval_collection_cache_clear(session->oval.collection_cache);
+#endif
 
 	/* Locate all OVAL files */
 	if (session->oval.custom_resources == NULL) {
@@ -1195,6 +1217,9 @@ int xccdf_session_load_oval(struct xccdf_session *session)
 		/* store our name in the generated documents */
 		oval_agent_set_product_name(tmp_sess, session->oval.product_cpe != NULL ?
 				session->oval.product_cpe : (char *) oscap_productname);
+		oval_agent_set_eval_workers(tmp_sess, session->oval.eval_workers);
+		if (session->oval.collection_cache != NULL)
+			oval_agent_set_collection_cache(tmp_sess, session->oval.collection_cache);
 
 		/* remember sessions */
 		void *new_oval_agents = realloc(session->oval.agents, (idx + 2) * sizeof(struct oval_agent_session *));
@@ -1327,6 +1352,79 @@ int xccdf_session_load_tailoring(struct xccdf_session *session)
 	return xccdf_policy_model_set_tailoring(session->xccdf.policy_model, tailoring) ? 0 : 1;
 }
 
+/**
+ * Collect OVAL objects of the definitions which are going to be evaluated
+ * by the policy in parallel, before the evaluation starts.
+ */
+static void _xccdf_session_prefetch_oval(struct xccdf_session *session, struct xccdf_policy *policy)
+{
+	if (session->oval.eval_workers < 2 || session->oval.agents == NULL || session->oval.user_eval_fn != NULL)
+		return;
+
+	size_t agents_count = 0;
+	while (session->oval.agents[agents_count] != NULL)
+		agents_count++;
+	struct oscap_stringlist **ids = malloc(agents_count * sizeof(struct oscap_stringlist *));
+	for (size_t idx = 0; idx < agents_count; idx++)
+		ids[idx] = oscap_stringlist_new();
+
+	struct oscap_list *checks = xccdf_policy_get_planned_checks(policy);
+	struct oscap_iterator *check_it = oscap_iterator_new(checks);
+	while (oscap_iterator_has_more(check_it)) {
+		struct xccdf_check *check = oscap_iterator_next(check_it);
+		if (oscap_strcmp(xccdf_check_get_system(check), oval_sysname) != 0)
+			continue;
+
+		/* Content references are alternatives, the first one known
+		 * to an agent is the one which gets evaluated. */
+		bool resolved = false;
+		struct xccdf_check_content_ref_iterator *content_it = xccdf_check_get_content_refs(check);
+		while (!resolved && xccdf_check_content_ref_iterator_has_more(content_it)) {
+			struct xccdf_check_content_ref *content = xccdf_check_content_ref_iterator_next(content_it);
+			const char *name = xccdf_check_content_ref_get_name(content);
+			const char *href = xccdf_check_content_ref_get_href(content);
+
+			for (size_t idx = 0; !resolved && idx < agents_count; idx++) {
+				if (oscap_strcmp(oval_agent_get_filename(session->oval.agents[idx]), href) != 0)
+					continue;
+				struct oval_definition_model *def_model = oval_agent_get_definition_model(session->oval.agents[idx]);
+				if (name == NULL) {
+					struct oval_definition_iterator *def_it = oval_definition_model_get_definitions(def_model);
+					while (oval_definition_iterator_has_more(def_it))
+						oscap_stringlist_add_string(ids[idx], oval_definition_get_id(oval_definition_iterator_next(def_it)));
+					oval_definition_iterator_free(def_it);
+					resolved = true;
+				} else if (oval_definition_model_get_definition(def_model, name) != NULL) {
+					oscap_stringlist_add_string(ids[idx], name);
+					resolved = true;
+				}
+			}
+		}
+		xccdf_check_content_ref_iterator_free(content_it);
+	}
+	oscap_iterator_free(check_it);
+	oscap_list_free(checks, NULL);
+
+	for (size_t idx = 0; idx < agents_count; idx++) {
+		if (oval_agent_prefetch_definitions(session->oval.agents[idx], ids[idx]) != 0)
+			dW("Parallel collection of OVAL objects failed, falling back to serial collection.");
+		oscap_stringlist_free(ids[idx]);
+	}
+	free(ids);
+}
+
+static void _xccdf_session_prefetch_check_engines(struct xccdf_session *session, struct xccdf_policy *policy)
+{
+	if (oscap_list_get_itemcount(session->check_engine_plugins) == 0)
+		return;
+
+	/* The scripts of the check engine plugins can run while the OVAL
+	 * objects are collected. */
+	struct oscap_list *checks = xccdf_policy_get_planned_checks(policy);
+	xccdf_policy_prefetch_checks(policy, checks);
+	oscap_list_free(checks, NULL);
+}
+
 int xccdf_session_evaluate(struct xccdf_session *session)
 {
 	struct xccdf_policy *policy = xccdf_session_get_xccdf_policy(session);
@@ -1347,10 +1445,18 @@ int xccdf_session_evaluate(struct xccdf_session *session)
 	}
 	oscap_iterator_free(sit);
 
+	_xccdf_session_prefetch_check_engines(session, policy);
+	_xccdf_session_prefetch_oval(session, policy);
+
 	session->xccdf.result = xccdf_policy_evaluate(policy);
 	if (session->xccdf.result == NULL)
 		return 1;
 
+	if (session->oval.agents != NULL) {
+		for (int i = 0; session->oval.agents[i]; i++)
+			oval_agent_renumber_items(session->oval.agents[i]);
+	}
+
 	/* Write results into XCCDF Test Result model */
 	xccdf_result_set_benchmark_uri(session->xccdf.result, oscap_source_readable_origin(session->source));
 	struct oscap_text *title = oscap_text_new();
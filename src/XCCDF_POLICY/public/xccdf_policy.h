@@ -72,8 +72,32 @@ struct xccdf_policy_iterator;
 typedef enum {
 	POLICY_ENGINE_QUERY_NAMES_FOR_HREF = 1,		/// Considering xccdf:check-content-ref, what are possible @name attributes for given href?
 	POLICY_ENGINE_QUERY_OVAL_DEFS_FOR_HREF = 2,	/// Considering xccdf:check-content-ref, what are OVAL definitions for given href?
+	POLICY_ENGINE_QUERY_PREFETCH_CHECK = 3,		/// The check is going to be evaluated, the engine may start evaluating it ahead of time.
 } xccdf_policy_engine_query_t;
 
+/**
+ * Optional capabilities of a checking engine, declared when the engine is registered.
+ * @see xccdf_policy_model_register_engine_with_flags
+ */
+typedef enum {
+	XCCDF_POLICY_ENGINE_NONE = 0,
+	XCCDF_POLICY_ENGINE_PREFETCH = 1 << 0,	/// The engine handles POLICY_ENGINE_QUERY_PREFETCH_CHECK.
+} xccdf_policy_engine_flags_t;
+
+/**
+ * Check passed along with POLICY_ENGINE_QUERY_PREFETCH_CHECK. These are the
+ * arguments the eval function is going to be called with later on. The
+ * checks are announced in the order of the evaluation before the evaluation
+ * starts, but there is no guarantee a prefetched check is evaluated.
+ * Only the engines registered with XCCDF_POLICY_ENGINE_PREFETCH are queried.
+ */
+struct xccdf_policy_engine_prefetch {
+	struct xccdf_policy *policy;
+	const char *definition_id;
+	const char *href;
+	struct xccdf_value_binding_iterator *value_binding_it;
+};
+
 /**
  * Type of function which implements queries defined within xccdf_policy_engine_query_t.
  *
@@ -84,10 +108,12 @@ typedef enum {
  * dependent on query and defined as follows:
  *  - (const char *)href -- for POLICY_ENGINE_QUERY_NAMES_FOR_HREF
  *  - (const char *)href -- for POLICY_ENGINE_QUERY_OVAL_DEFS_FOR_HREF
+ *  - (struct xccdf_policy_engine_prefetch *) -- for POLICY_ENGINE_QUERY_PREFETCH_CHECK
  *
  * Expected return type depends also on query as follows:
  *  - (struct oscap_stringlist *) -- for POLICY_ENGINE_QUERY_NAMES_FOR_HREF
  *  - (struct oscap_list *) -- for POLICY_ENGINE_QUERY_OVAL_DEFS_FOR_HREF
+ *  - NULL -- for POLICY_ENGINE_QUERY_PREFETCH_CHECK
  *  - NULL shall be returned if the function doesn't understand the query.
  */
 typedef void *(*xccdf_policy_engine_query_fn) (void *, xccdf_policy_engine_query_t, void *);
@@ -239,6 +265,19 @@ OSCAP_API struct oscap_htable_iterator *xccdf_policy_model_get_cpe_oval_sessions
  */
 OSCAP_API bool xccdf_policy_model_register_engine_and_query_callback(struct xccdf_policy_model *model, char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn);
 
+/**
+ * Function to register callback for checking system which supports some of the optional queries
+ * @param model XCCDF Policy Model
+ * @param sys String representing given checking system
+ * @param eval_fn Callback - pointer to function called by XCCDF Policy system when rule parsed
+ * @param usr optional parameter for passing user data to callback
+ * @param query_fn - optional parameter for providing xccdf_policy_engine_query_fn implementation for given system.
+ * @param flags Bit mask of the capabilities of the engine
+ * @memberof xccdf_policy_model
+ * @return true if callback registered succesfully, false otherwise
+ */
+OSCAP_API bool xccdf_policy_model_register_engine_with_flags(struct xccdf_policy_model *model, char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn, xccdf_policy_engine_flags_t flags);
+
 typedef int (*policy_reporter_output)(struct xccdf_rule_result *, void *);
 
 /**
@@ -555,7 +555,7 @@ _xccdf_policy_is_engine_registered(struct xccdf_policy *policy, char *sysname)
 }
 
 static struct xccdf_check *
-_xccdf_policy_rule_get_applicable_check(struct xccdf_policy *policy, struct xccdf_item *rule)
+_xccdf_policy_rule_get_applicable_check(struct xccdf_policy *policy, struct xccdf_item *rule, bool quiet)
 {
 	// Citations inline come from NISTIR-7275r4.
 	struct xccdf_check *result = NULL;
@@ -590,9 +590,11 @@ _xccdf_policy_rule_get_applicable_check(struct xccdf_policy *policy, struct xccd
 			} else if (strcmp("http://oval.mitre.org/XMLSchema/oval-definitions-5", check->system) == 0) {
 				print_oval_warning = true;
 			} else if (strcmp("http://scap.nist.gov/schema/ocil/2", check->system) == 0) {
-				dI("This rule requires an OCIL check. OCIL checks are not supported by OpenSCAP.");
+				if (!quiet)
+					dI("This rule requires an OCIL check. OCIL checks are not supported by OpenSCAP.");
 			} else if (strcmp("http://open-scap.org/page/SCE", check->system) == 0) {
-				dI("This rule requires a SCE check but the SCE plugin was disabled.");
+				if (!quiet)
+					dI("This rule requires a SCE check but the SCE plugin was disabled.");
 			} else {
 				print_general_warning = true;
 				warning_check_system = check->system;
@@ -600,7 +602,9 @@ _xccdf_policy_rule_get_applicable_check(struct xccdf_policy *policy, struct xccd
 		}
 
 		// Only print a warning if we didn't select a check but could've otherwise.
-		if (print_oval_warning) {
+		if (quiet) {
+			// The rule is going to be evaluated later and will report it.
+		} else if (print_oval_warning) {
 			dW("Skipping rule that uses OVAL but is possibly malformed; "
 			       "an incorrect content reference prevents this check from being evaluated.\n");
 		} else if (print_general_warning && result == NULL) {
@@ -1093,7 +1097,7 @@ _xccdf_policy_rule_evaluate(struct xccdf_policy * policy, const struct xccdf_rul
 		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_APPLICABLE, NULL);
 	}
 
-	const struct xccdf_check *orig_check = _xccdf_policy_rule_get_applicable_check(policy, (struct xccdf_item *) rule);
+	const struct xccdf_check *orig_check = _xccdf_policy_rule_get_applicable_check(policy, (struct xccdf_item *) rule, false);
 	if (orig_check == NULL)
 		// No candidate or applicable check found.
 		return _xccdf_policy_report_rule_result(policy, result, rule, NULL, XCCDF_RESULT_NOT_CHECKED, "No candidate or applicable check found.");
@@ -1246,6 +1250,120 @@ static int xccdf_policy_item_evaluate(struct xccdf_policy * policy, struct xccdf
     return ret;
 }
 
+static bool _xccdf_policy_item_has_dependencies(const struct xccdf_item *item)
+{
+	struct oscap_string_iterator *conflicts_it = xccdf_item_get_conflicts(item);
+	struct oscap_stringlist_iterator *requires_it = xccdf_item_get_requires(item);
+	bool has_dependencies = oscap_string_iterator_has_more(conflicts_it) || oscap_stringlist_iterator_has_more(requires_it);
+	oscap_string_iterator_free(conflicts_it);
+	oscap_stringlist_iterator_free(requires_it);
+	return has_dependencies;
+}
+
+/**
+ * Collect the simple check which _xccdf_policy_rule_evaluate is going to
+ * evaluate for the given item. Rules whose evaluation depends on the
+ * outcome of other rules (requires, conflicts) or which use a complex
+ * check are left out.
+ */
+static void _xccdf_policy_item_plan_checks(struct xccdf_policy *policy, struct xccdf_item *item, bool parent_selected, struct oscap_list *checks)
+{
+	const char *item_id = xccdf_item_get_id(item);
+
+	switch (xccdf_item_get_type(item)) {
+	case XCCDF_RULE:{
+		if (oscap_htable_get(policy->skip_rules, item_id) != NULL)
+			return;
+		if (_user_specified_rule_mode(policy)) {
+			if (oscap_htable_get(policy->rules, item_id) == NULL)
+				return;
+		} else {
+			if (!parent_selected || !xccdf_policy_is_item_selected(policy, item_id))
+				return;
+			if (_xccdf_policy_item_has_dependencies(item))
+				return;
+		}
+
+		struct xccdf_refine_rule_internal *r_rule = oscap_htable_get(policy->refine_rules_internal, item_id);
+		if (xccdf_get_final_role((struct xccdf_rule *) item, r_rule) == XCCDF_ROLE_UNCHECKED)
+			return;
+		if (!xccdf_policy_model_item_is_applicable(policy->model, item))
+			return;
+
+		struct xccdf_check *check = _xccdf_policy_rule_get_applicable_check(policy, item, true);
+		if (check == NULL || xccdf_check_get_complex(check))
+			return;
+		struct oscap_list *bindings = xccdf_policy_check_get_value_bindings(policy, xccdf_check_get_exports(check));
+		if (bindings == NULL)
+			return;
+		oscap_list_free(bindings, (oscap_destruct_func) xccdf_value_binding_free);
+
+		oscap_list_add(checks, check);
+	} break;
+	case XCCDF_GROUP:{
+		if (_xccdf_policy_item_has_dependencies(item))
+			return;
+		bool is_selected = parent_selected && xccdf_policy_is_item_selected(policy, item_id);
+		struct xccdf_item_iterator *child_it = xccdf_group_get_content((const struct xccdf_group *) item);
+		while (xccdf_item_iterator_has_more(child_it))
+			_xccdf_policy_item_plan_checks(policy, xccdf_item_iterator_next(child_it), is_selected, checks);
+		xccdf_item_iterator_free(child_it);
+	} break;
+	default:
+		break;
+	}
+}
+
+struct oscap_list *xccdf_policy_get_planned_checks(struct xccdf_policy *policy)
+{
+	struct oscap_list *checks = oscap_list_new();
+	struct xccdf_benchmark *benchmark = xccdf_policy_model_get_benchmark(xccdf_policy_get_model(policy));
+	struct xccdf_item_iterator *item_it = xccdf_benchmark_get_content(benchmark);
+	while (xccdf_item_iterator_has_more(item_it))
+		_xccdf_policy_item_plan_checks(policy, xccdf_item_iterator_next(item_it), true, checks);
+	xccdf_item_iterator_free(item_it);
+	return checks;
+}
+
+void xccdf_policy_prefetch_checks(struct xccdf_policy *policy, struct oscap_list *checks)
+{
+	struct oscap_iterator *check_it = oscap_iterator_new(checks);
+	while (oscap_iterator_has_more(check_it)) {
+		struct xccdf_check *check = oscap_iterator_next(check_it);
+
+		// Only the first content reference is announced, the others
+		// are alternatives which are evaluated only if it fails.
+		struct xccdf_check_content_ref_iterator *content_it = xccdf_check_get_content_refs(check);
+		struct xccdf_check_content_ref *content = xccdf_check_content_ref_iterator_has_more(content_it) ?
+			xccdf_check_content_ref_iterator_next(content_it) : NULL;
+		xccdf_check_content_ref_iterator_free(content_it);
+		if (content == NULL)
+			continue;
+
+		// The evaluation tries the engines in turn, the first one is
+		// the one which gets the check unless it can't evaluate it.
+		struct oscap_iterator *engine_it = _xccdf_policy_get_engines_by_sysname(policy, xccdf_check_get_system(check));
+		struct xccdf_policy_engine *engine = oscap_iterator_has_more(engine_it) ? oscap_iterator_next(engine_it) : NULL;
+		oscap_iterator_free(engine_it);
+		if (engine == NULL || !xccdf_policy_engine_has_flag(engine, XCCDF_POLICY_ENGINE_PREFETCH))
+			continue;
+
+		struct oscap_list *bindings = xccdf_policy_check_get_value_bindings(policy, xccdf_check_get_exports(check));
+		if (bindings == NULL)
+			continue;
+		struct xccdf_policy_engine_prefetch prefetch = {
+			.policy = policy,
+			.definition_id = xccdf_check_content_ref_get_name(content),
+			.href = xccdf_check_content_ref_get_href(content),
+			.value_binding_it = (struct xccdf_value_binding_iterator *) oscap_iterator_new(bindings),
+		};
+		xccdf_policy_engine_query(engine, POLICY_ENGINE_QUERY_PREFETCH_CHECK, &prefetch);
+		xccdf_value_binding_iterator_free(prefetch.value_binding_it);
+		oscap_list_free(bindings, (oscap_destruct_func) xccdf_value_binding_free);
+	}
+	oscap_iterator_free(check_it);
+}
+
 struct oscap_file_entry {
 	char* system_name;
 	char* file;
@@ -1645,9 +1763,15 @@ const char * xccdf_policy_get_id(struct xccdf_policy * policy)
 
 bool
 xccdf_policy_model_register_engine_and_query_callback(struct xccdf_policy_model *model, char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn)
+{
+	return xccdf_policy_model_register_engine_with_flags(model, sys, eval_fn, usr, query_fn, XCCDF_POLICY_ENGINE_NONE);
+}
+
+bool
+xccdf_policy_model_register_engine_with_flags(struct xccdf_policy_model *model, char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn, xccdf_policy_engine_flags_t flags)
 {
         __attribute__nonnull__(model);
-	struct xccdf_policy_engine *engine = xccdf_policy_engine_new(sys, eval_fn, usr, query_fn);
+	struct xccdf_policy_engine *engine = xccdf_policy_engine_new(sys, eval_fn, usr, query_fn, flags);
 	return oscap_list_add(model->engines, engine);
 }
 
@@ -35,9 +35,10 @@ struct xccdf_policy_engine {
 	xccdf_policy_engine_eval_fn callback;   ///< format of callback function
 	void * usr;                             ///< User data structure
 	xccdf_policy_engine_query_fn query_fn;  ///< query callback function
+	xccdf_policy_engine_flags_t flags;      ///< optional capabilities
 };
 
-struct xccdf_policy_engine *xccdf_policy_engine_new(char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn)
+struct xccdf_policy_engine *xccdf_policy_engine_new(char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn, xccdf_policy_engine_flags_t flags)
 {
 	struct xccdf_policy_engine *engine = malloc(sizeof(struct xccdf_policy_engine));
         if (engine != NULL) {
@@ -45,10 +46,16 @@ struct xccdf_policy_engine *xccdf_policy_engine_new(char *sys, xccdf_policy_engi
 		engine->callback = eval_fn;
 		engine->usr = usr;
 		engine->query_fn = query_fn;
+		engine->flags = flags;
 	}
 	return engine;
 }
 
+bool xccdf_policy_engine_has_flag(const struct xccdf_policy_engine *engine, xccdf_policy_engine_flags_t flag)
+{
+	return (engine->flags & flag) == flag;
+}
+
 bool xccdf_policy_engine_filter(struct xccdf_policy_engine *engine, const char *sysname)
 {
 	return oscap_strcmp(engine->system, sysname) == 0;
@@ -43,9 +43,15 @@ struct xccdf_policy_engine;
  * @param eval_fn The eval function of newly created checking engine
  * @param usr User data structure
  * @param query_fn The query function of newly created checking engine
+ * @param flags Optional capabilities of the checking engine
  * @returns newly created checking engine
  */
-struct xccdf_policy_engine *xccdf_policy_engine_new(char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn);
+struct xccdf_policy_engine *xccdf_policy_engine_new(char *sys, xccdf_policy_engine_eval_fn eval_fn, void *usr, xccdf_policy_engine_query_fn query_fn, xccdf_policy_engine_flags_t flags);
+
+/**
+ * Returns true if the checking engine was registered with the given capability.
+ */
+bool xccdf_policy_engine_has_flag(const struct xccdf_policy_engine *engine, xccdf_policy_engine_flags_t flag);
 
 /**
  * Filter function returning true if given callback is for the given checking engine,
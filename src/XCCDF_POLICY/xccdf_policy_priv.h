@@ -136,5 +136,27 @@ int xccdf_policy_report_cb(struct xccdf_policy *policy, const char *sysname, voi
  */
 struct xccdf_benchmark *xccdf_policy_get_benchmark(const struct xccdf_policy *policy);
 
+/**
+ * Get simple checks which are going to be evaluated by xccdf_policy_evaluate.
+ * Rules with requires, conflicts or complex checks are not included, so the
+ * list might be incomplete, but it never contains a check which is not
+ * evaluated.
+ * @memberof xccdf_policy
+ * @param policy XCCDF Policy
+ * @returns list of struct xccdf_check owned by the benchmark; free the list only
+ */
+struct oscap_list *xccdf_policy_get_planned_checks(struct xccdf_policy *policy);
+
+/**
+ * Announce the planned checks to their checking engines with
+ * POLICY_ENGINE_QUERY_PREFETCH_CHECK, so that the engines can start
+ * evaluating them ahead of xccdf_policy_evaluate. Only the engines
+ * registered with XCCDF_POLICY_ENGINE_PREFETCH are queried.
+ * @memberof xccdf_policy
+ * @param policy XCCDF Policy
+ * @param checks list returned by xccdf_policy_get_planned_checks
+ */
+void xccdf_policy_prefetch_checks(struct xccdf_policy *policy, struct oscap_list *checks);
+
 
 #endif
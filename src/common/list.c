@@ -30,6 +30,8 @@
 #include <stdarg.h>
 
 #include "list.h"
+#include "MurmurHash3.h"
+
 static inline bool _oscap_iterator_has_more_internal(const struct oscap_iterator *it);
 
 struct oscap_list *oscap_list_new(void)
@@ -391,14 +393,38 @@ OSCAP_ITERATOR_REMOVE(oscap_stringlist, oscap_stringlist_free)
     /*OSCAP_ITERATOR_RESET(oscap_string)*/
 
 
-#define OSCAP_DEFAULT_HSIZE 389
-static inline unsigned int oscap_htable_hash(const char *str, size_t htable_size)
+/*
+ * The hash table is an open-addressing index (linear probing, power-of-two
+ * size) over individually allocated items. Items are also chained in the order
+ * of insertion, which gives iteration, cloning and dumping a deterministic
+ * order that does not depend on the table size or the hash function.
+ */
+#define OSCAP_DEFAULT_HSIZE 16
+#define OSCAP_HTABLE_SEED 0x0c5ca9u
+
+static inline uint32_t oscap_htable_hash(const char *str)
+{
+	uint32_t h;
+	MurmurHash3_x86_32(str, (int)strlen(str), OSCAP_HTABLE_SEED, &h);
+	return h;
+}
+
+static bool oscap_htable_resize(struct oscap_htable *htable, size_t hsize)
 {
-	unsigned h = 0;
-	unsigned char *p;
-	for (p = (unsigned char *)str; *p != '\0'; p++)
-		h = (97 * h) + *p;
-	return h % htable_size;
+	struct oscap_htable_item **table = calloc(hsize, sizeof(struct oscap_htable_item *));
+	if (table == NULL)
+		return false;
+
+	for (struct oscap_htable_item *item = htable->first; item != NULL; item = item->next) {
+		size_t i = item->hash & (hsize - 1);
+		while (table[i] != NULL)
+			i = (i + 1) & (hsize - 1);
+		table[i] = item;
+	}
+	free(htable->table);
+	htable->table = table;
+	htable->hsize = hsize;
+	return true;
 }
 
 struct oscap_htable *oscap_htable_new1(oscap_compare_func cmp, size_t hsize)
@@ -410,31 +436,32 @@ struct oscap_htable *oscap_htable_new1(oscap_compare_func cmp, size_t hsize)
 	t = malloc(sizeof(struct oscap_htable));
 	if (t == NULL)
 		return NULL;
-	t->hsize = hsize;
+	/* round up to a power of two with room for hsize items below the load limit */
+	size_t size = OSCAP_DEFAULT_HSIZE;
+	while (size * 3 / 4 < hsize)
+		size *= 2;
+	t->hsize = size;
 	t->itemcount = 0;
-	t->table = calloc(hsize, sizeof(struct oscap_htable_item *));
+	t->table = calloc(size, sizeof(struct oscap_htable_item *));
 	if (t->table == NULL) {
 		free(t);
 		return NULL;
 	}
+	t->first = NULL;
+	t->last = NULL;
 	t->cmp = cmp;
 	return t;
 }
 
 struct oscap_htable * oscap_htable_clone(const struct oscap_htable * table, oscap_clone_func cloner)
 {
-	struct oscap_htable *t = oscap_htable_new();
+	struct oscap_htable *t = oscap_htable_new1(table->cmp, table->itemcount);
 	if (t == NULL)
 		return NULL;
 
-	for (size_t i = 0; i < table->hsize; ++i) {
-		struct oscap_htable_item *item = table->table[i];
-		while (item != NULL) {
-			oscap_htable_add(t, item->key, (void *) cloner(item->value));
-			item = item->next;
-		}
-	}
-	
+	for (struct oscap_htable_item *item = table->first; item != NULL; item = item->next)
+		oscap_htable_add(t, item->key, (void *) cloner(item->value));
+
 	return t;
 }
 
@@ -449,7 +476,24 @@ static int oscap_htable_cmp(const char *s1, const char *s2)
 
 struct oscap_htable *oscap_htable_new(void)
 {
-	return oscap_htable_new1(oscap_htable_cmp, OSCAP_DEFAULT_HSIZE);
+	return oscap_htable_new1(oscap_htable_cmp, 1);
+}
+
+/*
+ * Find the index slot of the given key. Returns the slot holding the item,
+ * or the empty slot which terminates the probe sequence.
+ */
+static size_t oscap_htable_slot(const struct oscap_htable *htable, const char *key, uint32_t hash)
+{
+	size_t mask = htable->hsize - 1;
+	size_t i = hash & mask;
+	struct oscap_htable_item *htitem;
+	while ((htitem = htable->table[i]) != NULL) {
+		if (htitem->hash == hash && htable->cmp(htitem->key, key) == 0)
+			break;
+		i = (i + 1) & mask;
+	}
+	return i;
 }
 
 static struct oscap_htable_item *oscap_htable_lookup(struct oscap_htable *htable, const char *key)
@@ -457,55 +501,81 @@ static struct oscap_htable_item *oscap_htable_lookup(struct oscap_htable *htable
 	__attribute__nonnull__(htable);
 	if (key == NULL)
 		return NULL;
-	unsigned int hashcode = oscap_htable_hash(key, htable->hsize);
-	struct oscap_htable_item *htitem = htable->table[hashcode];
-	while (htitem != NULL) {
-		if (htable->cmp(htitem->key, key) == 0)
-			return htitem;
-		htitem = htitem->next;
-	}
-	return NULL;
+	return htable->table[oscap_htable_slot(htable, key, oscap_htable_hash(key))];
 }
 
 bool oscap_htable_add(struct oscap_htable * htable, const char *key, void *item)
 {
 	__attribute__nonnull__(htable);
-	/*
-	   unsigned int hashcode = oscap_htable_hash(key, htable->hsize);
-	   struct oscap_htable_item* htitem = htable->table[hashcode];
-	   while(htitem != NULL)
-	   {
-	   if( (*(htable->cmp))(htitem->key, key) == 0) return false;
-	   if(htitem->next == NULL) break;
-	   htitem = htitem->next;
-	   }
-	   // htitem points to the last item
-	 */
-	if (oscap_htable_lookup(htable, key) != NULL)
+	if (key == NULL)
+		return false;
+	uint32_t hash = oscap_htable_hash(key);
+	size_t slot = oscap_htable_slot(htable, key, hash);
+	if (htable->table[slot] != NULL)
 		return false;
-	unsigned int hashcode = oscap_htable_hash(key, htable->hsize);
+
+	/* keep the load factor under 3/4 */
+	if ((htable->itemcount + 1) * 4 > htable->hsize * 3) {
+		if (!oscap_htable_resize(htable, htable->hsize * 2))
+			return false;
+		slot = oscap_htable_slot(htable, key, hash);
+	}
+
 	struct oscap_htable_item *newhtitem;
 	newhtitem = malloc(sizeof(struct oscap_htable_item));
+	if (newhtitem == NULL)
+		return false;
 	newhtitem->key = oscap_strdup(key);
 	newhtitem->value = item;
-	newhtitem->next = htable->table[hashcode];
-	htable->table[hashcode] = newhtitem;
+	newhtitem->hash = hash;
+	newhtitem->next = NULL;
+	newhtitem->prev = htable->last;
+	if (htable->last != NULL)
+		htable->last->next = newhtitem;
+	else
+		htable->first = newhtitem;
+	htable->last = newhtitem;
+	htable->table[slot] = newhtitem;
 	htable->itemcount++;
 	return true;
 }
 
 void *oscap_htable_detach(struct oscap_htable *htable, const char *key)
 {
-	struct oscap_htable_item *htitem = oscap_htable_lookup(htable, key);
-	if (htitem) {
-		void *val = htitem->value;
-		free(htitem->key);
-		htitem->key = NULL;
-		htitem->value = NULL;
-		htable->itemcount--;
-		return val;
+	__attribute__nonnull__(htable);
+	if (key == NULL)
+		return NULL;
+	size_t mask = htable->hsize - 1;
+	size_t i = oscap_htable_slot(htable, key, oscap_htable_hash(key));
+	struct oscap_htable_item *htitem = htable->table[i];
+	if (htitem == NULL)
+		return NULL;
+
+	/* backward shift deletion, the probe sequences stay free of holes */
+	htable->table[i] = NULL;
+	for (size_t j = (i + 1) & mask; htable->table[j] != NULL; j = (j + 1) & mask) {
+		size_t home = htable->table[j]->hash & mask;
+		if (((j - home) & mask) >= ((j - i) & mask)) {
+			htable->table[i] = htable->table[j];
+			htable->table[j] = NULL;
+			i = j;
+		}
 	}
-	return NULL;
+
+	if (htitem->prev != NULL)
+		htitem->prev->next = htitem->next;
+	else
+		htable->first = htitem->next;
+	if (htitem->next != NULL)
+		htitem->next->prev = htitem->prev;
+	else
+		htable->last = htitem->prev;
+	htable->itemcount--;
+
+	void *val = htitem->value;
+	free(htitem->key);
+	free(htitem);
+	return val;
 }
 
 void *oscap_htable_get(struct oscap_htable *htable, const char *key)
@@ -529,34 +599,24 @@ void oscap_htable_dump(struct oscap_htable *htable, oscap_dump_func dumper, int
 		return;
 	}
 	printf(" (hash table, %u item%s)\n", (unsigned)htable->itemcount, (htable->itemcount == 1 ? "" : "s"));
-	int i;
-	for (i = 0; i < (int)htable->hsize; ++i) {
-		struct oscap_htable_item *item = htable->table[i];
-		while (item) {
-			oscap_print_depth(depth);
-			printf("'%s':\n", item->key);
-			dumper(item->value, depth + 1);
-			item = item->next;
-		}
+	for (struct oscap_htable_item *item = htable->first; item != NULL; item = item->next) {
+		oscap_print_depth(depth);
+		printf("'%s':\n", item->key);
+		dumper(item->value, depth + 1);
 	}
 }
 
 void oscap_htable_free(struct oscap_htable *htable, oscap_destruct_func destructor)
 {
 	if (htable) {
-		size_t ht;
 		struct oscap_htable_item *cur, *next;
 
-		for (ht = 0; ht < htable->hsize; ++ht) {
-			cur = htable->table[ht];
-			while (cur) {
-				next = cur->next;
-				free(cur->key);
-				if (destructor)
-					destructor(cur->value);
-				free(cur);
-				cur = next;
-			}
+		for (cur = htable->first; cur != NULL; cur = next) {
+			next = cur->next;
+			free(cur->key);
+			if (destructor)
+				destructor(cur->value);
+			free(cur);
 		}
 
 		free(htable->table);
@@ -571,8 +631,7 @@ void oscap_htable_free0(struct oscap_htable *htable)
 
 struct oscap_htable_iterator {
 	struct oscap_htable *htable;	// Table we iterate through
-	struct oscap_htable_item *cur;	// The current item
-	size_t hpos;			// Line on which we are now
+	struct oscap_htable_item *cur;	// The item to be returned next
 };
 
 struct oscap_htable_iterator *
@@ -580,8 +639,7 @@ oscap_htable_iterator_new(struct oscap_htable *htable)
 {
 	struct oscap_htable_iterator *hit = calloc(1, sizeof(struct oscap_htable_iterator));
 	hit->htable = htable;
-	hit->cur = NULL;
-	hit->hpos = 0;
+	hit->cur = (htable != NULL) ? htable->first : NULL;
 	return hit;
 }
 
@@ -589,50 +647,20 @@ bool
 oscap_htable_iterator_has_more(struct oscap_htable_iterator *hit)
 {
 	__attribute__nonnull__(hit);
-	if (hit->htable == NULL)
-		return false;
-	size_t i = hit->hpos;
-	if (hit->cur != NULL) {
-		if (hit->cur->next != NULL)
-			return true;
-		if (i + 1 >= hit->htable->hsize)
-			return false;
-		i++;
-	}
-	for (; i < hit->htable->hsize; i++) {
-		if (hit->htable->table[i] == NULL)
-			continue;
-		if (i != hit->hpos)
-			hit->hpos = i - 1;
-		return true;
-	}
-	hit->hpos = i;
-	return false;
+	return hit->cur != NULL;
 }
 
 const struct oscap_htable_item *
 oscap_htable_iterator_next(struct oscap_htable_iterator *hit)
 {
 	__attribute__nonnull__(hit);
-	if (hit->cur != NULL) {
-		if (hit->cur->next != NULL) {
-			hit->cur = hit->cur->next;
-			return hit->cur;
-		}
-		if (hit->hpos + 1 >= hit->htable->hsize) {
-			assert(false);
-			return NULL;
-		}
-		hit->hpos++;
-	}
-	for (; hit->hpos < hit->htable->hsize; hit->hpos++) {
-		if (hit->htable->table[hit->hpos] == NULL)
-			continue;
-		hit->cur = hit->htable->table[hit->hpos];
-		return hit->cur;
+	struct oscap_htable_item *item = hit->cur;
+	if (item == NULL) {
+		assert(false); // no more item found
+		return NULL;
 	}
-	assert(false); // no more item found
-	return NULL;
+	hit->cur = item->next;
+	return item;
 }
 
 const char *
@@ -663,8 +691,7 @@ void
 oscap_htable_iterator_reset(struct oscap_htable_iterator *hit)
 {
 	__attribute__nonnull__(hit);
-	hit->cur = NULL;
-	hit->hpos = 0;
+	hit->cur = (hit->htable != NULL) ? hit->htable->first : NULL;
 }
 
 void
@@ -30,6 +30,7 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "util.h"
 #include "public/oscap.h"
@@ -170,23 +171,28 @@ void *oscap_list_find(struct oscap_list *list, void *what, oscap_cmp_func compar
 typedef int (*oscap_compare_func) (const char *, const char *);
 // Hash table item.
 struct oscap_htable_item {
-	struct oscap_htable_item *next;	// Next item.
+	struct oscap_htable_item *next;	// Next item in insertion order.
 	char *key;		// Item key.
 	void *value;		// Item value.
+	struct oscap_htable_item *prev;	// Previous item in insertion order.
+	uint32_t hash;		// Hash of the key.
 };
 
 // Hash table.
 struct oscap_htable {
-	size_t hsize;		// Size of the hash table.
+	size_t hsize;		// Number of slots in the index, always a power of two.
 	size_t itemcount;	// Number of elements in the hash table.
-	struct oscap_htable_item **table;	// The table itself.
+	struct oscap_htable_item **table;	// Open-addressing index of the items.
 	oscap_compare_func cmp;	// Funcion used to compare keys (e.g. strcmp).
+	struct oscap_htable_item *first;	// First inserted item.
+	struct oscap_htable_item *last;	// Last inserted item.
 };
 
 /*
  * Create a new hash table.
  * @param cmp Pointer to a function used as the key comparator.
- * @hsize Size of the hash table.
+ *            It has to return 0 only for keys equal by strcmp(), the key hash relies on that.
+ * @hsize Expected number of items, the table grows automatically when exceeded.
  * @internal
  * @return new hash table
  */
@@ -195,7 +201,7 @@ struct oscap_htable *oscap_htable_new1(oscap_compare_func cmp, size_t hsize);
 /*
  * Create a new hash table.
  *
- * The table will use strcmp() as the comparison function and will have default table size.
+ * The table will use strcmp() as the comparison function and will have default initial size.
  * @see oscap_htable_new1()
  * @return new hash table
  */
@@ -250,7 +256,8 @@ void oscap_htable_free0(struct oscap_htable *htable);
 struct oscap_htable_iterator;
 
 /**
- * Create new iterator through hash table. No ordering is defined for items.
+ * Create new iterator through hash table. Items are visited in the order in which they were added.
+ * Detaching the item returned last is safe during the iteration, other modifications are not.
  * @param htable Hash table to iterate through.
  * @return the iterator
  */
@@ -0,0 +1,233 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <pcre.h>
+
+#include "util.h"
+#include "list.h"
+#include "debug_priv.h"
+#include "oscap_helpers.h"
+#include "oscap_pcre.h"
+
+/* Patterns compiled once the cache is full are not cached */
+#define OSCAP_PCRE_CACHE_MAX 1024
+
+#if defined(PCRE_STUDY_JIT_COMPILE)
+# define OSCAP_PCRE_STUDY_OPTIONS PCRE_STUDY_JIT_COMPILE
+# define oscap_pcre_free_study pcre_free_study
+#else
+# define OSCAP_PCRE_STUDY_OPTIONS 0
+# define oscap_pcre_free_study pcre_free
+#endif
+
+struct oscap_pcre {
+	pcre       *re;
+	pcre_extra *extra;
+	unsigned int refcnt;
+};
+
+static pthread_mutex_t oscap_pcre_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct oscap_htable *oscap_pcre_cache = NULL;
+static size_t oscap_pcre_cache_size = 0;
+static unsigned long oscap_pcre_cache_hits = 0;
+static unsigned long oscap_pcre_cache_misses = 0;
+
+static void oscap_pcre_free(struct oscap_pcre *re)
+{
+	if (re->extra != NULL)
+		oscap_pcre_free_study(re->extra);
+	pcre_free(re->re);
+	free(re);
+}
+
+/* Must be called with the cache mutex locked */
+static void oscap_pcre_unref(struct oscap_pcre *re)
+{
+	if (--re->refcnt == 0)
+		oscap_pcre_free(re);
+}
+
+static struct oscap_pcre *oscap_pcre_compile(const char *pattern, int options, const char **errptr, int *erroffset)
+{
+	const char *study_err = NULL;
+	pcre *compiled = pcre_compile(pattern, options, errptr, erroffset, NULL);
+
+	if (compiled == NULL)
+		return NULL;
+
+	struct oscap_pcre *re = malloc(sizeof(struct oscap_pcre));
+	re->re = compiled;
+	re->extra = pcre_study(compiled, OSCAP_PCRE_STUDY_OPTIONS, &study_err);
+	re->refcnt = 1;
+
+	if (study_err != NULL)
+		dD("pcre_study() failed on pattern '%s': %s", pattern, study_err);
+
+	return re;
+}
+
+struct oscap_pcre *oscap_pcre_acquire(const char *pattern, int options, const char **errptr, int *erroffset)
+{
+	struct oscap_pcre *re;
+	char *key;
+
+	if (pattern == NULL)
+		return NULL;
+
+	key = oscap_sprintf("%x:%s", (unsigned int) options, pattern);
+
+	pthread_mutex_lock(&oscap_pcre_cache_mutex);
+	if (oscap_pcre_cache == NULL)
+		oscap_pcre_cache = oscap_htable_new();
+
+	re = oscap_htable_get(oscap_pcre_cache, key);
+	if (re != NULL) {
+		++oscap_pcre_cache_hits;
+		++re->refcnt;
+		pthread_mutex_unlock(&oscap_pcre_cache_mutex);
+		free(key);
+		return re;
+	}
+	++oscap_pcre_cache_misses;
+	pthread_mutex_unlock(&oscap_pcre_cache_mutex);
+
+	/* compile without holding the lock, a concurrent miss is harmless */
+	re = oscap_pcre_compile(pattern, options, errptr, erroffset);
+	if (re == NULL) {
+		free(key);
+		return NULL;
+	}
+
+	pthread_mutex_lock(&oscap_pcre_cache_mutex);
+	if (oscap_pcre_cache == NULL)
+		oscap_pcre_cache = oscap_htable_new();
+
+	struct oscap_pcre *cached = oscap_htable_get(oscap_pcre_cache, key);
+	if (cached != NULL) {
+		++cached->refcnt;
+		oscap_pcre_unref(re);
+		re = cached;
+	} else if (oscap_pcre_cache_size < OSCAP_PCRE_CACHE_MAX) {
+		if (oscap_htable_add(oscap_pcre_cache, key, re)) {
+			++re->refcnt;
+			++oscap_pcre_cache_size;
+		}
+	}
+	pthread_mutex_unlock(&oscap_pcre_cache_mutex);
+
+	free(key);
+	return re;
+}
+
+void oscap_pcre_release(struct oscap_pcre *re)
+{
+	if (re == NULL)
+		return;
+
+	pthread_mutex_lock(&oscap_pcre_cache_mutex);
+	oscap_pcre_unref(re);
+	pthread_mutex_unlock(&oscap_pcre_cache_mutex);
+}
+
+/*
+ * The JIT code doesn't honour match_limit_recursion, it runs on its own
+ * stack instead (32 KiB unless a pcre_jit_stack is attached). A subject
+ * which overflows that stack is matched again by the interpreter, which
+ * respects the limits set in extra.
+ */
+static int oscap_pcre_exec_extra(const struct oscap_pcre *re, pcre_extra *extra, const char *subject, int length,
+		int startoffset, int options, int *ovector, int ovecsize)
+{
+	int rc = pcre_exec(re->re, extra, subject, length, startoffset, options, ovector, ovecsize);
+
+#if defined(PCRE_STUDY_JIT_COMPILE)
+	if (rc == PCRE_ERROR_JIT_STACKLIMIT && extra != NULL) {
+		pcre_extra nojit;
+
+		memcpy(&nojit, extra, sizeof(pcre_extra));
+		nojit.flags &= ~PCRE_EXTRA_EXECUTABLE_JIT;
+		dD("JIT stack exhausted, matching the pattern again without JIT.");
+		rc = pcre_exec(re->re, &nojit, subject, length, startoffset, options, ovector, ovecsize);
+	}
+#endif
+	return rc;
+}
+
+int oscap_pcre_exec(const struct oscap_pcre *re, const char *subject, int length,
+		int startoffset, int options, int *ovector, int ovecsize)
+{
+	return oscap_pcre_exec_extra(re, re->extra, subject, length, startoffset, options, ovector, ovecsize);
+}
+
+int oscap_pcre_exec_limited(const struct oscap_pcre *re, const char *subject, int length,
+		int startoffset, int options, int *ovector, int ovecsize, unsigned long recursion_limit)
+{
+	pcre_extra extra;
+
+	if (re->extra != NULL)
+		memcpy(&extra, re->extra, sizeof(pcre_extra));
+	else
+		memset(&extra, 0, sizeof(pcre_extra));
+
+	extra.match_limit_recursion = recursion_limit;
+	extra.flags |= PCRE_EXTRA_MATCH_LIMIT_RECURSION;
+
+	return oscap_pcre_exec_extra(re, &extra, subject, length, startoffset, options, ovector, ovecsize);
+}
+
+int oscap_pcre_fullinfo(const struct oscap_pcre *re, int what, void *where)
+{
+	return pcre_fullinfo(re->re, re->extra, what, where);
+}
+
+void oscap_pcre_cache_stats(unsigned long *hits, unsigned long *misses)
+{
+	pthread_mutex_lock(&oscap_pcre_cache_mutex);
+	if (hits != NULL)
+		*hits = oscap_pcre_cache_hits;
+	if (misses != NULL)
+		*misses = oscap_pcre_cache_misses;
+	pthread_mutex_unlock(&oscap_pcre_cache_mutex);
+}
+
+/* Must be called with the cache mutex locked */
+static void oscap_pcre_cache_unref(void *re)
+{
+	oscap_pcre_unref((struct oscap_pcre *) re);
+}
+
+void oscap_pcre_cache_clear(void)
+{
+	pthread_mutex_lock(&oscap_pcre_cache_mutex);
+	if (oscap_pcre_cache != NULL) {
+		dD("Regular expression cache: %lu hits, %lu misses, %zu patterns.",
+		   oscap_pcre_cache_hits, oscap_pcre_cache_misses, oscap_pcre_cache_size);
+		oscap_htable_free(oscap_pcre_cache, oscap_pcre_cache_unref);
+		oscap_pcre_cache = NULL;
+		oscap_pcre_cache_size = 0;
+	}
+	pthread_mutex_unlock(&oscap_pcre_cache_mutex);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef OSCAP_PCRE_H
+#define OSCAP_PCRE_H
+
+#include <pcre.h>
+
+/*
+ * Process-wide cache of compiled regular expressions. Patterns are keyed
+ * by the pattern string and the compile options, they are studied (and
+ * JIT compiled when PCRE supports it) once and shared by all threads,
+ * including the probe threads.
+ */
+struct oscap_pcre;
+
+/*
+ * Get a compiled pattern from the cache, compile it on a cache miss.
+ * The returned pattern has to be released by oscap_pcre_release().
+ * On failure NULL is returned and errptr/erroffset are set as by
+ * pcre_compile().
+ */
+struct oscap_pcre *oscap_pcre_acquire(const char *pattern, int options, const char **errptr, int *erroffset);
+
+/*
+ * Release a pattern obtained by oscap_pcre_acquire()
+ */
+void oscap_pcre_release(struct oscap_pcre *re);
+
+/*
+ * Match a compiled pattern, same as pcre_exec() with the study data
+ * of the pattern.
+ */
+int oscap_pcre_exec(const struct oscap_pcre *re, const char *subject, int length,
+		int startoffset, int options, int *ovector, int ovecsize);
+
+/*
+ * Same as oscap_pcre_exec(), the recursion of the match is limited to
+ * the given depth. The limit applies to the interpreter, which is used
+ * when the JIT code runs out of its stack.
+ */
+int oscap_pcre_exec_limited(const struct oscap_pcre *re, const char *subject, int length,
+		int startoffset, int options, int *ovector, int ovecsize, unsigned long recursion_limit);
+
+/*
+ * Get information about a compiled pattern, same as pcre_fullinfo()
+ */
+int oscap_pcre_fullinfo(const struct oscap_pcre *re, int what, void *where);
+
+/*
+ * Get the number of cache hits and misses since the start of the process
+ */
+void oscap_pcre_cache_stats(unsigned long *hits, unsigned long *misses);
+
+/*
+ * Drop all the patterns from the cache. Patterns which are still in use
+ * are freed once they are released.
+ */
+void oscap_pcre_cache_clear(void);
+
+#endif //OSCAP_PCRE_H
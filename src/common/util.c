@@ -39,6 +39,7 @@
 #include "oscap.h"
 #include "oscap_helpers.h"
 #include "debug_priv.h"
+#include "oscap_pcre.h"
 
 #ifdef OS_WINDOWS
 #include <stdlib.h>
@@ -361,7 +362,12 @@ char *oscap_path_join(const char *path1, const char *path2)
 	return joined_path;
 }
 
-int oscap_get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char ***substrings) {
+int oscap_get_substrings(char *str, int *ofs, struct oscap_pcre *re, int want_substrs, char ***substrings) {
+	return oscap_get_substrings_n(str, strlen(str), ofs, 0, re, want_substrs, substrings);
+}
+
+int oscap_get_substrings_n(const char *str, size_t str_len, int *ofs, int options, struct oscap_pcre *re, int want_substrs, char ***substrings)
+{
 	int i, ret, rc;
 	int ovector[60], ovector_len = sizeof (ovector) / sizeof (ovector[0]);
 	char **substrs;
@@ -372,24 +378,21 @@ int oscap_get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char *
 		ovector[i] = -1;
 	}
 
-	struct pcre_extra extra;
-	extra.match_limit_recursion = OSCAP_PCRE_EXEC_RECURSION_LIMIT_DEFAULT;
+	unsigned long recursion_limit = OSCAP_PCRE_EXEC_RECURSION_LIMIT_DEFAULT;
 	char *limit_str = getenv("OSCAP_PCRE_EXEC_RECURSION_LIMIT");
 	if (limit_str != NULL) {
 		unsigned long limit;
 		if (sscanf(limit_str, "%lu", &limit) == 1) {
-			extra.match_limit_recursion = limit;
+			recursion_limit = limit;
 		}
 	}
-	extra.flags = PCRE_EXTRA_MATCH_LIMIT_RECURSION;
 #if defined(OS_SOLARIS)
-	rc = pcre_exec(re, &extra, str, strlen(str), *ofs, PCRE_NO_UTF8_CHECK, ovector, ovector_len);
-#else
-	rc = pcre_exec(re, &extra, str, strlen(str), *ofs, 0, ovector, ovector_len);
+	options |= PCRE_NO_UTF8_CHECK;
 #endif
+	rc = oscap_pcre_exec_limited(re, str, (int)str_len, *ofs, options, ovector, ovector_len, recursion_limit);
 
 	if (rc < -1) {
-		dE("Function pcre_exec() failed to match a regular expression with return code %d on string '%s'.", rc, str);
+		dE("Function pcre_exec() failed to match a regular expression with return code %d on string '%.*s'.", rc, (int)str_len, str);
 		return rc;
 	} else if (rc == -1) {
 		/* no match */
@@ -480,7 +480,24 @@ char *oscap_strerror_r(int errnum, char *buf, size_t buflen);
  * @return count of matched substrings, 0 if no match
  * negative value on failure
  */
-int oscap_get_substrings(char *str, int *ofs, pcre *re, int want_substrs, char ***substrings);
+struct oscap_pcre;
+int oscap_get_substrings(char *str, int *ofs, struct oscap_pcre *re, int want_substrs, char ***substrings);
+
+/**
+ * Same as oscap_get_substrings(), but the subject doesn't have to be
+ * terminated and its length is given by the caller, so repeated matching
+ * over a large buffer doesn't need to scan it again.
+ * @param str subject string
+ * @param str_len length of the subject string
+ * @param ofs starting offset in str
+ * @param options pcre_exec() options, e.g. PCRE_NOTEOL or PCRE_NO_UTF8_CHECK
+ * @param re compiled regular expression
+ * @param want_substrs if non-zero, substrings will be returned
+ * @param substrings contains returned substrings
+ * @return count of matched substrings, 0 if no match
+ * negative value on failure
+ */
+int oscap_get_substrings_n(const char *str, size_t str_len, int *ofs, int options, struct oscap_pcre *re, int want_substrs, char ***substrings);
 
 
 #ifndef OS_WINDOWS
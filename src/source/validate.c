@@ -25,6 +25,7 @@
 #include <libxml/parser.h>
 #include <libxml/xmlerror.h>
 #include <libxml/xmlschemas.h>
+#include <pthread.h>
 #include <string.h>
 #ifdef OS_WINDOWS
 #include <io.h>
@@ -34,6 +35,8 @@
 
 #include "common/_error.h"
 #include "common/util.h"
+#include "common/list.h"
+#include "common/debug_priv.h"
 #include "oscap.h"
 #include "oscap_source.h"
 #include "source/oscap_source_priv.h"
@@ -83,11 +86,128 @@ static void oscap_xml_validity_handler(void *user, xmlErrorPtr error)
 	context->reporter(file, error->line, error->message, context->arg);
 }
 
+/*
+ * Parsed schemas are kept for the life of the process, keyed by their path.
+ * A parsed schema is read-only, so it can be used by several validation
+ * contexts at the same time, also from different threads.
+ */
+struct oscap_schema {
+	xmlSchemaPtr schema;
+	unsigned int refcnt;
+};
+
+static pthread_mutex_t oscap_schema_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct oscap_htable *oscap_schema_cache = NULL;
+
+/* Must be called with the cache mutex locked */
+static void oscap_schema_unref(struct oscap_schema *schema)
+{
+	if (--schema->refcnt == 0) {
+		xmlSchemaFree(schema->schema);
+		free(schema);
+	}
+}
+
+static struct oscap_schema *oscap_schema_parse(const char *schemapath, struct ctxt *context)
+{
+	xmlSchemaParserCtxtPtr parser_ctxt;
+	xmlSchemaPtr parsed;
+
+	parser_ctxt = xmlSchemaNewParserCtxt(schemapath);
+	if (parser_ctxt == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_XML, "Could not create parser context for validation");
+		return NULL;
+	}
+
+	xmlSchemaSetParserStructuredErrors(parser_ctxt, oscap_xml_validity_handler, context);
+
+	parsed = xmlSchemaParse(parser_ctxt);
+	xmlSchemaFreeParserCtxt(parser_ctxt);
+	if (parsed == NULL) {
+		oscap_seterr(OSCAP_EFAMILY_XML, "Could not parse XML schema");
+		return NULL;
+	}
+
+	struct oscap_schema *schema = malloc(sizeof(struct oscap_schema));
+	schema->schema = parsed;
+	schema->refcnt = 1;
+
+	return schema;
+}
+
+/*
+ * Get the parsed schema from the cache, parse it on a miss. Release the
+ * schema with oscap_schema_release().
+ */
+static struct oscap_schema *oscap_schema_acquire(const char *schemapath, struct ctxt *context)
+{
+	struct oscap_schema *schema;
+
+	pthread_mutex_lock(&oscap_schema_cache_mutex);
+	if (oscap_schema_cache == NULL)
+		oscap_schema_cache = oscap_htable_new();
+
+	schema = oscap_htable_get(oscap_schema_cache, schemapath);
+	if (schema != NULL) {
+		++schema->refcnt;
+		pthread_mutex_unlock(&oscap_schema_cache_mutex);
+		return schema;
+	}
+	pthread_mutex_unlock(&oscap_schema_cache_mutex);
+
+	/* parse without holding the lock, a concurrent miss is harmless */
+	schema = oscap_schema_parse(schemapath, context);
+	if (schema == NULL)
+		return NULL;
+
+	pthread_mutex_lock(&oscap_schema_cache_mutex);
+	if (oscap_schema_cache == NULL)
+		oscap_schema_cache = oscap_htable_new();
+
+	struct oscap_schema *cached = oscap_htable_get(oscap_schema_cache, schemapath);
+	if (cached != NULL) {
+		++cached->refcnt;
+		oscap_schema_unref(schema);
+		schema = cached;
+	} else if (oscap_htable_add(oscap_schema_cache, schemapath, schema)) {
+		dD("Parsed XML schema '%s' is cached.", schemapath);
+		++schema->refcnt;
+	}
+	pthread_mutex_unlock(&oscap_schema_cache_mutex);
+
+	return schema;
+}
+
+static void oscap_schema_release(struct oscap_schema *schema)
+{
+	if (schema == NULL)
+		return;
+
+	pthread_mutex_lock(&oscap_schema_cache_mutex);
+	oscap_schema_unref(schema);
+	pthread_mutex_unlock(&oscap_schema_cache_mutex);
+}
+
+/* Must be called with the cache mutex locked */
+static void oscap_schema_cache_unref(void *schema)
+{
+	oscap_schema_unref((struct oscap_schema *) schema);
+}
+
+void oscap_schema_cache_clear(void)
+{
+	pthread_mutex_lock(&oscap_schema_cache_mutex);
+	if (oscap_schema_cache != NULL) {
+		oscap_htable_free(oscap_schema_cache, oscap_schema_cache_unref);
+		oscap_schema_cache = NULL;
+	}
+	pthread_mutex_unlock(&oscap_schema_cache_mutex);
+}
+
 static inline int oscap_validate_xml(struct oscap_source *source, const char *schemafile, xml_reporter reporter, void *arg)
 {
 	int result = -1;
-	xmlSchemaParserCtxtPtr parser_ctxt = NULL;
-	xmlSchemaPtr schema = NULL;
+	struct oscap_schema *schema = NULL;
 	xmlSchemaValidCtxtPtr ctxt = NULL;
 	xmlDocPtr doc = NULL;
 
@@ -105,21 +225,11 @@ static inline int oscap_validate_xml(struct oscap_source *source, const char *sc
 		goto cleanup;
 	}
 
-	parser_ctxt = xmlSchemaNewParserCtxt(schemapath);
-	if (parser_ctxt == NULL) {
-		oscap_seterr(OSCAP_EFAMILY_XML, "Could not create parser context for validation");
+	schema = oscap_schema_acquire(schemapath, &context);
+	if (schema == NULL)
 		goto cleanup;
-	}
-
-	xmlSchemaSetParserStructuredErrors(parser_ctxt, oscap_xml_validity_handler, &context);
-
-	schema = xmlSchemaParse(parser_ctxt);
-	if (schema == NULL) {
-		oscap_seterr(OSCAP_EFAMILY_XML, "Could not parse XML schema");
-		goto cleanup;
-	}
 
-	ctxt = xmlSchemaNewValidCtxt(schema);
+	ctxt = xmlSchemaNewValidCtxt(schema->schema);
 	if (ctxt == NULL) {
 		oscap_seterr(OSCAP_EFAMILY_XML, "Could not create validation context");
 		goto cleanup;
@@ -148,10 +258,7 @@ static inline int oscap_validate_xml(struct oscap_source *source, const char *sc
 cleanup:
 	if (ctxt)
 		xmlSchemaFreeValidCtxt(ctxt);
-	if (schema)
-		xmlSchemaFree(schema);
-	if (parser_ctxt)
-		xmlSchemaFreeParserCtxt(parser_ctxt);
+	oscap_schema_release(schema);
 	free(schemapath);
 
 	return result;
@@ -42,4 +42,10 @@ struct oscap_schema_table_entry {
  */
 int oscap_source_validate_priv(struct oscap_source *source, oscap_document_type_t doc_type, const char *version, xml_reporter reporter, void *user);
 
+/**
+ * Drop the parsed XML schemas kept between validations. Schemas which
+ * are still in use are freed once their validation is finished.
+ */
+void oscap_schema_cache_clear(void);
+
 #endif
@@ -28,7 +28,9 @@
 #include <libxslt/transform.h>
 #include <libxslt/xsltutils.h>
 #include <libexslt/exslt.h>
+#include <pthread.h>
 #include <string.h>
+#include <sys/stat.h>
 
 #ifdef OS_WINDOWS
 #include <io.h>
@@ -38,6 +40,8 @@
 
 #include "common/_error.h"
 #include "common/util.h"
+#include "common/list.h"
+#include "common/debug_priv.h"
 #include "oscap.h"
 #include "oscap_source.h"
 #include "source/oscap_source_priv.h"
@@ -107,7 +111,206 @@ static inline int save_stylesheet_result_to_file(xmlDoc *resulting_doc, xsltStyl
 	return ret;
 }
 
-static xmlDoc *apply_xslt_path_internal(struct oscap_source *source, const char *xsltfile, const char **params, const char *path_to_xslt, xsltStylesheet **stylesheet)
+/*
+ * Compiled stylesheets are kept for the life of the process, keyed by their
+ * path. The parameters are only passed to xsltApplyStylesheet(), they don't
+ * change the compiled stylesheet. A compiled stylesheet isn't modified by
+ * the transformations, so it can be applied to several documents at the
+ * same time. A stylesheet is compiled again if its file or any of the files
+ * it imports or includes has changed.
+ */
+#if defined(OS_WINDOWS)
+# define ST_MTIME_NSEC(st) 0
+#elif defined(__APPLE__)
+# define ST_MTIME_NSEC(st) ((st)->st_mtimespec.tv_nsec)
+#else
+# define ST_MTIME_NSEC(st) ((st)->st_mtim.tv_nsec)
+#endif
+
+struct oscap_xslt_file {
+	char *path;
+	time_t mtime;
+	long mtime_nsec;
+	off_t size;
+};
+
+struct oscap_xslt {
+	xsltStylesheetPtr stylesheet;
+	struct oscap_xslt_file *files;
+	size_t nfiles;
+	unsigned int refcnt;
+};
+
+static pthread_mutex_t oscap_xslt_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct oscap_htable *oscap_xslt_cache = NULL;
+
+static void oscap_xslt_free(struct oscap_xslt *xslt)
+{
+	for (size_t i = 0; i < xslt->nfiles; ++i)
+		free(xslt->files[i].path);
+	free(xslt->files);
+	xsltFreeStylesheet(xslt->stylesheet);
+	free(xslt);
+}
+
+/* Must be called with the cache mutex locked */
+static void oscap_xslt_unref(struct oscap_xslt *xslt)
+{
+	if (--xslt->refcnt == 0)
+		oscap_xslt_free(xslt);
+}
+
+/* Files which can't be stat'ed are recorded as empty */
+static void oscap_xslt_file_stat(struct oscap_xslt_file *file, struct stat *st)
+{
+	if (stat(file->path, st) != 0)
+		memset(st, 0, sizeof(*st));
+}
+
+static void oscap_xslt_add_file(struct oscap_xslt *xslt, const xmlDoc *doc)
+{
+	if (doc == NULL || doc->URL == NULL)
+		return;
+
+	const char *path = (const char *) doc->URL;
+	if (strncmp(path, "file://", 7) == 0)
+		path += 7;
+
+	for (size_t i = 0; i < xslt->nfiles; ++i) {
+		if (strcmp(xslt->files[i].path, path) == 0)
+			return;
+	}
+
+	struct oscap_xslt_file *files = realloc(xslt->files, (xslt->nfiles + 1) * sizeof(struct oscap_xslt_file));
+	if (files == NULL)
+		return;
+	xslt->files = files;
+
+	struct oscap_xslt_file *file = &xslt->files[xslt->nfiles];
+	file->path = oscap_strdup(path);
+	if (file->path == NULL)
+		return;
+
+	struct stat st;
+	oscap_xslt_file_stat(file, &st);
+	file->mtime = st.st_mtime;
+	file->mtime_nsec = ST_MTIME_NSEC(&st);
+	file->size = st.st_size;
+	++xslt->nfiles;
+}
+
+/*
+ * Record the stylesheet document, the documents it includes and, recursively,
+ * the stylesheets it imports.
+ */
+static void oscap_xslt_add_files(struct oscap_xslt *xslt, xsltStylesheetPtr style)
+{
+	for (; style != NULL; style = style->next) {
+		oscap_xslt_add_file(xslt, style->doc);
+		for (xsltDocumentPtr include = style->docList; include != NULL; include = include->next)
+			oscap_xslt_add_file(xslt, include->doc);
+		oscap_xslt_add_files(xslt, style->imports);
+	}
+}
+
+static bool oscap_xslt_is_current(const struct oscap_xslt *xslt)
+{
+	for (size_t i = 0; i < xslt->nfiles; ++i) {
+		struct stat st;
+
+		oscap_xslt_file_stat(&xslt->files[i], &st);
+		if (xslt->files[i].mtime != st.st_mtime ||
+		    xslt->files[i].mtime_nsec != ST_MTIME_NSEC(&st) ||
+		    xslt->files[i].size != st.st_size)
+			return false;
+	}
+	return true;
+}
+
+static void oscap_xslt_release(struct oscap_xslt *xslt)
+{
+	if (xslt == NULL)
+		return;
+
+	pthread_mutex_lock(&oscap_xslt_cache_mutex);
+	oscap_xslt_unref(xslt);
+	pthread_mutex_unlock(&oscap_xslt_cache_mutex);
+}
+
+/*
+ * Get the compiled stylesheet from the cache, compile it on a miss.
+ * Release the stylesheet with oscap_xslt_release().
+ */
+static struct oscap_xslt *oscap_xslt_acquire(const char *xsltpath)
+{
+	struct oscap_xslt *xslt;
+
+	pthread_mutex_lock(&oscap_xslt_cache_mutex);
+	if (oscap_xslt_cache == NULL)
+		oscap_xslt_cache = oscap_htable_new();
+
+	xslt = oscap_htable_get(oscap_xslt_cache, xsltpath);
+	if (xslt != NULL)
+		++xslt->refcnt;
+	pthread_mutex_unlock(&oscap_xslt_cache_mutex);
+
+	/* the files are stat'ed without holding the lock */
+	if (xslt != NULL) {
+		if (oscap_xslt_is_current(xslt))
+			return xslt;
+		oscap_xslt_release(xslt);
+	}
+
+	/* compile without holding the lock, a concurrent miss is harmless */
+	xsltStylesheetPtr stylesheet = xsltParseStylesheetFile(BAD_CAST xsltpath);
+	if (stylesheet == NULL)
+		return NULL;
+
+	xslt = malloc(sizeof(struct oscap_xslt));
+	if (xslt == NULL) {
+		xsltFreeStylesheet(stylesheet);
+		return NULL;
+	}
+	xslt->stylesheet = stylesheet;
+	xslt->files = NULL;
+	xslt->nfiles = 0;
+	xslt->refcnt = 1;
+	oscap_xslt_add_files(xslt, stylesheet);
+
+	pthread_mutex_lock(&oscap_xslt_cache_mutex);
+	if (oscap_xslt_cache == NULL)
+		oscap_xslt_cache = oscap_htable_new();
+
+	/* a stale or concurrently compiled stylesheet is freed once released */
+	struct oscap_xslt *cached = oscap_htable_detach(oscap_xslt_cache, xsltpath);
+	if (cached != NULL)
+		oscap_xslt_unref(cached);
+	if (oscap_htable_add(oscap_xslt_cache, xsltpath, xslt)) {
+		dD("Compiled XSLT stylesheet '%s' is cached, it's built from %zu files.", xsltpath, xslt->nfiles);
+		++xslt->refcnt;
+	}
+	pthread_mutex_unlock(&oscap_xslt_cache_mutex);
+
+	return xslt;
+}
+
+/* Must be called with the cache mutex locked */
+static void oscap_xslt_cache_unref(void *xslt)
+{
+	oscap_xslt_unref((struct oscap_xslt *) xslt);
+}
+
+void oscap_xslt_cache_clear(void)
+{
+	pthread_mutex_lock(&oscap_xslt_cache_mutex);
+	if (oscap_xslt_cache != NULL) {
+		oscap_htable_free(oscap_xslt_cache, oscap_xslt_cache_unref);
+		oscap_xslt_cache = NULL;
+	}
+	pthread_mutex_unlock(&oscap_xslt_cache_mutex);
+}
+
+static xmlDoc *apply_xslt_path_internal(struct oscap_source *source, const char *xsltfile, const char **params, const char *path_to_xslt, struct oscap_xslt **stylesheet)
 {
 	xmlDoc *doc = oscap_source_get_xmlDoc(source);
 	if (doc == NULL || stylesheet == NULL || xsltfile == NULL) {
@@ -148,7 +351,7 @@ static xmlDoc *apply_xslt_path_internal(struct oscap_source *source, const char
 			ns_workaround = true;
 	}
 
-	*stylesheet = xsltParseStylesheetFile(BAD_CAST xsltpath);
+	*stylesheet = oscap_xslt_acquire(xsltpath);
 	if (*stylesheet == NULL) {
 		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not parse XSLT file '%s'", xsltpath);
 		free(xsltpath);
@@ -160,7 +363,7 @@ static xmlDoc *apply_xslt_path_internal(struct oscap_source *source, const char
 			oscap_seterr(OSCAP_EFAMILY_OSCAP, "Had problems employing XCCDF XSLT namespace workaround for XML document '%s'",
 				oscap_source_readable_origin(source));
 			free(xsltpath);
-			xsltFreeStylesheet(*stylesheet);
+			oscap_xslt_release(*stylesheet);
 			*stylesheet = NULL;
 			return NULL;
 		}
@@ -173,7 +376,7 @@ static xmlDoc *apply_xslt_path_internal(struct oscap_source *source, const char
 		if (params[i+1]) args[i+1] = oscap_sprintf("'%s'", params[i+1]);
 	}
 
-	xmlDoc *transformed = xsltApplyStylesheet(*stylesheet, doc, (const char **) args);
+	xmlDoc *transformed = xsltApplyStylesheet((*stylesheet)->stylesheet, doc, (const char **) args);
 	for (size_t i = 0; args[i]; i += 2) {
 		free(args[i+1]);
 	}
@@ -182,7 +385,7 @@ static xmlDoc *apply_xslt_path_internal(struct oscap_source *source, const char
 		oscap_seterr(OSCAP_EFAMILY_OSCAP, "Could not apply XSLT %s to XML file: %s", xsltpath,
 			oscap_source_readable_origin(source));
 		free(xsltpath);
-		xsltFreeStylesheet(*stylesheet);
+		oscap_xslt_release(*stylesheet);
 		*stylesheet = NULL;
 		return NULL;
 	}
@@ -193,31 +396,33 @@ static xmlDoc *apply_xslt_path_internal(struct oscap_source *source, const char
 
 int oscap_source_apply_xslt_path(struct oscap_source *source, const char *xsltfile, const char *outfile, const char **params, const char *path_to_xslt)
 {
-	xsltStylesheet *stylesheet = NULL;
+	struct oscap_xslt *stylesheet = NULL;
 	xmlDocPtr transformed = apply_xslt_path_internal(source, xsltfile, params, path_to_xslt, &stylesheet);
 	if (transformed == NULL) {
 		return -1;
 	}
-	int ret = save_stylesheet_result_to_file(transformed, stylesheet, outfile);
-	xsltFreeStylesheet(stylesheet);
+	int ret = save_stylesheet_result_to_file(transformed, stylesheet->stylesheet, outfile);
+	oscap_xslt_release(stylesheet);
 	xmlFreeDoc(transformed);
 	return ret;
 }
 
 char *oscap_source_apply_xslt_path_mem(struct oscap_source *source, const char *xsltfile, const char **params, const char *path_to_xslt)
 {
-	xsltStylesheet *stylesheet = NULL;
+	struct oscap_xslt *stylesheet = NULL;
 	xmlDocPtr transformed = apply_xslt_path_internal(source, xsltfile, params, path_to_xslt, &stylesheet);
 	if (transformed == NULL) {
 		return NULL;
 	}
 	xmlChar *result = NULL;
 	int len;
-	if (xsltSaveResultToString(&result, &len, transformed, stylesheet) != 0) {
+	if (xsltSaveResultToString(&result, &len, transformed, stylesheet->stylesheet) != 0) {
 		oscap_seterr(OSCAP_EFAMILY_XML, "Could not save transformend content to buffer, after applying XSLT %s",
 				xsltfile);
 		free(result);
 		result = NULL;
 	}
+	oscap_xslt_release(stylesheet);
+	xmlFreeDoc(transformed);
 	return (char *)result;
 }
@@ -55,4 +55,10 @@ int oscap_source_apply_xslt_path(struct oscap_source *source, const char *xsltfi
  */
 char *oscap_source_apply_xslt_path_mem(struct oscap_source *source, const char *xsltfile, const char **params, const char *path_to_xslt);
 
+/**
+ * Drop the compiled stylesheets kept between transformations. Stylesheets
+ * which are still in use are freed once their transformation is finished.
+ */
+void oscap_xslt_cache_clear(void);
+
 #endif
@@ -0,0 +1,26 @@
+#!/usr/bin/env bash
+. $builddir/tests/test_common.sh
+
+result=`mktemp`
+log=`mktemp`
+xpath="$XPATH"
+
+set -e
+set -o pipefail
+
+$OSCAP oval eval --verbose DEVEL --verbose-log-file $log --results $result $srcdir/test_object_dedup.xml
+
+# the duplicate gets the items of the first object and isn't sent to the probe
+grep -q "Using the items of file_object 'oval:x:obj:1' for 'oval:x:obj:2'" $log
+
+# both objects are still reported, with their own IDs
+co='/oval_results/results/system/oval_system_characteristics/collected_objects'
+[ $($xpath $result "count($co/object[@id='oval:x:obj:1'][@flag='complete'])") == "1" ]
+[ $($xpath $result "count($co/object[@id='oval:x:obj:2'][@flag='complete'])") == "1" ]
+[ $($xpath $result "count($co/object[@id='oval:x:obj:2'][@version='2'])") == "1" ]
+[ $($xpath $result "count($co/object[@id='oval:x:obj:3'][@flag='does not exist'])") == "1" ]
+[ "$($xpath $result "string($co/object[@id='oval:x:obj:1']/reference/@item_ref)")" == \
+  "$($xpath $result "string($co/object[@id='oval:x:obj:2']/reference/@item_ref)")" ]
+[ $($xpath $result "count(/oval_results/results/system/definitions/definition[@definition_id='oval:x:def:1'][@result='true'])") == "1" ]
+
+rm $result $log
@@ -0,0 +1,28 @@
+#!/usr/bin/env bash
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+name=$(basename $0 .sh)
+serial=$(mktemp ${name}.serial.XXXXXX)
+parallel=$(mktemp ${name}.parallel.XXXXXX)
+log=$(mktemp ${name}.log.XXXXXX)
+
+$OSCAP oval eval --results $serial $srcdir/$name.xml
+$OSCAP oval eval --oval-workers 4 --verbose INFO --verbose-log-file $log --results $parallel $srcdir/$name.xml
+
+# both objects with constant variables were collected by the parallel batch
+grep -q "Prefetching 2 independent objects using 4 workers." $log
+
+CO='/oval_results/results/system/oval_system_characteristics/collected_objects'
+result=$parallel
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1"][@result="true"]'
+assert_exists 1 $CO'/object[@id="oval:x:obj:1"]/variable_value[@variable_id="oval:x:var:1"][text()="/etc/passwd"]'
+assert_exists 1 $CO'/object[@id="oval:x:obj:2"]/variable_value[@variable_id="oval:x:var:2"][text()="root"]'
+assert_exists 1 $CO'/object[@id="oval:x:obj:3"]/variable_value[@variable_id="oval:x:var:3"][text()="/etc/passwd"]'
+
+# the system characteristics and the results match apart from the timestamps
+sed -i -E '/<(oval:)?timestamp>/d' $serial $parallel
+diff $serial $parallel
+
+rm $serial $parallel $log
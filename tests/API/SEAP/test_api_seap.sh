@@ -28,6 +28,17 @@ function test_api_seap_concurency {
     return $ret_val
 }
 
+function test_api_seap_bench {
+    local ret_val=0;
+
+    export SEXP_VALIDATE_DISABLE="1"
+    ./test_api_seap_bench
+    ret_val=$?
+    unset SEXP_VALIDATE_DISABLE
+
+    return $ret_val
+}
+
 function test_api_strto {
     ./test_api_strto
 }
@@ -40,9 +51,11 @@ if [ -z ${CUSTOM_OSCAP+x} ] ; then
     test_run "test_api_seap_concurency"           test_api_seap_concurency
     test_run "test_api_seap_spb"                  ./test_api_seap_spb
     test_run "test_api_seap_list"                 ./test_api_seap_list
+    test_run "test_api_seap_bench"                test_api_seap_bench
     test_run "test_api_seap_number_expression"    ./test_api_seap_number
     test_run "test_api_seap_string_expression"    ./test_api_seap_string
     test_run "test_api_SEXP_deepcmp"              ./test_api_SEXP_deepcmp
+    test_run "test_api_seap_arena"                ./test_api_seap_arena
     test_run "test_api_strto"                     ./test_api_strto
 fi
 
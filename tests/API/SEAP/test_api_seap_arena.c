@@ -0,0 +1,130 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sexp.h>
+
+#include "_sexp-arena.h"
+
+/* Enough values to fill several 64k chunks */
+#define VALUE_COUNT 4096
+
+#define CHECK(expr)                                                     \
+        do {                                                            \
+                if (!(expr)) {                                          \
+                        fprintf (stderr, "%s:%d: check failed: %s\n",   \
+                                 __FILE__, __LINE__, #expr);            \
+                        exit (1);                                       \
+                }                                                       \
+        } while (0)
+
+struct free_args {
+        SEXP_t **values;
+        size_t   count;
+};
+
+static void *free_values (void *arg)
+{
+        struct free_args *args = arg;
+
+        for (size_t i = 0; i < args->count; ++i)
+                SEXP_free (args->values[i]);
+
+        return (NULL);
+}
+
+int main (void)
+{
+        SEXP_t *values[VALUE_COUNT], *sexp;
+        SEXP_arena_t *arena;
+        struct free_args args;
+        pthread_t thread;
+        char *str;
+        size_t chunks;
+
+        setbuf (stdout, NULL);
+
+        CHECK(SEXP_arena_chunk_count () == 0);
+
+        arena = SEXP_arena_new ();
+        CHECK(arena != NULL);
+        CHECK(SEXP_arena_bind (arena) == NULL);
+
+        /* Strings, numbers and lists of both, interleaved */
+        for (size_t i = 0; i < VALUE_COUNT; ++i) {
+                switch (i % 3) {
+                case 0:
+                        values[i] = SEXP_string_newf ("value %zu", i);
+                        break;
+                case 1:
+                        values[i] = SEXP_number_newu_64 (i);
+                        break;
+                case 2:
+                        values[i] = SEXP_list_new (values[i - 2], values[i - 1], NULL);
+                        break;
+                }
+                CHECK(values[i] != NULL);
+        }
+
+        chunks = SEXP_arena_chunk_count ();
+        printf ("chunks after carving: %zu\n", chunks);
+        CHECK(chunks > 1);
+
+        CHECK(SEXP_arena_bind (NULL) == arena);
+
+        /* Values created without an arena don't use the chunks */
+        sexp = SEXP_string_newf ("%s", "not from the arena");
+        CHECK(SEXP_arena_chunk_count () == chunks);
+        SEXP_free (sexp);
+
+        /* The values outlive the arena and keep their chunks allocated */
+        SEXP_arena_free (arena);
+        CHECK(SEXP_arena_chunk_count () > 0);
+
+        for (size_t i = 2; i < VALUE_COUNT; i += 3) {
+                sexp = SEXP_list_first (values[i]);
+                str  = SEXP_string_cstr (sexp);
+                CHECK(str != NULL);
+                CHECK(strncmp (str, "value ", 6) == 0);
+                free (str);
+                SEXP_free (sexp);
+        }
+
+        /* The second half is freed by another thread at the same time */
+        args.values = values + VALUE_COUNT / 2;
+        args.count  = VALUE_COUNT - VALUE_COUNT / 2;
+        CHECK(pthread_create (&thread, NULL, free_values, &args) == 0);
+
+        for (size_t i = 0; i < VALUE_COUNT / 2; ++i)
+                SEXP_free (values[i]);
+
+        CHECK(pthread_join (thread, NULL) == 0);
+
+        printf ("chunks after freeing: %zu\n", SEXP_arena_chunk_count ());
+        CHECK(SEXP_arena_chunk_count () == 0);
+
+        return (0);
+}
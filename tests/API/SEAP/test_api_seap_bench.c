@@ -0,0 +1,192 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <sexp.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+/*
+ * SEXP list microbenchmarks. The timings are printed only, the test fails
+ * if the list contents or lengths are wrong. The per-item cost of the
+ * append and length benchmarks shouldn't grow with the list size.
+ */
+
+static double now (void)
+{
+        struct timespec ts;
+
+        clock_gettime (CLOCK_MONOTONIC, &ts);
+        return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+static void report (const char *name, size_t n, double t)
+{
+        printf ("%-24s n=%-8zu %10.3f ms %8.1f ns/item\n", name, n, t * 1e3, t * 1e9 / n);
+}
+
+/* append and query the length after each item, like probe_item_collect */
+static int bench_add (size_t n)
+{
+        SEXP_t *list, *item;
+        double  t;
+        size_t  i;
+        int     ret = 0;
+
+        item = SEXP_number_newu_32 (1);
+        list = SEXP_list_new (NULL);
+
+        t = now ();
+
+        for (i = 0; i < n; ++i) {
+                SEXP_list_add (list, item);
+
+                if (SEXP_list_length (list) != i + 1) {
+                        ret = 1;
+                        break;
+                }
+        }
+
+        report ("add+length", n, now () - t);
+
+        SEXP_free (list);
+        SEXP_free (item);
+
+        return (ret);
+}
+
+/* append to a list whose blocks are shared with its rest */
+static int bench_add_shared (size_t n)
+{
+        SEXP_t *list, *rest, *item, *memb;
+        double  t;
+        size_t  i;
+        int     ret = 0;
+
+        item = SEXP_number_newu_32 (1);
+        list = SEXP_list_new (NULL);
+
+        for (i = 0; i < n; ++i) {
+                SEXP_t *num = SEXP_number_newu_32 (i);
+
+                SEXP_list_add (list, num);
+                SEXP_free (num);
+        }
+
+        rest = SEXP_list_rest (list);
+
+        t = now ();
+
+        for (i = 0; i < n; ++i)
+                SEXP_list_add (list, item);
+
+        report ("add (shared blocks)", n, now () - t);
+
+        /* the rest must not see the items added to the list */
+        if (SEXP_list_length (list) != 2 * n || SEXP_list_length (rest) != n - 1)
+                ret = 1;
+
+        i = 1;
+        SEXP_list_foreach (memb, rest) {
+                if (SEXP_number_getu_32 (memb) != i++)
+                        ret = 1;
+        }
+
+        if (i != n)
+                ret = 1;
+
+        /* and the other way around */
+        SEXP_list_add (rest, item);
+
+        if (SEXP_list_length (list) != 2 * n || SEXP_list_length (rest) != n)
+                ret = 1;
+
+        memb = SEXP_list_nth (list, n + 1);
+
+        if (memb == NULL || SEXP_number_getu_32 (memb) != 1)
+                ret = 1;
+
+        SEXP_free (memb);
+        SEXP_free (rest);
+        SEXP_free (list);
+        SEXP_free (item);
+
+        return (ret);
+}
+
+/* walk the list with SEXP_list_rest */
+static int bench_rest (size_t n)
+{
+        SEXP_t *list, *item, *rest;
+        double  t;
+        size_t  i;
+        int     ret = 0;
+
+        item = SEXP_number_newu_32 (1);
+        list = SEXP_list_new (NULL);
+
+        for (i = 0; i < n; ++i)
+                SEXP_list_add (list, item);
+
+        t = now ();
+
+        rest = SEXP_ref (list);
+
+        for (i = n; i > 0; --i) {
+                SEXP_t *next;
+
+                if (SEXP_list_length (rest) != i)
+                        ret = 1;
+
+                next = SEXP_list_rest (rest);
+                SEXP_free (rest);
+                rest = next;
+        }
+
+        report ("rest+length", n, now () - t);
+
+        if (SEXP_list_length (rest) != 0)
+                ret = 1;
+
+        SEXP_free (rest);
+        SEXP_free (list);
+        SEXP_free (item);
+
+        return (ret);
+}
+
+int main (void)
+{
+        size_t n;
+        int    ret = 0;
+
+        setbuf (stdout, NULL);
+
+        for (n = 1000; n <= 1000000; n *= 10) {
+                ret |= bench_add (n);
+                ret |= bench_add_shared (n);
+                ret |= bench_rest (n);
+        }
+
+        return (ret);
+}
@@ -0,0 +1,30 @@
+#!/usr/bin/env bash
+. $builddir/tests/test_common.sh
+
+set -e
+set -o pipefail
+
+# The CPE OVAL file and the benchmark OVAL file have equal objects with
+# different IDs, the object is collected by the first session only.
+
+probecheck "environmentvariable58" || exit 255
+
+name=$(basename $0 .sh)
+stderr=$(make_temp_file /tmp ${name}.out)
+tmpdir=$(make_temp_dir /tmp ${name}.out)
+result=$(make_temp_file ${tmpdir} ${name}.out)
+verbose=$(make_temp_file ${tmpdir} ${name}.log)
+
+cpe=$srcdir/${name}.cpe.xml
+
+echo "Stderr file = $stderr"
+echo "Result file = $result"
+
+$OSCAP xccdf eval --verbose DEVEL --verbose-log-file $verbose --cpe $cpe --results $result $srcdir/${name}.xccdf.xml 2> $stderr
+[ -f $stderr ]; [ ! -s $stderr ]; :> $stderr
+assert_exists 1 '//TestResult/rule-result[@idref="xccdf_moc.elpmaxe.www_rule_1"]/result[text()="pass"]'
+
+[ "$(grep -c 'Reusing the collected items of an equal object' $verbose)" == "1" ]
+
+rm -rf $tmpdir
+rm $stderr
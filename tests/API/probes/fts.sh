@@ -95,10 +95,7 @@ gen_tree $ROOT
 #
 # All of this is implemented in oval_fts_list.c.
 
-while read args; do
-	[ -z "${args%%#*}" ] && continue
-	eval oval_fts $args
-done <<EOF
+TESTS=$(cat <<EOF
 test1 \
 '' '' \
 '' '' \
@@ -243,5 +240,27 @@ test20 \
 d1/d11/d111/f1111,
 
 EOF
+)
+
+while read args; do
+	[ -z "${args%%#*}" ] && continue
+	eval oval_fts $args
+done <<< "$TESTS"
+
+# the same results are expected when the walks are replayed from the snapshot
+export OSCAP_PROBE_FTS_SNAPSHOT=16
+while read args; do
+	[ -z "${args%%#*}" ] && continue
+	eval oval_fts $args
+done <<< "$TESTS"
+unset OSCAP_PROBE_FTS_SNAPSHOT
+
+# and when the directories are read ahead by the parallel walker
+export OSCAP_PROBE_FTS_THREADS=4
+while read args; do
+	[ -z "${args%%#*}" ] && continue
+	eval oval_fts $args
+done <<< "$TESTS"
+unset OSCAP_PROBE_FTS_THREADS
 
 rm -rf $tmpdir
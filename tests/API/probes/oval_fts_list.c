@@ -213,6 +213,18 @@ int main(int argc, char *argv[])
 		"filepath=%p\n"
 		"behaviors=%p\n", path, filename, filepath, behaviors);
 
+	oval_fts_snapshot_ref();
+
+	/* record the walks first so that the listing below is a replay */
+	if (getenv(OVAL_FTS_SNAPSHOT_ENV) != NULL) {
+		ofts = oval_fts_open_prefixed(NULL, path, filename, filepath, behaviors, result);
+		if (ofts != NULL) {
+			while ((ofts_ent = oval_fts_read(ofts)) != NULL)
+				oval_ftsent_free(ofts_ent);
+			oval_fts_close(ofts);
+		}
+	}
+
 	ofts = oval_fts_open_prefixed(NULL, path, filename, filepath, behaviors, result);
 
 	if (ofts != NULL) {
@@ -224,6 +236,8 @@ int main(int argc, char *argv[])
 		oval_fts_close(ofts);
 	}
 
+	oval_fts_snapshot_unref();
+
 	SEXP_free(path);
 	SEXP_free(filename);
 	SEXP_free(filepath);
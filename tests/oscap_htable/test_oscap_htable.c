@@ -0,0 +1,277 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "common/list.h"
+
+#define KEYS 2000
+
+int test_add_get_detach(void);
+int test_iteration_order(void);
+int test_clone(void);
+int bench(int items, int rounds);
+
+static int _cmp(const char *s1, const char *s2)
+{
+	if (s1 == NULL)
+		return -1;
+	if (s2 == NULL)
+		return 1;
+	return strcmp(s1, s2);
+}
+
+static char *_key(int i)
+{
+	static char key[32];
+	snprintf(key, sizeof(key), "oval:org.example:obj:%d", i);
+	return key;
+}
+
+int test_add_get_detach()
+{
+	/* start with the smallest table to exercise growing */
+	struct oscap_htable *h = oscap_htable_new1(_cmp, 1);
+	for (long i = 0; i < KEYS; i++) {
+		if (!oscap_htable_add(h, _key(i), (void *) (i + 1))) {
+			fprintf(stderr, "Failed to add '%s'.\n", _key(i));
+			return 1;
+		}
+	}
+	if (oscap_htable_add(h, _key(7), NULL)) {
+		fprintf(stderr, "Duplicate key was added.\n");
+		return 1;
+	}
+	/* detach every third key, the remaining keys must stay reachable */
+	for (long i = 0; i < KEYS; i += 3) {
+		if (oscap_htable_detach(h, _key(i)) != (void *) (i + 1)) {
+			fprintf(stderr, "Failed to detach '%s'.\n", _key(i));
+			return 1;
+		}
+	}
+	for (long i = 0; i < KEYS; i++) {
+		void *expected = (i % 3 == 0) ? NULL : (void *) (i + 1);
+		if (oscap_htable_get(h, _key(i)) != expected) {
+			fprintf(stderr, "Wrong value for '%s'.\n", _key(i));
+			return 1;
+		}
+	}
+	if (oscap_htable_itemcount(h) != KEYS - (KEYS + 2) / 3) {
+		fprintf(stderr, "Wrong item count: %zu.\n", oscap_htable_itemcount(h));
+		return 1;
+	}
+	/* detached key can be added again */
+	if (!oscap_htable_add(h, _key(0), (void *) 1) || oscap_htable_get(h, _key(0)) != (void *) 1) {
+		fprintf(stderr, "Failed to re-add a detached key.\n");
+		return 1;
+	}
+	oscap_htable_free0(h);
+	return 0;
+}
+
+int test_iteration_order()
+{
+	struct oscap_htable *h = oscap_htable_new();
+	for (long i = 0; i < KEYS; i++)
+		oscap_htable_add(h, _key(i), (void *) i);
+	oscap_htable_detach(h, _key(1));
+
+	long expected = 0;
+	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(h);
+	while (oscap_htable_iterator_has_more(hit)) {
+		const struct oscap_htable_item *item = oscap_htable_iterator_next(hit);
+		if (expected == 1)
+			expected++;
+		if (item->value != (void *) expected || strcmp(item->key, _key(expected)) != 0) {
+			fprintf(stderr, "Item '%s' returned out of the insertion order.\n", item->key);
+			return 1;
+		}
+		/* detaching the current item must not break the iteration */
+		if (expected % 2 == 0)
+			oscap_htable_detach(h, item->key);
+		expected++;
+	}
+	oscap_htable_iterator_free(hit);
+	if (expected != KEYS || oscap_htable_itemcount(h) != KEYS / 2 - 1) {
+		fprintf(stderr, "Iteration ended after %ld items.\n", expected);
+		return 1;
+	}
+	oscap_htable_free0(h);
+	return 0;
+}
+
+static void *_clone_value(void *value)
+{
+	return value;
+}
+
+int test_clone()
+{
+	struct oscap_htable *h = oscap_htable_new();
+	for (long i = 0; i < 100; i++)
+		oscap_htable_add(h, _key(i), (void *) i);
+	struct oscap_htable *c = oscap_htable_clone(h, _clone_value);
+	struct oscap_htable_iterator *hit = oscap_htable_iterator_new(h);
+	struct oscap_htable_iterator *cit = oscap_htable_iterator_new(c);
+	while (oscap_htable_iterator_has_more(hit)) {
+		if (!oscap_htable_iterator_has_more(cit) ||
+		    strcmp(oscap_htable_iterator_next_key(hit), oscap_htable_iterator_next_key(cit)) != 0) {
+			fprintf(stderr, "Clone differs from the original table.\n");
+			return 1;
+		}
+	}
+	oscap_htable_iterator_free(hit);
+	oscap_htable_iterator_free(cit);
+	oscap_htable_free0(h);
+	oscap_htable_free0(c);
+	return 0;
+}
+
+/*
+ * The chained hash table with a fixed number of buckets which was used
+ * before, kept here as the baseline for the benchmark.
+ */
+#define LEGACY_HSIZE 389
+
+struct legacy_item {
+	struct legacy_item *next;
+	char *key;
+	void *value;
+};
+
+struct legacy_htable {
+	struct legacy_item *table[LEGACY_HSIZE];
+};
+
+static unsigned int legacy_hash(const char *str)
+{
+	unsigned h = 0;
+	for (const unsigned char *p = (const unsigned char *)str; *p != '\0'; p++)
+		h = (97 * h) + *p;
+	return h % LEGACY_HSIZE;
+}
+
+static struct legacy_item *legacy_lookup(struct legacy_htable *t, const char *key)
+{
+	for (struct legacy_item *it = t->table[legacy_hash(key)]; it != NULL; it = it->next)
+		if (_cmp(it->key, key) == 0)
+			return it;
+	return NULL;
+}
+
+static bool legacy_add(struct legacy_htable *t, const char *key, void *value)
+{
+	if (legacy_lookup(t, key) != NULL)
+		return false;
+	unsigned int h = legacy_hash(key);
+	struct legacy_item *it = malloc(sizeof(struct legacy_item));
+	it->key = strdup(key);
+	it->value = value;
+	it->next = t->table[h];
+	t->table[h] = it;
+	return true;
+}
+
+static void legacy_free(struct legacy_htable *t)
+{
+	for (int i = 0; i < LEGACY_HSIZE; i++) {
+		struct legacy_item *it = t->table[i];
+		while (it != NULL) {
+			struct legacy_item *next = it->next;
+			free(it->key);
+			free(it);
+			it = next;
+		}
+	}
+	free(t);
+}
+
+static double _elapsed(const struct timespec *start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int bench(int items, int rounds)
+{
+	char **keys = malloc(items * sizeof(char *));
+	for (int i = 0; i < items; i++)
+		keys[i] = strdup(_key(i));
+
+	struct timespec start;
+	long found = 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	struct legacy_htable *l = calloc(1, sizeof(struct legacy_htable));
+	for (int i = 0; i < items; i++)
+		legacy_add(l, keys[i], keys[i]);
+	for (int r = 0; r < rounds; r++)
+		for (int i = 0; i < items; i++)
+			found += legacy_lookup(l, keys[i]) != NULL;
+	legacy_free(l);
+	printf("legacy  %8d items: %.3fs\n", items, _elapsed(&start));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	struct oscap_htable *h = oscap_htable_new();
+	for (int i = 0; i < items; i++)
+		oscap_htable_add(h, keys[i], keys[i]);
+	for (int r = 0; r < rounds; r++)
+		for (int i = 0; i < items; i++)
+			found += oscap_htable_get(h, keys[i]) != NULL;
+	oscap_htable_free0(h);
+	printf("htable  %8d items: %.3fs\n", items, _elapsed(&start));
+
+	for (int i = 0; i < items; i++)
+		free(keys[i]);
+	free(keys);
+	return found == 2L * items * rounds ? 0 : 1;
+}
+
+int main (int argc, char *argv[])
+{
+	int retval = 0;
+
+	/* test_oscap_htable --bench [items] [rounds] */
+	if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+		int items = argc > 2 ? atoi(argv[2]) : 100000;
+		int rounds = argc > 3 ? atoi(argv[3]) : 10;
+		return bench(items, rounds);
+	}
+
+	if ((retval = test_add_get_detach()) != 0 ) {
+		return retval;
+	}
+
+	if ((retval = test_iteration_order()) != 0 ) {
+		return retval;
+	}
+
+	if ((retval = test_clone()) != 0 ) {
+		return retval;
+	}
+
+	return retval;
+}
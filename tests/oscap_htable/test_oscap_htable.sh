@@ -0,0 +1,24 @@
+#!/usr/bin/env bash
+
+# Copyright 2026 Red Hat Inc., Durham, North Carolina.
+# All Rights Reserved.
+#
+# OpenScap Test Suite
+
+. $builddir/tests/test_common.sh
+
+# Test cases.
+
+function test_oscap_htable {
+    ./test_oscap_htable
+}
+
+# Testing.
+
+test_init
+
+if [ -z ${CUSTOM_OSCAP+x} ] ; then
+    test_run "test_oscap_htable" test_oscap_htable
+fi
+
+test_exit
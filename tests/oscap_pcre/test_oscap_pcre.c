@@ -0,0 +1,123 @@
+/*
+ * Copyright 2026 Red Hat Inc., Durham, North Carolina.
+ * All Rights Reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "common/oscap_pcre.h"
+
+int test_match(void);
+int test_cache_hits(void);
+int test_compile_error(void);
+
+static int _match(const char *pattern, int options, const char *subject)
+{
+	const char *err;
+	int errofs;
+	struct oscap_pcre *re = oscap_pcre_acquire(pattern, options, &err, &errofs);
+	if (re == NULL)
+		return -2;
+	int rc = oscap_pcre_exec(re, subject, strlen(subject), 0, 0, NULL, 0);
+	oscap_pcre_release(re);
+	return rc;
+}
+
+int test_match()
+{
+	if (_match("^foo[0-9]+$", 0, "foo42") < 0) {
+		fprintf(stderr, "Pattern did not match.\n");
+		return 1;
+	}
+	if (_match("^foo[0-9]+$", 0, "foo") != PCRE_ERROR_NOMATCH) {
+		fprintf(stderr, "Pattern matched unexpectedly.\n");
+		return 1;
+	}
+	/* same pattern, different options must not share the compiled code */
+	if (_match("^FOO", PCRE_CASELESS, "foo") < 0 || _match("^FOO", 0, "foo") != PCRE_ERROR_NOMATCH) {
+		fprintf(stderr, "Compile options were not taken into account.\n");
+		return 1;
+	}
+	return 0;
+}
+
+int test_cache_hits()
+{
+	unsigned long hits_before, misses_before, hits, misses;
+
+	oscap_pcre_cache_stats(&hits_before, &misses_before);
+	for (int i = 0; i < 100; i++) {
+		if (_match("^bar(baz)?$", 0, "barbaz") < 0) {
+			fprintf(stderr, "Pattern did not match.\n");
+			return 1;
+		}
+	}
+	oscap_pcre_cache_stats(&hits, &misses);
+	if (misses - misses_before != 1 || hits - hits_before != 99) {
+		fprintf(stderr, "Unexpected cache statistics: %lu hits, %lu misses.\n",
+			hits - hits_before, misses - misses_before);
+		return 1;
+	}
+
+	/* a pattern in use survives clearing of the cache */
+	const char *err;
+	int errofs;
+	struct oscap_pcre *re = oscap_pcre_acquire("^bar", 0, &err, &errofs);
+	oscap_pcre_cache_clear();
+	if (oscap_pcre_exec(re, "barbaz", 6, 0, 0, NULL, 0) < 0) {
+		fprintf(stderr, "Pattern did not match after clearing the cache.\n");
+		return 1;
+	}
+	oscap_pcre_release(re);
+	return 0;
+}
+
+int test_compile_error()
+{
+	const char *err = NULL;
+	int errofs = -1;
+	struct oscap_pcre *re = oscap_pcre_acquire("(unbalanced", 0, &err, &errofs);
+	if (re != NULL || err == NULL) {
+		fprintf(stderr, "Invalid pattern was compiled.\n");
+		return 1;
+	}
+	return 0;
+}
+
+int main (int argc, char *argv[])
+{
+	int retval = 0;
+	if ((retval = test_match()) != 0 ) {
+		return retval;
+	}
+
+	if ((retval = test_cache_hits()) != 0 ) {
+		return retval;
+	}
+
+	if ((retval = test_compile_error()) != 0 ) {
+		return retval;
+	}
+
+	oscap_pcre_cache_clear();
+	return retval;
+}
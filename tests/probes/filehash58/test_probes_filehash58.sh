@@ -120,6 +120,38 @@ function test_probes_filehash58_chroot_fail {
 	return $ret_val
 }
 
+function test_probes_filehash58_digest_cache {
+	local ret_val=0
+	local cache_dir="$(pwd)/digest_cache"
+
+	rm -rf cache "$cache_dir"
+	mkdir -p cache
+	echo foo > cache/oval-test
+	# only files which didn't change for a while are cached
+	sleep 3
+
+	export OSCAP_PROBE_DIGEST_CACHE="$cache_dir"
+
+	# offline scans don't use the cache unless it's enabled explicitly
+	test_probes_filehash58_chroot cache true || ret_val=1
+	[ -z "$(find "$cache_dir" -type f 2>/dev/null)" ] || ret_val=1
+
+	export OSCAP_PROBE_DIGEST_CACHE_OFFLINE=1
+	test_probes_filehash58_chroot cache true || ret_val=1
+	[ -n "$(find "$cache_dir" -type f)" ] || ret_val=1
+	# cached digest
+	test_probes_filehash58_chroot cache true || ret_val=1
+
+	# the changed file mustn't match the cached digest
+	echo bar > cache/oval-test
+	test_probes_filehash58_chroot cache false || ret_val=1
+
+	unset OSCAP_PROBE_DIGEST_CACHE OSCAP_PROBE_DIGEST_CACHE_OFFLINE
+	rm -rf cache "$cache_dir"
+
+	return $ret_val
+}
+
 # Testing.
 
 test_init
@@ -134,4 +166,6 @@ test_run "test_probes_filehash58_chroot_fail" test_probes_filehash58_chroot_fail
 
 test_run "test_probes_filehash58_chroot_pass" test_probes_filehash58_chroot_pass
 
+test_run "test_probes_filehash58_digest_cache" test_probes_filehash58_digest_cache
+
 test_exit
@@ -0,0 +1,49 @@
+#!/usr/bin/env bash
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+function perform_test {
+	probecheck "sysctl" || return 255
+	[ "$(uname)" = "Linux" ] || return 255
+
+	result=`mktemp`
+	stderr=`mktemp`
+	definitions=`mktemp`
+	hostname=`hostname`
+
+	# an interface with a dot in its name, e.g. a VLAN interface eth0.100
+	dotted_if=$(ls /proc/sys/net/ipv4/conf/ | grep -F '.' | head -n 1 || true)
+	if [ -n "$dotted_if" ]; then
+		dotted_name="net.ipv4.conf.$dotted_if.forwarding"
+	else
+		dotted_name="kernel.ostype"
+	fi
+	sed "s|@DOTTED_NAME@|$dotted_name|" $srcdir/test_sysctl_probe_names.oval.xml > $definitions
+
+	$OSCAP oval eval --results $result $definitions 2>$stderr
+
+	[ ! -s $stderr ]
+
+	sd="/oval_results/results/system/oval_system_characteristics/system_data"
+	co="/oval_results/results/system/oval_system_characteristics/collected_objects"
+
+	# the name with a slash isn't turned into a path
+	assert_exists 1 "$co/object[@id='oval:oscap:obj:1'][@flag='does not exist']"
+	assert_exists 0 "$sd/unix-sys:sysctl_item/unix-sys:name[contains(text(), '/')]"
+	assert_exists 0 "$sd/unix-sys:sysctl_item/unix-sys:value[starts-with(text(), 'root:')]"
+
+	assert_exists 1 "$sd/unix-sys:sysctl_item[unix-sys:name='kernel.hostname'][unix-sys:value='$hostname']"
+
+	if [ -n "$dotted_if" ]; then
+		assert_exists 1 "$co/object[@id='oval:oscap:obj:3'][@flag='complete']"
+		assert_exists 1 "$sd/unix-sys:sysctl_item/unix-sys:name[text()='$dotted_name']"
+	fi
+
+	rm $result
+	rm $stderr
+	rm $definitions
+}
+
+perform_test
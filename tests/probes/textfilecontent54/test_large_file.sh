@@ -0,0 +1,36 @@
+#!/usr/bin/env bash
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+# Matches patterns on a synthetic large file. The first object is matched
+# line by line in bounded memory, the second one on the whole file content,
+# both have to collect the same items. Set TFC54_BENCH_LINES to a larger
+# number to use this as a benchmark.
+lines=${TFC54_BENCH_LINES:-100000}
+
+name=$(basename $0 .sh)
+tmpdir=$(make_temp_dir /tmp ${name})
+tpl=${srcdir}/${name}.xml.tpl
+input=${tmpdir}/${name}.xml
+result=${tmpdir}/${name}.results.xml
+echo "Temp dir: $tmpdir"
+
+# prepare the environment
+sed "s@%PATH%@${tmpdir}@" $tpl > $input
+awk -v n=$lines 'BEGIN { for (i = 0; i < n; i++) printf("key_%d = value%d\n", i, i % 10) }' > "${tmpdir}/textfile"
+echo "Generated $(wc -c < "${tmpdir}/textfile") bytes in $lines lines."
+
+echo "Evaluating content."
+time $OSCAP oval eval --results $result $input || [ $? == 2 ]
+
+echo "Testing syschar values."
+expected=$(( (lines + 2) / 10 ))
+for obj in 1 2; do
+	[ "$($XPATH $result 'string(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:'$obj'"]/@flag)')" == "complete" ]
+	[ "$($XPATH $result 'count(/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:'$obj'"]/reference)')" == "$expected" ]
+done
+[ "$($XPATH $result 'string(/oval_results/results/system/tests/test[@test_id="oval:x:tst:1"]/@result)')" == "true" ]
+[ "$($XPATH $result 'string(/oval_results/results/system/tests/test[@test_id="oval:x:tst:2"]/@result)')" == "true" ]
+
+rm -rf $tmpdir
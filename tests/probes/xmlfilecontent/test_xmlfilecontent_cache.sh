@@ -0,0 +1,25 @@
+#!/usr/bin/env bash
+
+# The parsed documents are cached by the probe. Objects querying the same
+# file have to get the same results as from a freshly parsed document and
+# a file of the same content at another path mustn't be mixed up with it.
+
+. $builddir/tests/test_common.sh
+set -e -o pipefail
+
+dir=$(mktemp -d)
+result=$(mktemp)
+definitions=$(mktemp)
+
+cp $srcdir/example.xml $dir/first.xml
+sed 's/2013 Coyote Edition SP1/2014/' $srcdir/example.xml > $dir/second.xml
+sed "s|@DIR@|$dir|" $srcdir/test_xmlfilecontent_cache.xml > $definitions
+
+$OSCAP oval eval --results $result $definitions
+
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:x:def:1" and @result="true"]'
+assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:4" and @flag="error"]'
+assert_exists 1 '/oval_results/results/system/oval_system_characteristics/collected_objects/object[@id="oval:x:obj:4"]/message[contains(text(), "xmlXPathCompile")]'
+
+rm -rf $dir
+rm -f $result $definitions
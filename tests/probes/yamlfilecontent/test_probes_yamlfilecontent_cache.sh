@@ -0,0 +1,34 @@
+#!/usr/bin/env bash
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+probecheck "yamlfilecontent" || exit 255
+
+# Several objects query the same file, all but the first are answered
+# from the events recorded by the probe. A second file with a different
+# content must not be answered from the cache entry of the first one.
+tmpdir=$(mktemp -d)
+cp "${srcdir}/openshift-logging.yaml" "$tmpdir/a.yaml"
+sed 's/^  name: instance$/  name: other/' "${srcdir}/openshift-logging.yaml" > "$tmpdir/b.yaml"
+
+oval_file="$tmpdir/test_probes_yamlfilecontent_cache.xml"
+sed "s|@DIR@|$tmpdir|g" "${srcdir}/test_probes_yamlfilecontent_cache.xml" > "$oval_file"
+result="results.xml"
+
+[ -f $result ] && rm -f $result
+
+$OSCAP oval eval --results $result $oval_file
+
+[ -f $result ]
+
+assert_exists 1 '/oval_results/results/system/definitions/definition[@definition_id="oval:0:def:1" and @result="true"]'
+
+sd='/oval_results/results/system/oval_system_characteristics/system_data'
+
+assert_exists 1 $sd'/ind-sys:yamlfilecontent_item[ind-sys:filename="a.yaml"]/ind-sys:value/field[@name="#" and text()="instance"]'
+assert_exists 1 $sd'/ind-sys:yamlfilecontent_item[ind-sys:filename="b.yaml"]/ind-sys:value/field[@name="#" and text()="other"]'
+
+rm -rf "$tmpdir"
+rm -f "$result"
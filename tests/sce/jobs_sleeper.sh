@@ -0,0 +1,15 @@
+#!/usr/bin/env bash
+
+# The earlier checks sleep longer, so that the scripts run concurrently
+# finish in the reverse order of the benchmark.
+sleep $XCCDF_VALUE_DELAY
+
+echo "out $XCCDF_VALUE_ID first"
+echo "err $XCCDF_VALUE_ID first" >&2
+echo "out $XCCDF_VALUE_ID second"
+echo "err $XCCDF_VALUE_ID second" >&2
+
+if [ "$XCCDF_VALUE_ID" = "3" ]; then
+	exit $XCCDF_RESULT_FAIL
+fi
+exit $XCCDF_RESULT_PASS
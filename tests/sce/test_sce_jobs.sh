@@ -0,0 +1,43 @@
+#!/usr/bin/env bash
+
+# Test that the SCE scripts started ahead of time by several jobs give
+# the same results and output, in the same order, as a serial run.
+
+. $builddir/tests/test_common.sh
+
+set -e -o pipefail
+
+# The rule results without the timestamps
+function rule_results {
+    sed -n '/<rule-result/,/<\/rule-result>/p' "$1" | sed 's/ time="[^"]*"//'
+}
+
+function test_sce_jobs {
+
+    local xccdf_file=${srcdir}/$1
+    local serial=$(mktemp)
+    local parallel=$(mktemp)
+
+    OSCAP_SCE_JOBS=1 $OSCAP xccdf eval --results "$serial" "$xccdf_file" || [ $? -eq 2 ]
+    OSCAP_SCE_JOBS=4 $OSCAP xccdf eval --results "$parallel" "$xccdf_file" || [ $? -eq 2 ]
+    echo "===== result ====="
+    cat $parallel
+
+    result=$parallel
+    assert_exists 4 '//rule-result'
+    assert_exists 1 '//rule-result[1][@idref="xccdf_moc.elpmaxe.www_rule_1"]/result[text()="pass"]'
+    assert_exists 1 '//rule-result[3][@idref="xccdf_moc.elpmaxe.www_rule_3"]/result[text()="fail"]'
+    grep -q '<check-import import-name="stdout">out 1 first' $parallel
+    grep -q '^out 1 second' $parallel
+
+    diff <(rule_results $serial) <(rule_results $parallel)
+
+    rm -f $serial $parallel
+}
+
+# Testing.
+test_init
+
+test_run "SCE jobs" test_sce_jobs test_sce_jobs.xccdf.xml
+
+test_exit
@@ -116,7 +116,9 @@ static struct oscap_module OVAL_EVAL = {
 	"                                   (only applicable for source data streams)\n"
 	"   --fetch-remote-resources      - Download remote content referenced by OVAL Definitions.\n"
 	"                                   (only applicable for source data streams)\n"
-	"   --local-files <dir>           - Use locally downloaded copies of remote resources stored in the given directory.\n",
+	"   --local-files <dir>           - Use locally downloaded copies of remote resources stored in the given directory.\n"
+	"   --oval-workers <n>            - Collect OVAL objects of different types using <n> threads.\n"
+	"   --probe-memory-limit <MiB>    - Mark objects incomplete once the memory used by probes exceeds <MiB>.\n",
     .opt_parser = getopt_oval_eval,
     .func = app_evaluate_oval
 };
@@ -346,6 +348,7 @@ int app_evaluate_oval(const struct oscap_action *action)
 	oval_session_set_variables(session, action->f_variables);
 
 	oval_session_configure_remote_resources(session, action->remote_resources, action->local_files, download_reporting_callback);
+	oval_session_set_eval_workers(session, action->oval_workers);
 	/* load all necesary OVAL Definitions and bind OVAL Variables if provided */
 	if ((oval_session_load(session)) != 0)
 		goto cleanup;
@@ -501,7 +504,9 @@ enum oval_opt {
     OVAL_OPT_DATASTREAM_ID,
     OVAL_OPT_OVAL_ID,
 	OVAL_OPT_OUTPUT = 'o',
-	OVAL_OPT_LOCAL_FILES
+	OVAL_OPT_LOCAL_FILES,
+	OVAL_OPT_WORKERS,
+	OVAL_OPT_PROBE_MEMORY_LIMIT
 };
 
 #if defined(OVAL_PROBES_ENABLED)
@@ -523,6 +528,8 @@ bool getopt_oval_eval(int argc, char **argv, struct oscap_action *action)
 		{ "skip-validation",	no_argument, &action->validate, 0 },
 		{ "fetch-remote-resources", no_argument, &action->remote_resources, 1},
 		{ "local-files", required_argument, NULL, OVAL_OPT_LOCAL_FILES},
+		{ "oval-workers", required_argument, NULL, OVAL_OPT_WORKERS},
+		{ "probe-memory-limit", required_argument, NULL, OVAL_OPT_PROBE_MEMORY_LIMIT},
 		{ 0, 0, 0, 0 }
 	};
 
@@ -539,6 +546,14 @@ bool getopt_oval_eval(int argc, char **argv, struct oscap_action *action)
 		case OVAL_OPT_LOCAL_FILES:
 			action->local_files = optarg;
 			break;
+		case OVAL_OPT_WORKERS:
+			if (!parse_oval_workers(action, optarg))
+				return false;
+			break;
+		case OVAL_OPT_PROBE_MEMORY_LIMIT:
+			if (!parse_probe_memory_limit(action, optarg))
+				return false;
+			break;
 		case 0: break;
 		default: return oscap_module_usage(action->module, stderr, NULL);
 		}
@@ -435,6 +435,37 @@ bool check_verbose_options(struct oscap_action *action)
 	return true;
 }
 
+bool parse_oval_workers(struct oscap_action *action, const char *arg)
+{
+	char *end = NULL;
+	unsigned long workers = strtoul(arg, &end, 10);
+	if (*arg == '\0' || *arg == '-' || end == NULL || *end != '\0' || workers < 1 || workers > 256) {
+		oscap_module_usage(action->module, stderr,
+			"Invalid number of OVAL workers '%s'! It must be a number between 1 and 256.", arg);
+		return false;
+	}
+	action->oval_workers = (unsigned int) workers;
+	return true;
+}
+
+bool parse_probe_memory_limit(struct oscap_action *action, const char *arg)
+{
+	char *end = NULL;
+	unsigned long long limit = strtoull(arg, &end, 10);
+	if (*arg == '\0' || *arg == '-' || end == NULL || *end != '\0' || limit < 1) {
+		oscap_module_usage(action->module, stderr,
+			"Invalid probe memory limit '%s'! It must be a positive number of MiB.", arg);
+		return false;
+	}
+	/* probes read their limits from the environment, see probe/worker.c */
+#ifdef _WIN32
+	_putenv_s("OSCAP_PROBE_MEMORY_LIMIT", arg);
+#else
+	setenv("OSCAP_PROBE_MEMORY_LIMIT", arg, 1);
+#endif
+	return true;
+}
+
 void download_reporting_callback(bool warning, const char *format, ...)
 {
 	FILE *dest = stderr;
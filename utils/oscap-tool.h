@@ -176,6 +176,7 @@ struct oscap_action {
 	char *verbosity_level;
 	char *fix_type;
 	char *local_files;
+	unsigned int oval_workers;
 };
 
 int app_xslt(const char *infile, const char *xsltfile, const char *outfile, const char **params);
@@ -187,6 +188,8 @@ int oscap_module_call(struct oscap_action *action);
 
 void oscap_print_error(void);
 bool check_verbose_options(struct oscap_action *action);
+bool parse_oval_workers(struct oscap_action *action, const char *arg);
+bool parse_probe_memory_limit(struct oscap_action *action, const char *arg);
 void download_reporting_callback(bool warning, const char *format, ...);
 
 void report_missing_profile(const char *profile_suffix, const char *source_file);
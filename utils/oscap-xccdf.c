@@ -174,6 +174,8 @@ static struct oscap_module XCCDF_EVAL = {
 		"   --enforce-signature           - Process only signed data streams.\n"
 		"   --fetch-remote-resources      - Download remote content referenced by XCCDF.\n"
 		"   --local-files <dir>           - Use locally downloaded copies of remote resources stored in the given directory.\n"
+		"   --oval-workers <n>            - Collect OVAL objects of different types using <n> threads.\n"
+		"   --probe-memory-limit <MiB>    - Mark objects incomplete once the memory used by probes exceeds <MiB>.\n"
 		"   --progress                    - Switch to sparse output suitable for progress reporting.\n"
 		"                                   Format is \"$rule_id:$result\\n\".\n"
 		"   --progress-full               - Switch to sparse but a bit more saturated output also suitable for progress reporting.\n"
@@ -625,6 +627,7 @@ int app_evaluate_xccdf(const struct oscap_action *action)
 	xccdf_session_configure_remote_resources(session, action->remote_resources, action->local_files, download_reporting_callback);
 	xccdf_session_set_custom_oval_files(session, action->f_ovals);
 	xccdf_session_set_product_cpe(session, OSCAP_PRODUCTNAME);
+	xccdf_session_set_oval_eval_workers(session, action->oval_workers);
 	struct oscap_string_iterator *it = oscap_stringlist_get_strings(action->rules);
 	while (oscap_string_iterator_has_more(it)) {
 		const char *rid = oscap_string_iterator_next(it);
@@ -1200,7 +1203,9 @@ enum oval_opt {
     XCCDF_OPT_OUTPUT = 'o',
     XCCDF_OPT_RESULT_ID = 'i',
 	XCCDF_OPT_FIX_TYPE,
-	XCCDF_OPT_LOCAL_FILES
+	XCCDF_OPT_LOCAL_FILES,
+	XCCDF_OPT_OVAL_WORKERS,
+	XCCDF_OPT_PROBE_MEMORY_LIMIT
 };
 
 bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
@@ -1234,6 +1239,8 @@ bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
 		{"sce-template", 	required_argument, NULL, XCCDF_OPT_SCE_TEMPLATE},
 		{"fix-type", required_argument, NULL, XCCDF_OPT_FIX_TYPE},
 		{"local-files", required_argument, NULL, XCCDF_OPT_LOCAL_FILES},
+		{"oval-workers", required_argument, NULL, XCCDF_OPT_OVAL_WORKERS},
+		{"probe-memory-limit", required_argument, NULL, XCCDF_OPT_PROBE_MEMORY_LIMIT},
 	// flags
 		{"force",		no_argument, &action->force, 1},
 		{"oval-results",	no_argument, &action->oval_results, 1},
@@ -1297,6 +1304,14 @@ bool getopt_xccdf(int argc, char **argv, struct oscap_action *action)
 		case XCCDF_OPT_LOCAL_FILES:
 			action->local_files = optarg;
 			break;
+		case XCCDF_OPT_OVAL_WORKERS:
+			if (!parse_oval_workers(action, optarg))
+				return false;
+			break;
+		case XCCDF_OPT_PROBE_MEMORY_LIMIT:
+			if (!parse_probe_memory_limit(action, optarg))
+				return false;
+			break;
 		case 0: break;
 		default: return oscap_module_usage(action->module, stderr, NULL);
 		}